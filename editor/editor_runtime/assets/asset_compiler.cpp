@@ -20,16 +20,20 @@
 #include <core/serialization/types/unordered_map.hpp>
 #include <core/serialization/types/vector.hpp>
 #include <core/string_utils/string_utils.h>
+#include <core/system/subsystem.h>
 #include <core/uuid/uuid.hpp>
 
 #include <runtime/ecs/constructs/prefab.h>
 #include <runtime/ecs/constructs/scene.h>
+#include <runtime/ecs/constructs/utils.h>
 #include <runtime/meta/animation/animation.hpp>
 #include <runtime/meta/audio/sound.hpp>
 #include <runtime/meta/rendering/material.hpp>
 #include <runtime/meta/rendering/mesh.hpp>
+#include <runtime/rendering/streamed_texture.h>
 
 #include <array>
+#include <cstring>
 #include <fstream>
 
 namespace asset_compiler
@@ -186,6 +190,67 @@ void compile<gfx::shader>(const fs::path& absolute_meta_key, const fs::path& out
 	fs::remove(temp, err);
 }
 
+// Converts the ktx of a plain 2d texture with a full mip chain to the
+// streamed layout, smallest mip first. Anything else stays a ktx.
+static bool convert_to_streamed(const fs::byte_array_t& ktx, std::uint8_t texel_size,
+								gfx::texture_format format, fs::byte_array_t& output)
+{
+	static const std::uint8_t identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31,
+												0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+	const auto read_u32 = [&ktx](std::size_t offset) {
+		std::uint32_t value = 0;
+		std::memcpy(&value, ktx.data() + offset, sizeof(value));
+		return value;
+	};
+
+	if(ktx.size() < 64 || std::memcmp(ktx.data(), identifier, sizeof(identifier)) != 0 ||
+	   read_u32(12) != 0x04030201)
+	{
+		return false;
+	}
+
+	const auto width = read_u32(36);
+	const auto height = read_u32(40);
+	const auto depth = read_u32(44);
+	const auto layers = read_u32(48);
+	const auto faces = read_u32(52);
+	const auto mips = read_u32(56);
+	if(width == 0 || width > 0xFFFF || height == 0 || height > 0xFFFF || depth > 1 || layers > 0 ||
+	   faces != 1)
+	{
+		return false;
+	}
+
+	const auto info = runtime::streamed_texture::make_header(
+		static_cast<std::uint16_t>(width), static_cast<std::uint16_t>(height), texel_size, format);
+	if(info.mips != mips)
+	{
+		return false;
+	}
+
+	fs::byte_array_t chain;
+	chain.reserve(runtime::streamed_texture::get_resident_size(info, 0));
+	std::size_t offset = 64 + read_u32(60);
+	for(std::uint32_t mip = 0; mip < mips; ++mip)
+	{
+		if(offset + 4 > ktx.size())
+		{
+			return false;
+		}
+		const auto size = read_u32(offset);
+		offset += 4;
+		if(size != runtime::streamed_texture::get_mip_size(info, mip) || offset + size > ktx.size())
+		{
+			return false;
+		}
+		chain.insert(std::end(chain), ktx.data() + offset, ktx.data() + offset + size);
+		offset += (size + 3) & ~std::size_t(3);
+	}
+
+	runtime::streamed_texture::pack(info, chain.data(), output);
+	return true;
+}
+
 template <>
 void compile<gfx::texture>(const fs::path& absolute_meta_key, const fs::path& output)
 {
@@ -218,6 +283,21 @@ void compile<gfx::texture>(const fs::path& absolute_meta_key, const fs::path& ou
 	else
 	{
 		APPLOG_INFO("Successful compilation of {0}", str_input);
+
+		// Streamed textures are read partially, the tail first.
+		fs::byte_array_t streamed;
+		{
+			std::ifstream stream{str_output, std::ios::in | std::ios::binary};
+			const auto ktx = fs::read_stream(stream);
+			convert_to_streamed(ktx, 4, gfx::texture_format::BGRA8, streamed);
+		}
+		if(!streamed.empty())
+		{
+			std::ofstream stream{str_output, std::ios::out | std::ios::binary | std::ios::trunc};
+			stream.write(reinterpret_cast<const char*>(streamed.data()),
+						 static_cast<std::streamsize>(streamed.size()));
+		}
+
 		fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
 	}
 	fs::remove(temp, err);
@@ -428,7 +508,29 @@ void compile<scene>(const fs::path& absolute_meta_key, const fs::path& output)
 	fs::path absolute_key = fs::convert_to_protocol(absolute_meta_key);
 	absolute_key = fs::resolve_protocol(fs::replace(absolute_key, ":/meta", ":/data"));
 	absolute_key.replace_extension();
-	fs::copy_file(absolute_key, output, fs::copy_options::overwrite_existing, err);
-	APPLOG_INFO("Successful compilation of {0}", absolute_key.string());
+	std::string str_input = absolute_key.string();
+
+	fs::path temp = fs::temp_directory_path(err);
+	temp /= uuids::random_uuid(str_input).to_string() + ".buildtemp";
+
+	// The editor saves scenes in the associative format, the runtime loads
+	// the binary one.
+	bool converted = false;
+	{
+		std::ifstream input(str_input, std::ios::in | std::ios::binary);
+		std::ofstream soutput(temp.string(), std::ios::out | std::ios::binary);
+		converted = input.good() && soutput.good() && ecs::utils::convert_to_binary(input, soutput);
+	}
+
+	if(!converted)
+	{
+		APPLOG_ERROR("Failed compilation of {0}", str_input);
+		fs::remove(temp, err);
+		return;
+	}
+	fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
+	fs::remove(temp, err);
+
+	APPLOG_INFO("Successful compilation of {0}", str_input);
 }
 }
@@ -0,0 +1,336 @@
+#include "asset_database.h"
+#include "../meta/assets/asset_database.hpp"
+
+#include <core/logging/logging.h>
+#include <core/serialization/binary_archive.h>
+#include <core/serialization/types/map.hpp>
+#include <core/serialization/types/string.hpp>
+#include <core/serialization/types/unordered_map.hpp>
+#include <core/uuid/uuid.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace editor
+{
+namespace
+{
+/// Files of another version are discarded.
+constexpr std::uint32_t database_version = 3;
+
+std::string to_key(const fs::path& path)
+{
+	return fs::convert_to_protocol(path).generic_string();
+}
+
+bool read_contents(const fs::path& path, std::string& contents)
+{
+	std::ifstream stream(path.string(), std::ios::binary | std::ios::ate);
+	if(!stream)
+	{
+		return false;
+	}
+
+	const auto size = stream.tellg();
+	if(size < 0)
+	{
+		return false;
+	}
+	contents.resize(static_cast<std::size_t>(size));
+	stream.seekg(0);
+	return size == 0 || bool(stream.read(&contents[0], size));
+}
+
+// FNV-1a
+std::uint64_t hash_contents(const std::string& contents)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for(const auto c : contents)
+	{
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : scan_dependencies ()
+/// <summary>
+/// Protocol keys of the assets the contents refer to, like materials naming
+/// their textures as app:/data/textures/stone.png.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<std::string> scan_dependencies(const std::string& contents)
+{
+	static const std::string marker = ":/data/";
+	const auto is_protocol_char = [](char c) {
+		return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+	};
+	const auto is_path_char = [](char c) { return c != '"' && std::isprint(static_cast<unsigned char>(c)); };
+
+	std::vector<std::string> result;
+	auto pos = contents.find(marker);
+	while(pos != std::string::npos)
+	{
+		auto begin = pos;
+		while(begin > 0 && is_protocol_char(contents[begin - 1]))
+		{
+			--begin;
+		}
+		auto end = pos + marker.size();
+		while(end < contents.size() && is_path_char(contents[end]))
+		{
+			++end;
+		}
+
+		if(begin != pos && end != pos + marker.size())
+		{
+			result.emplace_back(contents, begin, end - begin);
+		}
+		pos = contents.find(marker, end);
+	}
+
+	std::sort(std::begin(result), std::end(result));
+	result.erase(std::unique(std::begin(result), std::end(result)), std::end(result));
+	return result;
+}
+}
+
+bool asset_database::open(const fs::path& file, const std::vector<fs::path>& roots)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	file_ = file;
+	roots_ = roots;
+	records_.clear();
+
+	trees_t trees;
+	bool loaded = false;
+	fs::error_code err;
+	if(fs::exists(file, err))
+	{
+		std::ifstream stream(file.string(), std::ios::binary);
+		cereal::iarchive_binary_t ar(stream);
+
+		std::uint32_t version = 0;
+		if(try_load(ar, cereal::make_nvp("version", version)) && version == database_version)
+		{
+			loaded = try_load(ar, cereal::make_nvp("trees", trees)) &&
+					 try_load(ar, cereal::make_nvp("records", records_));
+		}
+
+		if(!loaded)
+		{
+			APPLOG_WARNING("Discarding asset database {0}", file.string());
+			trees.clear();
+			records_.clear();
+		}
+	}
+
+	for(const auto& root : roots_)
+	{
+		auto it = trees.find(root.string());
+		if(it != std::end(trees))
+		{
+			fs::watcher::set_known_index(root, std::move(it->second));
+		}
+	}
+	return loaded;
+}
+
+void asset_database::close()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(file_.empty())
+	{
+		return;
+	}
+
+	trees_t trees;
+	for(const auto& root : roots_)
+	{
+		fs::watcher::tree_index index;
+		if(fs::watcher::get_index(root, index))
+		{
+			trees.emplace(root.string(), std::move(index));
+		}
+	}
+
+	// Written next to it first, a failed save keeps the previous file.
+	fs::path temp = file_;
+	temp.concat(".tmp");
+	{
+		std::ofstream stream(temp.string(), std::ios::binary | std::ios::trunc);
+		cereal::oarchive_binary_t ar(stream);
+		try_save(ar, cereal::make_nvp("version", database_version));
+		try_save(ar, cereal::make_nvp("trees", trees));
+		try_save(ar, cereal::make_nvp("records", records_));
+	}
+
+	fs::error_code err;
+	fs::rename(temp, file_, err);
+	if(err)
+	{
+		APPLOG_ERROR("Failed to save asset database {0}", file_.string());
+	}
+
+	file_.clear();
+	roots_.clear();
+	records_.clear();
+}
+
+bool asset_database::is_unchanged(const fs::path& source)
+{
+	std::uint64_t content_hash = 0;
+	std::vector<std::string> artifacts;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = records_.find(to_key(source));
+		if(it == std::end(records_) || it->second.artifacts.empty())
+		{
+			return false;
+		}
+
+		content_hash = it->second.content_hash;
+		for(const auto& a : it->second.artifacts)
+		{
+			artifacts.push_back(a.key);
+		}
+	}
+
+	const bool has_artifacts =
+		std::all_of(std::begin(artifacts), std::end(artifacts),
+					[](const std::string& key) { return fs::watcher::exists(fs::resolve_protocol(key)); });
+	if(!has_artifacts)
+	{
+		return false;
+	}
+
+	std::string contents;
+	return read_contents(source, contents) && hash_contents(contents) == content_hash;
+}
+
+void asset_database::on_compiled(const fs::path& source, const fs::path& output)
+{
+	std::string contents;
+	if(!read_contents(source, contents))
+	{
+		return;
+	}
+
+	fs::error_code err;
+	const auto time = fs::last_write_time(source, err);
+	const auto size = fs::file_size(source, err);
+	const auto content_hash = hash_contents(contents);
+	auto dependencies = scan_dependencies(contents);
+
+	fs::error_code output_err;
+	artifact compiled;
+	compiled.key = to_key(output);
+	compiled.time = fs::last_write_time(output, output_err);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto& r = records_[to_key(source)];
+	if(r.guid.empty())
+	{
+		r.guid = uuids::random_uuid().to_string();
+	}
+
+	// A source compiled from other contents than before loses its other artifacts.
+	if(r.content_hash != content_hash)
+	{
+		r.artifacts.clear();
+	}
+	r.content_hash = content_hash;
+	r.time = time;
+	r.size = size;
+	r.dependencies = std::move(dependencies);
+
+	auto it = std::find_if(std::begin(r.artifacts), std::end(r.artifacts),
+						   [&compiled](const artifact& a) { return a.key == compiled.key; });
+	if(output_err)
+	{
+		// The compilation failed.
+		if(it != std::end(r.artifacts))
+		{
+			r.artifacts.erase(it);
+		}
+	}
+	else if(it != std::end(r.artifacts))
+	{
+		*it = std::move(compiled);
+	}
+	else
+	{
+		r.artifacts.emplace_back(std::move(compiled));
+	}
+}
+
+void asset_database::on_removed(const fs::path& source)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	records_.erase(to_key(source));
+}
+
+void asset_database::on_renamed(const fs::path& old_source, const fs::path& new_source)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto old_key = to_key(old_source);
+	const auto new_key = to_key(new_source);
+	auto it = records_.find(old_key);
+	if(it == std::end(records_))
+	{
+		return;
+	}
+
+	auto r = std::move(it->second);
+	records_.erase(it);
+
+	// The artifacts are renamed along with it.
+	const auto old_prefix = fs::replace(old_key, ":/data", ":/cache").generic_string();
+	const auto new_prefix = fs::replace(new_key, ":/data", ":/cache").generic_string();
+	for(auto& a : r.artifacts)
+	{
+		if(a.key.compare(0, old_prefix.size(), old_prefix) == 0)
+		{
+			a.key = new_prefix + a.key.substr(old_prefix.size());
+		}
+	}
+	records_[new_key] = std::move(r);
+}
+
+bool asset_database::find_record(const std::string& key, record& result) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = records_.find(key);
+	if(it == std::end(records_))
+	{
+		return false;
+	}
+	result = it->second;
+	return true;
+}
+
+std::string asset_database::find_key(const std::string& guid) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = std::find_if(std::begin(records_), std::end(records_),
+						   [&guid](const records_t::value_type& pair) { return pair.second.guid == guid; });
+	return it != std::end(records_) ? it->first : std::string();
+}
+
+std::vector<std::string> asset_database::get_dependents(const std::string& key) const
+{
+	std::vector<std::string> result;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for(const auto& pair : records_)
+	{
+		const auto& deps = pair.second.dependencies;
+		if(std::binary_search(std::begin(deps), std::end(deps), key))
+		{
+			result.push_back(pair.first);
+		}
+	}
+	return result;
+}
+}
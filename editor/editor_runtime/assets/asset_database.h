@@ -0,0 +1,153 @@
+#pragma once
+#include <core/filesystem/filesystem_watcher.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : asset_database (Class)
+/// <summary>
+/// What is known about the assets of a set of asset directories, kept in a
+/// file between runs. Holds a record for every compiled source and the
+/// indices of the watched trees, so opening the directories again neither
+/// lists the unchanged ones nor compiles sources whose contents are the same.
+/// Updated from the watcher events, all functions are thread safe.
+///
+/// The file is read whole when opening rather than mapped, the records and
+/// indices are decoded into maps either way and the file is small next to
+/// the trees it describes. The entries the watcher takes from the indices
+/// are still checked against the file system one by one, in batches after
+/// the first listing, since a changed file does not touch its directory.
+/// </summary>
+//-----------------------------------------------------------------------------
+class asset_database
+{
+public:
+	struct artifact
+	{
+		/// The compiled file as a protocol key
+		std::string key;
+		/// Modification time of the compiled file
+		fs::file_time_type time;
+	};
+
+	struct record
+	{
+		/// Identifies the asset, kept when it is renamed
+		std::string guid;
+		/// Hash of the contents the source was last compiled from
+		std::uint64_t content_hash = 0;
+		/// Modification time of the source when it was hashed
+		fs::file_time_type time;
+		/// Size of the source when it was hashed
+		std::uintmax_t size = 0;
+		/// Assets the source refers to as protocol keys
+		std::vector<std::string> dependencies;
+		/// Files compiled from the source
+		std::vector<artifact> artifacts;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Loads the database from file and hands the known indices of the roots
+	/// to the watcher. Has to be called before the roots are watched. Returns
+	/// false when there was no usable database, which starts empty.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool open(const fs::path& file, const std::vector<fs::path>& roots);
+
+	//-----------------------------------------------------------------------------
+	//  Name : close ()
+	/// <summary>
+	/// Takes the indices of the roots from the watcher and saves the database
+	/// to the file it was opened from. Has to be called while the roots are
+	/// still watched. Does nothing when the database is not open.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void close();
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_unchanged ()
+	/// <summary>
+	/// Whether the contents of the source are the ones it was last compiled
+	/// from, so it does not have to be compiled again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_unchanged(const fs::path& source);
+
+	//-----------------------------------------------------------------------------
+	//  Name : on_compiled ()
+	/// <summary>
+	/// Records the contents and dependencies of the source and the file
+	/// compiled from it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void on_compiled(const fs::path& source, const fs::path& output);
+
+	//-----------------------------------------------------------------------------
+	//  Name : on_removed ()
+	/// <summary>
+	/// Forgets the record of the source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void on_removed(const fs::path& source);
+
+	//-----------------------------------------------------------------------------
+	//  Name : on_renamed ()
+	/// <summary>
+	/// Moves the record of the source, it keeps its guid.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void on_renamed(const fs::path& old_source, const fs::path& new_source);
+
+	//-----------------------------------------------------------------------------
+	//  Name : find_record ()
+	/// <summary>
+	/// Gets the record of the asset with the protocol key. Returns false when
+	/// it was never compiled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool find_record(const std::string& key, record& result) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : find_key ()
+	/// <summary>
+	/// Gets the protocol key of the asset with the guid, empty when unknown.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::string find_key(const std::string& guid) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dependents ()
+	/// <summary>
+	/// The assets referring to the asset with the protocol key.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<std::string> get_dependents(const std::string& key) const;
+
+	/// Records by the protocol keys of their sources
+	using records_t = std::unordered_map<std::string, record>;
+	/// Watched trees by their roots
+	using trees_t = std::map<std::string, fs::watcher::tree_index>;
+
+private:
+	/// Guards the members
+	mutable std::mutex mutex_;
+	/// File the database was opened from, empty when closed
+	fs::path file_;
+	/// Roots of the watched trees
+	std::vector<fs::path> roots_;
+	/// Records of the compiled sources
+	records_t records_;
+};
+}
@@ -0,0 +1,421 @@
+#include "thumbnail_system.h"
+
+#include <bimg/bimg.h>
+#include <bimg/decode.h>
+#include <bx/allocator.h>
+
+#include <core/common/hash.hpp>
+#include <core/graphics/texture.h>
+#include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
+#include <core/string_utils/string_utils.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/rendering/streamed_texture.h>
+#include <runtime/system/events.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace editor
+{
+constexpr std::uint16_t thumbnail_system::thumbnail_size;
+constexpr std::size_t thumbnail_system::max_inflight_requests;
+constexpr std::uint64_t thumbnail_system::max_unused_frames;
+
+namespace
+{
+constexpr std::uint32_t thumbnail_magic = 0x424d4854; // THMB
+
+fs::path get_compiled_path(const std::string& key)
+{
+	auto cache_key = fs::replace(key, ":/data", ":/cache");
+	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
+	return absolute_key.string() + ".asset";
+}
+
+// FNV-1a
+std::uint64_t hash_contents(const fs::byte_array_t& contents)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for(const auto c : contents)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+fs::path get_thumbnail_path(const std::string& key, const fs::byte_array_t& compiled)
+{
+	// The contents of the compiled asset are part of the hash, so only a
+	// recompile that changes them produces a new cache entry.
+	std::size_t seed = 0;
+	utils::hash_combine(seed, key);
+	utils::hash_combine(seed, hash_contents(compiled));
+
+	const auto protocol_end = key.find(":/");
+	const auto protocol = key.substr(0, protocol_end);
+	const auto dir = fs::resolve_protocol(protocol + ":/cache/thumbnails");
+	return dir / (std::to_string(seed) + ".thumb");
+}
+
+bool read_cached_thumbnail(const fs::path& path, thumbnail_system::thumbnail_data& data)
+{
+	std::ifstream stream{path.string(), std::ios::in | std::ios::binary};
+	if(!stream.good())
+	{
+		return false;
+	}
+
+	std::uint32_t magic = 0;
+	stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	stream.read(reinterpret_cast<char*>(&data.width), sizeof(data.width));
+	stream.read(reinterpret_cast<char*>(&data.height), sizeof(data.height));
+	if(!stream.good() || magic != thumbnail_magic || data.width == 0 || data.height == 0)
+	{
+		return false;
+	}
+
+	data.pixels.resize(std::size_t(data.width) * data.height * 4);
+	stream.read(reinterpret_cast<char*>(data.pixels.data()), std::streamsize(data.pixels.size()));
+	return stream.gcount() == std::streamsize(data.pixels.size());
+}
+
+void write_cached_thumbnail(const fs::path& path, const thumbnail_system::thumbnail_data& data)
+{
+	fs::error_code err;
+	fs::create_directories(path.parent_path(), err);
+
+	// write to a temporary first so a concurrent reader never sees half a file.
+	const auto temp = fs::path(path.string() + ".tmp");
+	{
+		std::ofstream stream{temp.string(), std::ios::out | std::ios::binary | std::ios::trunc};
+		stream.write(reinterpret_cast<const char*>(&thumbnail_magic), sizeof(thumbnail_magic));
+		stream.write(reinterpret_cast<const char*>(&data.width), sizeof(data.width));
+		stream.write(reinterpret_cast<const char*>(&data.height), sizeof(data.height));
+		stream.write(reinterpret_cast<const char*>(data.pixels.data()), std::streamsize(data.pixels.size()));
+	}
+	fs::rename(temp, path, err);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : downscale_bgra8 ()
+/// <summary>
+/// Box filters a BGRA8 image so that it fits in size x size keeping the
+/// aspect ratio.
+/// </summary>
+//-----------------------------------------------------------------------------
+void downscale_bgra8(const std::uint8_t* src, std::uint32_t src_width, std::uint32_t src_height,
+					 std::uint32_t size, thumbnail_system::thumbnail_data& data)
+{
+	const float scale = std::min(1.0f, float(size) / float(std::max(src_width, src_height)));
+	const auto dst_width = std::max<std::uint32_t>(1, std::uint32_t(float(src_width) * scale));
+	const auto dst_height = std::max<std::uint32_t>(1, std::uint32_t(float(src_height) * scale));
+
+	data.width = std::uint16_t(dst_width);
+	data.height = std::uint16_t(dst_height);
+	data.pixels.resize(std::size_t(dst_width) * dst_height * 4);
+
+	for(std::uint32_t y = 0; y < dst_height; ++y)
+	{
+		const auto y0 = (y * src_height) / dst_height;
+		const auto y1 = std::max(y0 + 1, ((y + 1) * src_height) / dst_height);
+		for(std::uint32_t x = 0; x < dst_width; ++x)
+		{
+			const auto x0 = (x * src_width) / dst_width;
+			const auto x1 = std::max(x0 + 1, ((x + 1) * src_width) / dst_width);
+
+			std::uint32_t sum[4] = {0, 0, 0, 0};
+			for(auto sy = y0; sy < y1; ++sy)
+			{
+				const auto* row = src + (std::size_t(sy) * src_width + x0) * 4;
+				for(auto sx = x0; sx < x1; ++sx, row += 4)
+				{
+					sum[0] += row[0];
+					sum[1] += row[1];
+					sum[2] += row[2];
+					sum[3] += row[3];
+				}
+			}
+
+			const auto count = (y1 - y0) * (x1 - x0);
+			auto* dst = &data.pixels[(std::size_t(y) * dst_width + x) * 4];
+			dst[0] = std::uint8_t(sum[0] / count);
+			dst[1] = std::uint8_t(sum[1] / count);
+			dst[2] = std::uint8_t(sum[2] / count);
+			dst[3] = std::uint8_t(sum[3] / count);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : generate_from_streamed ()
+/// <summary>
+/// Makes the thumbnail of a streamed texture from the smallest mip that is
+/// still at least as big as it. Returns false when the file is not a
+/// streamed BGRA8 texture.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool generate_from_streamed(const fs::byte_array_t& memory, thumbnail_system::thumbnail_data& data)
+{
+	namespace streamed_texture = runtime::streamed_texture;
+
+	streamed_texture::header info;
+	if(!streamed_texture::read_header(memory.data(), memory.size(), info) || info.texel_size != 4 ||
+	   info.format != std::uint32_t(gfx::texture_format::BGRA8))
+	{
+		return false;
+	}
+
+	std::uint32_t lod = 0;
+	for(std::uint32_t i = 1; i < info.mips; ++i)
+	{
+		const auto width = std::max<std::uint32_t>(1, std::uint32_t(info.width) >> i);
+		const auto height = std::max<std::uint32_t>(1, std::uint32_t(info.height) >> i);
+		if(std::max(width, height) < thumbnail_system::thumbnail_size)
+		{
+			break;
+		}
+		lod = i;
+	}
+
+	if(memory.size() < streamed_texture::get_read_size(info, lod))
+	{
+		return false;
+	}
+
+	// Unpacked the largest mip comes first.
+	fs::byte_array_t mips(streamed_texture::get_resident_size(info, lod));
+	streamed_texture::unpack(info, lod, memory.data(), mips.data());
+	downscale_bgra8(mips.data(), std::max<std::uint32_t>(1, std::uint32_t(info.width) >> lod),
+					std::max<std::uint32_t>(1, std::uint32_t(info.height) >> lod),
+					thumbnail_system::thumbnail_size, data);
+	return true;
+}
+
+bool generate_from_compiled(const fs::byte_array_t& memory, thumbnail_system::thumbnail_data& data)
+{
+	if(memory.empty())
+	{
+		return false;
+	}
+
+	if(generate_from_streamed(memory, data))
+	{
+		return true;
+	}
+
+	// Anything else is a ktx or dds bimg can parse.
+	bx::DefaultAllocator allocator;
+	bimg::ImageContainer* image =
+		bimg::imageParse(&allocator, memory.data(), static_cast<std::uint32_t>(memory.size()));
+	if(image == nullptr)
+	{
+		return false;
+	}
+
+	// Pick the smallest mip that is still at least as big as the thumbnail.
+	// Compiled textures have a full mip chain so this is usually a tiny copy.
+	std::uint8_t lod = 0;
+	for(std::uint8_t i = 1; i < image->m_numMips; ++i)
+	{
+		const auto width = std::max<std::uint32_t>(1, image->m_width >> i);
+		const auto height = std::max<std::uint32_t>(1, image->m_height >> i);
+		if(std::max(width, height) < thumbnail_system::thumbnail_size)
+		{
+			break;
+		}
+		lod = i;
+	}
+
+	bool result = false;
+	bimg::ImageMip mip;
+	if(bimg::imageGetRawData(*image, 0, lod, image->m_data, image->m_size, mip))
+	{
+		fs::byte_array_t converted(std::size_t(mip.m_width) * mip.m_height * 4);
+		if(bimg::imageConvert(&allocator, converted.data(), bimg::TextureFormat::BGRA8, mip.m_data,
+							  mip.m_format, mip.m_width, mip.m_height, 1))
+		{
+			downscale_bgra8(converted.data(), mip.m_width, mip.m_height, thumbnail_system::thumbnail_size,
+							data);
+			result = true;
+		}
+	}
+
+	bimg::imageFree(image);
+	return result;
+}
+
+std::shared_ptr<thumbnail_system::thumbnail_data> generate_thumbnail(const std::string& key)
+{
+	const auto compiled_path = get_compiled_path(key);
+
+	fs::error_code err;
+	if(!fs::exists(compiled_path, err))
+	{
+		return nullptr;
+	}
+
+	std::ifstream stream{compiled_path.string(), std::ios::in | std::ios::binary};
+	const auto compiled = fs::read_stream(stream);
+
+	auto data = std::make_shared<thumbnail_system::thumbnail_data>();
+	const auto thumbnail_path = get_thumbnail_path(key, compiled);
+	if(read_cached_thumbnail(thumbnail_path, *data))
+	{
+		return data;
+	}
+
+	if(!generate_from_compiled(compiled, *data))
+	{
+		APPLOG_WARNING("Failed to generate thumbnail for {0}", key);
+		return nullptr;
+	}
+
+	write_cached_thumbnail(thumbnail_path, *data);
+	return data;
+}
+}
+
+thumbnail_system::thumbnail_system()
+{
+	runtime::on_frame_end.connect(this, &thumbnail_system::frame_end);
+}
+
+thumbnail_system::~thumbnail_system()
+{
+	runtime::on_frame_end.disconnect(this, &thumbnail_system::frame_end);
+}
+
+asset_handle<gfx::texture> thumbnail_system::get_thumbnail(const std::string& key)
+{
+	auto& e = entries_[key];
+	e.last_used_frame = frame_;
+
+	if(!e.thumbnail && !e.failed && !e.queued && !e.request.valid())
+	{
+		e.queued = true;
+		queued_.push_back(key);
+	}
+
+	return e.thumbnail;
+}
+
+void thumbnail_system::invalidate(const std::string& key)
+{
+	auto it = entries_.find(key);
+	if(it == entries_.end())
+	{
+		return;
+	}
+
+	auto& e = it->second;
+	// an inflight request will be picked up and discarded by frame_end
+	if(e.request.valid())
+	{
+		e.thumbnail = {};
+		e.invalidated = true;
+		return;
+	}
+	entries_.erase(it);
+}
+
+void thumbnail_system::clear()
+{
+	queued_.clear();
+	for(auto it = entries_.begin(); it != entries_.end();)
+	{
+		if(it->second.request.valid())
+		{
+			it->second.thumbnail = {};
+			it->second.queued = false;
+			it->second.invalidated = true;
+			++it;
+		}
+		else
+		{
+			it = entries_.erase(it);
+		}
+	}
+}
+
+void thumbnail_system::frame_end(delta_t)
+{
+	PROFILE_SCOPE("thumbnail_system::frame_end");
+
+	++frame_;
+
+	// upload finished previews
+	for(auto& pair : entries_)
+	{
+		auto& e = pair.second;
+		if(!e.request.valid() || !e.request.is_ready())
+		{
+			continue;
+		}
+
+		auto data = e.request.get();
+		e.request = {};
+		--inflight_;
+
+		if(e.invalidated)
+		{
+			e.invalidated = false;
+			continue;
+		}
+
+		if(!data || data->pixels.empty())
+		{
+			e.failed = true;
+			continue;
+		}
+
+		const auto* mem = gfx::copy(data->pixels.data(), static_cast<std::uint32_t>(data->pixels.size()));
+		auto tex = std::make_shared<gfx::texture>(data->width, data->height, false, 1,
+												  gfx::texture_format::BGRA8, BGFX_SAMPLER_U_CLAMP |
+																				  BGFX_SAMPLER_V_CLAMP,
+												  mem);
+		e.thumbnail.link->id = pair.first;
+		e.thumbnail.link->asset = tex;
+	}
+
+	// dispatch queued requests, most recent first since those are
+	// what the user is looking at right now.
+	auto& ts = core::get_subsystem<core::task_system>();
+	while(inflight_ < max_inflight_requests && !queued_.empty())
+	{
+		const auto key = queued_.back();
+		queued_.pop_back();
+
+		auto it = entries_.find(key);
+		if(it == entries_.end() || !it->second.queued)
+		{
+			continue;
+		}
+
+		auto& e = it->second;
+		e.queued = false;
+		e.request = ts.push_on_worker_thread([](const std::string& key) { return generate_thumbnail(key); }, key);
+		++inflight_;
+	}
+
+	// release what is not on screen anymore
+	for(auto it = entries_.begin(); it != entries_.end();)
+	{
+		const auto& e = it->second;
+		if(!e.request.valid() && e.last_used_frame + max_unused_frames < frame_)
+		{
+			it = entries_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	queued_.erase(std::remove_if(std::begin(queued_), std::end(queued_),
+								 [this](const auto& key) { return entries_.find(key) == entries_.end(); }),
+				  std::end(queued_));
+}
+}
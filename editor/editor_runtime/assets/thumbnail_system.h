@@ -0,0 +1,106 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+#include <core/filesystem/filesystem.h>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_handle.h>
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace gfx
+{
+struct texture;
+}
+
+namespace editor
+{
+class thumbnail_system
+{
+public:
+	/// Max width/height in pixels of a generated thumbnail.
+	constexpr static std::uint16_t thumbnail_size = 128;
+
+	/// Max number of thumbnails that can be generated simultaneously.
+	constexpr static std::size_t max_inflight_requests = 2;
+
+	/// Thumbnails not drawn for this many frames are released.
+	constexpr static std::uint64_t max_unused_frames = 300;
+
+	struct thumbnail_data
+	{
+		std::uint16_t width = 0;
+		std::uint16_t height = 0;
+		/// BGRA8 pixels
+		fs::byte_array_t pixels;
+	};
+
+	thumbnail_system();
+	~thumbnail_system();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_thumbnail ()
+	/// <summary>
+	/// Returns a small preview texture for the texture asset with the specified
+	/// key. If the preview is not generated yet a request is queued and an empty
+	/// handle is returned. Call this every frame the preview is visible.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	asset_handle<gfx::texture> get_thumbnail(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Drops the in-memory preview for the key so that it is regenerated the next
+	/// time it is requested. The on-disk cache is keyed by the compiled asset's
+	/// contents so it does not need to be touched.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void invalidate(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Releases all in-memory previews and pending requests.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_end ()
+	/// <summary>
+	/// Dispatches queued requests, uploads finished previews and releases the ones
+	/// that were not used recently.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_end(delta_t dt);
+
+private:
+	struct entry
+	{
+		/// worker thread job producing the pixels
+		core::task_future<std::shared_ptr<thumbnail_data>> request;
+		/// uploaded preview
+		asset_handle<gfx::texture> thumbnail;
+		/// last frame this entry was requested
+		std::uint64_t last_used_frame = 0;
+		/// waiting for a free request slot
+		bool queued = false;
+		/// generation was attempted and failed
+		bool failed = false;
+		/// the inflight request result should be discarded
+		bool invalidated = false;
+	};
+
+	/// entries keyed by asset key
+	std::unordered_map<std::string, entry> entries_;
+	/// keys waiting for a free request slot
+	std::deque<std::string> queued_;
+	/// number of requests currently on the worker threads
+	std::size_t inflight_ = 0;
+	/// current frame
+	std::uint64_t frame_ = 0;
+};
+}
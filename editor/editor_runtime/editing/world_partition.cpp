@@ -0,0 +1,128 @@
+#include "world_partition.h"
+
+#include <core/logging/logging.h>
+
+#include <runtime/ecs/components/audio_source_component.h>
+#include <runtime/ecs/components/model_component.h>
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/constructs/world_layout.h>
+#include <runtime/rendering/model.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace editor
+{
+namespace
+{
+struct cell_content
+{
+	/// Roots of the cell.
+	std::vector<runtime::entity> roots;
+	/// The cell as it goes into the layout.
+	world_cell cell;
+};
+
+template <typename T>
+void add_dependency(const asset_handle<T>& handle, std::vector<std::string>& out)
+{
+	if(handle && !handle.id().empty())
+	{
+		out.push_back(handle.id());
+	}
+}
+
+void gather_dependencies(const runtime::entity& e, world_cell& cell)
+{
+	if(auto model_comp = e.get_component<model_component>().lock())
+	{
+		const auto& model = model_comp->get_model();
+		for(const auto& lod : model.get_lods())
+		{
+			add_dependency(lod, cell.meshes);
+		}
+		for(const auto& mat : model.get_materials())
+		{
+			add_dependency(mat, cell.materials);
+		}
+	}
+
+	if(auto source_comp = e.get_component<audio_source_component>().lock())
+	{
+		add_dependency(source_comp->get_sound(), cell.sounds);
+	}
+}
+
+void make_unique(std::vector<std::string>& keys)
+{
+	std::sort(std::begin(keys), std::end(keys));
+	keys.erase(std::unique(std::begin(keys), std::end(keys)), std::end(keys));
+}
+}
+
+bool build_world_partition(const fs::path& scene_path, const std::vector<runtime::entity>& roots,
+						   float cell_size)
+{
+	world_layout layout;
+	layout.cell_size = cell_size;
+
+	std::map<std::pair<std::int32_t, std::int32_t>, cell_content> cells;
+	for(const auto& root : roots)
+	{
+		auto transform_comp = root.get_component<transform_component>().lock();
+		if(!transform_comp)
+		{
+			continue;
+		}
+
+		const auto coordinates = layout.get_cell_coordinates(transform_comp->get_position());
+		auto& content = cells[coordinates];
+		content.roots.push_back(root);
+
+		std::vector<runtime::entity> hierarchy;
+		ecs::utils::collect_hierarchy(root, hierarchy);
+		for(const auto& e : hierarchy)
+		{
+			gather_dependencies(e, content.cell);
+		}
+	}
+
+	const auto dir = scene_path.parent_path();
+	const auto cells_dir = dir / (scene_path.stem().string() + ".cells");
+	fs::error_code err;
+	fs::create_directories(cells_dir, err);
+	if(err)
+	{
+		APPLOG_ERROR("Failed to create {0} : {1}", cells_dir.string(), err.message());
+		return false;
+	}
+
+	for(auto& pair : cells)
+	{
+		const auto& coordinates = pair.first;
+		auto& content = pair.second;
+		const auto name =
+			"cell_" + std::to_string(coordinates.first) + "_" + std::to_string(coordinates.second) + ".sgr";
+		const auto cell_path = cells_dir / name;
+		ecs::utils::save_entities_to_file(cell_path, content.roots);
+
+		auto& cell = content.cell;
+		cell.x = coordinates.first;
+		cell.z = coordinates.second;
+		cell.scene = fs::convert_to_protocol(cell_path).generic_string();
+		make_unique(cell.meshes);
+		make_unique(cell.materials);
+		make_unique(cell.sounds);
+		layout.cells.emplace_back(std::move(cell));
+	}
+
+	const auto layout_path = dir / (scene_path.stem().string() + ".world");
+	ecs::utils::save_world_layout_to_file(layout_path, layout);
+
+	APPLOG_INFO("Built world partition {0} with {1} cells.", layout_path.string(), layout.cells.size());
+	return true;
+}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <core/filesystem/filesystem.h>
+
+#include <runtime/ecs/ecs.h>
+
+#include <vector>
+
+namespace editor
+{
+//-----------------------------------------------------------------------------
+//  Name : build_world_partition ()
+/// <summary>
+/// Splits the entities of a scene into cells of a grid by the position of
+/// their roots. Every cell is saved as a scene of its own next to the source
+/// scene, in a folder named after it, together with a world layout listing
+/// the cells and the assets each of them uses.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool build_world_partition(const fs::path& scene_path, const std::vector<runtime::entity>& roots,
+						   float cell_size);
+}
@@ -5,6 +5,7 @@
 
 #include <core/filesystem/filesystem.h>
 #include <core/logging/logging.h>
+#include <core/string_utils/string_utils.h>
 #include <core/system/subsystem.h>
 
 #include <runtime/assets/asset_handle.h>
@@ -20,6 +21,9 @@
 #include <runtime/ecs/systems/scene_graph.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/mesh.h>
+
+#include <algorithm>
+#include <cctype>
 namespace
 {
 math::bbox calc_bounds(runtime::entity entity)
@@ -417,7 +421,25 @@ static void check_drag(runtime::entity entity)
 	}
 }
 
-void hierarchy_dock::draw_entity(runtime::entity entity)
+static bool name_matches(runtime::entity entity, const std::string& lower_filter)
+{
+	const auto matches = [&lower_filter](const std::string& name) {
+		auto it = std::search(std::begin(name), std::end(name), std::begin(lower_filter),
+							  std::end(lower_filter), [](char lhs, char rhs) {
+								  return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+							  });
+		return it != std::end(name);
+	};
+
+	const auto& name = entity.get_name();
+	if(!name.empty())
+	{
+		return matches(name);
+	}
+	return matches(entity.to_string());
+}
+
+void hierarchy_dock::draw_entity(runtime::entity entity, int depth, bool has_children)
 {
 	if(!entity)
 	{
@@ -438,7 +460,8 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 	}
 
 	std::string name = entity.to_string();
-	ImGuiTreeNodeFlags flags = 0 | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_OpenOnArrow;
+	ImGuiTreeNodeFlags flags = 0 | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_OpenOnArrow |
+							   ImGuiTreeNodeFlags_NoTreePushOnOpen;
 
 	if(is_selected)
 	{
@@ -456,22 +479,38 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 			}
 		}
 	}
-	auto trans_comp = entity.get_component<transform_component>().lock();
-	bool no_children = true;
-	if(trans_comp)
+
+	if(!has_children)
 	{
-		no_children = trans_comp->get_children().empty();
+		flags |= ImGuiTreeNodeFlags_Leaf;
 	}
 
-	if(no_children)
+	// rows are flat so the nesting is only visual
+	const float indent = float(depth) * gui::GetStyle().IndentSpacing;
+	if(depth > 0)
 	{
-		flags |= ImGuiTreeNodeFlags_Leaf;
+		gui::Indent(indent);
 	}
 
 	auto pos = gui::GetCursorScreenPos();
 	gui::AlignTextToFramePadding();
 
+	const bool was_opened = has_children && expanded_.count(entity) != 0;
+	gui::SetNextTreeNodeOpen(was_opened, ImGuiCond_Always);
 	bool opened = gui::TreeNodeEx(name.c_str(), flags);
+	if(has_children && opened != was_opened)
+	{
+		if(opened)
+		{
+			expanded_.insert(entity);
+		}
+		else
+		{
+			expanded_.erase(entity);
+		}
+		rows_dirty_ = true;
+	}
+
 	if(!edit_label_)
 	{
 		check_drag(entity);
@@ -509,12 +548,13 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 
 	if(gui::IsItemHovered() && !gui::IsMouseDragging(0))
 	{
+		const auto item_id = window->GetID(static_cast<int>(entity.id().index()));
 		if(gui::IsMouseClicked(0))
 		{
-			id_ = window->GetID(trans_comp.get());
+			id_ = item_id;
 		}
 
-		if(gui::IsMouseReleased(0) && window->GetID(trans_comp.get()) == id_)
+		if(gui::IsMouseReleased(0) && item_id == id_)
 		{
 			if(!is_selected)
 			{
@@ -539,37 +579,152 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 		}
 	}
 
-	if(opened)
+	if(depth > 0)
+	{
+		gui::Unindent(indent);
+	}
+
+	gui::PopID();
+	gui::PopID();
+}
+
+void hierarchy_dock::flatten(runtime::entity entity, int depth)
+{
+	auto trans_comp = entity.get_component<transform_component>().lock();
+	const bool has_children = trans_comp && !trans_comp->get_children().empty();
+
+	row r;
+	r.entity = entity;
+	r.depth = depth;
+	r.has_children = has_children;
+	rows_.emplace_back(r);
+
+	if(has_children && expanded_.count(entity) != 0)
 	{
-		if(!no_children)
+		for(const auto& child : trans_comp->get_children())
 		{
-			const auto& children = trans_comp->get_children();
-			for(auto& child : children)
+			if(child.valid())
 			{
-				if(child.valid())
-				{
-					draw_entity(child);
-				}
+				flatten(child, depth + 1);
 			}
 		}
+	}
+}
 
-		gui::TreePop();
+void hierarchy_dock::filter_all(runtime::entity entity)
+{
+	if(name_matches(entity, filter_))
+	{
+		row r;
+		r.entity = entity;
+		rows_.emplace_back(r);
 	}
 
-	gui::PopID();
-	gui::PopID();
+	auto trans_comp = entity.get_component<transform_component>().lock();
+	if(trans_comp)
+	{
+		for(const auto& child : trans_comp->get_children())
+		{
+			if(child.valid())
+			{
+				filter_all(child);
+			}
+		}
+	}
 }
 
-void hierarchy_dock::render(const ImVec2& /*unused*/)
+void hierarchy_dock::update_rows()
 {
 	auto& es = core::get_subsystem<editor::editing_system>();
 	auto& sg = core::get_subsystem<runtime::scene_graph>();
+
+	const auto filter = string_utils::to_lower(filter_input_.data());
+	const bool hierarchy_changed = sg.get_version() != rows_version_;
+	const bool filter_changed = filter != filter_;
+	if(!hierarchy_changed && !filter_changed && !rows_dirty_)
+	{
+		return;
+	}
+
+	// a filter that only got longer can only match a subset of what matched
+	// before, so narrow the current rows instead of walking the whole scene.
+	const bool narrowing = !hierarchy_changed && !rows_dirty_ && !filter_.empty() &&
+						   filter.find(filter_) != std::string::npos;
+
+	rows_version_ = sg.get_version();
+	rows_dirty_ = false;
+	filter_ = filter;
+
+	if(narrowing)
+	{
+		rows_.erase(std::remove_if(std::begin(rows_), std::end(rows_),
+								   [this](const row& r) {
+									   return !r.entity.valid() || !name_matches(r.entity, filter_);
+								   }),
+					std::end(rows_));
+		return;
+	}
+
+	auto& editor_camera = es.camera;
+	const auto& roots = sg.get_roots();
+
+	rows_.clear();
+	for(auto it = std::begin(expanded_); it != std::end(expanded_);)
+	{
+		if(it->valid())
+		{
+			++it;
+		}
+		else
+		{
+			it = expanded_.erase(it);
+		}
+	}
+
+	if(filter_.empty())
+	{
+		if(editor_camera.valid())
+		{
+			row r;
+			r.entity = editor_camera;
+			r.separator = true;
+			rows_.emplace_back(r);
+		}
+
+		for(auto& root : roots)
+		{
+			if(root.valid() && root != editor_camera)
+			{
+				flatten(root, 0);
+			}
+		}
+	}
+	else
+	{
+		for(auto& root : roots)
+		{
+			if(root.valid() && root != editor_camera)
+			{
+				filter_all(root);
+			}
+		}
+	}
+}
+
+void hierarchy_dock::render(const ImVec2& /*unused*/)
+{
+	auto& es = core::get_subsystem<editor::editing_system>();
 	auto& input = core::get_subsystem<runtime::input>();
 
-	auto& roots = sg.get_roots();
 	auto& editor_camera = es.camera;
 	auto& selected = es.selection_data.object;
 
+	gui::PushItemWidth(gui::GetContentRegionAvailWidth());
+	gui::InputText("##hierarchy_filter", filter_input_.data(), filter_input_.size());
+	gui::PopItemWidth();
+
+	update_rows();
+
 	ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
 							 ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoSavedSettings;
 
@@ -629,19 +784,27 @@ void hierarchy_dock::render(const ImVec2& /*unused*/)
 			}
 		}
 
-		if(editor_camera.valid())
+		// only the rows inside the scroll window are submitted
+		ImGuiListClipper clipper(int(rows_.size()));
+		while(clipper.Step())
 		{
-			draw_entity(editor_camera);
-			gui::Separator();
-		}
-
-		for(auto& root : roots)
-		{
-			if(root.valid())
+			for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
 			{
-				if(root != editor_camera)
+				// copy, drawing may modify the hierarchy
+				const auto r = rows_[std::size_t(i)];
+				if(r.entity.valid())
+				{
+					draw_entity(r.entity, r.depth, r.has_children);
+				}
+				else
+				{
+					gui::AlignTextToFramePadding();
+					gui::TextUnformatted("");
+				}
+
+				if(r.separator)
 				{
-					draw_entity(root);
+					gui::Separator();
 				}
 			}
 		}
@@ -4,15 +4,57 @@
 
 #include <runtime/ecs/ecs.h>
 
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 struct hierarchy_dock : public imguidock::dock
 {
 	hierarchy_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
 
 	void render(const ImVec2& area);
 
-	void draw_entity(runtime::entity entity);
+	void draw_entity(runtime::entity entity, int depth, bool has_children);
 
 private:
+	struct row
+	{
+		/// entity drawn on this row
+		runtime::entity entity;
+		/// nesting level used for indentation
+		int depth = 0;
+		/// can be expanded
+		bool has_children = false;
+		/// draw a separator after this row
+		bool separator = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_rows ()
+	/// <summary>
+	/// Rebuilds the flattened row list if the scene graph version, the expanded
+	/// state or the filter changed since the last rebuild.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_rows();
+	void flatten(runtime::entity entity, int depth);
+	void filter_all(runtime::entity entity);
+
 	bool edit_label_ = false;
 	ImGuiID id_ = 0;
+
+	/// flattened visible rows
+	std::vector<row> rows_;
+	/// entities whose children are visible
+	std::unordered_set<runtime::entity> expanded_;
+	/// scene graph version the rows were built for
+	std::uint64_t rows_version_ = ~std::uint64_t(0);
+	/// the rows need to be rebuilt regardless of the version
+	bool rows_dirty_ = true;
+	/// filter input buffer
+	std::array<char, 64> filter_input_{};
+	/// lower case filter the rows were built for
+	std::string filter_;
 };
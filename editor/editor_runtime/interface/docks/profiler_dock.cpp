@@ -0,0 +1,204 @@
+#include "profiler_dock.h"
+
+#include <core/logging/logging.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+namespace
+{
+ImU32 get_zone_color(const char* name)
+{
+	// zone names are literals or interned, so the pointer identifies the zone
+	const auto hash = std::hash<const void*>()(name) >> 4;
+	const float hue = float(hash % 360) / 360.0f;
+	return ImColor::HSV(hue, 0.5f, 0.7f);
+}
+
+float to_ms(std::uint64_t ns)
+{
+	return float(double(ns) / 1000000.0);
+}
+}
+
+profiler_dock::profiler_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
+{
+	initialize(dtitle, close_button, min_size, std::bind(&profiler_dock::render, this, std::placeholders::_1));
+}
+
+void profiler_dock::render(const ImVec2& /*unused*/)
+{
+	draw_toolbar();
+
+	auto& collector = profiler::collector::get();
+	const auto& frames = collector.get_frames();
+	if(frames.empty())
+	{
+		gui::TextUnformatted("No frames recorded.");
+		return;
+	}
+
+	if(!collector.is_paused())
+	{
+		selected_frame_ = 0;
+	}
+	selected_frame_ = std::min(selected_frame_, frames.size() - 1);
+
+	draw_frames(frames);
+
+	const auto& f = frames[frames.size() - 1 - selected_frame_];
+	gui::Text("FRAME %.3f ms", double(to_ms(f.end - f.begin)));
+	gui::Separator();
+
+	draw_flame(f);
+}
+
+void profiler_dock::draw_toolbar()
+{
+	auto& collector = profiler::collector::get();
+
+	bool paused = collector.is_paused();
+	if(gui::Checkbox("PAUSE", &paused))
+	{
+		collector.set_paused(paused);
+	}
+
+	gui::SameLine();
+	if(collector.is_capturing())
+	{
+		if(gui::Button("STOP CAPTURE"))
+		{
+			collector.stop_capture();
+		}
+	}
+	else if(gui::Button("START CAPTURE"))
+	{
+		collector.start_capture();
+	}
+
+	gui::SameLine();
+	if(gui::Button("SAVE TRACE"))
+	{
+		std::ofstream stream{trace_path_, std::ios::out | std::ios::trunc};
+		if(collector.write_chrome_trace(stream))
+		{
+			APPLOG_INFO("Profiler trace written to {0}", trace_path_);
+		}
+		else
+		{
+			APPLOG_ERROR("Could not write profiler trace to {0}", trace_path_);
+		}
+	}
+
+	const auto dropped = collector.get_dropped_zones();
+	if(dropped > 0)
+	{
+		gui::SameLine();
+		gui::Text("DROPPED ZONES: %llu", static_cast<unsigned long long>(dropped));
+	}
+}
+
+void profiler_dock::draw_frames(const std::deque<profiler::frame>& frames)
+{
+	std::vector<float> durations;
+	durations.reserve(profiler::collector::max_history_frames);
+	float max_duration = 0.0f;
+	for(const auto& f : frames)
+	{
+		durations.emplace_back(to_ms(f.end - f.begin));
+		max_duration = std::max(max_duration, durations.back());
+	}
+	// keep the bars aligned to the right while the history fills up
+	durations.insert(std::begin(durations), profiler::collector::max_history_frames - frames.size(), 0.0f);
+
+	const ImVec2 size(gui::GetContentRegionAvailWidth(), 60.0f);
+	gui::PlotHistogram("##frames", durations.data(), int(durations.size()), 0, nullptr, 0.0f,
+					   max_duration * 1.1f, size);
+
+	if(gui::IsItemHovered() && gui::IsMouseClicked(0))
+	{
+		const float x = gui::GetMousePos().x - gui::GetItemRectMin().x;
+		const auto bar = std::size_t(x / size.x * float(durations.size()));
+		const auto from_end = durations.size() - 1 - std::min(bar, durations.size() - 1);
+		if(from_end < frames.size())
+		{
+			selected_frame_ = from_end;
+			profiler::collector::get().set_paused(true);
+		}
+	}
+}
+
+void profiler_dock::draw_flame(const profiler::frame& f)
+{
+	zones_ = f.zones;
+	std::sort(std::begin(zones_), std::end(zones_), [](const auto& lhs, const auto& rhs) {
+		if(lhs.thread != rhs.thread)
+		{
+			return lhs.thread < rhs.thread;
+		}
+		return lhs.depth < rhs.depth;
+	});
+
+	const auto threads = profiler::collector::get().get_threads();
+
+	gui::BeginChild("##flame", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+	auto* draw_list = gui::GetWindowDrawList();
+	const float width = gui::GetContentRegionAvailWidth();
+	const float row_height = gui::GetTextLineHeightWithSpacing();
+	const auto frame_duration = double(std::max<std::uint64_t>(1, f.end - f.begin));
+
+	auto it = std::begin(zones_);
+	while(it != std::end(zones_))
+	{
+		const auto thread = it->thread;
+		auto end = std::find_if(it, std::end(zones_), [thread](const auto& z) { return z.thread != thread; });
+
+		const auto name_it = std::find_if(std::begin(threads), std::end(threads),
+										  [thread](const auto& info) { return info.index == thread; });
+		gui::TextUnformatted(name_it != std::end(threads) ? name_it->name.c_str() : "thread");
+
+		std::uint32_t max_depth = 0;
+		for(auto z = it; z != end; ++z)
+		{
+			max_depth = std::max(max_depth, z->depth);
+		}
+
+		const ImVec2 origin = gui::GetCursorScreenPos();
+		for(auto z = it; z != end; ++z)
+		{
+			// zones of other threads may have started before the frame
+			const auto begin = std::max(z->begin, f.begin);
+			const auto finish = std::max(z->end, begin);
+			const float x0 = float(double(begin - f.begin) / frame_duration) * width;
+			const float x1 = std::max(x0 + 1.0f, float(double(finish - f.begin) / frame_duration) * width);
+			const float y0 = float(z->depth) * row_height;
+
+			const ImVec2 min(origin.x + x0, origin.y + y0);
+			const ImVec2 max(origin.x + x1, origin.y + y0 + row_height - 1.0f);
+			draw_list->AddRectFilled(min, max, get_zone_color(z->name));
+
+			if(x1 - x0 > gui::CalcTextSize(z->name).x + 4.0f)
+			{
+				draw_list->PushClipRect(min, max, true);
+				draw_list->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, z->name);
+				draw_list->PopClipRect();
+			}
+
+			if(gui::IsWindowHovered() && gui::IsMouseHoveringRect(min, max))
+			{
+				gui::BeginTooltip();
+				gui::Text("%s", z->name);
+				gui::Text("%.3f ms", double(to_ms(z->end - z->begin)));
+				gui::EndTooltip();
+			}
+		}
+
+		gui::Dummy(ImVec2(width, float(max_depth + 1) * row_height));
+		gui::Separator();
+		it = end;
+	}
+
+	gui::EndChild();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "imguidock.h"
+
+#include <core/profiler/profiler.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+struct profiler_dock : public imguidock::dock
+{
+	profiler_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
+
+	void render(const ImVec2& area);
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : draw_toolbar ()
+	/// <summary>
+	/// Pause, capture and trace export controls.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_toolbar();
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_frames ()
+	/// <summary>
+	/// Draws the frame time history. Clicking a frame pauses and selects it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_frames(const std::deque<profiler::frame>& frames);
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_flame ()
+	/// <summary>
+	/// Draws the zones of the frame as one flame graph lane per thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_flame(const profiler::frame& f);
+
+	/// selected frame counted from the most recent one
+	std::size_t selected_frame_ = 0;
+	/// zones of the drawn frame sorted by thread and depth
+	std::vector<profiler::zone> zones_;
+	/// where the last capture was saved
+	std::string trace_path_ = "profiler_trace.json";
+};
@@ -1,5 +1,6 @@
 #include "project_dock.h"
 #include "../../assets/asset_extensions.h"
+#include "../../assets/thumbnail_system.h"
 #include "../../editing/editing_system.h"
 
 #include <core/audio/sound.h>
@@ -425,9 +426,26 @@ void project_dock::render(const ImVec2& /*area*/)
 
 	auto& es = core::get_subsystem<editor::editing_system>();
 	auto& am = core::get_subsystem<runtime::asset_manager>();
+	auto& thumbnails = core::get_subsystem<editor::thumbnail_system>();
 	ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
 							 ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoSavedSettings;
 	fs::path current_path = cache_.get_path();
+
+	// A clicked texture is loaded without blocking and selected once ready.
+	if(pending_selection_.valid() && pending_selection_.is_ready())
+	{
+		es.select(pending_selection_.get());
+		pending_selection_ = {};
+		pending_key_.clear();
+	}
+
+	// Selecting anything else drops a pending texture.
+	const auto select = [&](const auto& entry) {
+		pending_selection_ = {};
+		pending_key_.clear();
+		es.select(entry);
+	};
+
 	if(gui::BeginChild("assets_content", gui::GetContentRegionAvail(), false, flags))
 	{
 		const auto is_selected = [&](const auto& entry) {
@@ -479,7 +497,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				const auto& icon = folder_preview;
 				is_popup_opened |= draw_entry(icon, false, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  [&]() // on_double_click
 											  {
 												  current_path = entry;
@@ -512,11 +530,18 @@ void project_dock::render(const ImVec2& /*area*/)
 				{
 					entry = entry_future.get();
 				}
-				const auto& icon = entry ? entry : loading_preview;
-				bool is_loading = !entry;
+				// Textures are drawn with small previews so that browsing a folder
+				// does not load full mip chains. The texture itself is loaded only
+				// when it gets selected.
+				const auto thumbnail = thumbnails.get_thumbnail(relative);
+				const bool is_loading = pending_key_ == relative;
+				const auto& icon = thumbnail && !is_loading ? thumbnail : loading_preview;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  {
+												  pending_selection_ = am.load<asset_t>(relative);
+												  pending_key_ = relative;
+											  },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 				return;
@@ -537,7 +562,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 
@@ -558,7 +583,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 				return;
@@ -578,7 +603,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 
@@ -599,7 +624,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 
@@ -620,7 +645,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 
@@ -641,7 +666,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  nullptr, // on_double_click
 											  on_rename, on_delete);
 
@@ -662,7 +687,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				bool is_loading = !entry;
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
-											  { es.select(entry); },
+											  { select(entry); },
 											  [&]() // on_double_click
 											  {
 												  if(!entry)
@@ -2,6 +2,16 @@
 #include "imguidock.h"
 
 #include <core/filesystem/filesystem_cache.hpp>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_handle.h>
+
+#include <string>
+
+namespace gfx
+{
+struct texture;
+}
 
 class project_dock : public imguidock::dock
 {
@@ -20,4 +30,8 @@ private:
 	fs::path cache_path_with_protocol_;
 	fs::path root_;
 	float scale_ = 0.75f;
+	/// Texture loading to be selected once it is ready
+	core::task_future<asset_handle<gfx::texture>> pending_selection_;
+	/// Key of the texture loading to be selected, empty when none
+	std::string pending_key_;
 };
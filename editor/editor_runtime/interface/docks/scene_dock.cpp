@@ -15,6 +15,7 @@
 #include <runtime/ecs/components/transform_component.h>
 #include <runtime/ecs/constructs/prefab.h>
 #include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/systems/deferred_rendering.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/camera.h>
 #include <runtime/rendering/mesh.h>
@@ -114,6 +115,13 @@ void scene_dock::show_statistics(const ImVec2& area, unsigned int fps, bool& sho
 				gui::Text("Texture mem: %s / %s", tmp3, tmp0);
 			}
 
+			const auto& dr = core::get_subsystem<runtime::deferred_rendering>();
+			char transient[64];
+			bx::prettify(transient, 64, dr.get_transient_memory());
+			char unaliased[64];
+			bx::prettify(unaliased, 64, dr.get_unaliased_memory());
+			gui::Text("Transient Target mem: %s (unaliased %s)", transient, unaliased);
+
 			gui::Separator();
 
 			const auto& gui_sys = core::get_subsystem<gui_system>();
@@ -695,6 +703,8 @@ void scene_dock::render(const ImVec2& area)
 						   editor_camera.has_component<transform_component>();
 
 	show_statistics(area, sim.get_fps(), show_gbuffer);
+	// the g-buffer is transient unless something wants to look at it
+	core::get_subsystem<runtime::deferred_rendering>().set_persistent_g_buffer(show_gbuffer);
 
 	if(!has_edit_camera)
 	{
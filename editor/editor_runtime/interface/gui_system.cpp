@@ -8,6 +8,7 @@
 #include <core/graphics/uniform.h>
 #include <core/graphics/vertex_buffer.h>
 #include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
 #include <core/serialization/associative_archive.h>
 #include <core/system/subsystem.h>
 
@@ -35,6 +36,7 @@ const gfx::embedded_shader s_embedded_shaders[] = {BGFX_EMBEDDED_SHADER(vs_ocorn
 std::unique_ptr<gpu_program> s_program;
 asset_handle<gfx::texture> s_font_texture;
 std::uint32_t s_draw_calls = 0;
+const gfx::uniform_id s_tex("s_tex");
 
 void render_func(ImDrawData* _draw_data)
 {
@@ -106,7 +108,7 @@ void render_func(ImDrawData* _draw_data)
 				const std::uint16_t width = std::uint16_t(std::min(cmd->ClipRect.z, 65535.0f) - x);
 				const std::uint16_t height = std::uint16_t(std::min(cmd->ClipRect.w, 65535.0f) - y);
 
-				program->set_texture(0, "s_tex", tex);
+				program->set_texture(0, s_tex, tex);
 
 				gfx::set_scissor(x, y, width, height);
 				gfx::set_state(state);
@@ -426,6 +428,8 @@ gui_system::~gui_system()
 
 void gui_system::frame_begin(delta_t /*unused*/)
 {
+	PROFILE_SCOPE("gui_system::frame_begin");
+
 	imgui_frame_begin();
 }
 
@@ -41,11 +41,8 @@ static bool process_drag_drop_target(asset_handle<asset_t>& entry)
 										  std::size_t(payload->DataSize));
 
 				std::string key = fs::convert_to_protocol(fs::path(absolute_path)).generic_string();
-				auto entry_future = am.template find_asset_entry<asset_t>(key);
-				if(entry_future.is_ready())
-				{
-					entry = entry_future.get();
-				}
+				// some asset types are loaded on demand so make sure it is.
+				entry = am.template load<asset_t>(key).get();
 
 				if(entry)
 				{
@@ -0,0 +1,127 @@
+#include "asset_database.hpp"
+
+#include <core/serialization/binary_archive.h>
+#include <core/serialization/types/string.hpp>
+#include <core/serialization/types/utility.hpp>
+#include <core/serialization/types/vector.hpp>
+
+#include <cstdint>
+
+namespace
+{
+std::int64_t to_count(const fs::file_time_type& time)
+{
+	return static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+fs::file_time_type from_count(std::int64_t count)
+{
+	return fs::file_time_type(fs::file_time_type::duration(count));
+}
+}
+
+namespace fs
+{
+SAVE(filesystem_watcher::entry)
+{
+	try_save(ar, cereal::make_nvp("path", obj.path.string()));
+	try_save(ar, cereal::make_nvp("last_mod_time", to_count(obj.last_mod_time)));
+	try_save(ar, cereal::make_nvp("size", static_cast<std::uint64_t>(obj.size)));
+	try_save(ar, cereal::make_nvp("type", static_cast<std::int32_t>(obj.type)));
+}
+SAVE_INSTANTIATE(filesystem_watcher::entry, cereal::oarchive_binary_t);
+
+LOAD(filesystem_watcher::entry)
+{
+	std::string path;
+	std::int64_t last_mod_time = 0;
+	std::uint64_t size = 0;
+	std::int32_t type = 0;
+	try_load(ar, cereal::make_nvp("path", path));
+	try_load(ar, cereal::make_nvp("last_mod_time", last_mod_time));
+	try_load(ar, cereal::make_nvp("size", size));
+	try_load(ar, cereal::make_nvp("type", type));
+
+	obj.path = path;
+	obj.last_path = obj.path;
+	obj.status = filesystem_watcher::entry_status::unmodified;
+	obj.last_mod_time = from_count(last_mod_time);
+	obj.size = static_cast<std::uintmax_t>(size);
+	obj.type = static_cast<fs::file_type>(type);
+}
+LOAD_INSTANTIATE(filesystem_watcher::entry, cereal::iarchive_binary_t);
+
+SAVE(filesystem_watcher::tree_index)
+{
+	std::vector<std::pair<std::string, std::int64_t>> directories;
+	directories.reserve(obj.directories.size());
+	for(const auto& dir : obj.directories)
+	{
+		directories.emplace_back(dir.first.string(), to_count(dir.second));
+	}
+
+	try_save(ar, cereal::make_nvp("entries", obj.entries));
+	try_save(ar, cereal::make_nvp("directories", directories));
+}
+SAVE_INSTANTIATE(filesystem_watcher::tree_index, cereal::oarchive_binary_t);
+
+LOAD(filesystem_watcher::tree_index)
+{
+	std::vector<std::pair<std::string, std::int64_t>> directories;
+	try_load(ar, cereal::make_nvp("entries", obj.entries));
+	try_load(ar, cereal::make_nvp("directories", directories));
+
+	obj.directories.clear();
+	obj.directories.reserve(directories.size());
+	for(const auto& dir : directories)
+	{
+		obj.directories.emplace_back(fs::path(dir.first), from_count(dir.second));
+	}
+}
+LOAD_INSTANTIATE(filesystem_watcher::tree_index, cereal::iarchive_binary_t);
+}
+
+namespace editor
+{
+SAVE(asset_database::artifact)
+{
+	try_save(ar, cereal::make_nvp("key", obj.key));
+	try_save(ar, cereal::make_nvp("time", to_count(obj.time)));
+}
+SAVE_INSTANTIATE(asset_database::artifact, cereal::oarchive_binary_t);
+
+LOAD(asset_database::artifact)
+{
+	std::int64_t time = 0;
+	try_load(ar, cereal::make_nvp("key", obj.key));
+	try_load(ar, cereal::make_nvp("time", time));
+	obj.time = from_count(time);
+}
+LOAD_INSTANTIATE(asset_database::artifact, cereal::iarchive_binary_t);
+
+SAVE(asset_database::record)
+{
+	try_save(ar, cereal::make_nvp("guid", obj.guid));
+	try_save(ar, cereal::make_nvp("content_hash", obj.content_hash));
+	try_save(ar, cereal::make_nvp("time", to_count(obj.time)));
+	try_save(ar, cereal::make_nvp("size", static_cast<std::uint64_t>(obj.size)));
+	try_save(ar, cereal::make_nvp("dependencies", obj.dependencies));
+	try_save(ar, cereal::make_nvp("artifacts", obj.artifacts));
+}
+SAVE_INSTANTIATE(asset_database::record, cereal::oarchive_binary_t);
+
+LOAD(asset_database::record)
+{
+	std::int64_t time = 0;
+	std::uint64_t size = 0;
+	try_load(ar, cereal::make_nvp("guid", obj.guid));
+	try_load(ar, cereal::make_nvp("content_hash", obj.content_hash));
+	try_load(ar, cereal::make_nvp("time", time));
+	try_load(ar, cereal::make_nvp("size", size));
+	try_load(ar, cereal::make_nvp("dependencies", obj.dependencies));
+	try_load(ar, cereal::make_nvp("artifacts", obj.artifacts));
+	obj.time = from_count(time);
+	obj.size = static_cast<std::uintmax_t>(size);
+}
+LOAD_INSTANTIATE(asset_database::record, cereal::iarchive_binary_t);
+}
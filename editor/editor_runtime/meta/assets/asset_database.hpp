@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../assets/asset_database.h"
+
+#include <core/serialization/serialization.h>
+
+namespace fs
+{
+SAVE_EXTERN(filesystem_watcher::entry);
+LOAD_EXTERN(filesystem_watcher::entry);
+SAVE_EXTERN(filesystem_watcher::tree_index);
+LOAD_EXTERN(filesystem_watcher::tree_index);
+}
+
+namespace editor
+{
+SAVE_EXTERN(asset_database::artifact);
+LOAD_EXTERN(asset_database::artifact);
+SAVE_EXTERN(asset_database::record);
+LOAD_EXTERN(asset_database::record);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <runtime/meta/meta.h>
 
+#include "assets/asset_database.hpp"
 #include "interface/gui_system.hpp"
 #include "system/project_manager.hpp"
@@ -3,6 +3,7 @@
 
 #include <core/graphics/debugdraw.h>
 #include <core/graphics/render_pass.h>
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 #include <runtime/assets/asset_manager.h>
@@ -21,6 +22,8 @@ namespace editor
 {
 void debugdraw_system::frame_render(delta_t)
 {
+	PROFILE_SCOPE("debugdraw_system::frame_render");
+
 	auto& es = core::get_subsystem<editing_system>();
 	auto& editor_camera = es.camera;
 	auto& selected = es.selection_data.object;
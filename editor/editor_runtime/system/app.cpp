@@ -1,12 +1,15 @@
 #include "app.h"
+#include "../assets/thumbnail_system.h"
 #include "../console/console_log.h"
 #include "../editing/editing_system.h"
 #include "../editing/picking_system.h"
+#include "../editing/world_partition.h"
 #include "../interface/docks/console_dock.h"
 #include "../interface/docks/docking.h"
 #include "../interface/docks/game_dock.h"
 #include "../interface/docks/hierarchy_dock.h"
 #include "../interface/docks/inspector_dock.h"
+#include "../interface/docks/profiler_dock.h"
 #include "../interface/docks/project_dock.h"
 #include "../interface/docks/scene_dock.h"
 #include "../interface/docks/style_dock.h"
@@ -16,6 +19,7 @@
 
 #include <core/filesystem/filesystem.h>
 #include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
 
 #include <runtime/assets/asset_manager.h>
 #include <runtime/ecs/components/camera_component.h>
@@ -220,6 +224,16 @@ auto save_scene()
 	es.save_editor_camera();
 }
 
+void partition_scene()
+{
+	auto& es = core::get_subsystem<editor::editing_system>();
+	if(es.scene != "")
+	{
+		save_scene();
+		editor::build_world_partition(es.scene, gather_scene_data(), 64.0f);
+	}
+}
+
 void save_scene_as()
 {
 	auto& es = core::get_subsystem<editor::editing_system>();
@@ -306,6 +320,12 @@ void app::draw_menubar(render_window& window)
 				save_scene_as();
 			}
 
+			if(gui::MenuItem("BUILD WORLD PARTITION", nullptr, false,
+							 es.scene != "" && current_project != ""))
+			{
+				partition_scene();
+			}
+
 			gui::EndMenu();
 		}
 		if(gui::BeginMenu("EDIT"))
@@ -432,6 +452,23 @@ void app::setup(cmd_line::parser& parser)
 
 void app::start(cmd_line::parser& parser)
 {
+	bool headless = false;
+	parser.try_get("headless", headless);
+	if(headless)
+	{
+		quit_with_error("The editor does not support headless mode.");
+		return;
+	}
+
+	// The editor tools draw with the scene from the owner thread.
+	bool render_thread = false;
+	parser.try_get("render_thread", render_thread);
+	if(render_thread)
+	{
+		quit_with_error("The editor does not support the render thread.");
+		return;
+	}
+
 	console_log_ = std::make_shared<console_log>();
 
 	auto logging_container = logging::get_mutable_logging_container();
@@ -442,6 +479,7 @@ void app::start(cmd_line::parser& parser)
 	core::add_subsystem<gui_system>();
 	core::add_subsystem<docking_system>();
 	core::add_subsystem<editing_system>();
+	core::add_subsystem<thumbnail_system>();
 	core::add_subsystem<picking_system>();
 	core::add_subsystem<debugdraw_system>();
 	core::add_subsystem<project_manager>();
@@ -465,6 +503,7 @@ void app::create_docks()
 	auto project = std::make_unique<project_dock>("PROJECT", true, ImVec2(200.0f, 200.0f));
 	auto console = std::make_unique<console_dock>("CONSOLE", true, ImVec2(200.0f, 200.0f), console_log_);
 	auto style = std::make_unique<style_dock>("STYLE", true, ImVec2(300.0f, 200.0f));
+	auto profiler = std::make_unique<profiler_dock>("PROFILER", true, ImVec2(300.0f, 200.0f));
 
 	auto& docking = core::get_subsystem<docking_system>();
 	auto& dockspace = docking.get_dockspace(main_window->get_id());
@@ -475,6 +514,7 @@ void app::create_docks()
 	dockspace.dock_to(console.get(), imguidock::slot::bottom, 300, true);
 	dockspace.dock_with(project.get(), console.get(), imguidock::slot::tab, 250, true);
 	dockspace.dock_with(style.get(), project.get(), imguidock::slot::right, 400, true);
+	dockspace.dock_with(profiler.get(), console.get(), imguidock::slot::tab, 250, false);
 
 	docking.register_dock(std::move(scene));
 	docking.register_dock(std::move(game));
@@ -483,6 +523,7 @@ void app::create_docks()
 	docking.register_dock(std::move(console));
 	docking.register_dock(std::move(project));
 	docking.register_dock(std::move(style));
+	docking.register_dock(std::move(profiler));
 }
 
 void app::register_console_commands()
@@ -501,6 +542,8 @@ void app::stop()
 
 void app::draw_docks(delta_t dt)
 {
+	PROFILE_SCOPE("editor::app::draw_docks");
+
 	auto& gui = core::get_subsystem<gui_system>();
 	auto& docking = core::get_subsystem<docking_system>();
 	auto& renderer = core::get_subsystem<runtime::renderer>();
@@ -1,6 +1,8 @@
 #include "project_manager.h"
 #include "../assets/asset_compiler.h"
+#include "../assets/asset_database.h"
 #include "../assets/asset_extensions.h"
+#include "../assets/thumbnail_system.h"
 #include "../editing/editing_system.h"
 #include "../meta/system/project_manager.hpp"
 
@@ -41,6 +43,100 @@ static void unwatch(std::vector<uint64_t>& watchers)
 	watchers.clear();
 };
 
+static fs::path get_source_path(const fs::path& absolute_meta_key)
+{
+	auto key = fs::convert_to_protocol(absolute_meta_key);
+	auto source = fs::resolve_protocol(fs::replace(key, ":/meta", ":/data"));
+	source.replace_extension();
+	return source;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : recompile_dependents ()
+/// <summary>
+/// Touches the metadata of the assets referring to the source, so the cache
+/// syncer compiles them again.
+/// </summary>
+//-----------------------------------------------------------------------------
+static void recompile_dependents(const asset_database& db, const fs::path& source)
+{
+	for(const auto& dependent : db.get_dependents(fs::convert_to_protocol(source).generic_string()))
+	{
+		auto meta = fs::resolve_protocol(fs::replace(dependent, ":/data", ":/meta"));
+		meta.concat(".meta");
+		std::ofstream output(meta.string(), std::ofstream::trunc);
+		output.write("metadata", 8);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : compile_source ()
+/// <summary>
+/// Compiles the source of the metadata and records it. A changed source has
+/// its dependents compiled again. Compiling them does not go further, their
+/// own sources did not change, so a cycle of references ends there.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+static void compile_source(asset_database& db, const fs::path& ref_path, const fs::path& output,
+						   bool is_initial_listing)
+{
+	const auto source = get_source_path(ref_path);
+	const bool changed = !is_initial_listing && !db.is_unchanged(source);
+	asset_compiler::compile<T>(ref_path, output);
+	db.on_compiled(source, output);
+	if(changed)
+	{
+		recompile_dependents(db, source);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : open_database ()
+/// <summary>
+/// Opens the asset database of the protocol. Has to be done before its
+/// directories are watched, so their first scans can trust it.
+/// </summary>
+//-----------------------------------------------------------------------------
+static void open_database(asset_database& db, const std::string& protocol)
+{
+	db.open(fs::resolve_protocol(protocol + "/cache/assets.db"),
+			{fs::resolve_protocol(protocol + "/data"), fs::resolve_protocol(protocol + "/meta"),
+			 fs::resolve_protocol(protocol + "/cache")});
+}
+
+//-----------------------------------------------------------------------------
+//  Name : is_loaded_on_demand ()
+/// <summary>
+/// Assets of this type are not loaded by the initial listing but only when
+/// something requests them. Changes are reloaded only if already loaded.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+static bool is_loaded_on_demand()
+{
+	return false;
+}
+
+template <>
+bool is_loaded_on_demand<gfx::texture>()
+{
+	return true;
+}
+
+template <typename T>
+static void on_asset_changed(const std::string& /*key*/)
+{
+}
+
+template <>
+void on_asset_changed<gfx::texture>(const std::string& key)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto& thumbnails = core::get_subsystem<thumbnail_system>();
+	auto task = ts.push_on_owner_thread([key, &thumbnails]() { thumbnails.invalidate(key); });
+}
+
 template <typename T>
 static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildcard, bool reload_async)
 {
@@ -59,6 +155,11 @@ static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildca
 
 				if(entry.type == fs::file_type::regular)
 				{
+					if(!is_initial_list)
+					{
+						on_asset_changed<T>(key);
+					}
+
 					if(entry.status == fs::watcher::entry_status::removed)
 					{
 						auto task = ts.push_on_owner_thread([key, &am]() { am.clear_asset<T>(key); });
@@ -75,6 +176,12 @@ static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildca
 					else
 					{
 						using namespace runtime;
+						if(is_loaded_on_demand<T>() &&
+						   (is_initial_list || !am.find_asset_entry<T>(key).valid()))
+						{
+							continue;
+						}
+
 						load_flags flags = is_initial_list ? load_flags::standard : load_flags::reload;
 
 						// created or modified
@@ -87,20 +194,19 @@ static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildca
 
 template <typename T>
 static void add_to_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& dir,
-						  const fs::syncer::on_entry_removed_t& on_removed,
+						  asset_database& db, const fs::syncer::on_entry_removed_t& on_removed,
 						  const fs::syncer::on_entry_renamed_t& on_renamed)
 {
 	auto& ts = core::get_subsystem<core::task_system>();
-	auto on_modified = [&ts](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
+	auto on_modified = [&ts, &db](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
 		auto task = ts.push_on_worker_thread(
-			[ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
+			[&db, ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
 				fs::path output = synced_paths.front();
-				fs::error_code err;
-				if(is_initial_listing && fs::exists(output, err))
+				if(is_initial_listing && fs::watcher::exists(output))
 				{
 					return;
 				}
-				asset_compiler::compile<T>(ref_path, output);
+				compile_source<T>(db, ref_path, output, is_initial_listing);
 			});
 	};
 
@@ -114,14 +220,14 @@ static void add_to_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, c
 
 template <>
 void add_to_syncer<gfx::shader>(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& dir,
-								const fs::syncer::on_entry_removed_t& on_removed,
+								asset_database& db, const fs::syncer::on_entry_removed_t& on_removed,
 								const fs::syncer::on_entry_renamed_t& on_renamed)
 {
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto on_modified = [&ts](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
+	auto on_modified = [&ts, &db](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
 		auto task = ts.push_on_worker_thread(
-			[ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
+			[&db, ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
 				const auto& renderer_extension = gfx::get_renderer_filename_extension();
 				auto it = std::find_if(std::begin(synced_paths), std::end(synced_paths),
 									   [&renderer_extension](const auto& key) {
@@ -135,13 +241,12 @@ void add_to_syncer<gfx::shader>(std::vector<uint64_t>& watchers, fs::syncer& syn
 
 				fs::path output = *it;
 
-				fs::error_code err;
-				if(is_initial_listing && fs::exists(output, err))
+				if(is_initial_listing && fs::watcher::exists(output))
 				{
 					return;
 				}
 
-				asset_compiler::compile<gfx::shader>(ref_path, output);
+				compile_source<gfx::shader>(db, ref_path, output, is_initial_listing);
 			});
 	};
 
@@ -160,9 +265,13 @@ void project_manager::close_project()
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
 	auto& am = core::get_subsystem<runtime::asset_manager>();
 	auto& es = core::get_subsystem<editing_system>();
+	auto& thumbnails = core::get_subsystem<thumbnail_system>();
 	es.close_project();
+	thumbnails.clear();
 	ecs.dispose();
 	am.clear("app:/data");
+	// Saved while the trees are still watched.
+	app_database_.close();
 	unwatch(app_watchers_);
 	app_meta_syncer_.unsync();
 	app_cache_syncer_.unsync();
@@ -186,9 +295,11 @@ bool project_manager::open_project(const fs::path& project_path)
 
 	save_config();
 
-	setup_meta_syncer(app_meta_syncer_, fs::resolve_protocol("app:/data"), fs::resolve_protocol("app:/meta"));
+	open_database(app_database_, "app:");
+	setup_meta_syncer(app_meta_syncer_, fs::resolve_protocol("app:/data"), fs::resolve_protocol("app:/meta"),
+					  app_database_);
 	setup_cache_syncer(app_watchers_, app_cache_syncer_, fs::resolve_protocol("app:/meta"),
-					   fs::resolve_protocol("app:/cache"));
+					   fs::resolve_protocol("app:/cache"), app_database_);
 
 	auto& es = core::get_subsystem<editing_system>();
 	es.load_editor_camera();
@@ -265,11 +376,12 @@ void project_manager::setup_directory(fs::syncer& syncer)
 }
 
 void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data_dir,
-										const fs::path& meta_dir)
+										const fs::path& meta_dir, asset_database& db)
 {
 	setup_directory(syncer);
 
-	const auto on_file_removed = [](const auto& /*ref_path*/, const auto& synced_paths) {
+	const auto on_file_removed = [&db](const auto& ref_path, const auto& synced_paths) {
+		db.on_removed(ref_path);
 		for(const auto& synced_path : synced_paths)
 		{
 			fs::error_code err;
@@ -277,7 +389,8 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 		}
 	};
 
-	const auto on_file_renamed = [](const auto& /*ref_path*/, const auto& synced_paths) {
+	const auto on_file_renamed = [&db](const auto& ref_path, const auto& synced_paths) {
+		db.on_renamed(ref_path.first, ref_path.second);
 		for(const auto& synced_path : synced_paths)
 		{
 			fs::error_code err;
@@ -285,12 +398,16 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 		}
 	};
 
-	const auto on_file_modified = [](const auto& /*ref_path*/, const auto& synced_paths,
-									 bool is_initial_listing) {
+	const auto on_file_modified = [&db](const auto& ref_path, const auto& synced_paths,
+										bool is_initial_listing) {
 		for(const auto& synced_path : synced_paths)
 		{
-			fs::error_code err;
-			if(is_initial_listing && fs::exists(synced_path, err))
+			if(is_initial_listing && fs::watcher::exists(synced_path))
+			{
+				return;
+			}
+			// Touched without changing, what was compiled from it is still current.
+			if(!is_initial_listing && db.is_unchanged(ref_path))
 			{
 				return;
 			}
@@ -314,7 +431,8 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 }
 
 void project_manager::setup_cache_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer,
-										 const fs::path& meta_dir, const fs::path& cache_dir)
+										 const fs::path& meta_dir, const fs::path& cache_dir,
+										 asset_database& db)
 {
 	setup_directory(syncer);
 
@@ -337,14 +455,14 @@ void project_manager::setup_cache_syncer(std::vector<uint64_t>& watchers, fs::sy
 		}
 	};
 
-	add_to_syncer<gfx::texture>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<gfx::shader>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<mesh>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<audio::sound>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<material>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<runtime::animation>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<prefab>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<scene>(watchers, syncer, cache_dir, on_removed, on_renamed);
+	add_to_syncer<gfx::texture>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<gfx::shader>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<mesh>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<audio::sound>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<material>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<runtime::animation>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<prefab>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
+	add_to_syncer<scene>(watchers, syncer, cache_dir, db, on_removed, on_renamed);
 
 	syncer.sync(meta_dir, cache_dir);
 }
@@ -371,20 +489,26 @@ void project_manager::save_config()
 project_manager::project_manager()
 {
 	load_config();
+	open_database(engine_database_, "engine:");
 	setup_meta_syncer(engine_meta_syncer_, fs::resolve_protocol("engine:/data"),
-					  fs::resolve_protocol("engine:/meta"));
+					  fs::resolve_protocol("engine:/meta"), engine_database_);
 	setup_cache_syncer(engine_watchers_, engine_cache_syncer_, fs::resolve_protocol("engine:/meta"),
-					   fs::resolve_protocol("engine:/cache"));
+					   fs::resolve_protocol("engine:/cache"), engine_database_);
+	open_database(editor_database_, "editor:");
 	setup_meta_syncer(editor_meta_syncer_, fs::resolve_protocol("editor:/data"),
-					  fs::resolve_protocol("editor:/meta"));
+					  fs::resolve_protocol("editor:/meta"), editor_database_);
 	setup_cache_syncer(editor_watchers_, editor_cache_syncer_, fs::resolve_protocol("editor:/meta"),
-					   fs::resolve_protocol("editor:/cache"));
+					   fs::resolve_protocol("editor:/cache"), editor_database_);
 }
 
 project_manager::~project_manager()
 {
 	save_config();
 
+	app_database_.close();
+	editor_database_.close();
+	engine_database_.close();
+
 	unwatch(app_watchers_);
 
 	app_meta_syncer_.unsync();
@@ -1,4 +1,6 @@
 #pragma once
+#include "../assets/asset_database.h"
+
 #include <core/filesystem/filesystem_syncer.h>
 #include <core/math/math_includes.h>
 
@@ -109,22 +111,27 @@ public:
 
 private:
 	void setup_directory(fs::syncer& syncer);
-	void setup_meta_syncer(fs::syncer& syncer, const fs::path& data_dir, const fs::path& meta_dir);
+	void setup_meta_syncer(fs::syncer& syncer, const fs::path& data_dir, const fs::path& meta_dir,
+						   asset_database& db);
 	void setup_cache_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& meta_dir,
-							const fs::path& cache_dir);
+							const fs::path& cache_dir, asset_database& db);
 	/// Project options
 	options options_;
 	/// Current project name
 	std::string project_name_;
 
+	/// What is known about the assets of the project
+	asset_database app_database_;
 	fs::syncer app_meta_syncer_;
 	fs::syncer app_cache_syncer_;
 	std::vector<std::uint64_t> app_watchers_;
 
+	asset_database editor_database_;
 	fs::syncer editor_meta_syncer_;
 	fs::syncer editor_cache_syncer_;
 	std::vector<std::uint64_t> editor_watchers_;
 
+	asset_database engine_database_;
 	fs::syncer engine_meta_syncer_;
 	fs::syncer engine_cache_syncer_;
 	std::vector<std::uint64_t> engine_watchers_;
@@ -0,0 +1,94 @@
+#include "benchmark.h"
+
+#include <core/system/subsystem.h>
+
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/ecs.h>
+
+#include <vector>
+
+namespace
+{
+constexpr std::size_t entity_count = 10000;
+}
+
+BENCHMARK(ecs_create_destroy)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	std::vector<runtime::entity> entities;
+	entities.reserve(entity_count);
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < entity_count; ++i)
+		{
+			entities.emplace_back(ecs.create());
+		}
+		for(auto& e : entities)
+		{
+			e.destroy();
+		}
+		entities.clear();
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+}
+
+BENCHMARK(ecs_assign_remove_transform)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	std::vector<runtime::entity> entities;
+	for(std::size_t i = 0; i < entity_count; ++i)
+	{
+		entities.emplace_back(ecs.create());
+	}
+
+	while(state.keep_running())
+	{
+		for(auto& e : entities)
+		{
+			e.assign<transform_component>();
+		}
+		for(auto& e : entities)
+		{
+			e.remove<transform_component>();
+		}
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+
+	for(auto& e : entities)
+	{
+		e.destroy();
+	}
+}
+
+BENCHMARK(ecs_iterate_transforms)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	std::vector<runtime::entity> entities;
+	for(std::size_t i = 0; i < entity_count; ++i)
+	{
+		auto e = ecs.create();
+		// every other entity has a transform so the iteration has to skip
+		if(i % 2 == 0)
+		{
+			e.assign<transform_component>();
+		}
+		entities.emplace_back(e);
+	}
+
+	std::size_t visited = 0;
+	while(state.keep_running())
+	{
+		ecs.for_each<transform_component>(
+			[&visited](runtime::entity, transform_component&) { ++visited; });
+	}
+	bench::do_not_optimize(visited);
+	state.set_items_processed(state.get_iterations() * entity_count);
+
+	for(auto& e : entities)
+	{
+		e.destroy();
+	}
+}
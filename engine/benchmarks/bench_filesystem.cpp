@@ -0,0 +1,211 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/filesystem/filesystem.h>
+#include <core/filesystem/filesystem_watcher.h>
+#include <core/filesystem/io_system.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t directory_count = 10;
+constexpr std::size_t files_per_directory = 100;
+constexpr std::size_t pack_entry_count = 1024;
+constexpr std::size_t pack_entry_size = 16 * 1024;
+
+struct temp_tree
+{
+	temp_tree()
+	{
+		fs::error_code err;
+		root = fs::temp_directory_path(err) / "ethereal_benchmarks_watcher";
+		fs::remove_all(root, err);
+		for(std::size_t d = 0; d < directory_count; ++d)
+		{
+			const auto dir = root / ("dir_" + std::to_string(d));
+			fs::create_directories(dir, err);
+			for(std::size_t f = 0; f < files_per_directory; ++f)
+			{
+				std::ofstream stream{(dir / ("file_" + std::to_string(f) + ".asset")).string()};
+				stream << f;
+			}
+		}
+	}
+
+	~temp_tree()
+	{
+		fs::error_code err;
+		fs::remove_all(root, err);
+	}
+
+	fs::path root;
+};
+
+struct temp_pack
+{
+	temp_pack()
+	{
+		fs::error_code err;
+		file = fs::temp_directory_path(err) / "ethereal_benchmarks_pack.bin";
+		std::ofstream stream{file.string(), std::ios::out | std::ios::binary | std::ios::trunc};
+		const std::vector<char> entry(pack_entry_size, 'x');
+		for(std::size_t i = 0; i < pack_entry_count; ++i)
+		{
+			stream.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+		}
+	}
+
+	~temp_pack()
+	{
+		fs::error_code err;
+		fs::remove(file, err);
+	}
+
+	fs::path file;
+};
+
+// Waits until the watcher reported the change. A watcher that misses it
+// fails the benchmark instead of hanging it.
+void wait_for_change(const std::atomic<std::uint64_t>& changes, std::uint64_t expected)
+{
+	using namespace std::literals;
+	const auto deadline = std::chrono::steady_clock::now() + 5s;
+	while(changes.load() < expected && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+	ensures(changes.load() >= expected);
+}
+}
+
+BENCHMARK(watcher_initial_scan)
+{
+	using namespace std::literals;
+	temp_tree tree;
+
+	std::size_t listed = 0;
+	while(state.keep_running())
+	{
+		// the initial list is built synchronously inside watch
+		const auto key = fs::watcher::watch(tree.root / "*", true, true, 1h,
+											[&listed](const auto& entries, bool) { listed += entries.size(); });
+		fs::watcher::unwatch(key);
+	}
+	bench::do_not_optimize(listed);
+	state.set_items_processed(state.get_iterations() * directory_count * (files_per_directory + 1));
+}
+
+BENCHMARK(watcher_change_latency)
+{
+	using namespace std::literals;
+	temp_tree tree;
+	const auto file = tree.root / "dir_0" / "file_0.asset";
+
+	std::atomic<std::uint64_t> changes{0};
+	const auto key = fs::watcher::watch(tree.root / "*", true, false, 1ms,
+										[&changes](const auto& entries, bool is_initial_list) {
+											if(!is_initial_list && !entries.empty())
+											{
+												++changes;
+											}
+										});
+
+	// measures the time from a modification until the watcher reports it,
+	// which includes one full poll of the watched tree
+	while(state.keep_running())
+	{
+		const auto expected = changes.load() + 1;
+		fs::watcher::touch(file, false);
+		wait_for_change(changes, expected);
+	}
+
+	fs::watcher::unwatch(key);
+}
+
+BENCHMARK(watcher_shared_change_latency)
+{
+	using namespace std::literals;
+	temp_tree tree;
+	const auto file = tree.root / "dir_0" / "file_0.asset";
+
+	// several watches over the same tree, like one per asset type
+	std::atomic<std::uint64_t> changes{0};
+	std::vector<std::uint64_t> keys;
+	for(const auto& wildcard : {"*.asset", "*.png", "*.mesh", "*.sound", "*.mat", "*.meta"})
+	{
+		keys.push_back(fs::watcher::watch(tree.root / wildcard, true, false, 1ms,
+										  [&changes](const auto& entries, bool is_initial_list) {
+											  if(!is_initial_list && !entries.empty())
+											  {
+												  ++changes;
+											  }
+										  }));
+	}
+
+	while(state.keep_running())
+	{
+		const auto expected = changes.load() + 1;
+		fs::watcher::touch(file, false);
+		wait_for_change(changes, expected);
+	}
+
+	for(const auto key : keys)
+	{
+		fs::watcher::unwatch(key);
+	}
+}
+
+BENCHMARK(io_pack_entries_stream)
+{
+	temp_pack pack;
+
+	// every entry on its own, like the loaders did with an ifstream each
+	std::vector<char> entry(pack_entry_size);
+	std::size_t bytes = 0;
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < pack_entry_count; ++i)
+		{
+			std::ifstream stream{pack.file.string(), std::ios::in | std::ios::binary};
+			stream.seekg(static_cast<std::streamoff>(i * pack_entry_size));
+			stream.read(entry.data(), static_cast<std::streamsize>(entry.size()));
+			bytes += static_cast<std::size_t>(stream.gcount());
+		}
+	}
+	bench::do_not_optimize(bytes);
+	state.set_items_processed(state.get_iterations() * pack_entry_count);
+}
+
+BENCHMARK(io_pack_entries_coalesced)
+{
+	temp_pack pack;
+	fs::io_system io;
+
+	std::vector<core::task_future<fs::io_result>> reads;
+	reads.reserve(pack_entry_count);
+	std::size_t bytes = 0;
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < pack_entry_count; ++i)
+		{
+			fs::io_request request;
+			request.file = pack.file;
+			request.offset = i * pack_entry_size;
+			request.size = pack_entry_size;
+			reads.emplace_back(io.read(request));
+		}
+		for(auto& read : reads)
+		{
+			bytes += read.get().size();
+		}
+		reads.clear();
+	}
+	bench::do_not_optimize(bytes);
+	state.set_items_processed(state.get_iterations() * pack_entry_count);
+}
@@ -0,0 +1,77 @@
+#include "benchmark.h"
+
+#include <core/math/math_includes.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t box_count = 10000;
+
+struct culling_data
+{
+	culling_data()
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> extent(0.5f, 10.0f);
+		std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+
+		bounds.reserve(box_count);
+		world.reserve(box_count);
+		for(std::size_t i = 0; i < box_count; ++i)
+		{
+			const math::vec3 half(extent(rng), extent(rng), extent(rng));
+			bounds.emplace_back(-half, half);
+
+			math::transform t;
+			t.set_position({position(rng), position(rng), position(rng)});
+			t.rotate(math::radians(angle(rng)), math::radians(angle(rng)), math::radians(angle(rng)));
+			world.emplace_back(t);
+		}
+	}
+
+	/// the camera frustum, a box covering a quarter of the scene
+	math::frustum frustum{math::bbox(-100.0f, -100.0f, -100.0f, 100.0f, 100.0f, 100.0f)};
+	std::vector<math::bbox> bounds;
+	std::vector<math::transform> world;
+};
+}
+
+BENCHMARK(frustum_test_aabb)
+{
+	culling_data data;
+	std::vector<math::bbox> world_bounds;
+	for(std::size_t i = 0; i < box_count; ++i)
+	{
+		world_bounds.emplace_back(math::bbox::mul(data.bounds[i], data.world[i]));
+	}
+
+	std::size_t visible = 0;
+	while(state.keep_running())
+	{
+		for(const auto& bounds : world_bounds)
+		{
+			visible += data.frustum.test_aabb(bounds) ? 1 : 0;
+		}
+	}
+	bench::do_not_optimize(visible);
+	state.set_items_processed(state.get_iterations() * box_count);
+}
+
+BENCHMARK(frustum_test_obb)
+{
+	culling_data data;
+
+	std::size_t visible = 0;
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < box_count; ++i)
+		{
+			visible += math::frustum::test_obb(data.frustum, data.bounds[i], data.world[i]) ? 1 : 0;
+		}
+	}
+	bench::do_not_optimize(visible);
+	state.set_items_processed(state.get_iterations() * box_count);
+}
@@ -0,0 +1,182 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <runtime/rendering/camera.h>
+#include <runtime/rendering/light_clusters.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t point_light_count = 512;
+constexpr std::size_t spot_light_count = 128;
+const math::vec3 eye{0.0f, 10.0f, -120.0f};
+const math::vec3 target{0.0f, 0.0f, 0.0f};
+
+struct cluster_data
+{
+	cluster_data()
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> range(2.0f, 15.0f);
+		std::uniform_real_distribution<float> rotation(-180.0f, 180.0f);
+		std::uniform_real_distribution<float> cone(20.0f, 90.0f);
+
+		for(std::size_t i = 0; i < point_light_count + spot_light_count; ++i)
+		{
+			light l;
+			l.type = i < point_light_count ? light_type::point : light_type::spot;
+			l.point_data.range = range(rng);
+			l.spot_data.set_range(l.point_data.range);
+			l.spot_data.set_outer_angle(cone(rng));
+
+			math::transform world;
+			world.set_position({position(rng), position(rng) * 0.1f, position(rng)});
+			world.rotate(math::radians(rotation(rng)), math::radians(rotation(rng)), 0.0f);
+			lights.emplace_back(light_clusters::make_light_data(l, world));
+		}
+
+		cam.set_viewport_size({1920, 1080});
+		cam.set_fov(60.0f);
+		cam.set_near_clip(0.1f);
+		cam.set_far_clip(300.0f);
+		cam.look_at(eye, target);
+	}
+
+	/// camera looking across all lights
+	camera cam;
+	std::vector<light_clusters::light_data> lights;
+};
+
+// Selects the binning implementation for its lifetime.
+struct level_scope
+{
+	level_scope(math::simd::level l)
+		: previous(math::simd::get_level())
+	{
+		math::simd::set_level(l);
+	}
+	~level_scope()
+	{
+		math::simd::set_level(previous);
+	}
+
+	math::simd::level previous;
+};
+
+void build(const cluster_data& data, const std::vector<light_clusters::light_data>& lights,
+		   light_clusters& clusters, core::task_system* ts = nullptr)
+{
+	clusters.build(lights, data.cam.get_view(), data.cam.get_projection(), data.cam.get_near_clip(),
+				   data.cam.get_far_clip(), ts);
+}
+
+void check_clusters(const cluster_data& data, core::task_system* ts)
+{
+	// The scalar binning is the reference for the vectorised one.
+	light_clusters expected;
+	{
+		level_scope scalar(math::simd::level::scalar);
+		build(data, data.lights, expected);
+	}
+
+	light_clusters clusters;
+	build(data, data.lights, clusters, ts);
+	ensures(clusters.get_light_indices() == expected.get_light_indices());
+	for(std::uint32_t i = 0; i < light_clusters::cluster_count; ++i)
+	{
+		ensures(clusters.get_clusters()[i].offset == expected.get_clusters()[i].offset);
+		ensures(clusters.get_clusters()[i].count == expected.get_clusters()[i].count);
+	}
+	ensures(clusters.get_dropped_lights() == 0);
+
+	// A small light in the middle of the screen is in the middle tiles of its
+	// slice and only touches their neighbours in the slices around its depth.
+	constexpr float depth = 20.0f;
+	light l;
+	l.type = light_type::point;
+	l.point_data.range = 1.0f;
+	math::transform world;
+	world.set_position(eye + math::normalize(target - eye) * depth);
+	const std::vector<light_clusters::light_data> lights{light_clusters::make_light_data(l, world)};
+	build(data, lights, clusters, ts);
+
+	const auto first_slice = clusters.get_slice(depth - l.point_data.range);
+	const auto last_slice = clusters.get_slice(depth + l.point_data.range);
+	for(std::uint32_t z = 0; z < light_clusters::slices; ++z)
+	{
+		for(std::uint32_t y = 0; y < light_clusters::tiles_y; ++y)
+		{
+			for(std::uint32_t x = 0; x < light_clusters::tiles_x; ++x)
+			{
+				const auto& c = clusters.get_clusters()[light_clusters::get_cluster_index(x, y, z)];
+				const auto center_x = light_clusters::tiles_x / 2;
+				const auto center_y = light_clusters::tiles_y / 2;
+				const bool middle = (x == center_x - 1 || x == center_x) && y == center_y;
+				const bool around = x + 2 >= center_x && x <= center_x + 1 && y + 1 >= center_y &&
+									y <= center_y + 1 && z >= first_slice && z <= last_slice;
+				if(middle && z == clusters.get_slice(depth))
+				{
+					ensures(c.count == 1 && clusters.get_light_indices()[c.offset] == 0);
+				}
+				ensures(c.count == 0 || (c.count == 1 && around));
+			}
+		}
+	}
+
+	// The lights past the limit are dropped and reported.
+	std::vector<light_clusters::light_data> too_many(light_clusters::max_lights + 5, lights.front());
+	build(data, too_many, clusters, ts);
+	ensures(clusters.get_dropped_lights() == 5);
+}
+
+void build_clusters(bench::state& state, core::task_system* ts)
+{
+	cluster_data data;
+	check_clusters(data, ts);
+	light_clusters clusters;
+
+	std::size_t indices = 0;
+	while(state.keep_running())
+	{
+		clusters.build(data.lights, data.cam.get_view(), data.cam.get_projection(), data.cam.get_near_clip(),
+					   data.cam.get_far_clip(), ts);
+		indices += clusters.get_light_indices().size();
+	}
+	bench::do_not_optimize(indices);
+	state.set_items_processed(state.get_iterations() * data.lights.size());
+}
+}
+
+BENCHMARK(light_clusters_build)
+{
+	build_clusters(state, nullptr);
+}
+
+BENCHMARK(light_clusters_build_parallel)
+{
+	build_clusters(state, &core::get_subsystem<core::task_system>());
+}
+
+BENCHMARK(light_clusters_pack)
+{
+	cluster_data data;
+	light_clusters clusters;
+	clusters.build(data.lights, data.cam.get_view(), data.cam.get_projection(), data.cam.get_near_clip(),
+				   data.cam.get_far_clip());
+
+	std::vector<float> texels;
+	while(state.keep_running())
+	{
+		light_clusters::pack_lights(data.lights, texels);
+		clusters.pack_clusters(texels);
+		clusters.pack_indices(texels);
+	}
+	bench::do_not_optimize(texels.data());
+	state.set_items_processed(state.get_iterations() * light_clusters::cluster_count);
+}
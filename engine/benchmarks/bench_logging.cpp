@@ -0,0 +1,84 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/logging/logging.h>
+#include <core/logging/mpsc_queue.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t message_count = 10000;
+constexpr std::size_t producer_count = 4;
+}
+
+// Trace is below the default level, so these measure what a disabled log
+// statement costs at the call site.
+BENCHMARK(logging_filtered_registry_lookup)
+{
+	const std::string key = "app:/data/models/rock.obj";
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < message_count; ++i)
+		{
+			spdlog::get(APPLOG)->trace("Loading {0} ({1})", key, i);
+		}
+	}
+	state.set_items_processed(state.get_iterations() * message_count);
+}
+
+BENCHMARK(logging_filtered_macro)
+{
+	const std::string key = "app:/data/models/rock.obj";
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < message_count; ++i)
+		{
+			APPLOG_TRACE("Loading {0} ({1})", key, i);
+		}
+	}
+	state.set_items_processed(state.get_iterations() * message_count);
+}
+
+BENCHMARK(logging_mpsc_queue)
+{
+	logging::mpsc_queue<std::uint64_t> queue(1024);
+	while(state.keep_running())
+	{
+		std::vector<std::thread> producers;
+		for(std::size_t p = 0; p < producer_count; ++p)
+		{
+			producers.emplace_back([&queue, p]() {
+				for(std::size_t i = 0; i < message_count; ++i)
+				{
+					while(!queue.try_push([&](std::uint64_t& value) { value = p * message_count + i; }))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		std::uint64_t sum = 0;
+		std::size_t popped = 0;
+		while(popped < producer_count * message_count)
+		{
+			if(queue.try_pop([&](std::uint64_t value) { sum += value; }))
+			{
+				++popped;
+			}
+		}
+		for(auto& producer : producers)
+		{
+			producer.join();
+		}
+
+		const std::uint64_t total = producer_count * message_count;
+		ensures(sum == total * (total - 1) / 2);
+	}
+	state.set_items_processed(state.get_iterations() * producer_count * message_count);
+}
@@ -0,0 +1,228 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/math/math_includes.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t box_count = 10003;
+
+struct batch_data
+{
+	batch_data()
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> extent(0.5f, 10.0f);
+		std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+
+		bounds.reserve(box_count);
+		spheres.reserve(box_count);
+		world.reserve(box_count);
+		for(std::size_t i = 0; i < box_count; ++i)
+		{
+			const math::vec3 half(extent(rng), extent(rng), extent(rng));
+			bounds.push_back(math::bbox(-half, half));
+
+			math::transform t;
+			t.set_position({position(rng), position(rng), position(rng)});
+			t.rotate(math::radians(angle(rng)), math::radians(angle(rng)), math::radians(angle(rng)));
+			world.emplace_back(t);
+
+			spheres.push_back(t.get_position(), math::length(half));
+		}
+		math::batch::mul(bounds, world, world_bounds);
+	}
+
+	/// the camera frustum, a box covering a quarter of the scene
+	math::frustum frustum{math::bbox(-100.0f, -100.0f, -100.0f, 100.0f, 100.0f, 100.0f)};
+	/// a tilted plane through the scene
+	math::plane plane =
+		math::plane::from_point_normal({10.0f, 0.0f, 0.0f}, math::normalize(math::vec3(1.0f, 1.0f, 0.0f)));
+	math::bbox_soa bounds;
+	math::bbox_soa world_bounds;
+	math::sphere_soa spheres;
+	std::vector<math::transform> world;
+};
+
+// Selects the batch implementation for the lifetime of the benchmark.
+struct level_scope
+{
+	level_scope(math::simd::level l)
+		: previous(math::simd::get_level())
+	{
+		math::simd::set_level(l);
+	}
+	~level_scope()
+	{
+		math::simd::set_level(previous);
+	}
+
+	math::simd::level previous;
+};
+
+bool is_close(float a, float b)
+{
+	return math::abs(a - b) <= 1e-4f * math::max(1.0f, math::abs(a));
+}
+
+void check_mul(const batch_data& data, const math::bbox_soa& result)
+{
+	for(std::size_t i = 0; i < box_count; ++i)
+	{
+		const auto expected = math::bbox::mul(data.bounds.get(i), data.world[i]);
+		const auto actual = result.get(i);
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			ensures(is_close(expected.min[axis], actual.min[axis]));
+			ensures(is_close(expected.max[axis], actual.max[axis]));
+		}
+	}
+}
+
+void mul_each(bench::state& state, math::simd::level l)
+{
+	batch_data data;
+	level_scope scope(l);
+
+	math::bbox_soa result;
+	math::batch::mul(data.bounds, data.world, result);
+	check_mul(data, result);
+
+	while(state.keep_running())
+	{
+		math::batch::mul(data.bounds, data.world, result);
+	}
+	bench::do_not_optimize(result.min_x.data());
+	state.set_items_processed(state.get_iterations() * box_count);
+}
+
+void classify_frustum(bench::state& state, math::simd::level l)
+{
+	batch_data data;
+	level_scope scope(l);
+
+	std::vector<math::volume_query> result;
+	math::batch::classify_aabb(data.frustum, data.world_bounds, result);
+	for(std::size_t i = 0; i < box_count; ++i)
+	{
+		ensures(result[i] == data.frustum.classify_aabb(data.world_bounds.get(i)));
+	}
+
+	while(state.keep_running())
+	{
+		math::batch::classify_aabb(data.frustum, data.world_bounds, result);
+	}
+	bench::do_not_optimize(result.data());
+	state.set_items_processed(state.get_iterations() * box_count);
+}
+
+void classify_plane(bench::state& state, math::simd::level l)
+{
+	batch_data data;
+
+	// The scalar path is the reference for the vectorised ones.
+	std::vector<math::plane_query> expected;
+	{
+		level_scope scalar(math::simd::level::scalar);
+		math::batch::classify_aabb(data.plane, data.world_bounds, expected);
+	}
+
+	level_scope scope(l);
+	std::vector<math::plane_query> result;
+	math::batch::classify_aabb(data.plane, data.world_bounds, result);
+	ensures(result == expected);
+
+	while(state.keep_running())
+	{
+		math::batch::classify_aabb(data.plane, data.world_bounds, result);
+	}
+	bench::do_not_optimize(result.data());
+	state.set_items_processed(state.get_iterations() * box_count);
+}
+
+void test_sphere(bench::state& state, math::simd::level l)
+{
+	batch_data data;
+	level_scope scope(l);
+
+	std::vector<std::uint8_t> result;
+	math::batch::test_sphere(data.frustum, data.spheres, result);
+	for(std::size_t i = 0; i < box_count; ++i)
+	{
+		const math::vec3 center(data.spheres.center_x[i], data.spheres.center_y[i], data.spheres.center_z[i]);
+		ensures((result[i] != 0) == data.frustum.test_sphere(center, data.spheres.radius[i]));
+	}
+
+	while(state.keep_running())
+	{
+		math::batch::test_sphere(data.frustum, data.spheres, result);
+	}
+	bench::do_not_optimize(result.data());
+	state.set_items_processed(state.get_iterations() * box_count);
+}
+}
+
+// Levels the machine does not support fall back to the best supported one.
+BENCHMARK(math_batch_mul_scalar)
+{
+	mul_each(state, math::simd::level::scalar);
+}
+
+BENCHMARK(math_batch_mul_sse2)
+{
+	mul_each(state, math::simd::level::sse2);
+}
+
+BENCHMARK(math_batch_mul_avx)
+{
+	mul_each(state, math::simd::level::avx);
+}
+
+BENCHMARK(math_batch_classify_frustum_scalar)
+{
+	classify_frustum(state, math::simd::level::scalar);
+}
+
+BENCHMARK(math_batch_classify_frustum_sse2)
+{
+	classify_frustum(state, math::simd::level::sse2);
+}
+
+BENCHMARK(math_batch_classify_frustum_avx)
+{
+	classify_frustum(state, math::simd::level::avx);
+}
+
+BENCHMARK(math_batch_classify_plane_scalar)
+{
+	classify_plane(state, math::simd::level::scalar);
+}
+
+BENCHMARK(math_batch_classify_plane_sse2)
+{
+	classify_plane(state, math::simd::level::sse2);
+}
+
+BENCHMARK(math_batch_classify_plane_avx)
+{
+	classify_plane(state, math::simd::level::avx);
+}
+
+BENCHMARK(math_batch_test_sphere_scalar)
+{
+	test_sphere(state, math::simd::level::scalar);
+}
+
+BENCHMARK(math_batch_test_sphere_sse2)
+{
+	test_sphere(state, math::simd::level::sse2);
+}
+
+BENCHMARK(math_batch_test_sphere_avx)
+{
+	test_sphere(state, math::simd::level::avx);
+}
@@ -0,0 +1,88 @@
+#include "benchmark.h"
+
+#include <core/graphics/graphics.h>
+
+#include <runtime/rendering/mesh.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t grid_size = 64;
+
+struct grid_data
+{
+	grid_data()
+	{
+		const auto& format = gfx::mesh_vertex::get_layout();
+		const auto stride = format.getStride();
+		const auto position_offset = format.getOffset(gfx::attribute::Position);
+
+		// quads do not share their corners so the weld step has work to do
+		vertex_count = grid_size * grid_size * 4;
+		vertices.resize(vertex_count * stride, 0);
+
+		std::uint32_t v = 0;
+		for(std::uint32_t z = 0; z < grid_size; ++z)
+		{
+			for(std::uint32_t x = 0; x < grid_size; ++x)
+			{
+				const float corners[4][3] = {{float(x), 0.0f, float(z)},
+											 {float(x + 1), 0.0f, float(z)},
+											 {float(x + 1), 0.0f, float(z + 1)},
+											 {float(x), 0.0f, float(z + 1)}};
+				for(const auto& corner : corners)
+				{
+					std::memcpy(&vertices[v * stride + position_offset], corner, sizeof(corner));
+					++v;
+				}
+
+				const auto base = v - 4;
+				mesh::triangle t0;
+				t0.indices[0] = base;
+				t0.indices[1] = base + 2;
+				t0.indices[2] = base + 1;
+				mesh::triangle t1;
+				t1.indices[0] = base;
+				t1.indices[1] = base + 3;
+				t1.indices[2] = base + 2;
+				faces.emplace_back(t0);
+				faces.emplace_back(t1);
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> vertices;
+	std::uint32_t vertex_count = 0;
+	mesh::triangle_array_t faces;
+};
+}
+
+BENCHMARK(mesh_end_prepare_weld_optimize)
+{
+	grid_data data;
+	const auto& format = gfx::mesh_vertex::get_layout();
+
+	while(state.keep_running())
+	{
+		mesh m;
+		m.prepare_mesh(format, data.vertices.data(), data.vertex_count, data.faces, false, true, true);
+		bench::do_not_optimize(m);
+	}
+	state.set_items_processed(state.get_iterations() * data.faces.size());
+}
+
+BENCHMARK(mesh_end_prepare)
+{
+	grid_data data;
+	const auto& format = gfx::mesh_vertex::get_layout();
+
+	while(state.keep_running())
+	{
+		mesh m;
+		m.prepare_mesh(format, data.vertices.data(), data.vertex_count, data.faces, false, false, false);
+		bench::do_not_optimize(m);
+	}
+	state.set_items_processed(state.get_iterations() * data.faces.size());
+}
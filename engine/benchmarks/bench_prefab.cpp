@@ -0,0 +1,146 @@
+#include "benchmark.h"
+
+#include <core/filesystem/filesystem.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/constructs/prefab.h>
+#include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/ecs.h>
+// pulls in the cereal registrations of all serializable types
+#include <runtime/meta/meta.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t instance_count = 500;
+constexpr std::size_t child_count = 8;
+
+// A root with a row of children.
+runtime::entity create_hierarchy()
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	auto root = ecs.create();
+	root.set_name("root");
+	root.assign<transform_component>();
+	for(std::size_t i = 0; i < child_count; ++i)
+	{
+		auto child = ecs.create();
+		child.set_name("child_" + std::to_string(i));
+		auto transform = child.assign<transform_component>().lock();
+		transform->set_parent(root);
+		transform->set_local_position({float(i), 0.0f, 0.0f});
+	}
+	return root;
+}
+
+// The hierarchy saved the way the editor saves prefabs.
+std::shared_ptr<std::istream> create_prefab_data()
+{
+	auto root = create_hierarchy();
+
+	fs::error_code err;
+	const auto path = fs::temp_directory_path(err) / "ethereal_benchmarks_prefab.pfb";
+	ecs::utils::save_entity_to_file(path, root);
+	root.destroy();
+
+	std::ifstream file(path.string(), std::fstream::binary);
+	auto data = std::make_shared<std::stringstream>();
+	*data << file.rdbuf();
+	file.close();
+	fs::remove(path, err);
+	return data;
+}
+
+void destroy_entities(std::vector<runtime::entity>& entities)
+{
+	for(auto& e : entities)
+	{
+		e.destroy();
+	}
+	entities.clear();
+}
+}
+
+BENCHMARK(prefab_instantiate_parsed)
+{
+	auto data = create_prefab_data();
+
+	std::vector<runtime::entity> roots;
+	roots.reserve(instance_count);
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < instance_count; ++i)
+		{
+			std::vector<runtime::entity> out_data;
+			ecs::utils::deserialize_data(*data, out_data);
+			roots.push_back(out_data.front());
+		}
+
+		state.pause_timing();
+		destroy_entities(roots);
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * instance_count);
+}
+
+BENCHMARK(prefab_instantiate_compiled)
+{
+	prefab pfab;
+	pfab.data = create_prefab_data();
+	// compile the template outside of the measurement
+	auto roots = pfab.instantiate(1);
+	destroy_entities(roots);
+
+	while(state.keep_running())
+	{
+		roots = pfab.instantiate(instance_count);
+
+		state.pause_timing();
+		destroy_entities(roots);
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * instance_count);
+}
+
+BENCHMARK(clone_entity_each)
+{
+	auto original = create_hierarchy();
+
+	std::vector<runtime::entity> roots;
+	roots.reserve(instance_count);
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < instance_count; ++i)
+		{
+			roots.push_back(ecs::utils::clone_entity(original));
+		}
+
+		state.pause_timing();
+		destroy_entities(roots);
+		state.resume_timing();
+	}
+	original.destroy();
+	state.set_items_processed(state.get_iterations() * instance_count);
+}
+
+BENCHMARK(clone_entities_batch)
+{
+	auto original = create_hierarchy();
+
+	std::vector<runtime::entity> roots;
+	while(state.keep_running())
+	{
+		roots = ecs::utils::clone_entities(original, instance_count);
+
+		state.pause_timing();
+		destroy_entities(roots);
+		state.resume_timing();
+	}
+	original.destroy();
+	state.set_items_processed(state.get_iterations() * instance_count);
+}
@@ -0,0 +1,171 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/graphics/render_graph.h>
+
+#include <array>
+#include <vector>
+
+namespace
+{
+using resource_id = gfx::render_graph::resource_id;
+
+gfx::render_graph::texture_desc get_desc(std::uint16_t size, gfx::texture_format format)
+{
+	gfx::render_graph::texture_desc desc;
+	desc.width = size;
+	desc.height = size;
+	desc.format = format;
+	return desc;
+}
+
+struct view
+{
+	/// Targets of the g-buffer pass.
+	std::array<resource_id, 5> g_buffer;
+	/// Target of the light pass.
+	resource_id light = 0;
+	/// Target of the overlay pass, nothing reads it.
+	resource_id overlay = 0;
+	/// The passes in declaration order.
+	std::array<gfx::render_graph::pass_id, 4> passes;
+};
+
+// Same shape as the deferred renderer, without executing anything, plus an
+// overlay pass that compile culls.
+view add_view(gfx::render_graph& graph, std::uint16_t size, resource_id output)
+{
+	view v;
+	v.passes[0] = graph.add_pass("g_buffer_fill",
+								 [&](gfx::render_graph::builder& builder) {
+									 for(std::size_t i = 0; i < 4; ++i)
+									 {
+										 const auto desc = get_desc(size, gfx::texture_format::RGBA8);
+										 v.g_buffer[i] = builder.write(builder.create("GBUFFER", desc));
+									 }
+									 const auto desc = get_desc(size, gfx::texture_format::D24);
+									 v.g_buffer[4] = builder.write(builder.create("DEPTH", desc));
+								 },
+								 nullptr);
+	v.passes[1] = graph.add_pass("light_buffer_fill",
+								 [&](gfx::render_graph::builder& builder) {
+									 for(auto id : v.g_buffer)
+									 {
+										 builder.read(id);
+									 }
+									 const auto desc = get_desc(size, gfx::texture_format::RGBA16F);
+									 v.light = builder.write(builder.create("LBUFFER", desc));
+								 },
+								 nullptr);
+	v.passes[2] = graph.add_pass("output_buffer_fill",
+								 [&](gfx::render_graph::builder& builder) {
+									 builder.read(v.light);
+									 builder.write(output);
+								 },
+								 nullptr);
+	v.passes[3] = graph.add_pass("overlay_fill",
+								 [&](gfx::render_graph::builder& builder) {
+									 builder.read(v.light);
+									 const auto desc = get_desc(size, gfx::texture_format::RGBA8);
+									 v.overlay = builder.write(builder.create("OVERLAY", desc));
+								 },
+								 nullptr);
+	return v;
+}
+
+std::vector<view> add_views(gfx::render_graph& graph)
+{
+	std::vector<view> views;
+	for(std::size_t face = 0; face < 6 * 6; ++face)
+	{
+		views.emplace_back(add_view(graph, 256, graph.import_texture("CUBEMAP", nullptr)));
+	}
+	for(std::size_t camera = 0; camera < 2; ++camera)
+	{
+		views.emplace_back(add_view(graph, 1024, graph.import_texture("OUTPUT", nullptr)));
+	}
+	return views;
+}
+
+bool overlaps(const gfx::render_graph& graph, resource_id lhs, resource_id rhs)
+{
+	return graph.get_first_pass(lhs) <= graph.get_last_pass(rhs) &&
+		   graph.get_first_pass(rhs) <= graph.get_last_pass(lhs);
+}
+
+void check_graph(const gfx::render_graph& graph, const std::vector<view>& views)
+{
+	constexpr auto invalid_index = gfx::render_graph::invalid_index;
+	for(const auto& v : views)
+	{
+		// Only the overlay pass is culled, its target is never allocated.
+		ensures(!graph.is_culled(v.passes[0]));
+		ensures(!graph.is_culled(v.passes[1]));
+		ensures(!graph.is_culled(v.passes[2]));
+		ensures(graph.is_culled(v.passes[3]));
+		ensures(graph.get_physical_index(v.overlay) == invalid_index);
+		ensures(graph.get_first_pass(v.overlay) == invalid_index);
+
+		for(auto id : v.g_buffer)
+		{
+			ensures(graph.get_first_pass(id) == v.passes[0]);
+			ensures(graph.get_last_pass(id) == v.passes[1]);
+		}
+		ensures(graph.get_first_pass(v.light) == v.passes[1]);
+		ensures(graph.get_last_pass(v.light) == v.passes[2]);
+	}
+
+	// Resources sharing a texture match it and are never alive together.
+	const auto count = resource_id(graph.get_resource_count());
+	for(resource_id lhs = 0; lhs < count; ++lhs)
+	{
+		const auto physical = graph.get_physical_index(lhs);
+		if(physical == invalid_index)
+		{
+			continue;
+		}
+		for(resource_id rhs = lhs + 1; rhs < count; ++rhs)
+		{
+			if(graph.get_physical_index(rhs) == physical)
+			{
+				ensures(!overlaps(graph, lhs, rhs));
+			}
+		}
+	}
+
+	// The views run one after the other, so all of them reuse the six
+	// textures of the first view of their size.
+	ensures(graph.get_physical_count() == 2 * 6);
+	for(std::size_t i = 0; i < views.size(); ++i)
+	{
+		const auto& first = i < 6 * 6 ? views.front() : views[6 * 6];
+		for(std::size_t target = 0; target < views[i].g_buffer.size(); ++target)
+		{
+			ensures(graph.get_physical_index(views[i].g_buffer[target]) ==
+					graph.get_physical_index(first.g_buffer[target]));
+		}
+		ensures(graph.get_physical_index(views[i].light) == graph.get_physical_index(first.light));
+	}
+	ensures(graph.get_transient_memory() < graph.get_unaliased_memory());
+}
+}
+
+BENCHMARK(render_graph_compile_probes_and_cameras)
+{
+	{
+		gfx::render_graph graph;
+		const auto views = add_views(graph);
+		graph.compile();
+		check_graph(graph, views);
+	}
+
+	std::uint64_t transient = 0;
+	while(state.keep_running())
+	{
+		gfx::render_graph graph;
+		add_views(graph);
+		graph.compile();
+		transient += graph.get_transient_memory();
+	}
+	bench::do_not_optimize(transient);
+}
@@ -0,0 +1,69 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/system/subsystem.h>
+
+#include <runtime/rendering/renderer.h>
+
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t commands_per_frame = 1024;
+
+void check_recording(runtime::renderer& rend)
+{
+	std::vector<int> executed;
+	std::thread::id executed_on;
+	for(int i = 0; i < 64; ++i)
+	{
+		rend.record([&executed, i]() { executed.push_back(i); });
+	}
+	rend.record([&executed_on]() { executed_on = std::this_thread::get_id(); });
+
+	// With a render thread the commands wait for the end of the frame.
+	ensures(!rend.has_render_thread() || executed.empty());
+
+	const auto frame = rend.get_render_frame();
+	rend.frame_end(delta_t::zero());
+	rend.flush();
+
+	std::vector<int> expected(64);
+	std::iota(expected.begin(), expected.end(), 0);
+	ensures(executed == expected);
+	ensures(rend.has_render_thread() == (executed_on != std::this_thread::get_id()));
+	ensures(rend.get_render_frame() > frame);
+
+	// Runs right away, on the thread calling the bgfx api.
+	std::thread::id ran_on;
+	rend.run_on_render_thread([&ran_on]() { ran_on = std::this_thread::get_id(); });
+	ensures(ran_on == executed_on);
+}
+}
+
+BENCHMARK(renderer_frame)
+{
+	auto& rend = core::get_subsystem<runtime::renderer>();
+	check_recording(rend);
+
+	// Written on the render thread, read after the flush.
+	std::uint64_t executed = 0;
+	std::uint64_t frames = 0;
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < commands_per_frame; ++i)
+		{
+			rend.record([&executed]() { ++executed; });
+		}
+		rend.frame_end(delta_t::zero());
+		++frames;
+	}
+	rend.flush();
+	ensures(executed == frames * commands_per_frame);
+
+	bench::do_not_optimize(executed);
+	state.set_items_processed(state.get_iterations() * commands_per_frame);
+}
@@ -0,0 +1,123 @@
+#include "benchmark.h"
+
+#include <core/filesystem/filesystem.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/constructs/binary_scene.h>
+#include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/ecs.h>
+// pulls in the cereal registrations of all serializable types
+#include <runtime/meta/meta.h>
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t entity_count = 1000;
+
+std::vector<runtime::entity> create_entities()
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	std::vector<runtime::entity> entities;
+	entities.reserve(entity_count);
+	for(std::size_t i = 0; i < entity_count; ++i)
+	{
+		auto e = ecs.create();
+		e.set_name("entity_" + std::to_string(i));
+		auto transform = e.assign<transform_component>().lock();
+		transform->set_local_position({float(i), 0.0f, 0.0f});
+		entities.emplace_back(e);
+	}
+	return entities;
+}
+
+void destroy_entities(std::vector<runtime::entity>& entities)
+{
+	for(auto& e : entities)
+	{
+		e.destroy();
+	}
+	entities.clear();
+}
+
+fs::path get_temp_file()
+{
+	fs::error_code err;
+	return fs::temp_directory_path(err) / "ethereal_benchmarks_entities.bin";
+}
+}
+
+BENCHMARK(serialization_save_entities)
+{
+	const auto path = get_temp_file();
+	auto entities = create_entities();
+
+	while(state.keep_running())
+	{
+		ecs::utils::save_entities_to_file(path, entities);
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+
+	destroy_entities(entities);
+	fs::error_code err;
+	fs::remove(path, err);
+}
+
+BENCHMARK(serialization_load_entities)
+{
+	const auto path = get_temp_file();
+	auto entities = create_entities();
+	ecs::utils::save_entities_to_file(path, entities);
+	destroy_entities(entities);
+
+	std::vector<runtime::entity> loaded;
+	while(state.keep_running())
+	{
+		ecs::utils::load_entities_from_file(path, loaded);
+
+		state.pause_timing();
+		destroy_entities(loaded);
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+
+	fs::error_code err;
+	fs::remove(path, err);
+}
+
+BENCHMARK(serialization_save_entities_binary)
+{
+	auto entities = create_entities();
+
+	std::stringstream stream;
+	while(state.keep_running())
+	{
+		stream.str(std::string());
+		ecs::binary_scene::save(stream, entities);
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+
+	destroy_entities(entities);
+}
+
+BENCHMARK(serialization_load_entities_binary)
+{
+	auto entities = create_entities();
+	std::stringstream stream;
+	ecs::binary_scene::save(stream, entities);
+	destroy_entities(entities);
+
+	std::vector<runtime::entity> loaded;
+	while(state.keep_running())
+	{
+		ecs::utils::deserialize_data(stream, loaded);
+
+		state.pause_timing();
+		destroy_entities(loaded);
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * entity_count);
+}
@@ -0,0 +1,141 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+
+#include <runtime/rendering/shadow_atlas.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t atlas_size = 2048;
+constexpr std::uint32_t min_size = 64;
+
+// Maps of every size that cover the atlas exactly, taking turns between the
+// sizes so large and small ones end up next to each other.
+std::vector<std::uint32_t> get_mixed_sizes()
+{
+	std::array<std::vector<std::uint32_t>, 5> classes{{std::vector<std::uint32_t>(1, 1024),
+													   std::vector<std::uint32_t>(4, 512),
+													   std::vector<std::uint32_t>(12, 256),
+													   std::vector<std::uint32_t>(48, 128),
+													   std::vector<std::uint32_t>(128, 64)}};
+	std::vector<std::uint32_t> sizes;
+	bool added = true;
+	while(added)
+	{
+		added = false;
+		for(auto& sizes_of_class : classes)
+		{
+			if(!sizes_of_class.empty())
+			{
+				sizes.push_back(sizes_of_class.back());
+				sizes_of_class.pop_back();
+				added = true;
+			}
+		}
+	}
+	return sizes;
+}
+
+bool overlaps(const urect32_t& lhs, const urect32_t& rhs)
+{
+	return lhs.left < rhs.right && rhs.left < lhs.right && lhs.top < rhs.bottom && rhs.top < lhs.bottom;
+}
+
+void allocate_all(shadow_atlas& atlas, const std::vector<std::uint32_t>& sizes,
+				  std::vector<shadow_atlas::handle>& handles)
+{
+	handles.clear();
+	for(const auto size : sizes)
+	{
+		handles.push_back(atlas.allocate(size));
+	}
+}
+
+// Every other map first, then the rest.
+void free_interleaved(shadow_atlas& atlas, const std::vector<shadow_atlas::handle>& handles)
+{
+	for(std::size_t i = 0; i < handles.size(); i += 2)
+	{
+		atlas.free(handles[i]);
+	}
+	for(std::size_t i = 1; i < handles.size(); i += 2)
+	{
+		atlas.free(handles[i]);
+	}
+}
+
+void check_atlas(const std::vector<std::uint32_t>& sizes)
+{
+	shadow_atlas atlas(atlas_size, min_size);
+	ensures(atlas.fit_size(1) == min_size);
+	ensures(atlas.fit_size(300) == 512);
+	ensures(atlas.fit_size(atlas_size * 2) == atlas_size);
+
+	std::vector<shadow_atlas::handle> handles;
+	allocate_all(atlas, sizes, handles);
+	for(std::size_t i = 0; i < handles.size(); ++i)
+	{
+		ensures(handles[i] != shadow_atlas::invalid_handle);
+		const auto rect = atlas.get_rect(handles[i]);
+		ensures(rect.width() == sizes[i] && rect.height() == sizes[i]);
+		ensures(rect.right <= atlas_size && rect.bottom <= atlas_size);
+		for(std::size_t j = 0; j < i; ++j)
+		{
+			ensures(!overlaps(rect, atlas.get_rect(handles[j])));
+		}
+	}
+	ensures(atlas.get_used_area() == std::uint64_t(atlas_size) * atlas_size);
+
+	// The atlas is full, even the smallest map is refused.
+	ensures(atlas.allocate(min_size) == shadow_atlas::invalid_handle);
+
+	// Half of the maps are spread all over, nothing large fits in between.
+	for(std::size_t i = 0; i < handles.size(); i += 2)
+	{
+		atlas.free(handles[i]);
+	}
+	ensures(atlas.get_used_area() > 0);
+	ensures(atlas.allocate(atlas_size) == shadow_atlas::invalid_handle);
+
+	// Freeing the rest merges everything back into one square.
+	for(std::size_t i = 1; i < handles.size(); i += 2)
+	{
+		atlas.free(handles[i]);
+	}
+	ensures(atlas.get_used_area() == 0);
+	const auto whole = atlas.allocate(atlas_size);
+	ensures(whole != shadow_atlas::invalid_handle);
+	const auto rect = atlas.get_rect(whole);
+	ensures(rect.left == 0 && rect.top == 0 && rect.width() == atlas_size);
+	ensures(atlas.allocate(min_size) == shadow_atlas::invalid_handle);
+
+	// A freed square can be split up again.
+	atlas.free(whole);
+	allocate_all(atlas, sizes, handles);
+	for(const auto h : handles)
+	{
+		ensures(h != shadow_atlas::invalid_handle);
+	}
+}
+}
+
+BENCHMARK(shadow_atlas_churn)
+{
+	const auto sizes = get_mixed_sizes();
+	check_atlas(sizes);
+
+	shadow_atlas atlas(atlas_size, min_size);
+	std::vector<shadow_atlas::handle> handles;
+	handles.reserve(sizes.size());
+	while(state.keep_running())
+	{
+		allocate_all(atlas, sizes, handles);
+		free_interleaved(atlas, handles);
+	}
+	bench::do_not_optimize(handles.data());
+	state.set_items_processed(state.get_iterations() * sizes.size());
+}
@@ -0,0 +1,34 @@
+#include "benchmark.h"
+
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <vector>
+
+namespace
+{
+constexpr std::size_t task_count = 10000;
+}
+
+BENCHMARK(task_system_push_wait)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+
+	std::vector<core::task_future<int>> tasks;
+	tasks.reserve(task_count);
+	while(state.keep_running())
+	{
+		for(std::size_t i = 0; i < task_count; ++i)
+		{
+			tasks.emplace_back(ts.push_on_worker_thread([i]() { return int(i & 0xff); }));
+		}
+		int sum = 0;
+		for(auto& task : tasks)
+		{
+			sum += task.get();
+		}
+		bench::do_not_optimize(sum);
+		tasks.clear();
+	}
+	state.set_items_processed(state.get_iterations() * task_count);
+}
@@ -0,0 +1,216 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+
+#include <runtime/rendering/texture_residency.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t texture_count = 4096;
+constexpr std::uint64_t tail_size = 64 * 1024;
+constexpr std::uint64_t budget = 512ull * 1024 * 1024;
+
+std::vector<runtime::texture_residency::item> make_items()
+{
+	namespace residency = runtime::texture_residency;
+
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> size_shift(8, 12);
+	std::uniform_real_distribution<float> distance(1.0f, 200.0f);
+	std::uniform_int_distribution<int> visible(0, 3);
+
+	std::vector<residency::item> items;
+	items.reserve(texture_count);
+	for(std::size_t i = 0; i < texture_count; ++i)
+	{
+		const auto size = static_cast<std::uint16_t>(1 << size_shift(rng));
+		residency::item item;
+		item.info = runtime::streamed_texture::make_header(size, size, 4, 0);
+		item.tail = residency::get_tail_mip(item.info, tail_size);
+		item.resident = item.tail;
+		item.wanted = item.tail;
+
+		// A quarter of the textures is off screen.
+		if(visible(rng) != 0)
+		{
+			const float pixels = residency::get_screen_size(1.0f, distance(rng), 0.577f, 1080.0f);
+			item.wanted = residency::select_mip(item.info, pixels);
+			item.priority = pixels;
+			item.last_visible = 1;
+		}
+		items.emplace_back(item);
+	}
+	return items;
+}
+
+runtime::texture_residency::item make_item(std::uint16_t size, float priority, std::uint64_t last_visible)
+{
+	namespace residency = runtime::texture_residency;
+
+	residency::item item;
+	item.info = runtime::streamed_texture::make_header(size, size, 4, 0);
+	item.tail = residency::get_tail_mip(item.info, tail_size);
+	item.resident = item.tail;
+	item.wanted = priority > 0.0f ? 0 : item.tail;
+	item.priority = priority;
+	item.last_visible = last_visible;
+	return item;
+}
+
+std::uint64_t get_tails_size(const std::vector<runtime::texture_residency::item>& items)
+{
+	std::uint64_t size = 0;
+	for(const auto& i : items)
+	{
+		size += runtime::streamed_texture::get_resident_size(i.info, i.tail);
+	}
+	return size;
+}
+
+void check_select_mip()
+{
+	namespace residency = runtime::texture_residency;
+
+	// The first mip with at least as many texels across as the screen needs.
+	const auto info = runtime::streamed_texture::make_header(1024, 1024, 4, 0);
+	const auto last = std::uint32_t(info.mips) - 1;
+	ensures(residency::select_mip(info, 4096.0f) == 0);
+	ensures(residency::select_mip(info, 1024.0f) == 0);
+	ensures(residency::select_mip(info, 1023.0f) == 0);
+	ensures(residency::select_mip(info, 512.0f) == 1);
+	ensures(residency::select_mip(info, 1.0f) == last);
+	ensures(residency::select_mip(info, 0.0f) == last);
+
+	std::uint32_t previous = 0;
+	for(float texels = 1024.0f; texels >= 1.0f; texels *= 0.9f)
+	{
+		const auto mip = residency::select_mip(info, texels);
+		ensures(mip >= previous && mip <= last);
+		ensures(float(1024u >> mip) >= texels);
+		ensures(mip == last || float(1024u >> (mip + 1)) < texels);
+		previous = mip;
+	}
+}
+
+void check_get_tail_mip()
+{
+	namespace residency = runtime::texture_residency;
+
+	// The largest tail within the size, a small texture is all tail.
+	for(int shift = 0; shift <= 13; ++shift)
+	{
+		const auto size = static_cast<std::uint16_t>(1 << shift);
+		const auto info = runtime::streamed_texture::make_header(size, size, 4, 0);
+		const auto tail = residency::get_tail_mip(info, tail_size);
+		ensures(tail < info.mips);
+		ensures(tail == std::uint32_t(info.mips) - 1 ||
+				runtime::streamed_texture::get_resident_size(info, tail) <= tail_size);
+		ensures(tail == 0 || runtime::streamed_texture::get_resident_size(info, tail - 1) > tail_size);
+	}
+
+	const auto small = runtime::streamed_texture::make_header(64, 64, 4, 0);
+	ensures(residency::get_tail_mip(small, tail_size) == 0);
+	const auto single = runtime::streamed_texture::make_header(1, 1, 4, 0);
+	ensures(residency::get_tail_mip(single, 0) == 0);
+}
+
+void check_plan(const std::vector<runtime::texture_residency::item>& source)
+{
+	namespace residency = runtime::texture_residency;
+	namespace streamed = runtime::streamed_texture;
+
+	// The budget is respected, the tails are kept and nothing beyond what is
+	// wanted or resident is loaded.
+	const auto tails = get_tails_size(source);
+	for(const auto plan_budget : {std::uint64_t(0), tails + 1024 * 1024, budget})
+	{
+		auto items = source;
+		const auto used = residency::plan(items, plan_budget);
+
+		std::uint64_t targets = 0;
+		for(const auto& i : items)
+		{
+			ensures(i.target <= i.tail);
+			ensures(i.target >= std::min(i.wanted, i.resident));
+			targets += streamed::get_resident_size(i.info, i.target);
+		}
+		ensures(used == targets);
+		ensures(used <= std::max(plan_budget, tails));
+	}
+
+	// Equal textures get their mips in the order of their screen pixels.
+	{
+		std::vector<residency::item> items;
+		for(int i = 0; i < 8; ++i)
+		{
+			items.push_back(make_item(1024, float(10 + i * 10), 1));
+		}
+		const auto full = streamed::get_resident_size(items.front().info, 0);
+		const auto tail = streamed::get_resident_size(items.front().info, items.front().tail);
+		residency::plan(items, get_tails_size(items) + 3 * (full - tail));
+		for(std::size_t i = 1; i < items.size(); ++i)
+		{
+			ensures(items[i].target <= items[i - 1].target);
+		}
+		ensures(items.back().target == 0);
+		ensures(items.front().target > items.back().target);
+	}
+
+	// The next level goes to the most screen pixels per byte.
+	{
+		std::vector<residency::item> items{make_item(1024, 100.0f, 1), make_item(1024, 10.0f, 1)};
+		const auto tail = items.front().tail;
+		residency::plan(items, get_tails_size(items) + streamed::get_mip_size(items.front().info, tail - 1));
+		ensures(items[0].target == tail - 1);
+		ensures(items[1].target == tail);
+	}
+
+	// Mips no longer wanted stay while there is room, the most recently
+	// visible first, and are evicted under pressure.
+	{
+		std::vector<residency::item> items{make_item(1024, 0.0f, 3), make_item(1024, 0.0f, 5)};
+		for(auto& i : items)
+		{
+			i.resident = 0;
+		}
+		const auto full = streamed::get_resident_size(items.front().info, 0);
+		const auto tail = streamed::get_resident_size(items.front().info, items.front().tail);
+
+		auto kept = items;
+		residency::plan(kept, 2 * full);
+		ensures(kept[0].target == 0 && kept[1].target == 0);
+
+		auto recent = items;
+		residency::plan(recent, get_tails_size(items) + full - tail);
+		ensures(recent[1].target == 0);
+		ensures(recent[0].target == recent[0].tail);
+
+		auto evicted = items;
+		residency::plan(evicted, 0);
+		ensures(evicted[0].target == evicted[0].tail && evicted[1].target == evicted[1].tail);
+	}
+}
+}
+
+BENCHMARK(texture_residency_plan)
+{
+	check_select_mip();
+	check_get_tail_mip();
+
+	const auto source = make_items();
+	check_plan(source);
+
+	std::uint64_t used = 0;
+	auto items = source;
+	while(state.keep_running())
+	{
+		items = source;
+		used += runtime::texture_residency::plan(items, budget);
+	}
+	bench::do_not_optimize(used);
+	state.set_items_processed(state.get_iterations() * texture_count);
+}
@@ -0,0 +1,74 @@
+#include "benchmark.h"
+
+#include <core/system/subsystem.h>
+
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/ecs.h>
+
+#include <vector>
+
+namespace
+{
+constexpr std::size_t children_per_node = 8;
+constexpr std::size_t depth = 4;
+
+void build_hierarchy(runtime::entity_component_system& ecs, runtime::entity parent, std::size_t level,
+					 std::vector<runtime::entity>& entities, std::vector<runtime::entity>& leaves)
+{
+	for(std::size_t i = 0; i < children_per_node; ++i)
+	{
+		auto e = ecs.create();
+		auto transform = e.assign<transform_component>().lock();
+		transform->set_local_position({float(i), float(level), 0.0f});
+		transform->set_parent(parent);
+		entities.emplace_back(e);
+
+		if(level + 1 < depth)
+		{
+			build_hierarchy(ecs, e, level + 1, entities, leaves);
+		}
+		else
+		{
+			leaves.emplace_back(e);
+		}
+	}
+}
+}
+
+BENCHMARK(transform_hierarchy_resolve)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	std::vector<runtime::entity> entities;
+	std::vector<runtime::entity> leaves;
+	auto root = ecs.create();
+	auto root_transform = root.assign<transform_component>().lock();
+	entities.emplace_back(root);
+	build_hierarchy(ecs, root, 0, entities, leaves);
+
+	std::vector<std::shared_ptr<transform_component>> leaf_transforms;
+	for(auto& e : leaves)
+	{
+		leaf_transforms.emplace_back(e.get_component<transform_component>().lock());
+	}
+
+	float x = 0.0f;
+	while(state.keep_running())
+	{
+		// moving the root dirties the whole hierarchy
+		x = x > 0.0f ? 0.0f : 1.0f;
+		root_transform->set_local_position({x, 0.0f, 0.0f});
+		for(auto& transform : leaf_transforms)
+		{
+			bench::do_not_optimize(transform->get_transform());
+		}
+	}
+	state.set_items_processed(state.get_iterations() * entities.size());
+
+	leaf_transforms.clear();
+	root_transform.reset();
+	for(auto it = entities.rbegin(); it != entities.rend(); ++it)
+	{
+		it->destroy();
+	}
+}
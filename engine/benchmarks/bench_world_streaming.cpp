@@ -0,0 +1,191 @@
+#include "benchmark.h"
+
+#include <core/common/assert.hpp>
+#include <core/filesystem/filesystem.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_manager.h>
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/constructs/binary_scene.h>
+#include <runtime/ecs/constructs/scene.h>
+#include <runtime/ecs/constructs/world_layout.h>
+#include <runtime/ecs/ecs.h>
+#include <runtime/ecs/systems/world_streaming.h>
+// pulls in the cereal registrations of all serializable types
+#include <runtime/meta/meta.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::int32_t grid_size = 8;
+constexpr float cell_size = 64.0f;
+constexpr float radius = 80.0f;
+constexpr std::size_t child_count = 63;
+constexpr std::size_t entities_per_cell = child_count + 1;
+constexpr std::size_t instantiate_budget = 48;
+constexpr std::size_t settle_frames = 512;
+
+// A cell holding a root with a row of children, in the binary format.
+std::string create_cell_data()
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	auto root = ecs.create();
+	root.assign<transform_component>();
+	for(std::size_t i = 0; i < child_count; ++i)
+	{
+		auto child = ecs.create();
+		auto transform = child.assign<transform_component>().lock();
+		transform->set_parent(root);
+		transform->set_local_position({float(i), 0.0f, 0.0f});
+	}
+
+	std::ostringstream stream;
+	ecs::binary_scene::save(stream, {root});
+	root.destroy();
+	return stream.str();
+}
+
+// A square grid of cells all holding the same scene.
+std::string create_layout()
+{
+	world_layout layout;
+	layout.cell_size = cell_size;
+	for(std::int32_t z = 0; z < grid_size; ++z)
+	{
+		for(std::int32_t x = 0; x < grid_size; ++x)
+		{
+			world_cell cell;
+			cell.x = x;
+			cell.z = z;
+			cell.scene = "benchmarks:/cell_" + std::to_string(x) + "_" + std::to_string(z) + ".sc";
+			layout.cells.emplace_back(cell);
+		}
+	}
+
+	fs::error_code err;
+	fs::add_path_protocol("benchmarks:", fs::temp_directory_path(err));
+	const std::string key = "benchmarks:/ethereal_benchmarks_world.layout";
+	ecs::utils::save_world_layout_to_file(fs::resolve_protocol(key), layout);
+	return key;
+}
+
+// Scenes are made from the cell data instead of read from the disk.
+void setup_scene_storage(const std::string& cell_data)
+{
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	auto& storage = am.add_storage<scene>();
+	storage.load_from_file = [cell_data](core::task_future<asset_handle<scene>>& output,
+										 const std::string& key) {
+		auto& ts = core::get_subsystem<core::task_system>();
+		output = ts.push_or_execute_on_owner_thread([cell_data, key]() {
+			asset_handle<scene> result;
+			auto sc = std::make_shared<scene>();
+			sc->data = std::make_shared<std::istringstream>(cell_data);
+			result.link->id = key;
+			result.link->asset = sc;
+			return result;
+		});
+		return true;
+	};
+}
+
+std::size_t get_wanted_cells(const math::vec3& position)
+{
+	world_layout layout;
+	layout.cell_size = cell_size;
+	std::size_t count = 0;
+	for(std::int32_t z = 0; z < grid_size; ++z)
+	{
+		for(std::int32_t x = 0; x < grid_size; ++x)
+		{
+			world_cell cell;
+			cell.x = x;
+			cell.z = z;
+			count += layout.get_distance(cell, position) <= radius ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+void settle(runtime::world_streaming& streaming)
+{
+	for(std::size_t i = 0; i < settle_frames; ++i)
+	{
+		streaming.frame_update(delta_t::zero());
+	}
+}
+
+void check_streaming(runtime::world_streaming& streaming)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	const auto base = ecs.size();
+
+	// The entities of a cell are created within the budget, a frame at a time.
+	const math::vec3 near{cell_size * 0.5f, 0.0f, cell_size * 0.5f};
+	const auto source = streaming.add_source(near, radius);
+	for(std::size_t i = 0; i < 4; ++i)
+	{
+		const auto before = ecs.size();
+		streaming.frame_update(delta_t::zero());
+		ensures(ecs.size() - before <= instantiate_budget);
+	}
+
+	settle(streaming);
+	const auto near_cells = get_wanted_cells(near);
+	ensures(near_cells > 1 && near_cells < std::size_t(grid_size * grid_size));
+	ensures(streaming.get_loaded_cell_count() == near_cells);
+	ensures(ecs.size() == base + near_cells * entities_per_cell);
+
+	// Moving to the far corner unloads all of them and loads the ones there.
+	const math::vec3 far{cell_size * (grid_size - 0.5f), 0.0f, cell_size * (grid_size - 0.5f)};
+	streaming.set_source(source, far, radius);
+	settle(streaming);
+	const auto far_cells = get_wanted_cells(far);
+	ensures(streaming.get_loaded_cell_count() == far_cells);
+	ensures(ecs.size() == base + far_cells * entities_per_cell);
+
+	// Without a source nothing stays.
+	streaming.remove_source(source);
+	settle(streaming);
+	ensures(streaming.get_loaded_cell_count() == 0);
+	ensures(ecs.size() == base);
+}
+}
+
+BENCHMARK(world_streaming_move)
+{
+	setup_scene_storage(create_cell_data());
+	const auto key = create_layout();
+
+	runtime::world_streaming streaming;
+	streaming.set_budget(instantiate_budget, instantiate_budget * 2);
+	ensures(streaming.open(key));
+	check_streaming(streaming);
+
+	// The source travels along the diagonal of the grid and back.
+	const float length = cell_size * grid_size;
+	const auto source = streaming.add_source({0.0f, 0.0f, 0.0f}, radius);
+	std::uint64_t frame = 0;
+	while(state.keep_running())
+	{
+		const auto t = float(frame % 512) / 256.0f;
+		const auto along = (t < 1.0f ? t : 2.0f - t) * length;
+		streaming.set_source(source, {along, 0.0f, along}, radius);
+		streaming.frame_update(delta_t::zero());
+		++frame;
+	}
+	streaming.remove_source(source);
+	streaming.close();
+
+	fs::error_code err;
+	fs::remove(fs::resolve_protocol(key), err);
+
+	bench::do_not_optimize(frame);
+	state.set_items_processed(state.get_iterations());
+}
@@ -0,0 +1,220 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace bench
+{
+namespace
+{
+struct entry
+{
+	const char* name;
+	function_t fn;
+};
+
+std::vector<entry>& get_benchmarks()
+{
+	static std::vector<entry> benchmarks;
+	return benchmarks;
+}
+
+state run_once(const entry& e, std::uint64_t iterations)
+{
+	state st(iterations);
+	e.fn(st);
+	return st;
+}
+
+double get_ns_per_iteration(const state& st)
+{
+	const auto ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(st.get_elapsed());
+	return ns.count() / double(std::max<std::uint64_t>(1, st.get_iterations()));
+}
+
+double get_median(std::vector<double> samples)
+{
+	if(samples.empty())
+	{
+		return 0.0;
+	}
+	std::sort(std::begin(samples), std::end(samples));
+	return samples[samples.size() / 2];
+}
+
+void write_json_string(std::ostream& stream, const std::string& str)
+{
+	stream << '"';
+	for(const auto c : str)
+	{
+		if(c == '"' || c == '\\')
+		{
+			stream << '\\';
+		}
+		stream << c;
+	}
+	stream << '"';
+}
+}
+
+state::state(std::uint64_t iterations)
+	: iterations_(iterations)
+	, remaining_(iterations)
+{
+}
+
+bool state::keep_running()
+{
+	if(!started_)
+	{
+		started_ = true;
+		resume_timing();
+	}
+
+	if(remaining_ == 0)
+	{
+		pause_timing();
+		return false;
+	}
+
+	--remaining_;
+	return true;
+}
+
+void state::pause_timing()
+{
+	if(running_)
+	{
+		elapsed_ += clock_t::now() - start_;
+		running_ = false;
+	}
+}
+
+void state::resume_timing()
+{
+	if(!running_)
+	{
+		running_ = true;
+		start_ = clock_t::now();
+	}
+}
+
+bool register_benchmark(const char* name, function_t fn)
+{
+	get_benchmarks().push_back({name, std::move(fn)});
+	return true;
+}
+
+std::vector<result> run_benchmarks(const options& opts)
+{
+	auto benchmarks = get_benchmarks();
+	// registration order depends on the link order, keep the output stable
+	std::sort(std::begin(benchmarks), std::end(benchmarks),
+			  [](const auto& lhs, const auto& rhs) { return std::string(lhs.name) < rhs.name; });
+
+	std::vector<result> results;
+	for(const auto& e : benchmarks)
+	{
+		if(!opts.filter.empty() && std::string(e.name).find(opts.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		// calibrate, growing the iteration count until a run takes long enough
+		std::uint64_t iterations = 1;
+		for(;;)
+		{
+			const auto st = run_once(e, iterations);
+			if(st.get_elapsed() >= opts.min_time || iterations >= (std::uint64_t(1) << 32))
+			{
+				break;
+			}
+
+			const auto elapsed = std::max<double>(1.0, double(st.get_elapsed().count()));
+			const auto target = double(state::clock_t::duration(opts.min_time).count());
+			const auto scale = std::min(10.0, std::max(1.5, 1.2 * target / elapsed));
+			iterations = std::max<std::uint64_t>(iterations + 1, std::uint64_t(double(iterations) * scale));
+		}
+
+		result r;
+		r.name = e.name;
+		r.iterations = iterations;
+
+		std::vector<double> items_per_second;
+		for(std::uint32_t i = 0; i < std::max<std::uint32_t>(1, opts.repetitions); ++i)
+		{
+			const auto st = run_once(e, iterations);
+			r.samples.emplace_back(get_ns_per_iteration(st));
+
+			const auto seconds = std::chrono::duration<double>(st.get_elapsed()).count();
+			if(st.get_items_processed() > 0 && seconds > 0.0)
+			{
+				items_per_second.emplace_back(double(st.get_items_processed()) / seconds);
+			}
+		}
+		r.items_per_second = get_median(items_per_second);
+
+		std::cout << std::left << std::setw(40) << r.name << std::right << std::setw(16) << std::fixed
+				  << std::setprecision(1) << get_median(r.samples) << " ns" << std::setw(12) << r.iterations
+				  << " it" << std::endl;
+
+		results.emplace_back(std::move(r));
+	}
+
+	return results;
+}
+
+void write_json(std::ostream& stream, const std::vector<result>& results)
+{
+	const auto now = std::time(nullptr);
+	char date[64] = {};
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	stream << std::setprecision(3) << std::fixed;
+	stream << "{\n";
+	stream << "\t\"context\": {\n";
+	stream << "\t\t\"date\": \"" << date << "\",\n";
+	stream << "\t\t\"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+	stream << "\t\t\"build_type\": \"release\"\n";
+#else
+	stream << "\t\t\"build_type\": \"debug\"\n";
+#endif
+	stream << "\t},\n";
+	stream << "\t\"benchmarks\": [";
+
+	bool first = true;
+	for(const auto& r : results)
+	{
+		auto sorted = r.samples;
+		std::sort(std::begin(sorted), std::end(sorted));
+		double mean = 0.0;
+		for(auto sample : sorted)
+		{
+			mean += sample;
+		}
+		mean /= double(std::max<std::size_t>(1, sorted.size()));
+
+		stream << (first ? "\n" : ",\n");
+		stream << "\t\t{\n";
+		stream << "\t\t\t\"name\": ";
+		write_json_string(stream, r.name);
+		stream << ",\n";
+		stream << "\t\t\t\"iterations\": " << r.iterations << ",\n";
+		stream << "\t\t\t\"repetitions\": " << r.samples.size() << ",\n";
+		stream << "\t\t\t\"ns_per_iteration\": {";
+		stream << "\"min\": " << (sorted.empty() ? 0.0 : sorted.front()) << ", ";
+		stream << "\"median\": " << get_median(sorted) << ", ";
+		stream << "\"mean\": " << mean << ", ";
+		stream << "\"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << "},\n";
+		stream << "\t\t\t\"items_per_second\": " << r.items_per_second << "\n";
+		stream << "\t\t}";
+		first = false;
+	}
+
+	stream << "\n\t]\n}\n";
+}
+}
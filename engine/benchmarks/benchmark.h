@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : state (Class)
+/// <summary>
+/// Passed to every benchmark function. Everything before the first call to
+/// keep_running is setup and is not timed. The timed loop is
+///
+///     while(state.keep_running()) { ... }
+///
+/// </summary>
+//-----------------------------------------------------------------------------
+class state
+{
+public:
+	using clock_t = std::chrono::high_resolution_clock;
+
+	explicit state(std::uint64_t iterations);
+
+	//-----------------------------------------------------------------------------
+	//  Name : keep_running ()
+	/// <summary>
+	/// Starts the timer on the first call and stops it once the requested
+	/// number of iterations was done.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool keep_running();
+
+	//-----------------------------------------------------------------------------
+	//  Name : pause_timing ()
+	/// <summary>
+	/// Excludes the following code from the measurement until resume_timing.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void pause_timing();
+	void resume_timing();
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_items_processed ()
+	/// <summary>
+	/// Total number of items processed by all iterations. Used to report
+	/// throughput.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline void set_items_processed(std::uint64_t items)
+	{
+		items_ = items;
+	}
+
+	inline std::uint64_t get_items_processed() const
+	{
+		return items_;
+	}
+
+	inline std::uint64_t get_iterations() const
+	{
+		return iterations_;
+	}
+
+	inline clock_t::duration get_elapsed() const
+	{
+		return elapsed_;
+	}
+
+private:
+	/// requested iterations
+	std::uint64_t iterations_ = 0;
+	/// iterations left
+	std::uint64_t remaining_ = 0;
+	/// items processed
+	std::uint64_t items_ = 0;
+	/// time measured so far
+	clock_t::duration elapsed_ = clock_t::duration::zero();
+	/// start of the current timed section
+	clock_t::time_point start_;
+	/// the loop was entered
+	bool started_ = false;
+	/// the timer is running
+	bool running_ = false;
+};
+
+using function_t = std::function<void(state&)>;
+
+struct result
+{
+	/// benchmark name
+	std::string name;
+	/// iterations per repetition
+	std::uint64_t iterations = 0;
+	/// nanoseconds per iteration of every repetition
+	std::vector<double> samples;
+	/// items per second of the median repetition, zero when not reported
+	double items_per_second = 0.0;
+};
+
+struct options
+{
+	/// only run benchmarks whose name contains this
+	std::string filter;
+	/// minimum time a repetition should take
+	std::chrono::milliseconds min_time{200};
+	/// number of measured repetitions
+	std::uint32_t repetitions = 5;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : register_benchmark ()
+/// <summary>
+/// Adds a benchmark to the global list. Use the BENCHMARK macro instead.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool register_benchmark(const char* name, function_t fn);
+
+//-----------------------------------------------------------------------------
+//  Name : run_benchmarks ()
+/// <summary>
+/// Runs all registered benchmarks matching the options. Each one is first
+/// calibrated to find an iteration count that takes at least min_time, then
+/// measured for the requested number of repetitions.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<result> run_benchmarks(const options& opts);
+
+//-----------------------------------------------------------------------------
+//  Name : write_json ()
+/// <summary>
+/// Writes the results in a machine readable form for trend tracking.
+/// </summary>
+//-----------------------------------------------------------------------------
+void write_json(std::ostream& stream, const std::vector<result>& results);
+
+//-----------------------------------------------------------------------------
+//  Name : do_not_optimize ()
+/// <summary>
+/// Keeps the compiler from discarding the computation of the value.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+	static const void* volatile sink = nullptr;
+	sink = &value;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+}
+
+#define BENCHMARK(name)                                                                                      \
+	static void name(bench::state& state);                                                                   \
+	static const bool name##_registered = bench::register_benchmark(#name, name);                            \
+	static void name(bench::state& state)
@@ -0,0 +1,88 @@
+#include "benchmark.h"
+
+#include <core/cmd_line/parser.hpp>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_manager.h>
+#include <runtime/ecs/ecs.h>
+#include <runtime/rendering/renderer.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	core::details::initialize();
+
+	auto logging_container = logging::get_mutable_logging_container();
+	logging_container->add_sink(std::make_shared<logging::sinks::platform_sink_mt>());
+	logging::create_async(APPLOG, logging_container);
+
+	cmd_line::parser parser(argc, argv);
+	parser.set_optional<std::string>("f", "filter", "", "Only run benchmarks containing this string.");
+	parser.set_optional<std::string>("o", "out", "", "File to write the json results to.");
+	parser.set_optional<unsigned int>("r", "repetitions", 5, "Measured repetitions per benchmark.");
+	parser.set_optional<unsigned int>("t", "min_time", 200, "Minimum duration of a repetition in ms.");
+	parser.set_optional<bool>("st", "single_thread", false, "Submit the frames without the render thread.");
+
+	std::stringstream out, err;
+	if(!parser.run(out, err))
+	{
+		std::cerr << out.str() << err.str() << std::endl;
+		core::details::dispose();
+		return 1;
+	}
+
+	bench::options opts;
+	std::string out_path;
+	unsigned int repetitions = opts.repetitions;
+	unsigned int min_time = static_cast<unsigned int>(opts.min_time.count());
+	parser.try_get("filter", opts.filter);
+	parser.try_get("out", out_path);
+	parser.try_get("repetitions", repetitions);
+	parser.try_get("min_time", min_time);
+	bool single_thread = false;
+	parser.try_get("single_thread", single_thread);
+	opts.repetitions = repetitions;
+	opts.min_time = std::chrono::milliseconds(min_time);
+
+	// nothing is drawn, but meshes and textures still go through bgfx, which
+	// runs headless like the runtime and submits on the render thread
+	std::vector<const char*> renderer_args{argv[0], "--headless"};
+	if(!single_thread)
+	{
+		renderer_args.emplace_back("--render_thread");
+	}
+	cmd_line::parser renderer_parser(static_cast<int>(renderer_args.size()), renderer_args.data());
+	renderer_parser.set_optional<bool>("hl", "headless", false, "Run on the Noop backend.");
+	renderer_parser.set_optional<bool>("rt", "render_thread", false, "Submit on the render thread.");
+	renderer_parser.run();
+	core::add_subsystem<runtime::renderer>(renderer_parser);
+
+	std::uint64_t frame = 0;
+	ecs::set_frame_getter([&frame]() { return frame; });
+
+	core::add_subsystem<core::task_system>(false);
+	core::add_subsystem<runtime::entity_component_system>();
+	core::add_subsystem<runtime::asset_manager>();
+
+	const auto results = bench::run_benchmarks(opts);
+
+	if(!out_path.empty())
+	{
+		std::ofstream stream{out_path, std::ios::out | std::ios::trunc};
+		bench::write_json(stream, results);
+	}
+	else
+	{
+		bench::write_json(std::cout, results);
+	}
+
+	core::details::dispose();
+
+	return 0;
+}
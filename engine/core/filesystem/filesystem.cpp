@@ -82,11 +82,17 @@ auto read_stream_into_container(std::basic_istream<CharT, Traits>& in,
 		throw std::ios_base::failure{"error"};
 	};
 
-	if(!in.ignore(std::numeric_limits<std::streamsize>::max()))
+	// Seek to the end for the size, ignoring would read the whole stream twice.
+	if(!in.seekg(0, std::ios::end))
 	{
 		throw std::ios_base::failure{"error"};
 	};
-	auto const char_count = in.gcount();
+	auto const end_pos = in.tellg();
+	if(std::streamsize(-1) == end_pos || end_pos < start_pos)
+	{
+		throw std::ios_base::failure{"error"};
+	};
+	auto const char_count = static_cast<std::streamsize>(end_pos - start_pos);
 
 	if(!in.seekg(start_pos))
 	{
@@ -1,6 +1,18 @@
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <set>
 #include <utility>
 
 #include "filesystem_watcher.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 namespace fs
 {
 using namespace std::literals;
@@ -81,159 +93,713 @@ static std::pair<path, std::string> visit_wild_card_path(const fs::path& path, b
 	return path_filter;
 }
 
-class filesystem_watcher::impl
+namespace
+{
+bool is_separator(char c)
+{
+	return c == '/' || c == char(fs::path::preferred_separator);
+}
+
+// Whether key is a path below dir, both as produced by the directory iterators.
+bool is_under(const std::string& key, const std::string& dir)
+{
+	if(key.size() <= dir.size() || key.compare(0, dir.size(), dir) != 0)
+	{
+		return false;
+	}
+	return dir.empty() || is_separator(dir.back()) || is_separator(key[dir.size()]);
+}
+
+bool is_child(const std::string& key, const std::string& dir)
+{
+	if(!is_under(key, dir))
+	{
+		return false;
+	}
+	const auto name = key.find_first_not_of("/\\", dir.size());
+	return name != std::string::npos && key.find_first_of("/\\", name) == std::string::npos;
+}
+
+// The wild card of a watch, matched the way visit_wild_card_path does.
+struct wildcard
+{
+	bool matches(const std::string& p) const
+	{
+		if(!enabled)
+		{
+			return true;
+		}
+		return (before.empty() || p.find(before) != std::string::npos) &&
+			   (after.empty() || p.find(after) != std::string::npos);
+	}
+
+	std::string before;
+	std::string after;
+	bool enabled = false;
+};
+
+wildcard make_wildcard(const fs::path& root, const std::string& filter)
+{
+	wildcard result;
+	if(filter.empty())
+	{
+		return result;
+	}
+
+	const std::string full = (root / filter).string();
+	const auto wildcard_pos = full.find('*');
+	result.before = full.substr(0, wildcard_pos);
+	result.after = full.substr(wildcard_pos + 1);
+	result.enabled = true;
+	return result;
+}
+
+// A created entry with the size and time of a removed one is the same entry renamed.
+void detect_renames(std::vector<filesystem_watcher::entry>& changes)
+{
+	using status = filesystem_watcher::entry_status;
+	for(auto removed = std::begin(changes); removed != std::end(changes);)
+	{
+		if(removed->status != status::removed)
+		{
+			++removed;
+			continue;
+		}
+
+		const auto is_same = [&removed](const filesystem_watcher::entry& e) {
+			return e.status == status::created && e.size == removed->size &&
+				   e.last_mod_time == removed->last_mod_time;
+		};
+		const auto created = std::find_if(std::begin(changes), std::end(changes), is_same);
+		if(created == std::end(changes))
+		{
+			++removed;
+			continue;
+		}
+
+		created->status = status::renamed;
+		created->last_path = removed->path;
+		removed = changes.erase(removed);
+	}
+}
+}
+
+struct filesystem_watcher::subscriber
+{
+	/// Snapshot of the watched tree
+	std::shared_ptr<snapshot> tree;
+	/// Filter applied
+	wildcard filter;
+	/// Callback for list of modifications
+	notify_callback callback;
+	/// How often the changes are reported
+	clock_t::duration poll_interval = 500ms;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : backend (Class)
+/// <summary>
+/// Tells which directories of the snapshots changed, so only those are
+/// scanned again instead of the whole trees.
+/// </summary>
+//-----------------------------------------------------------------------------
+#if defined(__linux__)
+class filesystem_watcher::backend
 {
 public:
+	static std::unique_ptr<backend> create()
+	{
+		std::unique_ptr<backend> result(new backend());
+		if(result->events_ < 0 || result->wake_ < 0)
+		{
+			return nullptr;
+		}
+		return result;
+	}
+
+	~backend()
+	{
+		if(events_ >= 0)
+		{
+			::close(events_);
+		}
+		if(wake_ >= 0)
+		{
+			::close(wake_);
+		}
+	}
+
 	//-----------------------------------------------------------------------------
-	//  Name : impl ()
+	//  Name : watch_directory ()
 	/// <summary>
-	///
-	///
-	///
+	/// Reports the changes of the direct children of the directory to the
+	/// snapshot. Returns false when the os refuses more watches.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	impl(const fs::path& path, const std::string& filter, bool recursive, bool initial_list,
-		 clock_t::duration poll_interval, notify_callback list_callback)
-		: filter_(filter)
-		, callback_(std::move(list_callback))
-		, poll_interval_(poll_interval)
-		, recursive_(recursive)
+	bool watch_directory(const std::shared_ptr<snapshot>& owner, const std::string& dir)
 	{
-		root_ = path;
-		std::vector<filesystem_watcher::entry> entries;
-		std::vector<size_t> created;
-		std::vector<size_t> modified;
-		// make sure we store all initial write time
-		if(!filter_.empty())
-		{
-			visit_wild_card_path(path / filter, recursive, false,
-								 [this, &entries, &created, &modified](const fs::path& p) {
-									 poll_entry(p, entries, created, modified);
-									 return false;
-								 });
+		const std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+								   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+		const int wd = inotify_add_watch(events_, dir.c_str(), mask);
+		if(wd < 0)
+		{
+			// A directory removed while it was scanned is not a failure.
+			return errno == ENOENT || errno == ENOTDIR;
 		}
-		else
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto& watches = watches_[wd];
+		const auto it = std::find_if(std::begin(watches), std::end(watches), [&](const watched_dir& w) {
+			return w.owner.lock() == owner && w.dir == dir;
+		});
+		if(it == std::end(watches))
 		{
-			poll_entry(root_, entries, created, modified);
+			watches.push_back({owner, dir});
 		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : unwatch_directory ()
+	/// <summary>
+	/// Stops reporting the directory and the directories below it to the owner.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void unwatch_directory(const snapshot* owner, const std::string& dir)
+	{
+		remove_if([&](const watched_dir& w) {
+			return w.owner.lock().get() == owner && (w.dir == dir || is_under(w.dir, dir));
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : unwatch_all ()
+	/// <summary>
+	/// Stops reporting any directory to the owner.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void unwatch_all(const snapshot* owner)
+	{
+		remove_if([&](const watched_dir& w) {
+			const auto locked = w.owner.lock();
+			return !locked || locked.get() == owner;
+		});
+	}
 
-		if(initial_list)
+	//-----------------------------------------------------------------------------
+	//  Name : wait ()
+	/// <summary>
+	/// Blocks until the os reports changes, wake is called or the timeout
+	/// expires, then marks the changed directories of the snapshots dirty.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wait(clock_t::duration timeout)
+	{
+		using namespace std::chrono;
+		const auto ms = duration_cast<milliseconds>(timeout).count();
+		const int timeout_ms = int(std::min<decltype(ms)>(std::max<decltype(ms)>(ms, 0), 60 * 60 * 1000));
+
+		pollfd fds[2] = {};
+		fds[0].fd = events_;
+		fds[0].events = POLLIN;
+		fds[1].fd = wake_;
+		fds[1].events = POLLIN;
+		if(::poll(fds, 2, timeout_ms) <= 0)
+		{
+			return;
+		}
+
+		if(fds[1].revents & POLLIN)
 		{
-			// this means that the first watch won't call the callback function
-			// so we have to manually call it here if we want that behavior
-			if(!entries.empty() && callback_)
+			std::uint64_t value = 0;
+			auto result = ::read(wake_, &value, sizeof(value));
+			(void)result;
+		}
+
+		if(fds[0].revents & POLLIN)
+		{
+			read_events();
+		}
+	}
+
+	void wake()
+	{
+		const std::uint64_t value = 1;
+		auto result = ::write(wake_, &value, sizeof(value));
+		(void)result;
+	}
+
+private:
+	backend()
+		: events_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+		, wake_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+	{
+	}
+
+	struct watched_dir
+	{
+		/// Snapshot notified about the directory
+		std::weak_ptr<snapshot> owner;
+		/// The directory as stored in the snapshot
+		std::string dir;
+	};
+
+	template <typename Predicate>
+	void remove_if(Predicate predicate)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(auto it = std::begin(watches_); it != std::end(watches_);)
+		{
+			auto& watches = it->second;
+			watches.erase(std::remove_if(std::begin(watches), std::end(watches), predicate),
+						  std::end(watches));
+			if(watches.empty())
+			{
+				inotify_rm_watch(events_, it->first);
+				it = watches_.erase(it);
+			}
+			else
 			{
-				callback_(entries, true);
+				++it;
 			}
 		}
 	}
 
+	void read_events();
+
+	/// Inotify instance
+	int events_ = -1;
+	/// Event fd waking up wait
+	int wake_ = -1;
+	/// Guards watches_
+	std::mutex mutex_;
+	/// The directories of every watch descriptor
+	std::map<int, std::vector<watched_dir>> watches_;
+};
+#else
+class filesystem_watcher::backend
+{
+public:
+	static std::unique_ptr<backend> create()
+	{
+		return nullptr;
+	}
+
+	bool watch_directory(const std::shared_ptr<snapshot>&, const std::string&)
+	{
+		return false;
+	}
+	void unwatch_directory(const snapshot*, const std::string&)
+	{
+	}
+	void unwatch_all(const snapshot*)
+	{
+	}
+	void wait(clock_t::duration)
+	{
+	}
+	void wake()
+	{
+	}
+};
+#endif
+
+//-----------------------------------------------------------------------------
+//  Name : snapshot (Class)
+/// <summary>
+/// The entries of a watched tree. Every watch of the same tree shares it,
+/// each refresh lists the changes once for all of them.
+/// </summary>
+//-----------------------------------------------------------------------------
+class filesystem_watcher::snapshot : public std::enable_shared_from_this<snapshot>
+{
+public:
+	snapshot(const fs::path& root, bool recursive, bool single)
+		: root_(root)
+		, root_key_(root.string())
+		, recursive_(recursive)
+		, single_(single)
+	{
+	}
+
 	//-----------------------------------------------------------------------------
-	//  Name : watch ()
+	//  Name : scan ()
 	/// <summary>
-	///
-	///
-	///
+	/// Walks the whole tree. When events are given the directories are
+	/// watched and later refreshes only scan the ones that changed.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void watch()
+	void scan(backend* events, std::vector<filesystem_watcher::entry>& changes)
 	{
+		event_driven_ = events != nullptr && !single_;
+		dirty_.clear();
+		dirty_all_ = false;
+		unverified_.clear();
 
-		std::vector<filesystem_watcher::entry> entries;
-		std::vector<size_t> created;
-		std::vector<size_t> modified;
-		// otherwise we check the whole parent directory
-		if(!filter_.empty())
-		{
-			visit_wild_card_path(root_ / filter_, recursive_, false,
-								 [this, &entries, &created, &modified](const fs::path& p) {
-									 poll_entry(p, entries, created, modified);
-									 return false;
-								 });
+		if(single_)
+		{
+			poll_single(changes);
 		}
 		else
 		{
-			poll_entry(root_, entries, created, modified);
+			scan_directory(events, root_key_, recursive_, changes);
 		}
+		detect_renames(changes);
 
-		process_modifications(entries, created, modified);
+		// Only the first scan may trust the index.
+		known_entries_.clear();
+		known_dirs_.clear();
+	}
 
-		if(!entries.empty() && callback_)
+	//-----------------------------------------------------------------------------
+	//  Name : refresh ()
+	/// <summary>
+	/// Lists the changes since the last refresh. Returns false when nothing
+	/// could have changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool refresh(backend* events, std::vector<filesystem_watcher::entry>& changes)
+	{
+		if(!event_driven_ || dirty_all_)
+		{
+			scan(event_driven_ ? events : nullptr, changes);
+			return true;
+		}
+
+		if(dirty_.empty() && unverified_.empty())
 		{
-			callback_(entries, false);
+			return false;
 		}
+
+		auto dirty = std::move(dirty_);
+		dirty_.clear();
+		for(const auto& dir : dirty)
+		{
+			scan_directory(events, dir, false, changes);
+		}
+		verify(changes);
+		detect_renames(changes);
+		return true;
 	}
 
-	void process_modifications(std::vector<filesystem_watcher::entry>& entries,
-							   const std::vector<size_t>& created, const std::vector<size_t>& /*unused*/)
+	void mark_dirty(const std::string& dir)
 	{
-		using namespace std::literals;
+		dirty_.insert(dir);
+	}
+
+	void mark_all_dirty()
+	{
+		dirty_all_ = true;
+	}
+
+	bool is_dirty() const
+	{
+		return !event_driven_ || dirty_all_ || !dirty_.empty() || !unverified_.empty();
+	}
+
+	bool is_event_driven() const
+	{
+		return event_driven_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : list ()
+	/// <summary>
+	/// The entries accepted by the filter, as created entries.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void list(const wildcard& filter, std::vector<filesystem_watcher::entry>& result) const
+	{
+		for(const auto& pair : entries_)
+		{
+			if(filter.matches(pair.first))
+			{
+				result.push_back(pair.second.info);
+				result.back().status = filesystem_watcher::entry_status::created;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_known ()
+	/// <summary>
+	/// The index the first scan may take the children of unchanged
+	/// directories from.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_known(filesystem_watcher::tree_index index)
+	{
+		for(auto& e : index.entries)
+		{
+			auto key = e.path.string();
+			known_entries_.emplace(std::move(key), std::move(e));
+		}
+		for(const auto& dir : index.directories)
+		{
+			known_dirs_.emplace(dir.first.string(), dir.second);
+		}
+	}
 
-		auto it = std::begin(entries_);
-		while(it != std::end(entries_))
+	void get_index(filesystem_watcher::tree_index& result) const
+	{
+		result.entries.clear();
+		result.entries.reserve(entries_.size());
+		for(const auto& pair : entries_)
 		{
-			auto& fi = it->second;
+			result.entries.push_back(pair.second.info);
+			result.entries.back().last_path = pair.second.info.path;
+			result.entries.back().status = filesystem_watcher::entry_status::unmodified;
+		}
+
+		result.directories.assign(std::begin(listed_), std::end(listed_));
+	}
+
+	// Whether the path is below the root of a recursive snapshot.
+	bool covers(const std::string& key) const
+	{
+		return recursive_ && !single_ && is_under(key, root_key_);
+	}
+
+	bool contains(const std::string& key) const
+	{
+		return entries_.find(key) != std::end(entries_);
+	}
+
+	/// Guards everything but the members guarded by the watcher mutex
+	std::mutex mutex;
+	/// Subscribers of the snapshot, guarded by the watcher mutex
+	std::vector<std::shared_ptr<subscriber>> subscribers;
+	/// Shortest interval of the subscribers, guarded by the watcher mutex
+	clock_t::duration poll_interval = 500ms;
+	/// Time of the last refresh, only used by the watcher thread
+	clock_t::time_point last_refresh = clock_t::now();
+	/// The first scan is done
+	bool is_scanned = false;
+	/// The last watcher of the tree is gone
+	bool is_released = false;
+
+private:
+	struct node
+	{
+		/// The entry reported to the subscribers
+		filesystem_watcher::entry info;
+		/// Scan the entry was last seen by
+		std::uint64_t generation = 0;
+	};
+
+	void poll_single(std::vector<filesystem_watcher::entry>& changes)
+	{
+		fs::error_code err;
+		if(!fs::exists(root_, err))
+		{
+			auto it = entries_.find(root_key_);
+			if(it != std::end(entries_))
+			{
+				it->second.info.status = filesystem_watcher::entry_status::removed;
+				changes.push_back(it->second.info);
+				entries_.erase(it);
+			}
+			return;
+		}
+		poll_entry(root_, ++generation_, changes);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : scan_directory ()
+	/// <summary>
+	/// Scans the children of the directory, and everything below it when deep.
+	/// New directories of recursive snapshots are always scanned deep.
+	/// Entries that were not found any more are reported as removed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void scan_directory(backend* events, const std::string& dir, bool deep,
+						std::vector<filesystem_watcher::entry>& changes)
+	{
+		const auto generation = ++generation_;
+		std::vector<fs::path> pending{fs::path(dir)};
+		while(!pending.empty())
+		{
+			const auto current = std::move(pending.back());
+			pending.pop_back();
+			const auto current_key = current.string();
+
+			// Watch before listing, so nothing created in between is missed.
+			if(events && event_driven_ && !events->watch_directory(shared_from_this(), current_key))
+			{
+				events->unwatch_all(this);
+				event_driven_ = false;
+			}
+
+			if(recursive_ && stamp_directory(current_key))
+			{
+				adopt_known(current_key, generation, pending, changes);
+				continue;
+			}
+
 			fs::error_code err;
-			if(!fs::exists(fi.path, err))
+			fs::directory_iterator it(current, err);
+			const fs::directory_iterator end;
+			for(; !err && it != end; it.increment(err))
 			{
-				bool was_removed = true;
-				for(auto idx : created)
+				const auto& p = it->path();
+				const bool created = poll_entry(p, generation, changes);
+				fs::error_code status_err;
+				if(recursive_ && (deep || created) && fs::is_directory(it->symlink_status(status_err)))
 				{
-					auto& e = entries[idx];
-					if(e.size == fi.size)
-					{
-						//using sys_clock = std::chrono::system_clock;
-						//std::chrono::microseconds tolerance = 1000us;
-						//auto diff = sys_clock::from_time_t(e.last_mod_time - fi.last_mod_time);
-						//auto d = std::chrono::time_point_cast<std::chrono::microseconds>(diff);
-						if(e.last_mod_time == fi.last_mod_time)
-						{
-
-							e.status = filesystem_watcher::entry_status::renamed;
-							e.last_path = fi.path;
-							was_removed = false;
-							break;
-						}
-					}
+					pending.push_back(p);
 				}
+			}
+		}
+
+		sweep(events, dir, deep, generation, changes);
+	}
 
-				if(was_removed)
+	void sweep(backend* events, const std::string& dir, bool deep, std::uint64_t generation,
+			   std::vector<filesystem_watcher::entry>& changes)
+	{
+		std::vector<std::string> removed_dirs;
+		auto it = entries_.lower_bound(dir);
+		while(it != std::end(entries_) && it->first.compare(0, dir.size(), dir) == 0)
+		{
+			const auto& key = it->first;
+			auto& n = it->second;
+			const bool removed =
+				n.generation != generation && is_under(key, dir) &&
+				(deep || is_child(key, dir) ||
+				 std::any_of(std::begin(removed_dirs), std::end(removed_dirs),
+							 [&key](const std::string& removed_dir) { return is_under(key, removed_dir); }));
+			if(!removed)
+			{
+				++it;
+				continue;
+			}
+
+			if(n.info.type == fs::file_type::directory)
+			{
+				removed_dirs.push_back(key);
+				listed_.erase(key);
+				if(events && event_driven_)
 				{
-					fi.status = filesystem_watcher::entry_status::removed;
-					entries.push_back(fi);
+					events->unwatch_directory(this, key);
 				}
+			}
+			n.info.status = filesystem_watcher::entry_status::removed;
+			changes.push_back(n.info);
+			it = entries_.erase(it);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : stamp_directory ()
+	/// <summary>
+	/// Remembers the modification time of the directory before it is listed,
+	/// anything changed while listing makes the time stale. Returns true when
+	/// the directory did not change since the known index was taken.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool stamp_directory(const std::string& dir)
+	{
+		fs::error_code err;
+		const auto time = fs::last_write_time(dir, err);
+		// A change within the time resolution of the file system would keep a recent stamp.
+		if(err || time + 2s > fs::now())
+		{
+			listed_.erase(dir);
+			return false;
+		}
+
+		listed_[dir] = time;
+		const auto known = known_dirs_.find(dir);
+		return known != std::end(known_dirs_) && known->second == time;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : adopt_known ()
+	/// <summary>
+	/// Takes the children of an unchanged directory from the known index
+	/// without touching the file system. They are queued for verification.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void adopt_known(const std::string& dir, std::uint64_t generation, std::vector<fs::path>& pending,
+					 std::vector<filesystem_watcher::entry>& changes)
+	{
+		auto it = known_entries_.lower_bound(dir);
+		for(; it != std::end(known_entries_) && it->first.compare(0, dir.size(), dir) == 0; ++it)
+		{
+			if(!is_child(it->first, dir))
+			{
+				continue;
+			}
+
+			auto& n = entries_[it->first];
+			n.generation = generation;
+			n.info = it->second;
+			n.info.status = filesystem_watcher::entry_status::created;
+			changes.push_back(n.info);
+			unverified_.push_back(it->first);
 
-				it = entries_.erase(it);
+			if(n.info.type == fs::file_type::directory)
+			{
+				pending.push_back(n.info.path);
 			}
-			else
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : verify ()
+	/// <summary>
+	/// Checks a batch of the adopted entries against the file system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void verify(std::vector<filesystem_watcher::entry>& changes)
+	{
+		for(std::size_t i = 0; i < 2048 && !unverified_.empty(); ++i)
+		{
+			const auto key = std::move(unverified_.front());
+			unverified_.pop_front();
+
+			const auto it = entries_.find(key);
+			if(it == std::end(entries_))
 			{
-				it++;
+				continue;
 			}
+
+			auto& n = it->second;
+			fs::error_code err;
+			if(!fs::exists(n.info.path, err))
+			{
+				n.info.status = filesystem_watcher::entry_status::removed;
+				changes.push_back(n.info);
+				listed_.erase(key);
+				entries_.erase(it);
+				continue;
+			}
+			poll_entry(n.info.path, n.generation, changes);
 		}
 	}
 
 	//-----------------------------------------------------------------------------
 	//  Name : poll_entry ()
 	/// <summary>
-	///
-	///
-	///
+	/// Updates the entry of the path, returns true when it is new.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void poll_entry(const fs::path& path, std::vector<filesystem_watcher::entry>& modifications,
-					std::vector<size_t>& created, std::vector<size_t>& modified)
+	bool poll_entry(const fs::path& path, std::uint64_t generation,
+					std::vector<filesystem_watcher::entry>& changes)
 	{
 		// get the last modification time
 		fs::error_code err;
 		auto time = fs::last_write_time(path, err);
 		auto size = fs::file_size(path, err);
 		fs::file_status status = fs::status(path, err);
-		// add a new modification time to the map
-		std::string key = path.string();
+
+		auto key = path.string();
 		auto it = entries_.find(key);
 		if(it != entries_.end())
 		{
-			auto& fi = it->second;
+			auto& n = it->second;
+			auto& fi = n.info;
+			n.generation = generation;
 
 			if(fi.last_mod_time != time || fi.size != size || fi.type != status.type())
 			{
@@ -241,49 +807,136 @@ public:
 				fi.last_mod_time = time;
 				fi.status = filesystem_watcher::entry_status::modified;
 				fi.type = status.type();
-				modifications.push_back(fi);
-				modified.push_back(modifications.size() - 1);
+				changes.push_back(fi);
 			}
 			else
 			{
 				fi.status = filesystem_watcher::entry_status::unmodified;
-				fi.type = status.type();
 			}
+			return false;
 		}
-		else
-		{
-			// or compare with an older one
-			auto& fi = entries_[key];
-			fi.path = path;
-			fi.last_path = path;
-			fi.last_mod_time = time;
-			fi.status = filesystem_watcher::entry_status::created;
-			fi.size = size;
-			fi.type = status.type();
 
-			modifications.push_back(fi);
-			created.push_back(modifications.size() - 1);
-		}
+		auto& n = entries_[std::move(key)];
+		auto& fi = n.info;
+		n.generation = generation;
+		fi.path = path;
+		fi.last_path = path;
+		fi.last_mod_time = time;
+		fi.status = filesystem_watcher::entry_status::created;
+		fi.size = size;
+		fi.type = status.type();
+		changes.push_back(fi);
+		return true;
 	}
 
-protected:
-	friend class filesystem_watcher;
-	/// Path to watch
+	/// Root of the tree
 	fs::path root_;
-	/// Filter applied
-	std::string filter_;
-	/// Callback for list of modifications
-	notify_callback callback_;
-	/// Cache watched files
-	std::map<std::string, filesystem_watcher::entry> entries_;
-	///
-	clock_t::duration poll_interval_ = 500ms;
-
-	clock_t::time_point last_poll_ = clock_t::now();
-	///
+	/// Root as the entries store it
+	std::string root_key_;
+	/// Scan the subdirectories
 	bool recursive_ = false;
+	/// Watches the root itself instead of its children
+	bool single_ = false;
+	/// Refreshed from the events instead of scanning everything
+	bool event_driven_ = false;
+	/// Cached entries
+	std::map<std::string, node> entries_;
+	/// Directories changes were reported for
+	std::set<std::string> dirty_;
+	/// The events were lost, everything has to be scanned
+	bool dirty_all_ = false;
+	/// Number of the current scan
+	std::uint64_t generation_ = 0;
+	/// Modification time of the directories from before they were last listed
+	std::map<std::string, fs::file_time_type> listed_;
+	/// Entries of the index handed to the first scan
+	std::map<std::string, filesystem_watcher::entry> known_entries_;
+	/// Directories of the index handed to the first scan
+	std::map<std::string, fs::file_time_type> known_dirs_;
+	/// Adopted entries not checked against the file system yet
+	std::deque<std::string> unverified_;
 };
 
+#if defined(__linux__)
+void filesystem_watcher::backend::read_events()
+{
+	std::vector<std::pair<std::weak_ptr<snapshot>, std::string>> dirty;
+	bool overflow = false;
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	for(;;)
+	{
+		const auto length = ::read(events_, buffer, sizeof(buffer));
+		if(length <= 0)
+		{
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(auto ptr = buffer; ptr < buffer + length;)
+		{
+			const auto& event = *reinterpret_cast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event.len;
+
+			if(event.mask & IN_Q_OVERFLOW)
+			{
+				overflow = true;
+				continue;
+			}
+
+			const auto it = watches_.find(event.wd);
+			if(it == std::end(watches_))
+			{
+				continue;
+			}
+
+			for(const auto& w : it->second)
+			{
+				dirty.emplace_back(w.owner, w.dir);
+			}
+
+			// The os dropped the watch, the directory is gone.
+			if(event.mask & IN_IGNORED)
+			{
+				watches_.erase(it);
+			}
+		}
+	}
+
+	if(overflow)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(const auto& pair : watches_)
+		{
+			for(const auto& w : pair.second)
+			{
+				dirty.emplace_back(w.owner, std::string());
+			}
+		}
+	}
+
+	// Marked after releasing the lock, scans lock the snapshot first.
+	for(const auto& pair : dirty)
+	{
+		auto owner = pair.first.lock();
+		if(!owner)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(owner->mutex);
+		if(pair.second.empty())
+		{
+			owner->mark_all_dirty();
+		}
+		else
+		{
+			owner->mark_dirty(pair.second);
+		}
+	}
+}
+#endif
+
 static filesystem_watcher& get_watcher()
 {
 	// create the static filesystem_watcher instance
@@ -307,6 +960,66 @@ void filesystem_watcher::unwatch_all()
 	unwatch_all_impl();
 }
 
+bool filesystem_watcher::get_index(const fs::path& root, tree_index& result)
+{
+	auto& wd = get_watcher();
+	std::shared_ptr<snapshot> tree;
+	{
+		std::lock_guard<std::mutex> lock(wd.mutex_);
+		auto it = wd.snapshots_.find(root.string() + "|recursive");
+		if(it == std::end(wd.snapshots_))
+		{
+			return false;
+		}
+		tree = it->second;
+	}
+
+	std::lock_guard<std::mutex> lock(tree->mutex);
+	if(!tree->is_scanned || tree->is_released)
+	{
+		return false;
+	}
+	tree->get_index(result);
+	return true;
+}
+
+void filesystem_watcher::set_known_index(const fs::path& root, tree_index index)
+{
+	auto& wd = get_watcher();
+	std::lock_guard<std::mutex> lock(wd.mutex_);
+	wd.known_[root.string()] = std::move(index);
+}
+
+bool filesystem_watcher::exists(const fs::path& path)
+{
+	auto& wd = get_watcher();
+	const auto key = path.string();
+	std::vector<std::shared_ptr<snapshot>> trees;
+	{
+		std::lock_guard<std::mutex> lock(wd.mutex_);
+		for(const auto& pair : wd.snapshots_)
+		{
+			if(pair.second->covers(key))
+			{
+				trees.push_back(pair.second);
+			}
+		}
+	}
+
+	// Locked after releasing the watcher mutex, like the watcher thread does.
+	for(const auto& tree : trees)
+	{
+		std::lock_guard<std::mutex> lock(tree->mutex);
+		if(tree->is_scanned && !tree->is_released)
+		{
+			return tree->contains(key);
+		}
+	}
+
+	fs::error_code err;
+	return fs::exists(path, err);
+}
+
 void filesystem_watcher::touch(const fs::path& path, bool recursive, fs::file_time_type time)
 {
 	fs::error_code err;
@@ -332,6 +1045,8 @@ void filesystem_watcher::touch(const fs::path& path, bool recursive, fs::file_ti
 	}
 }
 
+filesystem_watcher::filesystem_watcher() = default;
+
 filesystem_watcher::~filesystem_watcher()
 {
 	close();
@@ -350,45 +1065,106 @@ void filesystem_watcher::close()
 	}
 }
 
+void filesystem_watcher::wake()
+{
+	if(backend_)
+	{
+		backend_->wake();
+	}
+	cv_.notify_all();
+}
+
 void filesystem_watcher::start()
 {
+	backend_ = backend::create();
 	watching_ = true;
 	thread_ = std::thread([this]() {
-		// keep watching for modifications every ms milliseconds
+		// keep refreshing the snapshots that are due
 		using namespace std::literals;
 		while(watching_)
 		{
 			clock_t::duration sleep_time = 99999h;
 
-			// iterate through each watcher and check for modification
-			std::map<std::uint64_t, std::shared_ptr<impl>> watchers;
+			std::vector<std::shared_ptr<snapshot>> snapshots;
 			{
 				std::unique_lock<std::mutex> lock(mutex_);
-				watchers = watchers_;
+				snapshots.reserve(snapshots_.size());
+				for(const auto& pair : snapshots_)
+				{
+					snapshots.push_back(pair.second);
+				}
 			}
 
-			for(auto& pair : watchers)
+			for(auto& tree : snapshots)
 			{
-				auto watcher = pair.second;
+				clock_t::duration poll_interval;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					poll_interval = tree->poll_interval;
+				}
 
-				auto now = clock_t::now();
+				std::vector<filesystem_watcher::entry> changes;
+				{
+					std::unique_lock<std::mutex> lock(tree->mutex);
+					// Trees refreshed from events wait for them.
+					if(!tree->is_scanned || tree->is_released || !tree->is_dirty())
+					{
+						continue;
+					}
 
-				auto diff = (watcher->last_poll_ + watcher->poll_interval_) - now;
-				if(diff <= clock_t::duration(0))
+					auto now = clock_t::now();
+					auto diff = (tree->last_refresh + poll_interval) - now;
+					if(diff > clock_t::duration(0))
+					{
+						sleep_time = std::min(sleep_time, diff);
+						continue;
+					}
+
+					tree->refresh(backend_.get(), changes);
+					tree->last_refresh = now;
+					// Trees still verifying adopted entries continue with the next batch.
+					if(!tree->is_event_driven() || tree->is_dirty())
+					{
+						sleep_time = std::min(sleep_time, poll_interval);
+					}
+				}
+
+				if(changes.empty())
 				{
-					watcher->watch();
-					watcher->last_poll_ = now;
+					continue;
+				}
 
-					sleep_time = std::min(sleep_time, watcher->poll_interval_);
+				std::vector<std::shared_ptr<subscriber>> subscribers;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					subscribers = tree->subscribers;
 				}
-				else
+
+				// fan the changes out to the watchers of the tree
+				std::vector<filesystem_watcher::entry> entries;
+				for(const auto& sub : subscribers)
 				{
-					sleep_time = std::min(sleep_time, diff);
+					entries.clear();
+					std::copy_if(std::begin(changes), std::end(changes), std::back_inserter(entries),
+								 [&sub](const filesystem_watcher::entry& e) {
+									 return sub->filter.matches(e.path.string());
+								 });
+					if(!entries.empty() && sub->callback)
+					{
+						sub->callback(entries, false);
+					}
 				}
 			}
 
-			std::unique_lock<std::mutex> lock(mutex_);
-			cv_.wait_for(lock, sleep_time);
+			if(backend_)
+			{
+				backend_->wait(sleep_time);
+			}
+			else
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait_for(lock, sleep_time);
+			}
 		}
 	});
 }
@@ -431,15 +1207,65 @@ std::uint64_t filesystem_watcher::watch_impl(const fs::path& path, bool recursiv
 		static std::atomic<std::uint64_t> free_id = {1};
 
 		auto key = free_id++;
+
+		// without a wild card only the path itself is watched
+		const bool single = filter.empty();
+		auto sub = std::make_shared<subscriber>();
+		sub->filter = make_wildcard(p, filter);
+		sub->callback = std::move(list_callback);
+		sub->poll_interval = poll_interval;
+
+		const auto tree_key = p.string() + (single ? "|single" : recursive ? "|recursive" : "|flat");
+		{
+			std::lock_guard<std::mutex> lock(wd.mutex_);
+			auto& tree = wd.snapshots_[tree_key];
+			if(!tree)
+			{
+				tree = std::make_shared<snapshot>(p, recursive && !single, single);
+				const auto known = wd.known_.find(p.string());
+				if(known != std::end(wd.known_))
+				{
+					if(recursive && !single)
+					{
+						tree->set_known(std::move(known->second));
+					}
+					wd.known_.erase(known);
+				}
+			}
+			sub->tree = tree;
+		}
+
+		// we do it like this because if initial_list is true we don't want
+		// to call a user callback on a locked mutex
+		std::vector<filesystem_watcher::entry> entries;
+		{
+			std::lock_guard<std::mutex> lock(sub->tree->mutex);
+			if(!sub->tree->is_scanned)
+			{
+				std::vector<filesystem_watcher::entry> changes;
+				sub->tree->scan(wd.backend_.get(), changes);
+				sub->tree->is_scanned = true;
+			}
+			if(initial_list)
+			{
+				sub->tree->list(sub->filter, entries);
+			}
+		}
+
+		if(!entries.empty() && sub->callback)
+		{
+			sub->callback(entries, true);
+		}
+
 		{
-			// we do it like this because if initial_list is true we don't want
-			// to call a user callback on a locked mutex
-			auto imp =
-				std::make_shared<impl>(p, filter, recursive, initial_list, poll_interval, std::move(list_callback));
 			std::lock_guard<std::mutex> lock(wd.mutex_);
-			wd.watchers_.emplace(key, std::move(imp));
+			auto& subscribers = sub->tree->subscribers;
+			sub->tree->poll_interval =
+				subscribers.empty() ? poll_interval : std::min(sub->tree->poll_interval, poll_interval);
+			subscribers.push_back(sub);
+			wd.watchers_.emplace(key, std::move(sub));
 		}
-		wd.cv_.notify_all();
+		wd.wake();
 		return key;
 	}
 
@@ -450,20 +1276,79 @@ void filesystem_watcher::unwatch_impl(std::uint64_t key)
 {
 	auto& wd = get_watcher();
 
+	std::shared_ptr<snapshot> released;
 	{
 		std::lock_guard<std::mutex> lock(wd.mutex_);
-		wd.watchers_.erase(key);
+		auto it = wd.watchers_.find(key);
+		if(it == std::end(wd.watchers_))
+		{
+			return;
+		}
+
+		auto sub = it->second;
+		wd.watchers_.erase(it);
+
+		auto& tree = sub->tree;
+		auto& subscribers = tree->subscribers;
+		subscribers.erase(std::remove(std::begin(subscribers), std::end(subscribers), sub),
+						  std::end(subscribers));
+		if(subscribers.empty())
+		{
+			for(auto tree_it = std::begin(wd.snapshots_); tree_it != std::end(wd.snapshots_); ++tree_it)
+			{
+				if(tree_it->second == tree)
+				{
+					wd.snapshots_.erase(tree_it);
+					break;
+				}
+			}
+			released = tree;
+		}
+		else
+		{
+			tree->poll_interval = subscribers.front()->poll_interval;
+			for(const auto& other : subscribers)
+			{
+				tree->poll_interval = std::min(tree->poll_interval, other->poll_interval);
+			}
+		}
 	}
-	wd.cv_.notify_all();
+
+	if(released)
+	{
+		std::lock_guard<std::mutex> lock(released->mutex);
+		released->is_released = true;
+		if(wd.backend_)
+		{
+			wd.backend_->unwatch_all(released.get());
+		}
+	}
+	wd.wake();
 }
 
 void filesystem_watcher::unwatch_all_impl()
 {
 	auto& wd = get_watcher();
+	std::map<std::string, std::shared_ptr<snapshot>> released;
 	{
 		std::lock_guard<std::mutex> lock(wd.mutex_);
 		wd.watchers_.clear();
+		released.swap(wd.snapshots_);
+		for(auto& pair : released)
+		{
+			pair.second->subscribers.clear();
+		}
+	}
+
+	for(const auto& pair : released)
+	{
+		std::lock_guard<std::mutex> lock(pair.second->mutex);
+		pair.second->is_released = true;
+		if(wd.backend_)
+		{
+			wd.backend_->unwatch_all(pair.second.get());
+		}
 	}
-	wd.cv_.notify_all();
+	wd.wake();
 }
 }
@@ -10,6 +10,8 @@
 #include <string>
 #include <thread>
 #include <functional>
+#include <utility>
+#include <vector>
 
 #include "filesystem.h"
 
@@ -41,6 +43,22 @@ public:
 		fs::file_type type;
 	};
 
+	//-----------------------------------------------------------------------------
+	//  Name : tree_index (Struct)
+	/// <summary>
+	/// What a recursively watched tree looked like. Given back to the watcher
+	/// on the next run, the first scan of the tree only lists the directories
+	/// that changed since.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct tree_index
+	{
+		/// Entries of the tree
+		std::vector<entry> entries;
+		/// Directories with their modification time from before they were listed
+		std::vector<std::pair<fs::path, fs::file_time_type>> directories;
+	};
+
 	using notify_callback = std::function<void(const std::vector<entry>&, bool)>;
 	using clock_t = std::chrono::steady_clock;
 	//-----------------------------------------------------------------------------
@@ -49,7 +67,11 @@ public:
 	/// Watches a file or directory for modification and call back the specified
 	/// std::function. A list of modified files or directory is passed as argument
 	/// of the callback. Use this version only if you are watching multiple files
-	/// or a directory.
+	/// or a directory. Watches of the same directory share one snapshot of it,
+	/// each watch only gets the changes matching its wild card. Where the os
+	/// reports changes (inotify on linux) only the changed directories are
+	/// scanned again and the poll interval just limits how often changes are
+	/// reported, elsewhere the snapshot is scanned every poll interval.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static std::uint64_t watch(const fs::path& path, bool recursive, bool initial_list,
@@ -71,6 +93,38 @@ public:
 	//-----------------------------------------------------------------------------
 	static void unwatch_all();
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_index ()
+	/// <summary>
+	/// Gets the index of the recursively watched tree at root. Returns false
+	/// when the tree is not watched.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool get_index(const fs::path& root, tree_index& result);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_known_index ()
+	/// <summary>
+	/// Hands an index saved by a previous run to the next recursive watch of
+	/// root. Directories with the same modification time are not listed again
+	/// but take their children from the index. Those are checked against the
+	/// file system in the background afterwards and reported as modified or
+	/// removed when they changed, as a changed file does not touch its
+	/// directory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_known_index(const fs::path& root, tree_index index);
+
+	//-----------------------------------------------------------------------------
+	//  Name : exists ()
+	/// <summary>
+	/// Same as fs::exists, but answered from the snapshot of a recursively
+	/// watched tree containing the path when there is one. The snapshot can
+	/// miss changes newer than the poll interval.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool exists(const fs::path& path);
+
 	//-----------------------------------------------------------------------------
 	//  Name : touch ()
 	/// <summary>
@@ -91,7 +145,7 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	~filesystem_watcher();
-	filesystem_watcher() = default;
+	filesystem_watcher();
 
 protected:
 	//-----------------------------------------------------------------------------
@@ -129,17 +183,33 @@ protected:
 
 	static void unwatch_all_impl();
 
+	//-----------------------------------------------------------------------------
+	//  Name : wake ()
+	/// <summary>
+	/// Wakes the thread up after the watches changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wake();
+
 	/// Mutex for the file watchers
 	std::mutex mutex_;
 	/// Atomic bool sync
 	std::atomic<bool> watching_ = {false};
 
 	std::condition_variable cv_;
-	/// Thread that polls for changes
+	/// Thread that refreshes the snapshots
 	std::thread thread_;
 	/// Registered file watchers
-	class impl;
-	std::map<std::uint64_t, std::shared_ptr<impl>> watchers_;
+	struct subscriber;
+	std::map<std::uint64_t, std::shared_ptr<subscriber>> watchers_;
+	/// Snapshots of the watched trees, shared by the watchers of the same tree
+	class snapshot;
+	std::map<std::string, std::shared_ptr<snapshot>> snapshots_;
+	/// Indices of the trees not watched yet, by their root
+	std::map<std::string, tree_index> known_;
+	/// Change notifications of the os, null when the snapshots are polled
+	class backend;
+	std::unique_ptr<backend> backend_;
 };
 }
 
@@ -0,0 +1,516 @@
+#include "io_system.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs
+{
+namespace
+{
+// Coalesced requests are read at once up to this size.
+constexpr std::uint64_t max_span_size = 4 * 1024 * 1024;
+
+error_code get_last_error()
+{
+#if defined(_WIN32)
+	return error_code(static_cast<int>(GetLastError()), std::system_category());
+#else
+	return error_code(errno, std::generic_category());
+#endif
+}
+
+class native_file
+{
+public:
+	native_file(const fs::path& file)
+	{
+#if defined(_WIN32)
+		handle_ = CreateFileW(file.wstring().c_str(), GENERIC_READ,
+							  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+		do
+		{
+			handle_ = ::open(file.string().c_str(), O_RDONLY | O_CLOEXEC);
+		} while(handle_ == -1 && errno == EINTR);
+#endif
+	}
+
+	~native_file()
+	{
+		if(is_open())
+		{
+#if defined(_WIN32)
+			CloseHandle(handle_);
+#else
+			::close(handle_);
+#endif
+		}
+	}
+
+	native_file(const native_file&) = delete;
+	native_file& operator=(const native_file&) = delete;
+
+	bool is_open() const
+	{
+#if defined(_WIN32)
+		return handle_ != INVALID_HANDLE_VALUE;
+#else
+		return handle_ != -1;
+#endif
+	}
+
+	bool get_size(std::uint64_t& size) const
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER result;
+		if(!GetFileSizeEx(handle_, &result))
+		{
+			return false;
+		}
+		size = static_cast<std::uint64_t>(result.QuadPart);
+#else
+		struct stat info;
+		if(::fstat(handle_, &info) != 0)
+		{
+			return false;
+		}
+		size = static_cast<std::uint64_t>(info.st_size);
+#endif
+		return true;
+	}
+
+	// Reads until size bytes were read or the end of the file, returns the bytes read.
+	std::size_t read_at(std::uint64_t offset, std::uint8_t* data, std::size_t size, error_code& err) const
+	{
+		std::size_t total = 0;
+		while(total < size)
+		{
+#if defined(_WIN32)
+			OVERLAPPED overlapped = {};
+			overlapped.Offset = static_cast<DWORD>(offset + total);
+			overlapped.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+			DWORD count = 0;
+			const auto chunk = static_cast<DWORD>(std::min<std::size_t>(size - total, 1u << 30));
+			if(!ReadFile(handle_, data + total, chunk, &count, &overlapped))
+			{
+				if(GetLastError() != ERROR_HANDLE_EOF)
+				{
+					err = get_last_error();
+				}
+				break;
+			}
+#else
+			const auto position = static_cast<off_t>(offset + total);
+			const auto count = ::pread(handle_, data + total, size - total, position);
+			if(count < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+				err = get_last_error();
+				break;
+			}
+#endif
+			if(count == 0)
+			{
+				break;
+			}
+			total += static_cast<std::size_t>(count);
+		}
+		return total;
+	}
+
+private:
+#if defined(_WIN32)
+	HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+	int handle_ = -1;
+#endif
+};
+
+std::uint64_t get_end(const io_request& request)
+{
+	return request.offset + request.size;
+}
+}
+
+struct io_system::pending_read
+{
+	/// What to read
+	io_request request;
+	/// Order within the priority
+	std::uint64_t sequence = 0;
+	/// Called with the bytes read
+	completion_t on_complete;
+};
+
+struct io_system::block_pool : std::enable_shared_from_this<io_system::block_pool>
+{
+	block_pool(std::size_t block_size, std::size_t max_free)
+		: block_size(block_size)
+		, max_free(max_free)
+	{
+	}
+
+	std::shared_ptr<std::uint8_t> acquire()
+	{
+		std::unique_ptr<std::uint8_t[]> data;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(!free.empty())
+			{
+				data = std::move(free.back());
+				free.pop_back();
+			}
+		}
+		if(!data)
+		{
+			data.reset(new std::uint8_t[block_size]);
+		}
+
+		// A request larger than the pool does not wait for buffers, the ones
+		// beyond the pool are freed instead of kept.
+		auto pool = shared_from_this();
+		return std::shared_ptr<std::uint8_t>(data.release(), [pool](std::uint8_t* block) {
+			std::unique_ptr<std::uint8_t[]> released(block);
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			if(pool->free.size() < pool->max_free)
+			{
+				pool->free.emplace_back(std::move(released));
+			}
+		});
+	}
+
+	/// Size of every buffer
+	const std::size_t block_size;
+	/// Buffers kept at most
+	const std::size_t max_free;
+	/// Protects the free buffers
+	std::mutex mutex;
+	/// Buffers not in use
+	std::vector<std::unique_ptr<std::uint8_t[]>> free;
+};
+
+bool io_result::ok() const
+{
+	return !error_;
+}
+
+const error_code& io_result::get_error() const
+{
+	return error_;
+}
+
+std::size_t io_result::size() const
+{
+	return size_;
+}
+
+void io_result::copy_to(std::uint8_t* output) const
+{
+	auto offset = offset_;
+	auto remaining = size_;
+	for(const auto& block : blocks_)
+	{
+		const auto count = std::min(remaining, block_size_ - offset);
+		std::memcpy(output, block.get() + offset, count);
+		output += count;
+		remaining -= count;
+		offset = 0;
+	}
+}
+
+byte_array_t io_result::to_bytes() const
+{
+	byte_array_t result(size_);
+	copy_to(result.data());
+	return result;
+}
+
+std::string io_result::to_string() const
+{
+	std::string result(size_, '\0');
+	copy_to(reinterpret_cast<std::uint8_t*>(&result[0]));
+	return result;
+}
+
+io_streambuf::io_streambuf(io_result result)
+	: result_(std::move(result))
+	, remaining_(result_.size_)
+{
+}
+
+io_streambuf::int_type io_streambuf::underflow()
+{
+	if(gptr() < egptr())
+	{
+		return traits_type::to_int_type(*gptr());
+	}
+	if(remaining_ == 0 || next_block_ >= result_.blocks_.size())
+	{
+		return traits_type::eof();
+	}
+
+	const auto offset = next_block_ == 0 ? result_.offset_ : 0;
+	const auto count = std::min(remaining_, result_.block_size_ - offset);
+	auto begin = reinterpret_cast<char*>(const_cast<std::uint8_t*>(result_.blocks_[next_block_].get()));
+	begin += offset;
+	setg(begin, begin, begin + count);
+	remaining_ -= count;
+	++next_block_;
+	return traits_type::to_int_type(*gptr());
+}
+
+io_system::io_system(std::size_t threads, std::size_t block_size, std::size_t pooled_blocks)
+	: pool_(std::make_shared<block_pool>(block_size, pooled_blocks))
+	, block_size_(block_size)
+{
+	threads = std::max<std::size_t>(threads, 1);
+	threads_.reserve(threads);
+	for(std::size_t i = 0; i < threads; ++i)
+	{
+		threads_.emplace_back(&io_system::run, this);
+	}
+}
+
+io_system::~io_system()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		done_ = true;
+	}
+	wakeup_.notify_all();
+
+	for(auto& thread : threads_)
+	{
+		if(thread.joinable())
+		{
+			thread.join();
+		}
+	}
+
+	// Reads queued from here on fail right away.
+	std::vector<std::shared_ptr<pending_read>> pending;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending.swap(pending_);
+	}
+	for(auto& read : pending)
+	{
+		io_result result;
+		result.error_ = std::make_error_code(std::errc::operation_canceled);
+		read->on_complete(std::move(result));
+	}
+}
+
+core::task_future<io_result> io_system::read(const io_request& request)
+{
+	auto promise = std::make_shared<std::promise<io_result>>();
+	auto future = core::task_future<io_result>::from_shared_future(promise->get_future().share());
+	read(request, [promise](io_result result) { promise->set_value(std::move(result)); });
+	return future;
+}
+
+void io_system::read(const io_request& request, completion_t on_complete)
+{
+	auto pending = std::make_shared<pending_read>();
+	pending->request = request;
+	pending->on_complete = std::move(on_complete);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if(done_)
+		{
+			lock.unlock();
+			io_result result;
+			result.error_ = std::make_error_code(std::errc::operation_canceled);
+			pending->on_complete(std::move(result));
+			return;
+		}
+		pending->sequence = sequence_++;
+		pending_.emplace_back(std::move(pending));
+	}
+	wakeup_.notify_one();
+}
+
+io_system::statistics io_system::get_statistics() const
+{
+	statistics result;
+	result.requests = requests_.load();
+	result.reads = reads_.load();
+	result.bytes = bytes_.load();
+	return result;
+}
+
+void io_system::run()
+{
+	std::vector<std::shared_ptr<pending_read>> span;
+	while(pop_span(span))
+	{
+		read_span(span);
+		span.clear();
+	}
+}
+
+bool io_system::pop_span(std::vector<std::shared_ptr<pending_read>>& span)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	wakeup_.wait(lock, [this]() { return done_ || !pending_.empty(); });
+	if(done_)
+	{
+		return false;
+	}
+
+	const auto is_before = [](const auto& lhs, const auto& rhs) {
+		if(lhs->request.priority != rhs->request.priority)
+		{
+			return lhs->request.priority > rhs->request.priority;
+		}
+		return lhs->sequence < rhs->sequence;
+	};
+	auto first = std::min_element(std::begin(pending_), std::end(pending_), is_before);
+	span.emplace_back(std::move(*first));
+	pending_.erase(first);
+
+	// The size of a whole file read is only known once the file is open.
+	const auto& request = span.front()->request;
+	if(request.size == io_request::whole_file)
+	{
+		return true;
+	}
+
+	// Take the requests touching the span until none is left, each one
+	// taken can bring the next one in reach.
+	auto begin = request.offset;
+	auto end = get_end(request);
+	bool extended = true;
+	while(extended)
+	{
+		extended = false;
+		for(auto it = std::begin(pending_); it != std::end(pending_);)
+		{
+			const auto& other = (*it)->request;
+			const auto other_end = get_end(other);
+			if(other.size == io_request::whole_file || other.offset > end || other_end < begin ||
+			   other.file != request.file)
+			{
+				++it;
+				continue;
+			}
+
+			const auto span_begin = std::min(begin, other.offset);
+			const auto span_end = std::max(end, other_end);
+			if(span_end - span_begin > max_span_size)
+			{
+				++it;
+				continue;
+			}
+
+			begin = span_begin;
+			end = span_end;
+			extended = true;
+			span.emplace_back(std::move(*it));
+			it = pending_.erase(it);
+		}
+	}
+	return true;
+}
+
+void io_system::read_span(std::vector<std::shared_ptr<pending_read>>& span)
+{
+	const auto fail = [&span](const error_code& err) {
+		for(auto& pending : span)
+		{
+			io_result result;
+			result.error_ = err;
+			pending->on_complete(std::move(result));
+		}
+	};
+
+	native_file file(span.front()->request.file);
+	std::uint64_t file_size = 0;
+	if(!file.is_open() || !file.get_size(file_size))
+	{
+		fail(get_last_error());
+		return;
+	}
+
+	auto& first = span.front()->request;
+	if(first.size == io_request::whole_file)
+	{
+		first.size = first.offset < file_size ? file_size - first.offset : 0;
+	}
+
+	std::uint64_t begin = std::numeric_limits<std::uint64_t>::max();
+	std::uint64_t end = 0;
+	for(const auto& pending : span)
+	{
+		begin = std::min(begin, pending->request.offset);
+		end = std::max(end, get_end(pending->request));
+	}
+	end = std::max(begin, std::min(end, file_size));
+
+	// Read the span into buffers back to back.
+	std::vector<std::shared_ptr<const std::uint8_t>> blocks;
+	std::uint64_t read_end = begin;
+	error_code err;
+	while(read_end < end)
+	{
+		auto block = pool_->acquire();
+		const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(block_size_, end - read_end));
+		const auto count = file.read_at(read_end, block.get(), size, err);
+		read_end += count;
+		blocks.emplace_back(std::move(block));
+		if(count < size)
+		{
+			break;
+		}
+	}
+	++reads_;
+	bytes_ += read_end - begin;
+
+	for(auto& pending : span)
+	{
+		auto& request = pending->request;
+		io_result result;
+		if(get_end(request) > read_end && request.clamp_to_end && !err)
+		{
+			request.size = request.offset < read_end ? read_end - request.offset : 0;
+		}
+
+		if(get_end(request) > read_end)
+		{
+			result.error_ = err ? err : std::make_error_code(std::errc::result_out_of_range);
+		}
+		else if(request.size > 0)
+		{
+			const auto first_block = static_cast<std::size_t>((request.offset - begin) / block_size_);
+			const auto last_block = static_cast<std::size_t>((get_end(request) - 1 - begin) / block_size_);
+			result.blocks_.assign(std::begin(blocks) + std::ptrdiff_t(first_block),
+								  std::begin(blocks) + std::ptrdiff_t(last_block + 1));
+			result.block_size_ = block_size_;
+			result.offset_ = static_cast<std::size_t>((request.offset - begin) % block_size_);
+			result.size_ = static_cast<std::size_t>(request.size);
+		}
+		++requests_;
+		pending->on_complete(std::move(result));
+	}
+}
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "filesystem.h"
+
+#include "../tasks/task_system.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs
+{
+enum class io_priority : std::uint8_t
+{
+	low,
+	normal,
+	high,
+};
+
+struct io_request
+{
+	/// Size that reads from the offset to the end of the file
+	static constexpr std::uint64_t whole_file = std::numeric_limits<std::uint64_t>::max();
+
+	/// The file to read
+	fs::path file;
+	/// Offset of the first byte
+	std::uint64_t offset = 0;
+	/// Bytes to read
+	std::uint64_t size = whole_file;
+	/// Higher priorities are read first, equal ones in order
+	io_priority priority = io_priority::normal;
+	/// Whether a read past the end of the file gets the bytes up to it
+	/// instead of failing
+	bool clamp_to_end = false;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : io_result (Class)
+/// <summary>
+/// The bytes of a completed read. They stay in the pooled buffers they were
+/// read into, shared with the reads coalesced with this one, and go back to
+/// the pool once the last result using them is gone.
+/// </summary>
+//-----------------------------------------------------------------------------
+class io_result
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : ok ()
+	/// <summary>
+	/// Whether all the bytes requested were read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool ok() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_error ()
+	/// <summary>
+	/// Why the read failed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const error_code& get_error() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : size ()
+	/// <summary>
+	/// Number of bytes read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t size() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : copy_to ()
+	/// <summary>
+	/// Copies the bytes read to output, which has room for size() bytes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void copy_to(std::uint8_t* output) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : to_bytes ()
+	/// <summary>
+	/// Copies the bytes read to a byte array.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	byte_array_t to_bytes() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : to_string ()
+	/// <summary>
+	/// Copies the bytes read to a string.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::string to_string() const;
+
+private:
+	friend class io_system;
+	friend class io_streambuf;
+
+	/// The buffers holding the bytes
+	std::vector<std::shared_ptr<const std::uint8_t>> blocks_;
+	/// Size of every buffer
+	std::size_t block_size_ = 0;
+	/// Offset of the first byte in the first buffer
+	std::size_t offset_ = 0;
+	/// Number of bytes read
+	std::size_t size_ = 0;
+	/// Why the read failed
+	error_code error_;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : io_streambuf (Class)
+/// <summary>
+/// Input stream buffer over the bytes of a read, so archives read them
+/// without copying them first.
+/// </summary>
+//-----------------------------------------------------------------------------
+class io_streambuf : public std::streambuf
+{
+public:
+	explicit io_streambuf(io_result result);
+
+protected:
+	int_type underflow() override;
+
+private:
+	/// The bytes read
+	io_result result_;
+	/// Index of the buffer after the one being read
+	std::size_t next_block_ = 0;
+	/// Bytes not yet handed to the stream
+	std::size_t remaining_ = 0;
+};
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : io_system (Class)
+/// <summary>
+/// Reads files on a few threads of its own so the workers of the task system
+/// never wait for the disk. Requests are served by priority. Adjacent or
+/// overlapping requests to the same file, like the entries of a pack file,
+/// are coalesced into a single read. Reads go into fixed-size buffers taken
+/// from a pool. Chain the work on the data with ts.push_on_worker_thread or
+/// ts.push_on_owner_thread with the returned future as argument, the task
+/// only runs once the read completed.
+/// </summary>
+//-----------------------------------------------------------------------------
+class io_system
+{
+public:
+	using completion_t = std::function<void(io_result)>;
+
+	struct statistics
+	{
+		/// Requests completed
+		std::uint64_t requests = 0;
+		/// Reads issued to the os, coalesced requests share one
+		std::uint64_t reads = 0;
+		/// Bytes read from the os
+		std::uint64_t bytes = 0;
+	};
+
+	io_system(std::size_t threads = 2, std::size_t block_size = 256 * 1024, std::size_t pooled_blocks = 64);
+	~io_system();
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Queues a read. The future is ready once the bytes are in memory or the
+	/// read failed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	core::task_future<io_result> read(const io_request& request);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Queues a read and calls on_complete on the io thread once the bytes are
+	/// in memory or the read failed. It should only hand the data on, to the
+	/// task system or to another read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void read(const io_request& request, completion_t on_complete);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_statistics ()
+	/// <summary>
+	/// Counters of the reads done so far.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	statistics get_statistics() const;
+
+private:
+	struct pending_read;
+	struct block_pool;
+
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Main loop of the io threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void run();
+
+	//-----------------------------------------------------------------------------
+	//  Name : pop_span ()
+	/// <summary>
+	/// Takes the request to serve next together with the pending requests to
+	/// the same file that it can be read with. Returns false once stopped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool pop_span(std::vector<std::shared_ptr<pending_read>>& span);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read_span ()
+	/// <summary>
+	/// Reads the requests taken together and completes them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void read_span(std::vector<std::shared_ptr<pending_read>>& span);
+
+	/// Requests not yet taken by a thread
+	std::vector<std::shared_ptr<pending_read>> pending_;
+	/// Protects the pending requests
+	std::mutex mutex_;
+	/// Wakes up the threads
+	std::condition_variable wakeup_;
+	/// Order of the requests within a priority
+	std::uint64_t sequence_ = 0;
+	/// Whether the threads should exit
+	bool done_ = false;
+	/// The buffers
+	std::shared_ptr<block_pool> pool_;
+	/// Size of the buffers
+	std::size_t block_size_ = 0;
+	/// Requests completed
+	std::atomic<std::uint64_t> requests_{0};
+	/// Reads issued to the os
+	std::atomic<std::uint64_t> reads_{0};
+	/// Bytes read from the os
+	std::atomic<std::uint64_t> bytes_{0};
+	/// The io threads
+	std::vector<std::thread> threads_;
+};
+}
@@ -189,6 +189,11 @@ uint32_t frame(bool _capture)
 	return bgfx::frame(_capture);
 }
 
+render_frame_result render_frame(int32_t _msecs)
+{
+	return bgfx::renderFrame(_msecs);
+}
+
 renderer_type get_renderer_type()
 {
 	return bgfx::getRendererType();
@@ -970,7 +975,10 @@ const std::string& get_renderer_filename_extension()
 		{renderer_type::Direct3D9, ".dx9"},   {renderer_type::Direct3D11, ".dx11"},
 		{renderer_type::Direct3D12, ".dx12"}, {renderer_type::Gnm, ".gnm"},
 		{renderer_type::Metal, ".metal"},	 {renderer_type::OpenGL, ".gl"},
-		{renderer_type::OpenGLES, ".gles"},   {renderer_type::Noop, ".noop"}};
+		{renderer_type::OpenGLES, ".gles"},
+		// the noop backend only parses the shader headers, so any compiled
+		// flavour will do. Reuse the OpenGL one produced by the linux builds.
+		{renderer_type::Noop, ".gl"}};
 
 	const auto it = types.find(bgfx::getRendererType());
 	if(it != types.cend())
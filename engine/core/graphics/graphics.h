@@ -33,6 +33,7 @@ using topology_sort = bgfx::TopologySort::Enum;
 using topology = bgfx::Topology;
 using release_fn = bgfx::ReleaseFn;
 using encoder = bgfx::Encoder;
+using render_frame_result = bgfx::RenderFrame::Enum;
 
 using transform = bgfx::Transform;
 using dynamic_index_buffer_handle = bgfx::DynamicIndexBufferHandle;
@@ -105,6 +106,9 @@ void end(encoder* _encoder);
 /**/
 uint32_t frame(bool _capture = true);
 
+/**/
+render_frame_result render_frame(int32_t _msecs = -1);
+
 /**/
 renderer_type get_renderer_type();
 
@@ -90,4 +90,56 @@ std::shared_ptr<gfx::uniform> program::get_uniform(const std::string& _name, boo
 
 	return hUniform;
 }
+
+void program::set_texture(std::uint8_t _stage, const uniform_id& _sampler, gfx::frame_buffer* frameBuffer,
+						  uint8_t _attachment /*= 0 */,
+						  std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+{
+	if(frameBuffer == nullptr)
+	{
+		return;
+	}
+
+	gfx::set_texture(_stage, get_uniform(_sampler, true)->native_handle(),
+					 frameBuffer->get_texture(_attachment)->native_handle(), _flags);
+}
+
+void program::set_texture(std::uint8_t _stage, const uniform_id& _sampler, gfx::texture* _texture,
+						  std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+{
+	if(_texture == nullptr)
+	{
+		return;
+	}
+
+	gfx::set_texture(_stage, get_uniform(_sampler, true)->native_handle(), _texture->native_handle(), _flags);
+}
+
+void program::set_uniform(const uniform_id& _id, const void* _value, uint16_t _num)
+{
+	auto uniform = get_uniform(_id);
+
+	if(uniform)
+	{
+		gfx::set_uniform(uniform->native_handle(), _value, _num);
+	}
+}
+
+gfx::uniform* program::get_uniform(const uniform_id& _id, bool texture)
+{
+	const auto index = _id.index();
+	if(index >= resolved_.size())
+	{
+		resolved_.resize(index + 1);
+	}
+
+	auto& entry = resolved_[index];
+	if(!entry.resolved || (entry.uniform == nullptr && texture))
+	{
+		entry.uniform = get_uniform(_id.name(), texture).get();
+		entry.resolved = true;
+	}
+
+	return entry.uniform;
+}
 }
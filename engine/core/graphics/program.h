@@ -12,6 +12,7 @@ struct frame_buffer;
 struct texture;
 struct shader;
 struct uniform;
+class uniform_id;
 
 struct program : public handle_impl<program_handle>
 {
@@ -88,7 +89,57 @@ struct program : public handle_impl<program_handle>
 	//-----------------------------------------------------------------------------
 	std::shared_ptr<gfx::uniform> get_uniform(const std::string& _name, bool texture = false);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_texture ()
+	/// <summary>
+	/// Same as the string version but the sampler is resolved only once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_texture(std::uint8_t _stage, const uniform_id& _sampler, gfx::frame_buffer* _handle,
+					 uint8_t _attachment = 0,
+					 std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_texture ()
+	/// <summary>
+	/// Same as the string version but the sampler is resolved only once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_texture(std::uint8_t _stage, const uniform_id& _sampler, gfx::texture* _texture,
+					 std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_uniform ()
+	/// <summary>
+	/// Same as the string version but the uniform is resolved only once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_uniform(const uniform_id& _id, const void* _value, std::uint16_t _num = 1);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_uniform ()
+	/// <summary>
+	/// Resolves the uniform for the interned name on first use and returns the
+	/// cached result afterwards. The result is null if the program does not use
+	/// the uniform (unless texture is requested, in which case a sampler is
+	/// created like the string version does).
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	gfx::uniform* get_uniform(const uniform_id& _id, bool texture = false);
+
 	/// All uniforms for this program.
 	std::unordered_map<std::string, std::shared_ptr<gfx::uniform>> uniforms;
+
+private:
+	struct resolved_uniform
+	{
+		/// Uniform for the name, null if the program does not use it.
+		gfx::uniform* uniform = nullptr;
+		/// The name was looked up already.
+		bool resolved = false;
+	};
+
+	/// Uniforms resolved by interned name index.
+	std::vector<resolved_uniform> resolved_;
 };
 }
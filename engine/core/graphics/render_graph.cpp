@@ -0,0 +1,330 @@
+#include "render_graph.h"
+#include "render_view.h"
+
+#include <algorithm>
+
+namespace gfx
+{
+constexpr std::uint32_t render_graph::invalid_index;
+
+namespace
+{
+std::uint64_t get_memory(const render_graph::texture_desc& desc)
+{
+	texture_info info;
+	calc_texture_size(info, desc.width, desc.height, 1, false, false, 1, desc.format);
+	return info.storageSize;
+}
+}
+
+bool operator==(const render_graph::texture_desc& desc1, const render_graph::texture_desc& desc2)
+{
+	return desc1.width == desc2.width && desc1.height == desc2.height && desc1.format == desc2.format &&
+		   desc1.flags == desc2.flags;
+}
+
+render_graph::builder::builder(render_graph& graph, pass_id pass)
+	: graph_(graph)
+	, pass_(pass)
+{
+}
+
+render_graph::resource_id render_graph::builder::create(const std::string& name, const texture_desc& desc)
+{
+	resource res;
+	res.name = name;
+	res.desc = desc;
+	graph_.resources_.emplace_back(std::move(res));
+	return resource_id(graph_.resources_.size() - 1);
+}
+
+render_graph::resource_id render_graph::builder::read(resource_id id)
+{
+	graph_.passes_[pass_].reads.emplace_back(id);
+	return id;
+}
+
+render_graph::resource_id render_graph::builder::write(resource_id id)
+{
+	graph_.passes_[pass_].writes.emplace_back(id);
+	return id;
+}
+
+void render_graph::builder::set_side_effect()
+{
+	graph_.passes_[pass_].side_effect = true;
+}
+
+render_graph::resources::resources(const render_graph& graph, render_view& pool)
+	: graph_(graph)
+	, pool_(pool)
+{
+}
+
+std::shared_ptr<texture> render_graph::resources::get_texture(resource_id id) const
+{
+	if(id >= graph_.resources_.size())
+	{
+		return nullptr;
+	}
+
+	const auto& res = graph_.resources_[id];
+	if(res.imported)
+	{
+		return res.external;
+	}
+
+	if(res.physical == invalid_index)
+	{
+		return nullptr;
+	}
+
+	return graph_.physicals_[res.physical].tex;
+}
+
+std::shared_ptr<frame_buffer>
+render_graph::resources::get_fbo(const std::string& id, const std::vector<resource_id>& attachments) const
+{
+	std::vector<std::shared_ptr<texture>> textures;
+	textures.reserve(attachments.size());
+	for(auto attachment : attachments)
+	{
+		auto tex = get_texture(attachment);
+		if(!tex)
+		{
+			return nullptr;
+		}
+		textures.emplace_back(std::move(tex));
+	}
+
+	return pool_.get_fbo(id, textures);
+}
+
+render_graph::resource_id render_graph::import_texture(const std::string& name, std::shared_ptr<texture> tex)
+{
+	resource res;
+	res.name = name;
+	if(tex)
+	{
+		res.desc.width = tex->info.width;
+		res.desc.height = tex->info.height;
+		res.desc.format = tex->info.format;
+		res.desc.flags = tex->flags;
+	}
+	res.external = std::move(tex);
+	res.imported = true;
+	resources_.emplace_back(std::move(res));
+	return resource_id(resources_.size() - 1);
+}
+
+render_graph::pass_id render_graph::add_pass(const std::string& name, const setup_func_t& setup,
+											 execute_func_t execute)
+{
+	pass p;
+	p.name = name;
+	p.execute = std::move(execute);
+	passes_.emplace_back(std::move(p));
+
+	const auto id = pass_id(passes_.size() - 1);
+	builder b(*this, id);
+	setup(b);
+
+	compiled_ = false;
+	return id;
+}
+
+void render_graph::compile()
+{
+	// Walk backwards so the consumers are known before their producers. A pass
+	// survives if it has side effects or writes something that is consumed later.
+	std::vector<bool> needed(resources_.size(), false);
+	for(auto it = passes_.rbegin(); it != passes_.rend(); ++it)
+	{
+		auto& p = *it;
+		bool keep = p.side_effect;
+		for(auto id : p.writes)
+		{
+			keep |= needed[id] || resources_[id].imported;
+		}
+
+		p.culled = !keep;
+		if(keep)
+		{
+			for(auto id : p.reads)
+			{
+				needed[id] = true;
+			}
+		}
+	}
+
+	// Lifetimes of the transient resources over the remaining passes.
+	for(auto& res : resources_)
+	{
+		res.first = invalid_index;
+		res.last = invalid_index;
+		res.physical = invalid_index;
+	}
+
+	for(pass_id i = 0; i < passes_.size(); ++i)
+	{
+		const auto& p = passes_[i];
+		if(p.culled)
+		{
+			continue;
+		}
+
+		const auto visit = [this, i](resource_id id) {
+			auto& res = resources_[id];
+			if(res.imported)
+			{
+				return;
+			}
+			res.first = std::min(res.first, i);
+			res.last = res.last == invalid_index ? i : std::max(res.last, i);
+		};
+		std::for_each(std::begin(p.reads), std::end(p.reads), visit);
+		std::for_each(std::begin(p.writes), std::end(p.writes), visit);
+	}
+
+	// Assign physical textures in pass order. A texture goes back to the free
+	// list after the last pass of its resource, so resources of the same pass
+	// never alias each other.
+	physicals_.clear();
+	std::vector<std::uint32_t> free_list;
+	std::vector<bool> released(resources_.size(), false);
+	for(pass_id i = 0; i < passes_.size(); ++i)
+	{
+		const auto& p = passes_[i];
+		if(p.culled)
+		{
+			continue;
+		}
+
+		const auto allocate = [this, i, &free_list](resource_id id) {
+			auto& res = resources_[id];
+			if(res.imported || res.first != i || res.physical != invalid_index)
+			{
+				return;
+			}
+
+			const auto matches = [this, &res](std::uint32_t index) {
+				return physicals_[index].desc == res.desc;
+			};
+			auto it = std::find_if(std::begin(free_list), std::end(free_list), matches);
+			if(it != std::end(free_list))
+			{
+				res.physical = *it;
+				free_list.erase(it);
+				return;
+			}
+
+			physical phys;
+			phys.desc = res.desc;
+			const auto same_desc = [&res](const physical& other) { return other.desc == res.desc; };
+			phys.ordinal =
+				std::uint32_t(std::count_if(std::begin(physicals_), std::end(physicals_), same_desc));
+			physicals_.emplace_back(std::move(phys));
+			res.physical = std::uint32_t(physicals_.size() - 1);
+		};
+		std::for_each(std::begin(p.reads), std::end(p.reads), allocate);
+		std::for_each(std::begin(p.writes), std::end(p.writes), allocate);
+
+		const auto release = [this, i, &free_list, &released](resource_id id) {
+			const auto& res = resources_[id];
+			if(res.imported || res.last != i || released[id])
+			{
+				return;
+			}
+			released[id] = true;
+			free_list.emplace_back(res.physical);
+		};
+		std::for_each(std::begin(p.reads), std::end(p.reads), release);
+		std::for_each(std::begin(p.writes), std::end(p.writes), release);
+	}
+
+	compiled_ = true;
+}
+
+void render_graph::execute(render_view& pool)
+{
+	if(!compiled_)
+	{
+		compile();
+	}
+
+	for(auto& phys : physicals_)
+	{
+		const auto& desc = phys.desc;
+		const auto id = "TRANSIENT_" + std::to_string(phys.ordinal);
+		phys.tex = pool.get_texture(id, desc.width, desc.height, false, 1, desc.format, desc.flags);
+	}
+
+	resources res(*this, pool);
+	for(auto& p : passes_)
+	{
+		if(!p.culled && p.execute)
+		{
+			p.execute(res);
+		}
+	}
+
+	// The pool keeps the textures alive until they go unused for a frame.
+	for(auto& phys : physicals_)
+	{
+		phys.tex.reset();
+	}
+}
+
+bool render_graph::is_culled(pass_id id) const
+{
+	return passes_[id].culled;
+}
+
+std::uint32_t render_graph::get_physical_index(resource_id id) const
+{
+	return resources_[id].physical;
+}
+
+render_graph::pass_id render_graph::get_first_pass(resource_id id) const
+{
+	return resources_[id].first;
+}
+
+render_graph::pass_id render_graph::get_last_pass(resource_id id) const
+{
+	return resources_[id].last;
+}
+
+const render_graph::texture_desc& render_graph::get_physical_desc(std::uint32_t index) const
+{
+	return physicals_[index].desc;
+}
+
+std::size_t render_graph::get_physical_count() const
+{
+	return physicals_.size();
+}
+
+std::uint64_t render_graph::get_transient_memory() const
+{
+	std::uint64_t total = 0;
+	for(const auto& phys : physicals_)
+	{
+		total += get_memory(phys.desc);
+	}
+	return total;
+}
+
+std::uint64_t render_graph::get_unaliased_memory() const
+{
+	std::uint64_t total = 0;
+	for(const auto& res : resources_)
+	{
+		if(!res.imported && res.physical != invalid_index)
+		{
+			total += get_memory(res.desc);
+		}
+	}
+	return total;
+}
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "format.h"
+#include "frame_buffer.h"
+#include "texture.h"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gfx
+{
+class render_view;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : render_graph (Class)
+/// <summary>
+/// Frame level description of the render passes and the render targets they
+/// read and write. Passes are declared in submission order, then the graph is
+/// compiled, which culls the passes whose results are never consumed and
+/// assigns the transient targets to physical textures. Transient targets whose
+/// lifetimes do not overlap and whose descriptions match share a texture.
+/// Compiling does not touch the gpu, only execute does.
+/// </summary>
+//-----------------------------------------------------------------------------
+class render_graph
+{
+public:
+	using resource_id = std::uint32_t;
+	using pass_id = std::uint32_t;
+	static constexpr std::uint32_t invalid_index = std::numeric_limits<std::uint32_t>::max();
+
+	struct texture_desc
+	{
+		/// Width in pixels.
+		std::uint16_t width = 0;
+		/// Height in pixels.
+		std::uint16_t height = 0;
+		/// Texture format.
+		texture_format format = texture_format::Count;
+		/// Creation flags.
+		std::uint64_t flags = get_default_rt_sampler_flags();
+	};
+
+	class builder
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : create ()
+		/// <summary>
+		/// Declares a transient target owned by the graph. It only lives between
+		/// the first and the last pass that uses it, so its first use must fully
+		/// overwrite it, e.g. by clearing.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource_id create(const std::string& name, const texture_desc& desc);
+
+		//-----------------------------------------------------------------------------
+		//  Name : read ()
+		/// <summary>
+		/// Declares that the pass samples the resource.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource_id read(resource_id id);
+
+		//-----------------------------------------------------------------------------
+		//  Name : write ()
+		/// <summary>
+		/// Declares that the pass renders to the resource.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource_id write(resource_id id);
+
+		//-----------------------------------------------------------------------------
+		//  Name : set_side_effect ()
+		/// <summary>
+		/// The pass is never culled, even if nothing reads what it writes.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void set_side_effect();
+
+	private:
+		friend class render_graph;
+		builder(render_graph& graph, pass_id pass);
+
+		/// Owning graph.
+		render_graph& graph_;
+		/// Pass being declared.
+		pass_id pass_ = invalid_index;
+	};
+
+	class resources
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : get_texture ()
+		/// <summary>
+		/// Returns the texture backing the resource for the executing pass.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::shared_ptr<texture> get_texture(resource_id id) const;
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_fbo ()
+		/// <summary>
+		/// Returns a frame buffer with the resources as attachments. Frame buffers
+		/// are cached in the pool by the textures they bind.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::shared_ptr<frame_buffer> get_fbo(const std::string& id,
+											  const std::vector<resource_id>& attachments) const;
+
+	private:
+		friend class render_graph;
+		resources(const render_graph& graph, render_view& pool);
+
+		/// Owning graph.
+		const render_graph& graph_;
+		/// Pool the frame buffers are created from.
+		render_view& pool_;
+	};
+
+	using setup_func_t = std::function<void(builder&)>;
+	using execute_func_t = std::function<void(resources&)>;
+
+	//-----------------------------------------------------------------------------
+	//  Name : import_texture ()
+	/// <summary>
+	/// Adds a texture which lives outside of the graph, e.g. a camera output that
+	/// is presented later. Passes writing imported textures are never culled and
+	/// imported textures are never aliased.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	resource_id import_texture(const std::string& name, std::shared_ptr<texture> tex);
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_pass ()
+	/// <summary>
+	/// Adds a pass. The setup function is called immediately to declare the
+	/// resources, the execute function is called from execute if the pass
+	/// survived culling.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	pass_id add_pass(const std::string& name, const setup_func_t& setup, execute_func_t execute);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compile ()
+	/// <summary>
+	/// Culls unused passes, computes the lifetimes of the transient resources and
+	/// assigns them to physical textures.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void compile();
+
+	//-----------------------------------------------------------------------------
+	//  Name : execute ()
+	/// <summary>
+	/// Creates or reuses the physical textures from the pool and executes the
+	/// remaining passes in declaration order. The pool is a regular render view,
+	/// so it releases the textures that were not used the previous frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void execute(render_view& pool);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_culled ()
+	/// <summary>
+	/// Whether the pass was removed by compile.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_culled(pass_id id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_physical_index ()
+	/// <summary>
+	/// Physical texture assigned to a transient resource, or invalid_index for
+	/// imported resources and resources no remaining pass uses.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_physical_index(resource_id id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_first_pass ()
+	/// <summary>
+	/// First remaining pass using a transient resource, or invalid_index for
+	/// imported resources and resources no remaining pass uses.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	pass_id get_first_pass(resource_id id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_last_pass ()
+	/// <summary>
+	/// Last remaining pass using a transient resource, or invalid_index for
+	/// imported resources and resources no remaining pass uses.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	pass_id get_last_pass(resource_id id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_physical_desc ()
+	/// <summary>
+	/// Description of a physical texture.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const texture_desc& get_physical_desc(std::uint32_t index) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_physical_count ()
+	/// <summary>
+	/// Number of physical textures needed for the transient resources.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_physical_count() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_transient_memory ()
+	/// <summary>
+	/// Bytes used by the physical textures after aliasing.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_transient_memory() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_unaliased_memory ()
+	/// <summary>
+	/// Bytes the used transient resources would need without aliasing.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_unaliased_memory() const;
+
+	inline std::size_t get_pass_count() const
+	{
+		return passes_.size();
+	}
+
+	inline std::size_t get_resource_count() const
+	{
+		return resources_.size();
+	}
+
+private:
+	struct pass
+	{
+		/// Debug name.
+		std::string name;
+		/// Called on execution.
+		execute_func_t execute;
+		/// Sampled resources.
+		std::vector<resource_id> reads;
+		/// Rendered to resources.
+		std::vector<resource_id> writes;
+		/// Never culled.
+		bool side_effect = false;
+		/// Removed by compile.
+		bool culled = false;
+	};
+
+	struct resource
+	{
+		/// Debug name.
+		std::string name;
+		/// Description of a transient resource.
+		texture_desc desc;
+		/// Texture of an imported resource.
+		std::shared_ptr<texture> external;
+		/// Lives outside of the graph.
+		bool imported = false;
+		/// First pass using the resource.
+		pass_id first = invalid_index;
+		/// Last pass using the resource.
+		pass_id last = invalid_index;
+		/// Assigned physical texture.
+		std::uint32_t physical = invalid_index;
+	};
+
+	struct physical
+	{
+		/// Description shared by all resources aliasing this texture.
+		texture_desc desc;
+		/// Index among the physical textures with the same description. Keeps the
+		/// pool keys stable from frame to frame.
+		std::uint32_t ordinal = 0;
+		/// Texture while executing.
+		std::shared_ptr<texture> tex;
+	};
+
+	/// Declared passes.
+	std::vector<pass> passes_;
+	/// Declared resources.
+	std::vector<resource> resources_;
+	/// Physical textures after compile.
+	std::vector<physical> physicals_;
+	/// Whether compile was called.
+	bool compiled_ = false;
+};
+
+bool operator==(const render_graph::texture_desc& desc1, const render_graph::texture_desc& desc2);
+}
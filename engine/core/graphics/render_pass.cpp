@@ -23,10 +23,23 @@ gfx::view_id generate_id()
 }
 
 render_pass::render_pass(const std::string& n)
-    : id(generate_id())
+#if ETH_PROFILER_ENABLED
+	: render_pass(n.c_str(), profiler::intern(n))
+#else
+	: render_pass(n.c_str(), nullptr)
+#endif
 {
+}
+
+render_pass::render_pass(const char* n, const char* zone_name)
+	: id(generate_id())
+#if ETH_PROFILER_ENABLED
+	, zone(zone_name)
+#endif
+{
+	(void)zone_name;
 	reset_view(id);
-	set_view_name(id, n.c_str());
+	set_view_name(id, n);
 }
 
 void render_pass::bind(const frame_buffer* fb) const
@@ -1,4 +1,5 @@
 #pragma once
+#include "../profiler/profiler.h"
 #include "frame_buffer.h"
 #include <string>
 #include <unordered_map>
@@ -18,6 +19,19 @@ struct render_pass
 	//-----------------------------------------------------------------------------
 	render_pass(const std::string& n);
 
+	//-----------------------------------------------------------------------------
+	//  Name : render_pass ()
+	/// <summary>
+	/// Passes named by a string literal use it for their profiler zone as is,
+	/// only runtime generated names are interned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <std::size_t N>
+	render_pass(const char (&n)[N])
+		: render_pass(n, n)
+	{
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : bind ()
 	/// <summary>
@@ -80,5 +94,13 @@ struct render_pass
 	static gfx::view_id get_pass();
 	///
 	gfx::view_id id;
+
+#if ETH_PROFILER_ENABLED
+	/// Cpu time spent recording the pass.
+	profiler::scoped_zone zone;
+#endif
+
+private:
+	render_pass(const char* n, const char* zone_name);
 };
 }
@@ -1,5 +1,9 @@
 #include "uniform.h"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
 namespace gfx
 {
 
@@ -14,4 +18,23 @@ uniform::uniform(handle_type_t _handle)
 	gfx::get_uniform_info(_handle, info);
 	handle = gfx::create_uniform(info.name, info.type, info.num);
 }
+
+uniform_id::uniform_id(const char* _name)
+{
+	static std::mutex mutex;
+	// deque so that the interned names never move
+	static std::deque<std::string> names;
+	static std::unordered_map<std::string, std::uint32_t> indices;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = indices.find(_name);
+	if(it == indices.end())
+	{
+		names.emplace_back(_name);
+		it = indices.emplace(names.back(), static_cast<std::uint32_t>(names.size() - 1)).first;
+	}
+
+	index_ = it->second;
+	name_ = &names[index_];
+}
 }
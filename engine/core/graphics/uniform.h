@@ -1,6 +1,7 @@
 #pragma once
 
 #include "handle_impl.h"
+#include <cstdint>
 #include <string>
 
 namespace gfx
@@ -31,4 +32,47 @@ struct uniform : public handle_impl<uniform_handle>
 	/// Uniform info
 	uniform_info info;
 };
+
+//-----------------------------------------------------------------------------
+//  Name : uniform_id (Class)
+/// <summary>
+/// Interned uniform name. Every distinct name gets a small sequential index
+/// that programs use to resolve their uniforms once instead of looking them
+/// up by string on every call. Meant to be created once, e.g.
+/// static const gfx::uniform_id u_tiling("u_tiling");
+/// </summary>
+//-----------------------------------------------------------------------------
+class uniform_id
+{
+public:
+	explicit uniform_id(const char* _name);
+
+	//-----------------------------------------------------------------------------
+	//  Name : index ()
+	/// <summary>
+	/// Sequential index of the interned name.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t index() const
+	{
+		return index_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : name ()
+	/// <summary>
+	/// The interned name. Stays valid for the lifetime of the application.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const std::string& name() const
+	{
+		return *name_;
+	}
+
+private:
+	/// Sequential index of the name.
+	std::uint32_t index_ = 0;
+	/// Interned name storage.
+	const std::string* name_ = nullptr;
+};
 }
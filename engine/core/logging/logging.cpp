@@ -1,6 +1,240 @@
 #include "logging.h"
+#include "mpsc_queue.h"
 
-int logging_obj_export_symbols()
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace logging
+{
+std::atomic<int> min_level{static_cast<int>(level::info)};
+
+namespace
+{
+/// Records waiting for the sink thread, about 2MB.
+constexpr std::size_t queue_capacity = 4096;
+
+void write_record(logger& l, const record& r)
+{
+	try
+	{
+		if(r.format == nullptr)
+		{
+			l.log(r.lvl, fmt::StringRef(r.data, r.size));
+			return;
+		}
+
+		fmt::MemoryWriter w;
+		r.format(r, w);
+		l.log(r.lvl, fmt::StringRef(w.data(), w.size()));
+	}
+	catch(const std::exception& e)
+	{
+		// A deferred format string is only checked here, the sink thread keeps going.
+		l.log(level::err, fmt::StringRef(e.what()));
+	}
+}
+
+void fill_text(record& r, level::level_enum lvl, const char* text, std::size_t size)
+{
+	r.lvl = lvl;
+	r.format = nullptr;
+	r.format_string = nullptr;
+	r.size = std::min(size, max_record_size);
+	std::memcpy(r.data, text, r.size);
+}
+
+class sink_thread
 {
-	return 0;
-}
\ No newline at end of file
+public:
+	sink_thread()
+		: queue_(queue_capacity)
+	{
+	}
+
+	~sink_thread()
+	{
+		stop();
+	}
+
+	void start(std::shared_ptr<logger> l)
+	{
+		stop();
+
+		logger_ = std::move(l);
+		running_ = true;
+		thread_ = std::thread(&sink_thread::run, this);
+	}
+
+	void stop()
+	{
+		if(!running_.exchange(false))
+		{
+			return;
+		}
+
+		wakeup_.notify_one();
+		thread_.join();
+		logger_->flush();
+	}
+
+	bool is_running() const
+	{
+		return running_.load(std::memory_order_acquire);
+	}
+
+	template <typename F>
+	void push(F&& fill)
+	{
+		while(!queue_.try_push(fill))
+		{
+			wakeup_.notify_one();
+			std::this_thread::yield();
+		}
+		pushed_.fetch_add(1, std::memory_order_release);
+
+		if(waiting_.load(std::memory_order_acquire))
+		{
+			wakeup_.notify_one();
+		}
+	}
+
+	void flush()
+	{
+		const auto target = pushed_.load(std::memory_order_acquire);
+		while(is_running() && written_.load(std::memory_order_acquire) < target)
+		{
+			wakeup_.notify_one();
+			std::this_thread::yield();
+		}
+		logger_->flush();
+	}
+
+private:
+	void run()
+	{
+		using namespace std::literals;
+
+		for(;;)
+		{
+			drain();
+			if(!is_running())
+			{
+				drain();
+				return;
+			}
+
+			// A wake up missed between the checks is caught by the timeout.
+			std::unique_lock<std::mutex> lock(mutex_);
+			waiting_.store(true, std::memory_order_release);
+			wakeup_.wait_for(lock, 10ms);
+			waiting_.store(false, std::memory_order_release);
+		}
+	}
+
+	void drain()
+	{
+		while(queue_.try_pop([this](const record& r) { write_record(*logger_, r); }))
+		{
+			written_.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	/// Records from the logging threads.
+	mpsc_queue<record> queue_;
+	/// Logger writing to the sinks, only used on the sink thread.
+	std::shared_ptr<logger> logger_;
+	/// The sink thread.
+	std::thread thread_;
+	/// Is the sink thread running.
+	std::atomic<bool> running_{false};
+	/// Is the sink thread waiting for records.
+	std::atomic<bool> waiting_{false};
+	/// Guards the wait of the sink thread.
+	std::mutex mutex_;
+	/// Wakes the sink thread.
+	std::condition_variable wakeup_;
+	/// Records pushed so far.
+	std::atomic<std::uint64_t> pushed_{0};
+	/// Records written so far.
+	std::atomic<std::uint64_t> written_{0};
+};
+
+sink_thread& get_sink_thread()
+{
+	static sink_thread instance;
+	return instance;
+}
+}
+
+std::shared_ptr<logger> create_async(const std::string& name, sink_ptr sink)
+{
+	auto l = create(name, std::move(sink));
+	l->set_level(static_cast<level::level_enum>(min_level.load()));
+	get_sink_thread().start(l);
+	return l;
+}
+
+void set_level(level::level_enum lvl)
+{
+	min_level.store(static_cast<int>(lvl), std::memory_order_relaxed);
+	if(auto l = get(APPLOG))
+	{
+		l->set_level(lvl);
+	}
+}
+
+void flush()
+{
+	auto& thread = get_sink_thread();
+	if(thread.is_running())
+	{
+		thread.flush();
+	}
+}
+
+void push(level::level_enum lvl, const char* text, std::size_t size)
+{
+	auto& thread = get_sink_thread();
+	if(thread.is_running())
+	{
+		thread.push([&](record& r) { fill_text(r, lvl, text, size); });
+		return;
+	}
+
+	if(auto l = get(APPLOG))
+	{
+		l->log(lvl, fmt::StringRef(text, size));
+	}
+}
+
+void push_deferred(level::level_enum lvl, record::format_t format, const char* format_string,
+				   void (*store)(const void*, char*), const void* args)
+{
+	const auto fill = [&](record& r) {
+		r.lvl = lvl;
+		r.format = format;
+		r.format_string = format_string;
+		r.size = 0;
+		store(args, r.data);
+	};
+
+	auto& thread = get_sink_thread();
+	if(thread.is_running())
+	{
+		thread.push(fill);
+		return;
+	}
+
+	if(auto l = get(APPLOG))
+	{
+		record r;
+		fill(r);
+		write_record(*l, r);
+	}
+}
+}
@@ -47,6 +47,15 @@ using platform_sink_st = stdout_sink_st;
 #endif
 #include <spdlog/sinks/dist_sink.h>
 #include <spdlog/sinks/file_sinks.h>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace logging
 {
 using namespace spdlog;
@@ -55,11 +64,184 @@ inline std::shared_ptr<sinks::dist_sink_mt> get_mutable_logging_container()
 	static auto sink = std::make_shared<sinks::dist_sink_mt>();
 	return sink;
 }
+
+/// Longest message passed to the sink thread, longer ones are cut.
+constexpr std::size_t max_record_size = 480;
+
+//-----------------------------------------------------------------------------
+//  Name : record (Struct)
+/// <summary>
+/// A message on its way to the sink thread. Either the formatted text or,
+/// for deferred messages, the arguments to format it from.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct record
+{
+	using format_t = void (*)(const record&, fmt::MemoryWriter&);
+
+	/// Level of the message.
+	level::level_enum lvl = level::info;
+	/// Formats a deferred message from the arguments in data, null for text.
+	format_t format = nullptr;
+	/// Format string of a deferred message.
+	const char* format_string = nullptr;
+	/// Length of the text in data.
+	std::size_t size = 0;
+	/// The text or the arguments.
+	alignas(std::max_align_t) char data[max_record_size];
+};
+
+/// Lowest level written, kept apart from the logger so it is checked without
+/// a lookup.
+extern std::atomic<int> min_level;
+
+//-----------------------------------------------------------------------------
+//  Name : create_async ()
+/// <summary>
+/// Creates and registers a logger writing to sink and starts the sink thread.
+/// Messages logged through the APPLOG macros are formatted on the calling
+/// thread into a preallocated slot and written by the sink thread, so the
+/// caller never locks, allocates or waits for the sink.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::shared_ptr<logger> create_async(const std::string& name, sink_ptr sink);
+
+//-----------------------------------------------------------------------------
+//  Name : set_level ()
+/// <summary>
+/// Lowest level written from now on.
+/// </summary>
+//-----------------------------------------------------------------------------
+void set_level(level::level_enum lvl);
+
+//-----------------------------------------------------------------------------
+//  Name : should_log ()
+/// <summary>
+/// Is a message of that level written. Checked before anything is formatted.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline bool should_log(level::level_enum lvl)
+{
+	return static_cast<int>(lvl) >= min_level.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : flush ()
+/// <summary>
+/// Waits until the sink thread wrote everything logged before the call and
+/// flushes the sinks.
+/// </summary>
+//-----------------------------------------------------------------------------
+void flush();
+
+//-----------------------------------------------------------------------------
+//  Name : push ()
+/// <summary>
+/// Hands a message to the sink thread, waiting only while the queue is full.
+/// Before create_async the message is written right away.
+/// </summary>
+//-----------------------------------------------------------------------------
+void push(level::level_enum lvl, const char* text, std::size_t size);
+
+//-----------------------------------------------------------------------------
+//  Name : push_deferred ()
+/// <summary>
+/// Like push, with store copying the arguments into the record.
+/// </summary>
+//-----------------------------------------------------------------------------
+void push_deferred(level::level_enum lvl, record::format_t format, const char* format_string,
+				   void (*store)(const void*, char*), const void* args);
+
+template <typename T>
+void log(level::level_enum lvl, const T& msg)
+{
+	fmt::MemoryWriter w;
+	w << msg;
+	push(lvl, w.data(), w.size());
+}
+
+template <typename Arg, typename... Args>
+void log(level::level_enum lvl, fmt::CStringRef format, const Arg& arg, const Args&... args)
+{
+	fmt::MemoryWriter w;
+	w.write(format, arg, args...);
+	push(lvl, w.data(), w.size());
+}
+
+namespace deferred
+{
+template <typename Tuple, std::size_t... I>
+void format(const record& r, fmt::MemoryWriter& w, std::index_sequence<I...>)
+{
+	const auto& args = *reinterpret_cast<const Tuple*>(r.data);
+	w.write(r.format_string, std::get<I>(args)...);
+}
+
+template <typename Tuple>
+void format(const record& r, fmt::MemoryWriter& w)
+{
+	format<Tuple>(r, w, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+template <typename Tuple>
+void store(const void* args, char* data)
+{
+	new(data) Tuple(*static_cast<const Tuple*>(args));
+}
+
+template <typename... Args>
+struct all_trivial : std::true_type
+{
+};
+
+template <typename Arg, typename... Args>
+struct all_trivial<Arg, Args...>
+	: std::integral_constant<bool, std::is_trivially_copyable<Arg>::value && all_trivial<Args...>::value>
+{
+};
+}
+
+//-----------------------------------------------------------------------------
+//  Name : log_deferred ()
+/// <summary>
+/// Copies the arguments as they are and formats them on the sink thread,
+/// for hot paths where even formatting costs too much. The format string and
+/// any character pointers passed must outlive the call, string literals do.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename... Args>
+void log_deferred(level::level_enum lvl, const char* format, const Args&... args)
+{
+	using tuple_t = std::tuple<std::decay_t<Args>...>;
+	static_assert(deferred::all_trivial<std::decay_t<Args>...>::value,
+				  "deferred arguments are copied as they are, format others with log");
+	static_assert(sizeof(tuple_t) <= max_record_size, "deferred arguments too large");
+	static_assert(alignof(tuple_t) <= alignof(std::max_align_t), "deferred arguments overaligned");
+	static_assert(std::is_trivially_destructible<tuple_t>::value, "deferred arguments are never destroyed");
+
+	const tuple_t tuple(args...);
+	push_deferred(lvl, &deferred::format<tuple_t>, format, &deferred::store<tuple_t>, &tuple);
+}
+
 #define APPLOG "Log"
-#define APPLOG_INFO(...) spdlog::get(APPLOG)->info(__VA_ARGS__)
-#define APPLOG_TRACE(...) spdlog::get(APPLOG)->trace(__VA_ARGS__)
-#define APPLOG_ERROR(...) spdlog::get(APPLOG)->error(__VA_ARGS__)
-#define APPLOG_WARNING(...) spdlog::get(APPLOG)->warn(__VA_ARGS__)
-#define APPLOG_NOTICE(...) spdlog::get(APPLOG)->notice(__VA_ARGS__)
+#define APPLOG_LOG(lvl, ...)                                                                                 \
+	do                                                                                                       \
+	{                                                                                                        \
+		if(logging::should_log(lvl))                                                                         \
+			logging::log(lvl, __VA_ARGS__);                                                                  \
+	} while(false)
+#define APPLOG_DEFERRED(lvl, ...)                                                                            \
+	do                                                                                                       \
+	{                                                                                                        \
+		if(logging::should_log(lvl))                                                                         \
+			logging::log_deferred(lvl, __VA_ARGS__);                                                         \
+	} while(false)
+#define APPLOG_INFO(...) APPLOG_LOG(logging::level::info, __VA_ARGS__)
+#define APPLOG_TRACE(...) APPLOG_LOG(logging::level::trace, __VA_ARGS__)
+#define APPLOG_ERROR(...) APPLOG_LOG(logging::level::err, __VA_ARGS__)
+#define APPLOG_WARNING(...) APPLOG_LOG(logging::level::warn, __VA_ARGS__)
+#define APPLOG_NOTICE(...) APPLOG_LOG(logging::level::notice, __VA_ARGS__)
+#define APPLOG_TRACE_DEFERRED(...) APPLOG_DEFERRED(logging::level::trace, __VA_ARGS__)
+#define APPLOG_INFO_DEFERRED(...) APPLOG_DEFERRED(logging::level::info, __VA_ARGS__)
 #define APPLOG_SEPARATOR() APPLOG_INFO("-----------------------------")
 }
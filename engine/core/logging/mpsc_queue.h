@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace logging
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : mpsc_queue (Class)
+/// <summary>
+/// Bounded lock free queue for any number of producers and one consumer.
+/// Every slot carries a sequence number telling whether it is free, written
+/// or being written, so the elements are filled and read in place and never
+/// move. The capacity has to be a power of two.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+class mpsc_queue
+{
+public:
+	explicit mpsc_queue(std::size_t capacity)
+		: cells_(new cell[capacity])
+		, mask_(capacity - 1)
+	{
+		for(std::size_t i = 0; i < capacity; ++i)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	mpsc_queue(const mpsc_queue&) = delete;
+	mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : try_push ()
+	/// <summary>
+	/// Claims a free slot and calls fill with its element. Returns false
+	/// without calling it when the queue is full. Safe from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename F>
+	bool try_push(F&& fill)
+	{
+		auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+		cell* c = nullptr;
+		for(;;)
+		{
+			c = &cells_[pos & mask_];
+			const auto sequence = c->sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+			if(diff == 0)
+			{
+				if(enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		fill(c->data);
+		c->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : try_pop ()
+	/// <summary>
+	/// Calls consume with the oldest written element and frees its slot
+	/// afterwards. Returns false when there is none. Only one thread may pop.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename F>
+	bool try_pop(F&& consume)
+	{
+		auto& c = cells_[dequeue_pos_ & mask_];
+		const auto sequence = c.sequence.load(std::memory_order_acquire);
+		if(sequence != dequeue_pos_ + 1)
+		{
+			return false;
+		}
+
+		consume(c.data);
+		c.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+		++dequeue_pos_;
+		return true;
+	}
+
+private:
+	struct cell
+	{
+		/// Position the slot is free for, or that position plus one once written.
+		std::atomic<std::size_t> sequence;
+		/// The element.
+		T data;
+	};
+
+	/// The slots.
+	std::unique_ptr<cell[]> cells_;
+	/// Capacity minus one, to wrap positions.
+	std::size_t mask_ = 0;
+	/// Next position to write, shared by the producers.
+	alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+	/// Next position to read, owned by the consumer.
+	alignas(64) std::size_t dequeue_pos_ = 0;
+};
+}
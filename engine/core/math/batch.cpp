@@ -0,0 +1,300 @@
+#include "batch.h"
+#include "batch_kernels.h"
+#include "simd.h"
+
+#include <cassert>
+
+namespace math
+{
+namespace
+{
+static_assert(sizeof(plane) == sizeof(float) * 4, "planes are read as packed float arrays");
+
+using mul_kernel = std::size_t (*)(const kernels::bbox_in&, const float*, const kernels::bbox_out&,
+								   std::size_t);
+using mul_each_kernel = std::size_t (*)(const kernels::bbox_in&, const float* const*,
+										const kernels::bbox_out&, std::size_t);
+using classify_aabb_kernel = std::size_t (*)(const kernels::bbox_in&, const float*, std::size_t,
+											 volume_query*, std::size_t);
+using classify_plane_kernel = std::size_t (*)(const kernels::bbox_in&, const float*, plane_query*,
+											  std::size_t);
+using test_sphere_kernel = std::size_t (*)(const kernels::sphere_in&, const float*, std::size_t,
+										   std::uint8_t*, std::size_t);
+
+// Kernels of one level, a missing kernel means the scalar code does all the work.
+struct kernel_table
+{
+	mul_kernel mul = nullptr;
+	mul_each_kernel mul_each = nullptr;
+	classify_aabb_kernel classify_aabb = nullptr;
+	classify_plane_kernel classify_plane = nullptr;
+	test_sphere_kernel test_sphere = nullptr;
+};
+
+kernel_table make_sse2_table()
+{
+	kernel_table table;
+#if ETH_MATH_SSE2
+	table.mul = &kernels::mul_sse2;
+	table.mul_each = &kernels::mul_each_sse2;
+	table.classify_aabb = &kernels::classify_aabb_sse2;
+	table.classify_plane = &kernels::classify_plane_sse2;
+	table.test_sphere = &kernels::test_sphere_sse2;
+#endif
+	return table;
+}
+
+kernel_table make_avx_table()
+{
+	kernel_table table;
+#if ETH_MATH_AVX
+	table.mul = &kernels::mul_avx;
+	table.mul_each = &kernels::mul_each_avx;
+	table.classify_aabb = &kernels::classify_aabb_avx;
+	table.classify_plane = &kernels::classify_plane_avx;
+	table.test_sphere = &kernels::test_sphere_avx;
+#endif
+	return table;
+}
+
+const kernel_table& get_kernels()
+{
+	static const kernel_table tables[] = {kernel_table(), make_sse2_table(), make_avx_table()};
+	return tables[int(simd::get_level())];
+}
+
+kernels::bbox_in get_input(const bbox_soa& boxes)
+{
+	kernels::bbox_in in;
+	in.min_x = boxes.min_x.data();
+	in.min_y = boxes.min_y.data();
+	in.min_z = boxes.min_z.data();
+	in.max_x = boxes.max_x.data();
+	in.max_y = boxes.max_y.data();
+	in.max_z = boxes.max_z.data();
+	return in;
+}
+
+kernels::bbox_out get_output(bbox_soa& boxes)
+{
+	kernels::bbox_out out;
+	out.min_x = boxes.min_x.data();
+	out.min_y = boxes.min_y.data();
+	out.min_z = boxes.min_z.data();
+	out.max_x = boxes.max_x.data();
+	out.max_y = boxes.max_y.data();
+	out.max_z = boxes.max_z.data();
+	return out;
+}
+
+plane_query classify_plane(const plane& p, const bbox& bounds)
+{
+	vec3 near_point;
+	vec3 far_point;
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		const bool positive = p.data[axis] > 0.0f;
+		near_point[axis] = positive ? bounds.min[axis] : bounds.max[axis];
+		far_point[axis] = positive ? bounds.max[axis] : bounds.min[axis];
+	}
+
+	if(plane::dot_coord(p, near_point) > 0.0f)
+	{
+		return plane_query::front;
+	}
+	if(plane::dot_coord(p, far_point) < 0.0f)
+	{
+		return plane_query::back;
+	}
+	return plane_query::spanning;
+}
+}
+
+void bbox_soa::reserve(std::size_t count)
+{
+	min_x.reserve(count);
+	min_y.reserve(count);
+	min_z.reserve(count);
+	max_x.reserve(count);
+	max_y.reserve(count);
+	max_z.reserve(count);
+}
+
+void bbox_soa::resize(std::size_t count)
+{
+	min_x.resize(count);
+	min_y.resize(count);
+	min_z.resize(count);
+	max_x.resize(count);
+	max_y.resize(count);
+	max_z.resize(count);
+}
+
+void bbox_soa::clear()
+{
+	resize(0);
+}
+
+void bbox_soa::push_back(const bbox& bounds)
+{
+	min_x.push_back(bounds.min.x);
+	min_y.push_back(bounds.min.y);
+	min_z.push_back(bounds.min.z);
+	max_x.push_back(bounds.max.x);
+	max_y.push_back(bounds.max.y);
+	max_z.push_back(bounds.max.z);
+}
+
+void bbox_soa::set(std::size_t index, const bbox& bounds)
+{
+	min_x[index] = bounds.min.x;
+	min_y[index] = bounds.min.y;
+	min_z[index] = bounds.min.z;
+	max_x[index] = bounds.max.x;
+	max_y[index] = bounds.max.y;
+	max_z[index] = bounds.max.z;
+}
+
+bbox bbox_soa::get(std::size_t index) const
+{
+	return bbox(min_x[index], min_y[index], min_z[index], max_x[index], max_y[index], max_z[index]);
+}
+
+void sphere_soa::reserve(std::size_t count)
+{
+	center_x.reserve(count);
+	center_y.reserve(count);
+	center_z.reserve(count);
+	radius.reserve(count);
+}
+
+void sphere_soa::resize(std::size_t count)
+{
+	center_x.resize(count);
+	center_y.resize(count);
+	center_z.resize(count);
+	radius.resize(count);
+}
+
+void sphere_soa::clear()
+{
+	resize(0);
+}
+
+void sphere_soa::push_back(const vec3& center, float r)
+{
+	center_x.push_back(center.x);
+	center_y.push_back(center.y);
+	center_z.push_back(center.z);
+	radius.push_back(r);
+}
+
+void sphere_soa::set(std::size_t index, const vec3& center, float r)
+{
+	center_x[index] = center.x;
+	center_y[index] = center.y;
+	center_z[index] = center.z;
+	radius[index] = r;
+}
+
+namespace batch
+{
+void mul(const bbox_soa& boxes, const transform& t, bbox_soa& result)
+{
+	const auto count = boxes.size();
+	result.resize(count);
+
+	std::size_t done = 0;
+	if(auto kernel = get_kernels().mul)
+	{
+		done = kernel(get_input(boxes), value_ptr(t.get_matrix()), get_output(result), count);
+	}
+
+	for(auto i = done; i < count; ++i)
+	{
+		result.set(i, bbox::mul(boxes.get(i), t));
+	}
+}
+
+void mul(const bbox_soa& boxes, const std::vector<transform>& transforms, bbox_soa& result)
+{
+	const auto count = boxes.size();
+	assert(transforms.size() == count);
+	result.resize(count);
+
+	std::size_t done = 0;
+	if(auto kernel = get_kernels().mul_each)
+	{
+		std::vector<const float*> matrices;
+		matrices.reserve(count);
+		for(const auto& t : transforms)
+		{
+			matrices.push_back(value_ptr(t.get_matrix()));
+		}
+		done = kernel(get_input(boxes), matrices.data(), get_output(result), count);
+	}
+
+	for(auto i = done; i < count; ++i)
+	{
+		result.set(i, bbox::mul(boxes.get(i), transforms[i]));
+	}
+}
+
+void classify_aabb(const frustum& f, const bbox_soa& boxes, std::vector<volume_query>& result)
+{
+	const auto count = boxes.size();
+	result.resize(count);
+
+	std::size_t done = 0;
+	if(auto kernel = get_kernels().classify_aabb)
+	{
+		done = kernel(get_input(boxes), &f.planes[0].data[0], f.planes.size(), result.data(), count);
+	}
+
+	for(auto i = done; i < count; ++i)
+	{
+		result[i] = f.classify_aabb(boxes.get(i));
+	}
+}
+
+void classify_aabb(const plane& p, const bbox_soa& boxes, std::vector<plane_query>& result)
+{
+	const auto count = boxes.size();
+	result.resize(count);
+
+	std::size_t done = 0;
+	if(auto kernel = get_kernels().classify_plane)
+	{
+		done = kernel(get_input(boxes), &p.data[0], result.data(), count);
+	}
+
+	for(auto i = done; i < count; ++i)
+	{
+		result[i] = classify_plane(p, boxes.get(i));
+	}
+}
+
+void test_sphere(const frustum& f, const sphere_soa& spheres, std::vector<std::uint8_t>& result)
+{
+	const auto count = spheres.size();
+	result.resize(count);
+
+	std::size_t done = 0;
+	if(auto kernel = get_kernels().test_sphere)
+	{
+		kernels::sphere_in in;
+		in.center_x = spheres.center_x.data();
+		in.center_y = spheres.center_y.data();
+		in.center_z = spheres.center_z.data();
+		in.radius = spheres.radius.data();
+		done = kernel(in, &f.planes[0].data[0], f.planes.size(), result.data(), count);
+	}
+
+	for(auto i = done; i < count; ++i)
+	{
+		const vec3 center(spheres.center_x[i], spheres.center_y[i], spheres.center_z[i]);
+		result[i] = f.test_sphere(center, spheres.radius[i]) ? 1 : 0;
+	}
+}
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "bbox.h"
+#include "frustum.h"
+#include "math_types.h"
+#include "plane.h"
+#include "transform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace math
+{
+//-----------------------------------------------------------------------------
+// Main class declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : bbox_soa (Struct)
+/// <summary>
+/// Bounding boxes stored as one array per component, the layout the batch
+/// functions operate on.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct bbox_soa
+{
+	void reserve(std::size_t count);
+	void resize(std::size_t count);
+	void clear();
+	void push_back(const bbox& bounds);
+	void set(std::size_t index, const bbox& bounds);
+	bbox get(std::size_t index) const;
+
+	inline std::size_t size() const
+	{
+		return min_x.size();
+	}
+
+	std::vector<float> min_x;
+	std::vector<float> min_y;
+	std::vector<float> min_z;
+	std::vector<float> max_x;
+	std::vector<float> max_y;
+	std::vector<float> max_z;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : sphere_soa (Struct)
+/// <summary>
+/// Bounding spheres stored as one array per component.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct sphere_soa
+{
+	void reserve(std::size_t count);
+	void resize(std::size_t count);
+	void clear();
+	void push_back(const vec3& center, float r);
+	void set(std::size_t index, const vec3& center, float r);
+
+	inline std::size_t size() const
+	{
+		return center_x.size();
+	}
+
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> radius;
+};
+
+//-----------------------------------------------------------------------------
+// Batch versions of the bbox, frustum and plane queries. They use the
+// instruction set reported by simd::get_level() and give the same results
+// as the scalar functions they mirror. The result containers are resized to
+// the input size, a box batch may be transformed in place.
+//-----------------------------------------------------------------------------
+namespace batch
+{
+//-----------------------------------------------------------------------------
+//  Name : mul ()
+/// <summary>
+/// Transforms every box by the same transform, like bbox::mul.
+/// </summary>
+//-----------------------------------------------------------------------------
+void mul(const bbox_soa& boxes, const transform& t, bbox_soa& result);
+
+//-----------------------------------------------------------------------------
+//  Name : mul ()
+/// <summary>
+/// Transforms every box by the transform with the same index.
+/// </summary>
+//-----------------------------------------------------------------------------
+void mul(const bbox_soa& boxes, const std::vector<transform>& transforms, bbox_soa& result);
+
+//-----------------------------------------------------------------------------
+//  Name : classify_aabb ()
+/// <summary>
+/// Classifies every box against the frustum, like frustum::classify_aabb.
+/// </summary>
+//-----------------------------------------------------------------------------
+void classify_aabb(const frustum& f, const bbox_soa& boxes, std::vector<volume_query>& result);
+
+//-----------------------------------------------------------------------------
+//  Name : classify_aabb ()
+/// <summary>
+/// Classifies every box against the plane. Boxes touching the plane are
+/// reported as spanning it.
+/// </summary>
+//-----------------------------------------------------------------------------
+void classify_aabb(const plane& p, const bbox_soa& boxes, std::vector<plane_query>& result);
+
+//-----------------------------------------------------------------------------
+//  Name : test_sphere ()
+/// <summary>
+/// Tests every sphere against the frustum, like frustum::test_sphere.
+/// Visible spheres are set to 1.
+/// </summary>
+//-----------------------------------------------------------------------------
+void test_sphere(const frustum& f, const sphere_soa& spheres, std::vector<std::uint8_t>& result);
+}
+}
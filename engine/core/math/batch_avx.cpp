@@ -0,0 +1,74 @@
+#include "batch_kernels.h"
+
+// Compiled with avx enabled, see the CMakeLists.txt. Nothing but the kernels
+// may live here, they only run after the cpu was checked for avx.
+
+#if ETH_MATH_AVX
+#include <immintrin.h>
+
+namespace math
+{
+namespace kernels
+{
+namespace
+{
+struct avx_ops
+{
+	using reg = __m256;
+	static constexpr std::size_t width = 8;
+
+	static inline reg zero()
+	{
+		return _mm256_setzero_ps();
+	}
+	static inline reg set1(float v)
+	{
+		return _mm256_set1_ps(v);
+	}
+	static inline reg load(const float* p)
+	{
+		return _mm256_loadu_ps(p);
+	}
+	static inline void store(float* p, reg v)
+	{
+		_mm256_storeu_ps(p, v);
+	}
+	static inline reg add(reg a, reg b)
+	{
+		return _mm256_add_ps(a, b);
+	}
+	static inline reg mul(reg a, reg b)
+	{
+		return _mm256_mul_ps(a, b);
+	}
+	static inline reg min(reg a, reg b)
+	{
+		return _mm256_min_ps(a, b);
+	}
+	static inline reg max(reg a, reg b)
+	{
+		return _mm256_max_ps(a, b);
+	}
+	static inline reg cmpgt(reg a, reg b)
+	{
+		return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+	}
+	static inline reg cmpge(reg a, reg b)
+	{
+		return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+	}
+	static inline reg bit_or(reg a, reg b)
+	{
+		return _mm256_or_ps(a, b);
+	}
+	static inline int mask(reg v)
+	{
+		return _mm256_movemask_ps(v);
+	}
+};
+}
+
+ETH_MATH_DEFINE_KERNELS(avx, avx_ops)
+}
+}
+#endif
@@ -0,0 +1,326 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Batch kernels, private to the math library. The kernels are written once
+// against an Ops type wrapping the registers of an instruction set and are
+// instantiated in batch_sse2.cpp and batch_avx.cpp. Only raw arrays cross
+// this header, so the avx translation unit does not emit inline functions
+// the rest of the program could pick up.
+//-----------------------------------------------------------------------------
+#include "math_types.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ETH_MATH_SSE2 1
+#else
+#define ETH_MATH_SSE2 0
+#endif
+
+// Set by the build when batch_avx.cpp is compiled with avx enabled.
+#ifndef ETH_MATH_AVX
+#define ETH_MATH_AVX 0
+#endif
+
+namespace math
+{
+namespace kernels
+{
+struct bbox_in
+{
+	const float* min_x = nullptr;
+	const float* min_y = nullptr;
+	const float* min_z = nullptr;
+	const float* max_x = nullptr;
+	const float* max_y = nullptr;
+	const float* max_z = nullptr;
+};
+
+struct bbox_out
+{
+	float* min_x = nullptr;
+	float* min_y = nullptr;
+	float* min_z = nullptr;
+	float* max_x = nullptr;
+	float* max_y = nullptr;
+	float* max_z = nullptr;
+};
+
+struct sphere_in
+{
+	const float* center_x = nullptr;
+	const float* center_y = nullptr;
+	const float* center_z = nullptr;
+	const float* radius = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+// The kernels process the largest multiple of the register width and return
+// the number of items done, the caller finishes the rest with scalar code.
+// Matrices are column major 4x4, planes are a, b, c, d with the normals
+// pointing out of the volume.
+//-----------------------------------------------------------------------------
+#define ETH_MATH_DECLARE_KERNELS(suffix)                                                                     \
+	std::size_t mul_##suffix(const bbox_in& in, const float* matrix, const bbox_out& out,                  \
+							 std::size_t count);                                                             \
+	std::size_t mul_each_##suffix(const bbox_in& in, const float* const* matrices, const bbox_out& out,    \
+								  std::size_t count);                                                        \
+	std::size_t classify_aabb_##suffix(const bbox_in& in, const float* planes, std::size_t plane_count,    \
+									   volume_query* out, std::size_t count);                                \
+	std::size_t classify_plane_##suffix(const bbox_in& in, const float* plane, plane_query* out,           \
+										std::size_t count);                                                  \
+	std::size_t test_sphere_##suffix(const sphere_in& in, const float* planes, std::size_t plane_count,    \
+									 std::uint8_t* out, std::size_t count)
+
+#if ETH_MATH_SSE2
+ETH_MATH_DECLARE_KERNELS(sse2);
+#endif
+
+#if ETH_MATH_AVX
+ETH_MATH_DECLARE_KERNELS(avx);
+#endif
+
+#undef ETH_MATH_DECLARE_KERNELS
+
+namespace detail
+{
+// Lo and hi of one output axis of a transformed box, the same operations in
+// the same order as bbox::mul.
+template <typename Ops, typename Reg>
+inline void transform_axis(Reg c0, Reg c1, Reg c2, Reg p, Reg mn_x, Reg mn_y, Reg mn_z, Reg mx_x, Reg mx_y,
+						   Reg mx_z, Reg& lo, Reg& hi)
+{
+	const Reg xa = Ops::mul(c0, mn_x);
+	const Reg xb = Ops::mul(c0, mx_x);
+	const Reg ya = Ops::mul(c1, mn_y);
+	const Reg yb = Ops::mul(c1, mx_y);
+	const Reg za = Ops::mul(c2, mn_z);
+	const Reg zb = Ops::mul(c2, mx_z);
+	lo = Ops::add(Ops::add(Ops::add(Ops::min(xa, xb), Ops::min(ya, yb)), Ops::min(za, zb)), p);
+	hi = Ops::add(Ops::add(Ops::add(Ops::max(xa, xb), Ops::max(ya, yb)), Ops::max(za, zb)), p);
+}
+
+template <typename Ops, typename Reg>
+inline void transform_boxes(const Reg (&m)[12], const bbox_in& in, const bbox_out& out, std::size_t i)
+{
+	const Reg mn_x = Ops::load(in.min_x + i);
+	const Reg mn_y = Ops::load(in.min_y + i);
+	const Reg mn_z = Ops::load(in.min_z + i);
+	const Reg mx_x = Ops::load(in.max_x + i);
+	const Reg mx_y = Ops::load(in.max_y + i);
+	const Reg mx_z = Ops::load(in.max_z + i);
+
+	Reg lo;
+	Reg hi;
+	transform_axis<Ops>(m[0], m[3], m[6], m[9], mn_x, mn_y, mn_z, mx_x, mx_y, mx_z, lo, hi);
+	Ops::store(out.min_x + i, lo);
+	Ops::store(out.max_x + i, hi);
+	transform_axis<Ops>(m[1], m[4], m[7], m[10], mn_x, mn_y, mn_z, mx_x, mx_y, mx_z, lo, hi);
+	Ops::store(out.min_y + i, lo);
+	Ops::store(out.max_y + i, hi);
+	transform_axis<Ops>(m[2], m[5], m[8], m[11], mn_x, mn_y, mn_z, mx_x, mx_y, mx_z, lo, hi);
+	Ops::store(out.min_z + i, lo);
+	Ops::store(out.max_z + i, hi);
+}
+
+// Elements of the axes and the position, in the order transform_boxes reads them.
+constexpr std::size_t matrix_elements[12] = {0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14};
+
+template <typename Ops>
+inline std::size_t mul(const bbox_in& in, const float* matrix, const bbox_out& out, std::size_t count)
+{
+	using reg = typename Ops::reg;
+	reg m[12];
+	for(std::size_t e = 0; e < 12; ++e)
+	{
+		m[e] = Ops::set1(matrix[matrix_elements[e]]);
+	}
+
+	std::size_t i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+	{
+		transform_boxes<Ops>(m, in, out, i);
+	}
+	return i;
+}
+
+template <typename Ops>
+inline std::size_t mul_each(const bbox_in& in, const float* const* matrices, const bbox_out& out,
+							std::size_t count)
+{
+	using reg = typename Ops::reg;
+	std::size_t i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+	{
+		// Transpose the matrices of the lanes.
+		float lanes[12][Ops::width];
+		for(std::size_t k = 0; k < Ops::width; ++k)
+		{
+			const float* matrix = matrices[i + k];
+			for(std::size_t e = 0; e < 12; ++e)
+			{
+				lanes[e][k] = matrix[matrix_elements[e]];
+			}
+		}
+
+		reg m[12];
+		for(std::size_t e = 0; e < 12; ++e)
+		{
+			m[e] = Ops::load(lanes[e]);
+		}
+		transform_boxes<Ops>(m, in, out, i);
+	}
+	return i;
+}
+
+// Distance of the points that are nearest to and farthest along the plane
+// normal, picked per axis by the sign of the normal like frustum::classify_aabb.
+template <typename Ops, typename Reg>
+inline void plane_extents(const bbox_in& in, const float* plane, std::size_t i, Reg& near_dist, Reg& far_dist)
+{
+	const bool px = plane[0] > 0.0f;
+	const bool py = plane[1] > 0.0f;
+	const bool pz = plane[2] > 0.0f;
+	const Reg a = Ops::set1(plane[0]);
+	const Reg b = Ops::set1(plane[1]);
+	const Reg c = Ops::set1(plane[2]);
+	const Reg d = Ops::set1(plane[3]);
+
+	const Reg near_x = Ops::load((px ? in.min_x : in.max_x) + i);
+	const Reg near_y = Ops::load((py ? in.min_y : in.max_y) + i);
+	const Reg near_z = Ops::load((pz ? in.min_z : in.max_z) + i);
+	const Reg far_x = Ops::load((px ? in.max_x : in.min_x) + i);
+	const Reg far_y = Ops::load((py ? in.max_y : in.min_y) + i);
+	const Reg far_z = Ops::load((pz ? in.max_z : in.min_z) + i);
+
+	near_dist = Ops::add(
+		Ops::add(Ops::add(Ops::mul(a, near_x), Ops::mul(b, near_y)), Ops::mul(c, near_z)), d);
+	far_dist = Ops::add(Ops::add(Ops::add(Ops::mul(a, far_x), Ops::mul(b, far_y)), Ops::mul(c, far_z)), d);
+}
+
+template <typename Ops>
+inline std::size_t classify_aabb(const bbox_in& in, const float* planes, std::size_t plane_count,
+								 volume_query* out, std::size_t count)
+{
+	using reg = typename Ops::reg;
+	const reg zero = Ops::zero();
+	std::size_t i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+	{
+		reg outside = zero;
+		reg intersect = zero;
+		for(std::size_t p = 0; p < plane_count; ++p)
+		{
+			reg near_dist;
+			reg far_dist;
+			plane_extents<Ops>(in, planes + p * 4, i, near_dist, far_dist);
+			outside = Ops::bit_or(outside, Ops::cmpgt(near_dist, zero));
+			intersect = Ops::bit_or(intersect, Ops::cmpgt(far_dist, zero));
+		}
+
+		const int outside_bits = Ops::mask(outside);
+		const int intersect_bits = Ops::mask(intersect);
+		for(std::size_t k = 0; k < Ops::width; ++k)
+		{
+			if((outside_bits >> k) & 1)
+				out[i + k] = volume_query::outside;
+			else if((intersect_bits >> k) & 1)
+				out[i + k] = volume_query::intersect;
+			else
+				out[i + k] = volume_query::inside;
+		}
+	}
+	return i;
+}
+
+template <typename Ops>
+inline std::size_t classify_plane(const bbox_in& in, const float* plane, plane_query* out, std::size_t count)
+{
+	using reg = typename Ops::reg;
+	const reg zero = Ops::zero();
+	std::size_t i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+	{
+		reg near_dist;
+		reg far_dist;
+		plane_extents<Ops>(in, plane, i, near_dist, far_dist);
+
+		const int front_bits = Ops::mask(Ops::cmpgt(near_dist, zero));
+		const int back_bits = Ops::mask(Ops::cmpgt(zero, far_dist));
+		for(std::size_t k = 0; k < Ops::width; ++k)
+		{
+			if((front_bits >> k) & 1)
+				out[i + k] = plane_query::front;
+			else if((back_bits >> k) & 1)
+				out[i + k] = plane_query::back;
+			else
+				out[i + k] = plane_query::spanning;
+		}
+	}
+	return i;
+}
+
+template <typename Ops>
+inline std::size_t test_sphere(const sphere_in& in, const float* planes, std::size_t plane_count,
+							   std::uint8_t* out, std::size_t count)
+{
+	using reg = typename Ops::reg;
+	std::size_t i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+	{
+		const reg x = Ops::load(in.center_x + i);
+		const reg y = Ops::load(in.center_y + i);
+		const reg z = Ops::load(in.center_z + i);
+		const reg r = Ops::load(in.radius + i);
+
+		reg outside = Ops::zero();
+		for(std::size_t p = 0; p < plane_count; ++p)
+		{
+			const float* plane = planes + p * 4;
+			const reg dist = Ops::add(Ops::add(Ops::add(Ops::mul(Ops::set1(plane[0]), x),
+														Ops::mul(Ops::set1(plane[1]), y)),
+											   Ops::mul(Ops::set1(plane[2]), z)),
+									  Ops::set1(plane[3]));
+			outside = Ops::bit_or(outside, Ops::cmpge(dist, r));
+		}
+
+		const int outside_bits = Ops::mask(outside);
+		for(std::size_t k = 0; k < Ops::width; ++k)
+		{
+			out[i + k] = ((outside_bits >> k) & 1) ? 0 : 1;
+		}
+	}
+	return i;
+}
+}
+
+// Defines the kernels declared above for an Ops type.
+#define ETH_MATH_DEFINE_KERNELS(suffix, ops)                                                                 \
+	std::size_t mul_##suffix(const bbox_in& in, const float* matrix, const bbox_out& out,                  \
+							 std::size_t count)                                                              \
+	{                                                                                                        \
+		return detail::mul<ops>(in, matrix, out, count);                                                     \
+	}                                                                                                        \
+	std::size_t mul_each_##suffix(const bbox_in& in, const float* const* matrices, const bbox_out& out,    \
+								  std::size_t count)                                                         \
+	{                                                                                                        \
+		return detail::mul_each<ops>(in, matrices, out, count);                                              \
+	}                                                                                                        \
+	std::size_t classify_aabb_##suffix(const bbox_in& in, const float* planes, std::size_t plane_count,    \
+									   volume_query* out, std::size_t count)                                 \
+	{                                                                                                        \
+		return detail::classify_aabb<ops>(in, planes, plane_count, out, count);                              \
+	}                                                                                                        \
+	std::size_t classify_plane_##suffix(const bbox_in& in, const float* plane, plane_query* out,           \
+										std::size_t count)                                                   \
+	{                                                                                                        \
+		return detail::classify_plane<ops>(in, plane, out, count);                                           \
+	}                                                                                                        \
+	std::size_t test_sphere_##suffix(const sphere_in& in, const float* planes, std::size_t plane_count,    \
+									 std::uint8_t* out, std::size_t count)                                   \
+	{                                                                                                        \
+		return detail::test_sphere<ops>(in, planes, plane_count, out, count);                                \
+	}
+}
+}
@@ -0,0 +1,71 @@
+#include "batch_kernels.h"
+
+#if ETH_MATH_SSE2
+#include <emmintrin.h>
+
+namespace math
+{
+namespace kernels
+{
+namespace
+{
+struct sse2_ops
+{
+	using reg = __m128;
+	static constexpr std::size_t width = 4;
+
+	static inline reg zero()
+	{
+		return _mm_setzero_ps();
+	}
+	static inline reg set1(float v)
+	{
+		return _mm_set1_ps(v);
+	}
+	static inline reg load(const float* p)
+	{
+		return _mm_loadu_ps(p);
+	}
+	static inline void store(float* p, reg v)
+	{
+		_mm_storeu_ps(p, v);
+	}
+	static inline reg add(reg a, reg b)
+	{
+		return _mm_add_ps(a, b);
+	}
+	static inline reg mul(reg a, reg b)
+	{
+		return _mm_mul_ps(a, b);
+	}
+	static inline reg min(reg a, reg b)
+	{
+		return _mm_min_ps(a, b);
+	}
+	static inline reg max(reg a, reg b)
+	{
+		return _mm_max_ps(a, b);
+	}
+	static inline reg cmpgt(reg a, reg b)
+	{
+		return _mm_cmpgt_ps(a, b);
+	}
+	static inline reg cmpge(reg a, reg b)
+	{
+		return _mm_cmpge_ps(a, b);
+	}
+	static inline reg bit_or(reg a, reg b)
+	{
+		return _mm_or_ps(a, b);
+	}
+	static inline int mask(reg v)
+	{
+		return _mm_movemask_ps(v);
+	}
+};
+}
+
+ETH_MATH_DEFINE_KERNELS(sse2, sse2_ops)
+}
+}
+#endif
@@ -0,0 +1,197 @@
+#include "bvh.h"
+#include <algorithm>
+#include <numeric>
+
+namespace math
+{
+///////////////////////////////////////////////////////////////////////////////
+// bvh Member Functions
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+//  Name : build ()
+/// <summary>
+/// Builds the hierarchy over the specified primitive bounds. Nodes are split
+/// at the middle of the longest axis of the primitive centers, falling back
+/// to a median split when that would leave one side empty. Deep down the
+/// tree only median splits are made, which keeps it within max_depth levels
+/// however the primitives are clustered.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::build(const std::vector<bbox>& primitive_bounds, std::uint32_t max_leaf_size /* = 4 */)
+{
+	clear();
+	if(primitive_bounds.empty())
+	{
+		return;
+	}
+
+	const auto count = static_cast<std::uint32_t>(primitive_bounds.size());
+	primitives_.resize(count);
+	std::iota(std::begin(primitives_), std::end(primitives_), 0u);
+
+	std::vector<vec3> centers;
+	centers.reserve(count);
+	for(const auto& bounds : primitive_bounds)
+	{
+		centers.emplace_back(bounds.get_center());
+	}
+
+	nodes_.reserve(std::size_t(count) * 2);
+	build_node(primitive_bounds, centers, 0, count, std::max<std::uint32_t>(1, max_leaf_size), 0);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : clear ()
+/// <summary>
+/// Releases all nodes.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::clear()
+{
+	nodes_.clear();
+	primitives_.clear();
+}
+
+std::uint32_t bvh::build_node(const std::vector<bbox>& primitive_bounds, const std::vector<vec3>& centers,
+							  std::uint32_t begin, std::uint32_t end, std::uint32_t max_leaf_size,
+							  std::uint32_t depth)
+{
+	// Median splits halve the count, so 32 more levels reach the leaves of
+	// any 32 bit count.
+	constexpr std::uint32_t max_midpoint_depth = max_depth - 33;
+
+	const auto index = static_cast<std::uint32_t>(nodes_.size());
+	nodes_.emplace_back();
+
+	bbox bounds;
+	bbox center_bounds;
+	bounds.reset();
+	center_bounds.reset();
+	for(std::uint32_t i = begin; i < end; ++i)
+	{
+		const auto primitive = primitives_[i];
+		bounds.add_point(primitive_bounds[primitive].min);
+		bounds.add_point(primitive_bounds[primitive].max);
+		center_bounds.add_point(centers[primitive]);
+	}
+
+	nodes_[index].min = bounds.min;
+	nodes_[index].max = bounds.max;
+
+	const auto count = end - begin;
+	if(count <= max_leaf_size)
+	{
+		nodes_[index].first = begin;
+		nodes_[index].count = count;
+		return index;
+	}
+
+	const auto extents = center_bounds.get_dimensions();
+	int axis = 0;
+	if(extents.y > extents[axis])
+	{
+		axis = 1;
+	}
+	if(extents.z > extents[axis])
+	{
+		axis = 2;
+	}
+
+	const float split = center_bounds.get_center()[axis];
+	auto first = std::begin(primitives_) + begin;
+	auto last = std::begin(primitives_) + end;
+	auto middle = first;
+	if(depth < max_midpoint_depth)
+	{
+		middle = std::partition(first, last, [&centers, axis, split](std::uint32_t primitive) {
+			return centers[primitive][axis] < split;
+		});
+	}
+
+	if(middle == first || middle == last)
+	{
+		middle = first + (count / 2);
+		std::nth_element(first, middle, last, [&centers, axis](std::uint32_t lhs, std::uint32_t rhs) {
+			return centers[lhs][axis] < centers[rhs][axis];
+		});
+	}
+
+	const auto mid = static_cast<std::uint32_t>(middle - std::begin(primitives_));
+	build_node(primitive_bounds, centers, begin, mid, max_leaf_size, depth + 1);
+	const auto right = build_node(primitive_bounds, centers, mid, end, max_leaf_size, depth + 1);
+	nodes_[index].first = right;
+	nodes_[index].count = 0;
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : intersect_node () (Static)
+/// <summary>
+/// Slab test of the ray against the node bounds. The distance to the entry
+/// point (or zero when the origin is inside) is returned via the distance
+/// parameter.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool bvh::intersect_node(const node& n, const vec3& origin, const vec3& inv_direction, float max_distance,
+						 float& distance)
+{
+	const float tx1 = (n.min.x - origin.x) * inv_direction.x;
+	const float tx2 = (n.max.x - origin.x) * inv_direction.x;
+	const float ty1 = (n.min.y - origin.y) * inv_direction.y;
+	const float ty2 = (n.max.y - origin.y) * inv_direction.y;
+	const float tz1 = (n.min.z - origin.z) * inv_direction.z;
+	const float tz2 = (n.max.z - origin.z) * inv_direction.z;
+
+	const float t_min =
+		std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), 0.0f));
+	const float t_max = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)),
+								 std::min(std::max(tz1, tz2), max_distance));
+
+	distance = t_min;
+	return t_max >= t_min;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : intersect_triangle () (Static)
+/// <summary>
+/// Two sided Moller-Trumbore ray / triangle test. On success the distance
+/// along the (not necessarily normalized) direction is returned.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool bvh::intersect_triangle(const vec3& origin, const vec3& direction, const vec3& v0, const vec3& v1,
+							 const vec3& v2, float& distance)
+{
+	const vec3 edge1 = v1 - v0;
+	const vec3 edge2 = v2 - v0;
+	const vec3 p = cross(direction, edge2);
+	const float det = dot(edge1, p);
+	if(abs(det) < epsilon<float>() * epsilon<float>())
+	{
+		return false;
+	}
+
+	const float inv_det = 1.0f / det;
+	const vec3 s = origin - v0;
+	const float u = dot(s, p) * inv_det;
+	if(u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	const vec3 q = cross(s, edge1);
+	const float v = dot(direction, q) * inv_det;
+	if(v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	const float t = dot(edge2, q) * inv_det;
+	if(t < 0.0f)
+	{
+		return false;
+	}
+
+	distance = t;
+	return true;
+}
+}
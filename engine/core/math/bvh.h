@@ -0,0 +1,180 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// bvh Header Includes
+//-----------------------------------------------------------------------------
+#include "bbox.h"
+#include "math_types.h"
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace math
+{
+using namespace glm;
+//-----------------------------------------------------------------------------
+// Main class declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : bvh (Class)
+/// <summary>
+/// Bounding volume hierarchy over an arbitrary set of primitives described
+/// only by their bounding boxes. Nodes are stored flat in depth first order
+/// so that the left child of an inner node always directly follows it.
+/// </summary>
+//-----------------------------------------------------------------------------
+class bvh
+{
+public:
+	/// Deepest a node can be, the raycast stack holds one entry per level.
+	static constexpr std::uint32_t max_depth = 64;
+
+	struct node
+	{
+		/// Node bounds minimum.
+		vec3 min;
+		/// Right child index for inner nodes, first primitive for leaves.
+		std::uint32_t first = 0;
+		/// Node bounds maximum.
+		vec3 max;
+		/// Primitive count, zero for inner nodes.
+		std::uint32_t count = 0;
+	};
+
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	void build(const std::vector<bbox>& primitive_bounds, std::uint32_t max_leaf_size = 4);
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Walks the nodes hit by the ray front to back and calls the specified
+	/// function for every primitive in them as f(primitive_index, max_distance).
+	/// The function should return true and shorten max_distance when the
+	/// primitive was hit, which lets the walk skip everything behind it.
+	/// Returns true if any primitive was hit.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename F>
+	bool raycast(const vec3& origin, const vec3& direction, float& max_distance, F&& f) const;
+
+	//-------------------------------------------------------------------------
+	// Public Inline Methods
+	//-------------------------------------------------------------------------
+	inline bool empty() const
+	{
+		return nodes_.empty();
+	}
+	inline const std::vector<node>& get_nodes() const
+	{
+		return nodes_;
+	}
+	inline const std::vector<std::uint32_t>& get_primitives() const
+	{
+		return primitives_;
+	}
+
+	//-------------------------------------------------------------------------
+	// Public Static Functions
+	//-------------------------------------------------------------------------
+	static bool intersect_node(const node& n, const vec3& origin, const vec3& inv_direction,
+							   float max_distance, float& distance);
+	static bool intersect_triangle(const vec3& origin, const vec3& direction, const vec3& v0,
+								   const vec3& v1, const vec3& v2, float& distance);
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Methods
+	//-------------------------------------------------------------------------
+	std::uint32_t build_node(const std::vector<bbox>& primitive_bounds, const std::vector<vec3>& centers,
+							 std::uint32_t begin, std::uint32_t end, std::uint32_t max_leaf_size,
+							 std::uint32_t depth);
+
+	//-------------------------------------------------------------------------
+	// Private Member Variables
+	//-------------------------------------------------------------------------
+	/// Flattened nodes, root first.
+	std::vector<node> nodes_;
+	/// Primitive indices referenced by the leaves.
+	std::vector<std::uint32_t> primitives_;
+};
+
+template <typename F>
+inline bool bvh::raycast(const vec3& origin, const vec3& direction, float& max_distance, F&& f) const
+{
+	if(nodes_.empty())
+	{
+		return false;
+	}
+
+	const vec3 inv_direction = {direction.x != 0.0f ? 1.0f / direction.x : std::numeric_limits<float>::max(),
+								direction.y != 0.0f ? 1.0f / direction.y : std::numeric_limits<float>::max(),
+								direction.z != 0.0f ? 1.0f / direction.z : std::numeric_limits<float>::max()};
+
+	float distance = 0.0f;
+	if(!intersect_node(nodes_[0], origin, inv_direction, max_distance, distance))
+	{
+		return false;
+	}
+
+	bool hit = false;
+	// build keeps the tree within max_depth levels, the stack never holds
+	// more than one entry per level.
+	std::uint32_t stack[max_depth];
+	std::uint32_t stack_size = 0;
+	stack[stack_size++] = 0;
+	while(stack_size > 0)
+	{
+		const auto& n = nodes_[stack[--stack_size]];
+		if(n.count > 0)
+		{
+			for(std::uint32_t i = n.first; i < n.first + n.count; ++i)
+			{
+				if(f(primitives_[i], max_distance))
+				{
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		const auto left_index = std::uint32_t(&n - nodes_.data()) + 1;
+		const auto right_index = n.first;
+		float left_distance = 0.0f;
+		float right_distance = 0.0f;
+		const bool left_hit =
+			intersect_node(nodes_[left_index], origin, inv_direction, max_distance, left_distance);
+		const bool right_hit =
+			intersect_node(nodes_[right_index], origin, inv_direction, max_distance, right_distance);
+
+		// push the far child first so the near one is visited first
+		assert(stack_size + 2 <= max_depth);
+		if(left_hit && right_hit)
+		{
+			if(left_distance < right_distance)
+			{
+				stack[stack_size++] = right_index;
+				stack[stack_size++] = left_index;
+			}
+			else
+			{
+				stack[stack_size++] = left_index;
+				stack[stack_size++] = right_index;
+			}
+		}
+		else if(left_hit)
+		{
+			stack[stack_size++] = left_index;
+		}
+		else if(right_hit)
+		{
+			stack[stack_size++] = right_index;
+		}
+	}
+
+	return hit;
+}
+}
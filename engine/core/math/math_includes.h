@@ -1,11 +1,14 @@
 #pragma once
 
+#include "batch.h"
 #include "bbox.h"
 #include "bbox_extruded.h"
 #include "bsphere.h"
+#include "bvh.h"
 #include "frustum.h"
 #include "math_types.h"
 #include "plane.h"
+#include "simd.h"
 #include "transform.h"
 #include <cstdint>
 #include <vector>
@@ -0,0 +1,129 @@
+#include "simd.h"
+#include "batch_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define ETH_MATH_X86 1
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ETH_MATH_X86 1
+#include <cpuid.h>
+#else
+#define ETH_MATH_X86 0
+#endif
+
+namespace math
+{
+namespace simd
+{
+namespace
+{
+#if ETH_MATH_X86
+bool get_cpuid(unsigned int leaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 0);
+	if(unsigned(info[0]) < leaf)
+	{
+		return false;
+	}
+	__cpuid(info, int(leaf));
+	std::copy(info, info + 4, regs);
+	return true;
+#else
+	return __get_cpuid(leaf, &regs[0], &regs[1], &regs[2], &regs[3]) != 0;
+#endif
+}
+
+#if ETH_MATH_AVX
+unsigned long long get_xcr0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax = 0;
+	unsigned int edx = 0;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+#endif
+
+level detect_level()
+{
+	level result = level::scalar;
+#if ETH_MATH_X86
+	unsigned int regs[4] = {};
+	if(!get_cpuid(1, regs))
+	{
+		return result;
+	}
+
+	const bool has_sse2 = (regs[3] & (1u << 26)) != 0;
+	const bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool has_avx = (regs[2] & (1u << 28)) != 0;
+
+#if ETH_MATH_SSE2
+	if(has_sse2)
+	{
+		result = level::sse2;
+	}
+#endif
+
+#if ETH_MATH_AVX
+	// The os also has to preserve the upper halves of the ymm registers.
+	if(result == level::sse2 && has_osxsave && has_avx && (get_xcr0() & 0x6) == 0x6)
+	{
+		result = level::avx;
+	}
+#else
+	(void)has_osxsave;
+	(void)has_avx;
+#endif
+	(void)has_sse2;
+#endif
+	return result;
+}
+
+std::atomic<level>& get_current()
+{
+	static std::atomic<level> current(get_supported_level());
+	return current;
+}
+}
+
+level get_supported_level()
+{
+	static const level supported = detect_level();
+	return supported;
+}
+
+level get_level()
+{
+	return get_current().load(std::memory_order_relaxed);
+}
+
+void set_level(level l)
+{
+	const auto supported = get_supported_level();
+	get_current().store(int(l) > int(supported) ? supported : l, std::memory_order_relaxed);
+}
+
+const char* get_level_name(level l)
+{
+	switch(l)
+	{
+		case level::sse2:
+			return "sse2";
+		case level::avx:
+			return "avx";
+		default:
+			return "scalar";
+	}
+}
+}
+}
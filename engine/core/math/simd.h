@@ -0,0 +1,51 @@
+#pragma once
+
+namespace math
+{
+namespace simd
+{
+//-----------------------------------------------------------------------------
+// Main Enumerations
+//-----------------------------------------------------------------------------
+// Instruction sets the batch functions can use, each one implies the previous.
+enum class level
+{
+	scalar = 0,
+	sse2,
+	avx
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_supported_level ()
+/// <summary>
+/// Highest level supported by the cpu, the os and the build. Detected once.
+/// </summary>
+//-----------------------------------------------------------------------------
+level get_supported_level();
+
+//-----------------------------------------------------------------------------
+//  Name : get_level ()
+/// <summary>
+/// Level used by the batch functions, the supported one unless overridden.
+/// </summary>
+//-----------------------------------------------------------------------------
+level get_level();
+
+//-----------------------------------------------------------------------------
+//  Name : set_level ()
+/// <summary>
+/// Overrides the level used by the batch functions, clamped to the supported
+/// one. Meant for comparing the implementations.
+/// </summary>
+//-----------------------------------------------------------------------------
+void set_level(level l);
+
+//-----------------------------------------------------------------------------
+//  Name : get_level_name ()
+/// <summary>
+/// Readable name of the level.
+/// </summary>
+//-----------------------------------------------------------------------------
+const char* get_level_name(level l);
+}
+}
@@ -0,0 +1,56 @@
+#include "frame_allocator.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace core
+{
+namespace frame_arena
+{
+namespace
+{
+std::atomic<std::uint64_t> current_frame{0};
+
+struct thread_arena
+{
+	/// The memory of the thread.
+	linear_arena arena;
+	/// Frame the arena was last reset for.
+	std::uint64_t frame = 0;
+	/// Reset with the frame, false once the thread resets it itself.
+	bool follows_frame = true;
+};
+
+thread_arena& get_thread_arena()
+{
+	static thread_local thread_arena state;
+	return state;
+}
+}
+
+linear_arena& get()
+{
+	auto& state = get_thread_arena();
+	if(state.follows_frame)
+	{
+		const auto frame = current_frame.load(std::memory_order_acquire);
+		if(state.frame != frame)
+		{
+			state.arena.reset();
+			state.frame = frame;
+		}
+	}
+	return state.arena;
+}
+
+void end_frame()
+{
+	current_frame.fetch_add(1, std::memory_order_release);
+}
+
+void detach_thread()
+{
+	get_thread_arena().follows_frame = false;
+}
+}
+}
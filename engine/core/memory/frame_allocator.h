@@ -0,0 +1,98 @@
+#pragma once
+
+#include "linear_arena.h"
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace core
+{
+//-----------------------------------------------------------------------------
+// Per frame memory. Every thread has its own arena, so allocating from it
+// never locks. The arenas of the threads following the frame are released
+// when the frame ends, anything allocated from them must not outlive the
+// frame. Work running across frames, like the render thread executing the
+// previous frame, detaches its thread and resets the arena itself.
+//-----------------------------------------------------------------------------
+namespace frame_arena
+{
+//-----------------------------------------------------------------------------
+//  Name : get ()
+/// <summary>
+/// Arena of the calling thread. It is reset first if the frame ended since
+/// the thread last used it.
+/// </summary>
+//-----------------------------------------------------------------------------
+linear_arena& get();
+
+//-----------------------------------------------------------------------------
+//  Name : end_frame ()
+/// <summary>
+/// Releases the memory of the current frame on every thread that follows
+/// the frame. The arenas are reset by their threads on their next use.
+/// </summary>
+//-----------------------------------------------------------------------------
+void end_frame();
+
+//-----------------------------------------------------------------------------
+//  Name : detach_thread ()
+/// <summary>
+/// The calling thread no longer follows the frame, it resets its arena
+/// itself with get().reset().
+/// </summary>
+//-----------------------------------------------------------------------------
+void detach_thread();
+}
+
+//-----------------------------------------------------------------------------
+//  Name : frame_allocator (Class)
+/// <summary>
+/// Standard allocator for containers that live no longer than the frame.
+/// Memory comes from the arena of the allocating thread and is only given
+/// back when the frame ends.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+class frame_allocator
+{
+public:
+	using value_type = T;
+
+	frame_allocator() noexcept = default;
+
+	template <typename U>
+	frame_allocator(const frame_allocator<U>&) noexcept
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(frame_arena::get().allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, std::size_t) noexcept
+	{
+	}
+
+	template <typename U>
+	bool operator==(const frame_allocator<U>&) const noexcept
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const frame_allocator<U>&) const noexcept
+	{
+		return false;
+	}
+};
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+}
@@ -0,0 +1,96 @@
+#include "linear_arena.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace core
+{
+namespace
+{
+void* allocate_from(std::uint8_t* data, std::size_t size, std::size_t& offset, std::size_t bytes,
+					std::size_t alignment)
+{
+	const auto base = reinterpret_cast<std::uintptr_t>(data);
+	const auto mask = static_cast<std::uintptr_t>(alignment - 1);
+	const auto start = (base + offset + mask) & ~mask;
+	if(start + bytes > base + size)
+	{
+		return nullptr;
+	}
+
+	offset = start + bytes - base;
+	return reinterpret_cast<void*>(start);
+}
+}
+
+linear_arena::linear_arena(std::size_t block_size)
+	: block_size_(block_size)
+{
+}
+
+void* linear_arena::allocate(std::size_t size, std::size_t alignment)
+{
+	if(!blocks_.empty())
+	{
+		auto& current = blocks_.back();
+		if(auto ptr = allocate_from(current.data.get(), current.size, current.offset, size, alignment))
+		{
+			return ptr;
+		}
+	}
+
+	add_block(size + alignment);
+	auto& current = blocks_.back();
+	auto ptr = allocate_from(current.data.get(), current.size, current.offset, size, alignment);
+	if(ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void linear_arena::reset()
+{
+	if(blocks_.size() > 1)
+	{
+		const auto capacity = get_capacity();
+		blocks_.clear();
+		add_block(capacity);
+		return;
+	}
+
+	for(auto& b : blocks_)
+	{
+		b.offset = 0;
+	}
+}
+
+std::size_t linear_arena::get_used() const
+{
+	std::size_t result = 0;
+	for(const auto& b : blocks_)
+	{
+		result += b.offset;
+	}
+	return result;
+}
+
+std::size_t linear_arena::get_capacity() const
+{
+	std::size_t result = 0;
+	for(const auto& b : blocks_)
+	{
+		result += b.size;
+	}
+	return result;
+}
+
+void linear_arena::add_block(std::size_t min_size)
+{
+	block b;
+	b.size = std::max(block_size_, min_size);
+	b.data.reset(new std::uint8_t[b.size]);
+	blocks_.emplace_back(std::move(b));
+}
+}
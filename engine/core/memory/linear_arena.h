@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace core
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : linear_arena (Class)
+/// <summary>
+/// Bump allocator handing out memory from large blocks. Single allocations
+/// are never freed, everything is released at once by reset. Not thread safe.
+/// </summary>
+//-----------------------------------------------------------------------------
+class linear_arena
+{
+public:
+	explicit linear_arena(std::size_t block_size = 256 * 1024);
+	linear_arena(const linear_arena&) = delete;
+	linear_arena& operator=(const linear_arena&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : allocate ()
+	/// <summary>
+	/// Returns size bytes aligned to alignment, which has to be a power of two.
+	/// A new block is added when the current one is full.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void* allocate(std::size_t size, std::size_t alignment);
+
+	//-----------------------------------------------------------------------------
+	//  Name : reset ()
+	/// <summary>
+	/// Releases all allocations. When more than one block was needed they are
+	/// replaced by a single block of their combined size, so an arena reset
+	/// every frame stops allocating once it has seen the largest frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void reset();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_used ()
+	/// <summary>
+	/// Bytes handed out since the last reset, including alignment padding.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_used() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_capacity ()
+	/// <summary>
+	/// Bytes owned by the arena.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_capacity() const;
+
+private:
+	struct block
+	{
+		/// The memory of the block.
+		std::unique_ptr<std::uint8_t[]> data;
+		/// Size of the block.
+		std::size_t size = 0;
+		/// Bytes used from the start of the block.
+		std::size_t offset = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_block ()
+	/// <summary>
+	/// Adds a block of at least the given size, it becomes the current one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_block(std::size_t min_size);
+
+	/// Blocks of the arena, the last one is allocated from.
+	std::vector<block> blocks_;
+	/// Size of a new block unless an allocation needs more.
+	std::size_t block_size_ = 0;
+};
+}
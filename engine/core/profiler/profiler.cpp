@@ -0,0 +1,323 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_set>
+
+namespace profiler
+{
+constexpr std::size_t collector::max_history_frames;
+constexpr std::size_t collector::max_capture_zones;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+//  Name : thread_buffer (Struct)
+/// <summary>
+/// Single producer / single consumer ring of finished zones. Only the owning
+/// thread writes and only the collector reads, so two counters are enough.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct thread_buffer
+{
+	constexpr static std::size_t capacity = 1 << 14;
+
+	bool push(const zone& z)
+	{
+		const auto write = write_.load(std::memory_order_relaxed);
+		if(write - read_.load(std::memory_order_acquire) >= capacity)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		zones_[write % capacity] = z;
+		write_.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	void drain(std::vector<zone>& out)
+	{
+		const auto read = read_.load(std::memory_order_relaxed);
+		const auto write = write_.load(std::memory_order_acquire);
+		for(auto i = read; i < write; ++i)
+		{
+			out.emplace_back(zones_[i % capacity]);
+		}
+		read_.store(write, std::memory_order_release);
+	}
+
+	/// finished zones
+	std::array<zone, capacity> zones_;
+	/// total zones written
+	std::atomic<std::uint64_t> write_{0};
+	/// total zones read
+	std::atomic<std::uint64_t> read_{0};
+	/// zones lost because the ring was full
+	std::atomic<std::uint64_t> dropped_{0};
+	/// index of the thread
+	std::uint32_t index = 0;
+	/// current nesting depth, only touched by the owning thread
+	std::uint32_t depth = 0;
+	/// name of the thread, guarded by the registry mutex
+	std::string name;
+};
+
+struct registry
+{
+	std::mutex mutex;
+	std::vector<std::unique_ptr<thread_buffer>> buffers;
+	std::unordered_set<std::string> names;
+};
+
+registry& get_registry()
+{
+	static registry reg;
+	return reg;
+}
+
+thread_buffer& get_thread_buffer()
+{
+	// buffers are never released so zones recorded by a thread that has since
+	// exited can still be drained.
+	thread_local thread_buffer* buffer = []() {
+		auto& reg = get_registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		reg.buffers.emplace_back(std::make_unique<thread_buffer>());
+		auto result = reg.buffers.back().get();
+		result->index = static_cast<std::uint32_t>(reg.buffers.size() - 1);
+		result->name = "thread " + std::to_string(result->index);
+		return result;
+	}();
+	return *buffer;
+}
+
+const std::chrono::steady_clock::time_point& get_start_time()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return start;
+}
+
+void write_json_string(std::ostream& stream, const char* str)
+{
+	stream << '"';
+	for(; str != nullptr && *str != 0; ++str)
+	{
+		const char c = *str;
+		switch(c)
+		{
+			case '"':
+				stream << "\\\"";
+				break;
+			case '\\':
+				stream << "\\\\";
+				break;
+			case '\n':
+				stream << "\\n";
+				break;
+			case '\t':
+				stream << "\\t";
+				break;
+			default:
+				if(static_cast<unsigned char>(c) >= 0x20)
+				{
+					stream << c;
+				}
+				break;
+		}
+	}
+	stream << '"';
+}
+
+void write_microseconds(std::ostream& stream, std::uint64_t ns)
+{
+	// fixed three decimals keeps the nanosecond precision without going
+	// through floating point.
+	const auto us = ns / 1000;
+	const auto rest = ns % 1000;
+	stream << us << '.' << (rest / 100) << ((rest / 10) % 10) << (rest % 10);
+}
+}
+
+std::uint64_t now()
+{
+	const auto elapsed = std::chrono::steady_clock::now() - get_start_time();
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+const char* intern(const std::string& name)
+{
+	auto& reg = get_registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	return reg.names.emplace(name).first->c_str();
+}
+
+void set_thread_name(const std::string& name)
+{
+	auto& buffer = get_thread_buffer();
+	auto& reg = get_registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	buffer.name = name;
+}
+
+scoped_zone::scoped_zone(const char* name) noexcept
+	: name_(name)
+{
+	++get_thread_buffer().depth;
+	begin_ = now();
+}
+
+scoped_zone::~scoped_zone() noexcept
+{
+	const auto end = now();
+	auto& buffer = get_thread_buffer();
+	--buffer.depth;
+
+	zone z;
+	z.name = name_;
+	z.begin = begin_;
+	z.end = end;
+	z.thread = buffer.index;
+	z.depth = buffer.depth;
+	buffer.push(z);
+}
+
+collector& collector::get()
+{
+	static collector instance;
+	return instance;
+}
+
+void collector::frame_mark()
+{
+	frame f;
+	f.begin = last_mark_;
+	f.end = now();
+	last_mark_ = f.end;
+
+	{
+		auto& reg = get_registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		for(auto& buffer : reg.buffers)
+		{
+			buffer->drain(f.zones);
+		}
+	}
+
+	if(capturing_)
+	{
+		capture_.insert(std::end(capture_), std::begin(f.zones), std::end(f.zones));
+		if(capture_.size() >= max_capture_zones)
+		{
+			capturing_ = false;
+		}
+	}
+
+	if(paused_)
+	{
+		return;
+	}
+
+	frames_.emplace_back(std::move(f));
+	while(frames_.size() > max_history_frames)
+	{
+		frames_.pop_front();
+	}
+}
+
+const std::deque<frame>& collector::get_frames() const
+{
+	return frames_;
+}
+
+std::vector<thread_info> collector::get_threads() const
+{
+	std::vector<thread_info> result;
+
+	auto& reg = get_registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	result.reserve(reg.buffers.size());
+	for(const auto& buffer : reg.buffers)
+	{
+		thread_info info;
+		info.index = buffer->index;
+		info.name = buffer->name;
+		result.emplace_back(std::move(info));
+	}
+	return result;
+}
+
+std::uint64_t collector::get_dropped_zones() const
+{
+	std::uint64_t dropped = 0;
+
+	auto& reg = get_registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	for(const auto& buffer : reg.buffers)
+	{
+		dropped += buffer->dropped_.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+void collector::set_paused(bool paused)
+{
+	paused_ = paused;
+}
+
+bool collector::is_paused() const
+{
+	return paused_;
+}
+
+void collector::start_capture()
+{
+	capture_.clear();
+	capturing_ = true;
+}
+
+void collector::stop_capture()
+{
+	capturing_ = false;
+}
+
+bool collector::is_capturing() const
+{
+	return capturing_;
+}
+
+bool collector::write_chrome_trace(std::ostream& stream) const
+{
+	stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	bool first = true;
+	for(const auto& thread : get_threads())
+	{
+		stream << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+			   << thread.index << ",\"args\":{\"name\":";
+		write_json_string(stream, thread.name.c_str());
+		stream << "}}";
+		first = false;
+	}
+
+	for(const auto& z : capture_)
+	{
+		stream << (first ? "" : ",") << "\n{\"name\":";
+		write_json_string(stream, z.name);
+		stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << z.thread << ",\"ts\":";
+		write_microseconds(stream, z.begin);
+		stream << ",\"dur\":";
+		write_microseconds(stream, z.end - z.begin);
+		stream << "}";
+		first = false;
+	}
+
+	stream << "\n]}\n";
+	return stream.good();
+}
+}
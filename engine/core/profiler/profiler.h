@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#ifndef ETH_PROFILER_ENABLED
+#define ETH_PROFILER_ENABLED 0
+#endif
+
+namespace profiler
+{
+struct zone
+{
+	/// Static or interned name of the zone.
+	const char* name = nullptr;
+	/// Start time in nanoseconds since the profiler started.
+	std::uint64_t begin = 0;
+	/// End time in nanoseconds since the profiler started.
+	std::uint64_t end = 0;
+	/// Index of the thread that recorded the zone.
+	std::uint32_t thread = 0;
+	/// Nesting depth within the thread.
+	std::uint32_t depth = 0;
+};
+
+struct frame
+{
+	/// Time of the previous frame mark.
+	std::uint64_t begin = 0;
+	/// Time of this frame mark.
+	std::uint64_t end = 0;
+	/// Zones that finished during the frame.
+	std::vector<zone> zones;
+};
+
+struct thread_info
+{
+	/// Index used by the zones.
+	std::uint32_t index = 0;
+	/// Name given with set_thread_name.
+	std::string name;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : now ()
+/// <summary>
+/// Returns the nanoseconds elapsed since the profiler started.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t now();
+
+//-----------------------------------------------------------------------------
+//  Name : intern ()
+/// <summary>
+/// Returns a pointer to a copy of the name that stays valid for the lifetime
+/// of the application. Use for zones with runtime generated names.
+/// </summary>
+//-----------------------------------------------------------------------------
+const char* intern(const std::string& name);
+
+//-----------------------------------------------------------------------------
+//  Name : set_thread_name ()
+/// <summary>
+/// Names the calling thread in the captured traces.
+/// </summary>
+//-----------------------------------------------------------------------------
+void set_thread_name(const std::string& name);
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : scoped_zone (Class)
+/// <summary>
+/// Records the time between its construction and destruction into the ring
+/// buffer of the calling thread. The name must outlive the application, so
+/// use string literals or intern().
+/// </summary>
+//-----------------------------------------------------------------------------
+class scoped_zone
+{
+public:
+	explicit scoped_zone(const char* name) noexcept;
+	~scoped_zone() noexcept;
+
+	scoped_zone(const scoped_zone&) = delete;
+	scoped_zone& operator=(const scoped_zone&) = delete;
+
+private:
+	/// Name of the zone.
+	const char* name_ = nullptr;
+	/// Start time.
+	std::uint64_t begin_ = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : collector (Class)
+/// <summary>
+/// Drains the per thread ring buffers at every frame mark and keeps a short
+/// history of frames for live display, plus an optional capture that can be
+/// exported as a Chrome trace (also readable by Perfetto).
+/// </summary>
+//-----------------------------------------------------------------------------
+class collector
+{
+public:
+	/// Frames kept for the live view.
+	constexpr static std::size_t max_history_frames = 120;
+
+	/// Zones kept by a capture before it is stopped automatically.
+	constexpr static std::size_t max_capture_zones = 4 * 1024 * 1024;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get (static )
+	/// <summary>
+	/// Returns the collector instance.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static collector& get();
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_mark ()
+	/// <summary>
+	/// Ends the current frame and collects everything the threads recorded since
+	/// the previous mark. Call once per frame from the main thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_mark();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frames ()
+	/// <summary>
+	/// Returns the most recent frames, oldest first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::deque<frame>& get_frames() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_threads ()
+	/// <summary>
+	/// Returns all threads that have recorded zones so far.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<thread_info> get_threads() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dropped_zones ()
+	/// <summary>
+	/// Returns how many zones were lost because a ring buffer was full.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_dropped_zones() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_paused ()
+	/// <summary>
+	/// While paused the frame history is frozen. Recording still goes on so
+	/// captures are not affected.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_paused(bool paused);
+	bool is_paused() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : start_capture ()
+	/// <summary>
+	/// Starts accumulating all frames for export.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void start_capture();
+	void stop_capture();
+	bool is_capturing() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_chrome_trace ()
+	/// <summary>
+	/// Writes the last capture in the Chrome trace event JSON format.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool write_chrome_trace(std::ostream& stream) const;
+
+private:
+	/// Frames for the live view.
+	std::deque<frame> frames_;
+	/// Zones of the current or last capture.
+	std::vector<zone> capture_;
+	/// Time of the previous frame mark.
+	std::uint64_t last_mark_ = 0;
+	/// Whether the history is frozen.
+	bool paused_ = false;
+	/// Whether frames are added to the capture.
+	bool capturing_ = false;
+};
+}
+
+#if ETH_PROFILER_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ::profiler::scoped_zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD(name) ::profiler::set_thread_name(name)
+#define PROFILE_FRAME() ::profiler::collector::get().frame_mark()
+#else
+#define PROFILE_SCOPE(name) (void)0
+#define PROFILE_FUNCTION() (void)0
+#define PROFILE_THREAD(name) (void)0
+#define PROFILE_FRAME() (void)0
+#endif
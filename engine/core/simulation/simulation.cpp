@@ -16,6 +16,14 @@ simulation::simulation()
 
 void simulation::run_one_frame(bool is_active)
 {
+	if(fixed_timestep_ > duration_t::zero())
+	{
+		last_frame_timepoint_ = clock_t::now();
+		timestep_ = fixed_timestep_;
+		++frame_;
+		return;
+	}
+
 	// perform waiting loop if maximum fps set
 	auto max_fps = max_fps_;
 	if(!is_active && max_fps > 0)
@@ -119,6 +127,11 @@ void simulation::set_time_smoothing_step(std::uint32_t step)
 	smoothing_step_ = step;
 }
 
+void simulation::set_fixed_timestep(duration_t step)
+{
+	fixed_timestep_ = std::max(step, duration_t::zero());
+}
+
 simulation::duration_t simulation::get_time_since_launch() const
 {
 	return clock_t::now() - launch_timepoint_;
@@ -81,6 +81,15 @@ struct simulation
 	//-----------------------------------------------------------------------------
 	void set_time_smoothing_step(std::uint32_t step);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_fixed_timestep ()
+	/// <summary>
+	/// When non zero every frame advances by exactly this time step and the
+	/// fps limits are ignored. Used for deterministic headless runs.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_fixed_timestep(duration_t step);
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_time_since_launch ()
 	/// <summary>
@@ -120,6 +129,8 @@ protected:
 	std::uint64_t frame_ = 0;
 	/// how many frames to average for the smoothed time step
 	std::uint32_t smoothing_step_ = 11;
+	/// fixed time step, zero when disabled
+	duration_t fixed_timestep_ = duration_t::zero();
 	/// frame update timer
 	timepoint_t last_frame_timepoint_ = clock_t::now();
 	/// time point when we launched
@@ -1,5 +1,6 @@
 #include "task_system.h"
 #include "../common/platform/thread.hpp"
+#include "../profiler/profiler.h"
 #include <limits>
 
 namespace core
@@ -164,6 +165,11 @@ bool task_system::task_queue::cancel(uint64_t id)
 
 void task_system::run(std::size_t idx, const std::function<bool()>& condition, duration_t pop_timeout)
 {
+	if(idx != get_owner_thread_idx())
+	{
+		PROFILE_THREAD("task_worker " + std::to_string(idx));
+	}
+
 	while(condition())
 	{
 		const auto queue_index = get_thread_queue_idx(idx);
@@ -200,6 +206,7 @@ void task_system::run(std::size_t idx, const std::function<bool()>& condition, d
 
 		if(p.first)
 		{
+			PROFILE_SCOPE("task");
 			p.second();
 		}
 	}
@@ -297,6 +304,7 @@ void task_system::run_on_owner_thread(duration_t max_duration)
 
 		if(p.first)
 		{
+			PROFILE_SCOPE("task");
 			p.second();
 		}
 
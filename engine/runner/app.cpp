@@ -0,0 +1,133 @@
+#include "app.h"
+
+#include <core/filesystem/filesystem.h>
+#include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/assets/asset_manager.h>
+#include <runtime/ecs/components/camera_component.h>
+#include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/constructs/scene.h>
+#include <runtime/ecs/systems/world_streaming.h>
+#include <runtime/system/events.h>
+
+#include <algorithm>
+
+namespace runner
+{
+void app::setup(cmd_line::parser& parser)
+{
+	runtime::app::setup(parser);
+
+	parser.set_optional<std::string>("p", "project", "", "Directory of the project, the app: protocol.");
+	parser.set_optional<std::string>("s", "scene", "",
+									 "Key of the scene to play, like app:/data/scenes/main.sc.");
+	parser.set_optional<unsigned int>("e", "entities_per_frame", 256,
+									  "Entities of a binary scene completed per frame.");
+	parser.set_optional<std::string>("w", "world", "", "Key of a world layout streamed around the camera.");
+	parser.set_optional<float>("sr", "stream_radius", 128.0f, "Cells closer to the camera are streamed in.");
+}
+
+void app::start(cmd_line::parser& parser)
+{
+	// Nothing presents the cameras to a window.
+	bool headless = false;
+	parser.try_get("headless", headless);
+	if(!headless)
+	{
+		quit_with_error("The runner only runs headless, scenes are played in the editor.");
+		return;
+	}
+
+	std::string project;
+	parser.try_get("project", project);
+	if(!project.empty())
+	{
+		fs::add_path_protocol("app:", fs::absolute(project));
+	}
+
+	unsigned int entities_per_frame = 256;
+	parser.try_get("entities_per_frame", entities_per_frame);
+	entities_per_frame_ = std::max(1u, entities_per_frame);
+
+	runtime::app::start(parser);
+
+	std::string scene_key;
+	parser.try_get("scene", scene_key);
+	if(!scene_key.empty() && !load_scene(scene_key))
+	{
+		quit_with_error("Could not load the scene " + scene_key);
+		return;
+	}
+
+	std::string world_key;
+	parser.try_get("world", world_key);
+	if(!world_key.empty())
+	{
+		auto& streaming = core::get_subsystem<runtime::world_streaming>();
+		if(!streaming.open(world_key))
+		{
+			quit_with_error("Could not load the world " + world_key);
+			return;
+		}
+		parser.try_get("stream_radius", stream_radius_);
+		world_source_ = streaming.add_source(math::vec3(0.0f, 0.0f, 0.0f), stream_radius_);
+	}
+
+	runtime::on_frame_update.connect(this, &app::frame_update);
+}
+
+void app::stop()
+{
+	runtime::on_frame_update.disconnect(this, &app::frame_update);
+
+	if(world_source_ != 0)
+	{
+		auto& streaming = core::get_subsystem<runtime::world_streaming>();
+		streaming.remove_source(world_source_);
+		streaming.close();
+	}
+
+	runtime::app::stop();
+}
+
+bool app::load_scene(const std::string& key)
+{
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	auto sc = am.load<scene>(key).get();
+	if(!sc)
+	{
+		return false;
+	}
+
+	// Binary scenes come in a chunk of entities per frame, like in a game.
+	if(!sc->instantiate(scene::mode::standard, reader_))
+	{
+		sc->instantiate(scene::mode::standard);
+	}
+
+	APPLOG_INFO("Playing {0}", key);
+	return true;
+}
+
+void app::frame_update(delta_t /*dt*/)
+{
+	PROFILE_SCOPE("runner::app::frame_update");
+
+	if(!reader_.is_done())
+	{
+		reader_.step(entities_per_frame_);
+	}
+
+	if(world_source_ != 0)
+	{
+		auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+		auto& streaming = core::get_subsystem<runtime::world_streaming>();
+		ecs.for_each<transform_component, camera_component>(
+			[&](runtime::entity, transform_component& transform, camera_component&) {
+				streaming.set_source(world_source_, transform.get_position(), stream_radius_);
+			});
+	}
+}
+}
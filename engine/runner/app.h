@@ -0,0 +1,59 @@
+#pragma once
+
+#include <runtime/ecs/constructs/binary_scene.h>
+#include <runtime/system/app.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace runner
+{
+//-----------------------------------------------------------------------------
+//  Name : app (Class)
+/// <summary>
+/// Plays a compiled scene of a project without the editor. It only runs
+/// headless, on the Noop renderer for a fixed number of frames, and reports
+/// the frame timings, so the build machines can measure a scene. A world
+/// layout is streamed around the camera of the scene.
+/// </summary>
+//-----------------------------------------------------------------------------
+class app : public runtime::app
+{
+public:
+	virtual ~app() = default;
+
+	virtual void setup(cmd_line::parser& parser);
+
+	virtual void start(cmd_line::parser& parser);
+
+	virtual void stop();
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : load_scene ()
+	/// <summary>
+	/// Starts instantiating the scene with the key. Returns false when it could
+	/// not be loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load_scene(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_update ()
+	/// <summary>
+	/// Brings in the next chunk of entities of a binary scene and moves the
+	/// streaming source to the camera.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_update(delta_t dt);
+
+	/// instantiates a binary scene over several frames
+	ecs::binary_scene::reader reader_;
+	/// entities completed per frame
+	std::size_t entities_per_frame_ = 256;
+	/// streaming source following the camera, zero without a world
+	std::uint32_t world_source_ = 0;
+	/// cells closer to the camera than that are streamed in
+	float stream_radius_ = 128.0f;
+};
+}
@@ -1,6 +1,7 @@
 #include "asset_reader.h"
 #include "../../ecs/constructs/prefab.h"
 #include "../../ecs/constructs/scene.h"
+#include "../../ecs/systems/texture_streaming.h"
 #include "../../meta/animation/animation.hpp"
 #include "../../meta/audio/sound.hpp"
 #include "../../meta/rendering/material.hpp"
@@ -9,12 +10,14 @@
 
 #include <core/audio/sound.h>
 #include <core/filesystem/filesystem.h>
+#include <core/filesystem/io_system.h>
 #include <core/graphics/index_buffer.h>
 #include <core/graphics/shader.h>
 #include <core/graphics/texture.h>
 #include <core/graphics/uniform.h>
 #include <core/graphics/vertex_buffer.h>
 #include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
 #include <core/serialization/serialization.h>
@@ -22,11 +25,36 @@
 #include <core/serialization/types/vector.hpp>
 
 #include <cstdint>
+#include <future>
+#include <istream>
 
 namespace runtime
 {
 namespace asset_reader
 {
+namespace
+{
+struct texture_read
+{
+	/// The bytes read, all of the file or the head of a streamed texture
+	fs::io_result data;
+	/// Header of a streamed texture
+	streamed_texture::header info;
+	/// First mip read of a streamed texture
+	std::uint32_t first_mip = 0;
+	/// Whether the file is a streamed texture
+	bool streamed = false;
+	/// Whether the texture was loaded with its tail only to be streamed
+	bool stream = false;
+};
+
+fs::io_request make_request(const std::string& file)
+{
+	fs::io_request request;
+	request.file = file;
+	return request;
+}
+}
 
 template <>
 bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>& output,
@@ -39,6 +67,7 @@ bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>&
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -65,43 +94,89 @@ bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>&
 		return true;
 	}
 
-	auto read_memory = std::make_shared<fs::byte_array_t>();
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
+	// Textures loaded in a streaming scope are loaded with their tail only, the screen
+	// asks for the rest. The head of the file tells whether it is a streamed texture,
+	// anything else is read whole. Out of a scope all of the mips are loaded.
+	const bool streaming = core::has_subsystems<texture_streaming>() && texture_streaming_scope::is_active();
+	auto request = make_request(compiled_absolute_key);
+	if(streaming)
+	{
+		request.size = texture_streaming::get_head_size();
+		request.clamp_to_end = true;
+	}
+
+	auto read_memory = std::make_shared<std::promise<texture_read>>();
+	auto ready_memory_task =
+		core::task_future<texture_read>::from_shared_future(read_memory->get_future().share());
+	io.read(request, [&io, read_memory, request, streaming](fs::io_result head) mutable {
+		texture_read read;
+		std::uint8_t header[sizeof(streamed_texture::header)];
+		fs::io_streambuf buffer(head);
+		if(buffer.sgetn(reinterpret_cast<char*>(header), sizeof(header)) == sizeof(header))
 		{
-			return false;
+			read.streamed = streamed_texture::read_header(header, sizeof(header), read.info);
+			read.stream = read.streamed && streaming;
+			read.first_mip = read.stream ? texture_streaming::get_tail_mip(read.info) : 0;
 		}
-		auto stream = std::ifstream{compiled_absolute_key, std::ios::in | std::ios::binary};
-		*read_memory = fs::read_stream(stream);
-
-		return true;
-	};
 
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
-	{
-		if(!read_result)
+		if(!head.ok() || read.stream || head.size() < request.size)
 		{
-			return result;
+			read.data = std::move(head);
+			read_memory->set_value(std::move(read));
+			return;
 		}
-		// if someone destroyed our memory
-		if(!read_memory)
+
+		request.size = fs::io_request::whole_file;
+		request.clamp_to_end = false;
+		io.read(request, [read_memory, read](fs::io_result data) mutable {
+			read.data = std::move(data);
+			read_memory->set_value(std::move(read));
+		});
+	});
+
+	auto create_resource_func = [ result = original, key,
+								  compiled_absolute_key ](const texture_read& read) mutable
+	{
+		PROFILE_SCOPE("asset_reader::create texture");
+
+		// if nothing was read
+		if(!read.data.ok() || read.data.size() == 0)
 		{
 			return result;
 		}
-		// if nothing was read
-		if(read_memory->empty())
+
+		if(read.streamed)
 		{
+			const auto& info = read.info;
+			if(read.data.size() < streamed_texture::get_read_size(info, read.first_mip))
+			{
+				return result;
+			}
+
+			const auto data = read.data.to_bytes();
+			auto tex = texture_streaming::create_texture(info, read.first_mip, data.data());
+			if(tex)
+			{
+				result.link->id = key;
+				result.link->asset = tex;
+				// A streamed texture loaded again keeps being streamed.
+				if(core::has_subsystems<texture_streaming>())
+				{
+					auto& streaming = core::get_subsystem<texture_streaming>();
+					if(read.stream || streaming.is_streamed(key))
+					{
+						streaming.add_texture(result, compiled_absolute_key, info, read.first_mip);
+					}
+				}
+			}
 			return result;
 		}
 
-		const gfx::memory_view* mem =
-			gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-
-		read_memory->clear();
-		read_memory.reset();
+		const gfx::memory_view* mem = gfx::alloc(static_cast<std::uint32_t>(read.data.size()));
 
 		if(nullptr != mem)
 		{
+			read.data.copy_to(mem->data);
 			auto tex = std::make_shared<gfx::texture>(mem, 0, 0, nullptr);
 			result.link->id = key;
 			result.link->asset = tex;
@@ -110,7 +185,6 @@ bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>&
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -125,6 +199,7 @@ bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& o
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -153,43 +228,21 @@ bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& o
 		return true;
 	}
 
-	auto read_memory = std::make_shared<fs::byte_array_t>();
-
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
-		{
-			return false;
-		}
-		auto stream = std::ifstream{compiled_absolute_key, std::ios::in | std::ios::binary};
-		*read_memory = fs::read_stream(stream);
-
-		return true;
-	};
-
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, key ](const fs::io_result& read_memory) mutable
 	{
-		if(!read_result)
-		{
-			return result;
-		}
-		// if someone destroyed our memory
-		if(!read_memory)
-		{
-			return result;
-		}
+		PROFILE_SCOPE("asset_reader::create shader");
+
 		// if nothing was read
-		if(read_memory->empty())
+		if(!read_memory.ok() || read_memory.size() == 0)
 		{
 			return result;
 		}
 
-		const gfx::memory_view* mem =
-			gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-		read_memory->clear();
-		read_memory.reset();
+		const gfx::memory_view* mem = gfx::alloc(static_cast<std::uint32_t>(read_memory.size()));
 
 		if(nullptr != mem)
 		{
+			read_memory.copy_to(mem->data);
 			result.link->id = key;
 			result.link->asset = std::make_shared<gfx::shader>(mem);
 		}
@@ -197,7 +250,7 @@ bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& o
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto ready_memory_task = io.read(make_request(compiled_absolute_key));
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -212,6 +265,7 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -245,15 +299,17 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 	};
 
 	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
+	auto read_memory_func = [wrapper](const fs::io_result& read_memory) mutable {
+		PROFILE_SCOPE("asset_reader::read mesh");
+
 		mesh::load_data data;
 		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-			if(stream.bad())
+			if(!read_memory.ok())
 			{
 				return false;
 			}
+			fs::io_streambuf buffer(read_memory);
+			std::istream stream(&buffer);
 
 			cereal::iarchive_binary_t ar(stream);
 
@@ -272,6 +328,8 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 
 	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create mesh");
+
 		// Build the mesh
 		if(read_result)
 		{
@@ -289,7 +347,8 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -305,6 +364,7 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -338,14 +398,16 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 	};
 
 	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
-		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
+	auto read_memory_func = [wrapper](const fs::io_result& read_memory) mutable {
+		PROFILE_SCOPE("asset_reader::read sound");
 
-			if(stream.bad())
+		{
+			if(!read_memory.ok())
 			{
 				return false;
 			}
+			fs::io_streambuf buffer(read_memory);
+			std::istream stream(&buffer);
 
 			cereal::iarchive_binary_t ar(stream);
 
@@ -356,6 +418,8 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 
 	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create sound");
+
 		if(read_result)
 		{
 			if(!wrapper->data.data.empty())
@@ -369,7 +433,8 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -385,6 +450,7 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -418,15 +484,17 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 	};
 
 	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
+	auto read_memory_func = [wrapper](const fs::io_result& read_memory) mutable {
+		PROFILE_SCOPE("asset_reader::read animation");
+
 		auto& data = *wrapper->anim;
 		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-			if(stream.bad())
+			if(!read_memory.ok())
 			{
 				return false;
 			}
+			fs::io_streambuf buffer(read_memory);
+			std::istream stream(&buffer);
 
 			cereal::iarchive_binary_t ar(stream);
 
@@ -438,6 +506,8 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 
 	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create animation");
+
 		// Build the mesh
 		if(read_result && wrapper->anim)
 		{
@@ -450,7 +520,8 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -465,6 +536,7 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 	auto& am = core::get_subsystem<asset_manager>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
@@ -501,13 +573,15 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 
 	auto wrapper = std::make_shared<wrapper_t>();
 
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
-		std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
+	auto read_memory_func = [wrapper](const fs::io_result& read_memory) mutable {
+		PROFILE_SCOPE("asset_reader::read material");
 
-		if(stream.bad())
+		if(!read_memory.ok())
 		{
 			return false;
 		}
+		fs::io_streambuf buffer(read_memory);
+		std::istream stream(&buffer);
 		cereal::iarchive_binary_t ar(stream);
 
 		try_load(ar, cereal::make_nvp("material", wrapper->material));
@@ -517,6 +591,8 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 
 	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create material");
+
 		if(read_result)
 		{
 			result.link->id = key;
@@ -527,7 +603,8 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -542,6 +619,7 @@ bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, con
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -571,22 +649,26 @@ bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, con
 
 	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
 
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
+	// Only the bytes are read here. Decoding creates the entities and their
+	// components, which the ecs allows on the owner thread only, so it runs
+	// when the prefab is instantiated.
+	auto read_memory_func = [read_memory](const fs::io_result& data) {
+		PROFILE_SCOPE("asset_reader::read prefab");
+
+		if(!read_memory || !data.ok())
 		{
 			return false;
 		}
 
-		auto stream =
-			std::fstream{compiled_absolute_key, std::fstream::in | std::fstream::out | std::ios::binary};
-		auto mem = fs::read_stream(stream);
-		*read_memory = std::istringstream(std::string(mem.begin(), mem.end()));
+		*read_memory = std::istringstream(data.to_string());
 
 		return true;
 	};
 
 	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create prefab");
+
 		if(read_result)
 		{
 			auto pfab = std::make_shared<prefab>();
@@ -599,7 +681,8 @@ bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, con
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
@@ -614,6 +697,7 @@ bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const
 	}
 
 	auto& ts = core::get_subsystem<core::task_system>();
+	auto& io = core::get_subsystem<fs::io_system>();
 
 	auto create_resource_func_fallback = [ result = original, key ]() mutable
 	{
@@ -643,22 +727,26 @@ bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const
 
 	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
 
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
+	// Only the bytes are read here. Decoding creates the entities and their
+	// components, which the ecs allows on the owner thread only, so it runs
+	// when the scene is instantiated.
+	auto read_memory_func = [read_memory](const fs::io_result& data) {
+		PROFILE_SCOPE("asset_reader::read scene");
+
+		if(!read_memory || !data.ok())
 		{
 			return false;
 		}
 
-		auto stream =
-			std::fstream{compiled_absolute_key, std::fstream::in | std::fstream::out | std::ios::binary};
-		auto mem = fs::read_stream(stream);
-		*read_memory = std::istringstream(std::string(mem.begin(), mem.end()));
+		*read_memory = std::istringstream(data.to_string());
 
 		return true;
 	};
 
 	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
 	{
+		PROFILE_SCOPE("asset_reader::create scene");
+
 		if(read_result)
 		{
 			auto sc = std::make_shared<scene>();
@@ -671,7 +759,8 @@ bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
+	auto read_task = io.read(make_request(compiled_absolute_key));
+	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func, read_task);
 	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
 	return true;
 }
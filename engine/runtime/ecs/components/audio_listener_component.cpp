@@ -1,5 +1,10 @@
 #include "audio_listener_component.h"
 
+audio_listener_component::audio_listener_component(const audio_listener_component& rhs)
+	: component_impl(rhs)
+{
+}
+
 void audio_listener_component::update(const math::transform& t)
 {
 	auto pos = t.get_position();
@@ -21,6 +21,19 @@ class audio_listener_component : public runtime::component_impl<audio_listener_c
 	REFLECTABLEV(audio_listener_component, component)
 
 public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	audio_listener_component() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : audio_listener_component ()
+	/// <summary>
+	/// Copies the component with a listener of its own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	audio_listener_component(const audio_listener_component& rhs);
+
 	//-------------------------------------------------------------------------
 	// Public Methods
 	//-------------------------------------------------------------------------
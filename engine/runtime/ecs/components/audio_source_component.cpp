@@ -1,6 +1,19 @@
 #include "audio_source_component.h"
 #include <limits>
 
+audio_source_component::audio_source_component(const audio_source_component& rhs)
+	: component_impl(rhs)
+	, auto_play_(rhs.auto_play_)
+	, loop_(rhs.loop_)
+	, volume_(rhs.volume_)
+	, pitch_(rhs.pitch_)
+	, volume_rolloff_(rhs.volume_rolloff_)
+	, range_(rhs.range_)
+	, sound_(rhs.sound_)
+{
+	apply_all();
+}
+
 void audio_source_component::update(const math::transform& t)
 {
 	auto pos = t.get_position();
@@ -23,6 +23,19 @@ class audio_source_component : public runtime::component_impl<audio_source_compo
 	REFLECTABLEV(audio_source_component, component)
 
 public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	audio_source_component() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : audio_source_component ()
+	/// <summary>
+	/// Copies the settings and the sound into a source of its own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	audio_source_component(const audio_source_component& rhs);
+
 	//-------------------------------------------------------------------------
 	// Public Virtual Methods (Override)
 
@@ -7,6 +7,13 @@ camera_component::camera_component()
 	camera_.set_viewport_size({640, 480});
 }
 
+camera_component::camera_component(const camera_component& rhs)
+	: component_impl(rhs)
+	, camera_(rhs.camera_)
+	, hdr_(rhs.hdr_)
+{
+}
+
 camera_component::~camera_component()
 {
 }
@@ -32,6 +32,14 @@ public:
 	// Constructors & Destructors
 	//-------------------------------------------------------------------------
 	camera_component();
+
+	//-----------------------------------------------------------------------------
+	//  Name : camera_component ()
+	/// <summary>
+	/// Copies the camera, the render view is not shared with the copy.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	camera_component(const camera_component& rhs);
 	virtual ~camera_component();
 
 	//-------------------------------------------------------------------------
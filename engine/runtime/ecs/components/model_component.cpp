@@ -78,6 +78,14 @@ void model_component::set_bone_entities(const std::vector<runtime::entity>& bone
 	touch();
 }
 
+void model_component::remap_entities(const runtime::entity_remap_t& remap)
+{
+	for(auto& bone : bone_entities_)
+	{
+		bone = remap(bone);
+	}
+}
+
 const std::vector<runtime::entity>& model_component::get_bone_entities() const
 {
 	return bone_entities_;
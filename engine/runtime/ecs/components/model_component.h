@@ -105,6 +105,14 @@ public:
 	//-----------------------------------------------------------------------------
 	void set_model(const model& model);
 
+	//-----------------------------------------------------------------------------
+	//  Name : remap_entities (virtual )
+	/// <summary>
+	/// Redirects the bone entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remap_entities(const runtime::entity_remap_t& remap) override;
+
 	void set_bone_entities(const std::vector<runtime::entity>& bone_entities);
 	const std::vector<runtime::entity>& get_bone_entities() const;
 	void set_bone_transforms(const std::vector<math::transform>& bone_transforms);
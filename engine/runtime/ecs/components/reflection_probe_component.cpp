@@ -1,5 +1,11 @@
 #include "reflection_probe_component.h"
 
+reflection_probe_component::reflection_probe_component(const reflection_probe_component& rhs)
+	: component_impl(rhs)
+	, probe_(rhs.probe_)
+{
+}
+
 int reflection_probe_component::compute_projected_sphere_rect(irect32_t& rect, const math::vec3& position,
 															  const math::transform& view,
 															  const math::transform& proj)
@@ -36,20 +42,17 @@ std::shared_ptr<gfx::texture> reflection_probe_component::get_cubemap()
 	static auto flags = gfx::get_default_rt_sampler_flags() | BGFX_TEXTURE_BLIT_DST;
 
 	std::uint16_t size = 256;
-	return render_view_[0].get_texture("CUBEMAP", size, true, 1, buffer_format, flags);
+	return render_view_.get_texture("CUBEMAP", size, true, 1, buffer_format, flags);
 }
 
 std::shared_ptr<gfx::frame_buffer> reflection_probe_component::get_cubemap_fbo()
 {
-	return render_view_[0].get_fbo("CUBEMAP", {get_cubemap()});
+	return render_view_.get_fbo("CUBEMAP", {get_cubemap()});
 }
 
 void reflection_probe_component::update()
 {
-	for(auto& view : render_view_)
-	{
-		view.release_unused_resources();
-	}
+	render_view_.release_unused_resources();
 }
 
 void reflection_probe_component::set_probe(const reflection_probe& probe)
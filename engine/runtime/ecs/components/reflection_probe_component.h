@@ -8,7 +8,6 @@
 #include <core/common/basetypes.hpp>
 #include <core/graphics/render_pass.h>
 #include <core/graphics/render_view.h>
-#include <array>
 //-----------------------------------------------------------------------------
 // Forward Declarations
 //-----------------------------------------------------------------------------
@@ -28,6 +27,19 @@ class reflection_probe_component : public runtime::component_impl<reflection_pro
 	SERIALIZABLE(reflection_probe_component)
 	REFLECTABLEV(reflection_probe_component, runtime::component)
 public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	reflection_probe_component() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : reflection_probe_component ()
+	/// <summary>
+	/// Copies the probe, the render view is not shared with the copy.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	reflection_probe_component(const reflection_probe_component& rhs);
+
 	//-------------------------------------------------------------------------
 	// Public Methods
 	//-------------------------------------------------------------------------
@@ -68,14 +80,13 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : get_render_view ()
 	/// <summary>
-	///
-	///
-	///
+	/// Holds the cubemap. The targets used to render the faces are transient
+	/// and come from the render graph.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	inline gfx::render_view& get_render_view(size_t idx)
+	inline gfx::render_view& get_render_view()
 	{
-		return render_view_[idx];
+		return render_view_;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -107,5 +118,5 @@ private:
 	/// The probe object this component represents
 	reflection_probe probe_;
 	/// The render view for this component
-	std::array<gfx::render_view, 6> render_view_;
+	gfx::render_view render_view_;
 };
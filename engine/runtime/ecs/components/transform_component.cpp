@@ -4,6 +4,11 @@
 
 #include <algorithm>
 
+namespace runtime
+{
+event<void(entity)> on_entity_parent_changed;
+}
+
 void transform_component::on_entity_set()
 {
 	for(auto& child : children_)
@@ -19,6 +24,15 @@ void transform_component::on_entity_set()
 	}
 }
 
+void transform_component::remap_entities(const runtime::entity_remap_t& remap)
+{
+	parent_ = remap(parent_);
+	for(auto& child : children_)
+	{
+		child = remap(child);
+	}
+}
+
 transform_component::~transform_component()
 {
 	if(parent_.valid())
@@ -368,6 +382,8 @@ void transform_component::set_parent(runtime::entity parent, bool world_position
 	}
 
 	set_dirty(is_dirty());
+
+	runtime::on_entity_parent_changed(get_entity());
 }
 
 const runtime::entity& transform_component::get_parent() const
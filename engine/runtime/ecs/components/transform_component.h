@@ -77,6 +77,14 @@ public:
 	//-----------------------------------------------------------------------------
 	virtual void on_entity_set() override;
 
+	//-----------------------------------------------------------------------------
+	//  Name : remap_entities (virtual )
+	/// <summary>
+	/// Redirects the parent and the children.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remap_entities(const runtime::entity_remap_t& remap) override;
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_local_transform ()
 	/// <summary>
@@ -550,3 +558,9 @@ protected:
 	/// Should recalc world transform.
 	bool dirty_ = true;
 };
+
+namespace runtime
+{
+/// Fired after an entity was attached to a new parent or detached from its parent.
+extern event<void(entity)> on_entity_parent_changed;
+}
@@ -0,0 +1,384 @@
+#include "binary_scene.h"
+#include "../../meta/ecs/entity.hpp"
+#include "utils.h"
+
+#include <core/serialization/binary_archive.h>
+#include <core/serialization/serialization.h>
+#include <core/serialization/types/string.hpp>
+#include <core/serialization/types/vector.hpp>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+
+namespace ecs
+{
+namespace binary_scene
+{
+namespace
+{
+/// "ESCN" read as a little endian integer.
+constexpr std::uint32_t format_magic = 0x4e435345;
+constexpr std::uint32_t format_version = 1;
+/// Most components of one type in a section, more are split over several.
+constexpr std::size_t section_size = 512;
+
+using section_entry_t = std::pair<std::uint32_t, std::shared_ptr<runtime::component>>;
+
+std::string encode_section(runtime::serialization_context& context,
+						   const std::vector<section_entry_t>& entries, std::size_t first, std::size_t last)
+{
+	std::ostringstream stream;
+	{
+		cereal::oarchive_binary_t ar(stream);
+		runtime::serialization_scope scope(ar, context);
+
+		const auto count = static_cast<std::uint32_t>(last - first);
+		try_save(ar, cereal::make_nvp("count", count));
+		for(auto i = first; i < last; ++i)
+		{
+			try_save(ar, cereal::make_nvp("slot", entries[i].first));
+			try_save(ar, cereal::make_nvp("component", entries[i].second));
+		}
+	}
+	return stream.str();
+}
+
+std::vector<std::string> encode_sections(runtime::serialization_context& context,
+										 const std::vector<runtime::entity>& entities)
+{
+	// Ordered by type name so a scene is always saved the same way.
+	std::map<std::string, std::vector<section_entry_t>> by_type;
+	for(std::size_t slot = 0; slot < entities.size(); ++slot)
+	{
+		for(auto& component : entities[slot].all_components_shared())
+		{
+			const auto& type = typeid(*component);
+			by_type[type.name()].emplace_back(static_cast<std::uint32_t>(slot), std::move(component));
+		}
+	}
+
+	std::vector<std::string> sections;
+	for(const auto& type : by_type)
+	{
+		const auto& entries = type.second;
+		for(std::size_t first = 0; first < entries.size(); first += section_size)
+		{
+			const auto last = std::min(first + section_size, entries.size());
+			sections.emplace_back(encode_section(context, entries, first, last));
+		}
+	}
+	return sections;
+}
+
+void decode_section(runtime::serialization_context& context, const std::string& section,
+					std::vector<section_entry_t>& entries)
+{
+	std::istringstream stream(section);
+	cereal::iarchive_binary_t ar(stream);
+	runtime::serialization_scope scope(ar, context);
+
+	std::uint32_t count = 0;
+	if(!try_load(ar, cereal::make_nvp("count", count)) || count > section_size)
+	{
+		return;
+	}
+
+	entries.resize(count);
+	for(std::size_t i = 0; i < entries.size(); ++i)
+	{
+		if(!try_load(ar, cereal::make_nvp("slot", entries[i].first)) ||
+		   !try_load(ar, cereal::make_nvp("component", entries[i].second)))
+		{
+			entries.resize(i);
+			return;
+		}
+	}
+}
+}
+
+bool is_binary(std::istream& stream)
+{
+	const auto position = stream.tellg();
+
+	std::uint32_t magic = 0;
+	stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	const bool result = stream.gcount() == sizeof(magic) && magic == format_magic;
+
+	stream.clear();
+	stream.seekg(position);
+	return result;
+}
+
+void save(std::ostream& stream, const std::vector<runtime::entity>& data)
+{
+	std::vector<runtime::entity> entities;
+	std::unordered_map<std::uint64_t, std::uint32_t> slots;
+	std::vector<std::uint32_t> roots;
+	for(const auto& root : data)
+	{
+		if(!root.valid())
+		{
+			continue;
+		}
+
+		std::vector<runtime::entity> hierarchy;
+		utils::collect_hierarchy(root, hierarchy);
+		for(const auto& e : hierarchy)
+		{
+			if(slots.emplace(e.id().id(), static_cast<std::uint32_t>(entities.size())).second)
+			{
+				entities.push_back(e);
+			}
+		}
+		roots.push_back(slots[root.id().id()]);
+	}
+
+	runtime::serialization_context context;
+	std::vector<std::string> sections;
+	for(;;)
+	{
+		// Entities already in the context are only written as a reference.
+		context.clear();
+		context.reserve(entities.size());
+		for(const auto& e : entities)
+		{
+			context.add(e.id().id(), e);
+		}
+
+		sections = encode_sections(context, entities);
+		if(context.get_entities().size() == entities.size())
+		{
+			break;
+		}
+
+		// Components referred to entities outside of the table, which were
+		// written in place. Add them to the table and encode again.
+		for(const auto& entry : context.get_entities())
+		{
+			if(slots.emplace(entry.first, static_cast<std::uint32_t>(entities.size())).second)
+			{
+				entities.push_back(entry.second);
+			}
+		}
+	}
+
+	std::vector<std::uint64_t> ids;
+	std::vector<std::string> names;
+	ids.reserve(entities.size());
+	names.reserve(entities.size());
+	for(const auto& e : entities)
+	{
+		ids.push_back(e.id().id());
+		names.push_back(e.get_name());
+	}
+
+	cereal::oarchive_binary_t ar(stream);
+	try_save(ar, cereal::make_nvp("magic", format_magic));
+	try_save(ar, cereal::make_nvp("version", format_version));
+	try_save(ar, cereal::make_nvp("ids", ids));
+	try_save(ar, cereal::make_nvp("names", names));
+	try_save(ar, cereal::make_nvp("roots", roots));
+	try_save(ar, cereal::make_nvp("sections", sections));
+}
+
+bool reader::open(std::istream& stream, runtime::entity_component_system* world)
+{
+	*this = reader();
+	if(!is_binary(stream))
+	{
+		return false;
+	}
+
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::vector<std::uint64_t> ids;
+	std::vector<std::string> sections;
+	{
+		cereal::iarchive_binary_t ar(stream);
+		try_load(ar, cereal::make_nvp("magic", magic));
+		try_load(ar, cereal::make_nvp("version", version));
+		if(version == format_version)
+		{
+			try_load(ar, cereal::make_nvp("ids", ids));
+			try_load(ar, cereal::make_nvp("names", names_));
+			try_load(ar, cereal::make_nvp("roots", root_slots_));
+			try_load(ar, cereal::make_nvp("sections", sections));
+		}
+	}
+	stream.clear();
+	stream.seekg(0);
+
+	if(version != format_version)
+	{
+		return false;
+	}
+	names_.resize(ids.size());
+
+	world_ = world != nullptr ? world : &core::get_subsystem<runtime::entity_component_system>();
+	entities_.resize(ids.size());
+
+	// Every entity the components refer to is in the table, so decoding only
+	// reads the context and the sections can be decoded at the same time.
+	// The entities are created by step, until then the components refer to
+	// them by a stand in holding their slot.
+	runtime::serialization_context context;
+	context.reserve(ids.size());
+	for(std::size_t slot = 0; slot < ids.size(); ++slot)
+	{
+		context.add(ids[slot], runtime::entity(nullptr, runtime::entity::id_t(std::uint32_t(slot), 1)));
+	}
+	context.set_read_only(true);
+
+	std::vector<std::vector<section_entry_t>> decoded(sections.size());
+	if(!sections.empty())
+	{
+		auto& ts = core::get_subsystem<core::task_system>();
+		std::vector<core::task_future<void>> tasks;
+		for(std::size_t i = 1; i < sections.size(); ++i)
+		{
+			auto task = ts.push_on_worker_thread(
+				[&context, &sections, &decoded, i]() { decode_section(context, sections[i], decoded[i]); });
+			tasks.emplace_back(std::move(task));
+		}
+		decode_section(context, sections.front(), decoded.front());
+
+		for(auto& task : tasks)
+		{
+			task.wait();
+		}
+	}
+
+	// Sort the components by slot.
+	component_offsets_.assign(entities_.size() + 1, 0);
+	for(const auto& entries : decoded)
+	{
+		for(const auto& entry : entries)
+		{
+			if(entry.second && entry.first < entities_.size())
+			{
+				++component_offsets_[entry.first + 1];
+			}
+		}
+	}
+	for(std::size_t slot = 0; slot < entities_.size(); ++slot)
+	{
+		component_offsets_[slot + 1] += component_offsets_[slot];
+	}
+
+	components_.resize(component_offsets_.back());
+	auto next = component_offsets_;
+	for(auto& entries : decoded)
+	{
+		for(auto& entry : entries)
+		{
+			if(entry.second && entry.first < entities_.size())
+			{
+				components_[next[entry.first]++] = std::move(entry.second);
+			}
+		}
+	}
+
+	remaining_ = entities_.size();
+	return true;
+}
+
+bool reader::step(std::size_t max_entities)
+{
+	// A component referring to an entity further up the table creates it
+	// early, its components still come with its own step.
+	const auto remap = [this](const runtime::entity& e) {
+		if(e.valid() || e.id() == runtime::entity::INVALID)
+		{
+			return e;
+		}
+		return create_entity(e.id().index());
+	};
+
+	// Children come after their parents in the table. Going backwards assigns
+	// them first, so a transform finds the transforms of its children.
+	for(std::size_t count = 0; count < max_entities && remaining_ > 0; ++count)
+	{
+		const auto slot = --remaining_;
+		auto e = create_entity(slot);
+		if(!e.valid())
+		{
+			continue;
+		}
+
+		if(!names_[slot].empty())
+		{
+			e.set_name(names_[slot]);
+		}
+
+		for(auto i = component_offsets_[slot]; i < component_offsets_[slot + 1]; ++i)
+		{
+			auto& component = components_[i];
+			component->remap_entities(remap);
+			e.assign(component);
+			component->touch();
+			component.reset();
+		}
+	}
+
+	if(remaining_ == 0)
+	{
+		for(auto slot : root_slots_)
+		{
+			if(slot < entities_.size())
+			{
+				roots_.push_back(entities_[slot]);
+			}
+		}
+		root_slots_.clear();
+
+		components_.clear();
+		components_.shrink_to_fit();
+		component_offsets_.clear();
+		return true;
+	}
+	return false;
+}
+
+bool reader::is_done() const
+{
+	return remaining_ == 0;
+}
+
+const std::vector<runtime::entity>& reader::get_roots() const
+{
+	return roots_;
+}
+
+const std::vector<runtime::entity>& reader::get_entities() const
+{
+	return entities_;
+}
+
+std::size_t reader::get_remaining() const
+{
+	return remaining_;
+}
+
+runtime::entity reader::create_entity(std::size_t slot)
+{
+	if(slot >= entities_.size())
+	{
+		return {};
+	}
+
+	// Once created the handle keeps its id, even if the entity is destroyed.
+	auto& e = entities_[slot];
+	if(e.id() == runtime::entity::INVALID)
+	{
+		e = world_->create();
+	}
+	return e;
+}
+}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../ecs.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Compact format for scenes and other sets of entities. It holds a table of
+// the entities followed by sections of at most a fixed number of components
+// of one type each. Components refer to entities by their slot in the table,
+// so the sections can be decoded independently and in parallel.
+//-----------------------------------------------------------------------------
+namespace ecs
+{
+namespace binary_scene
+{
+//-----------------------------------------------------------------------------
+//  Name : is_binary ()
+/// <summary>
+/// Checks if the stream starts with data in the binary format. The stream
+/// position is left unchanged.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool is_binary(std::istream& stream);
+
+//-----------------------------------------------------------------------------
+//  Name : save ()
+/// <summary>
+/// Writes the entities, their children and every other entity their
+/// components refer to.
+/// </summary>
+//-----------------------------------------------------------------------------
+void save(std::ostream& stream, const std::vector<runtime::entity>& data);
+
+//-----------------------------------------------------------------------------
+//  Name : reader (Class)
+/// <summary>
+/// Loads data in the binary format. open decodes it, then step creates a
+/// limited number of entities per call and assigns their components, so a
+/// large scene can be brought in over several frames.
+/// </summary>
+//-----------------------------------------------------------------------------
+class reader
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Decodes the data, the component sections in parallel on the worker
+	/// threads. The entities are created in the given world, null for the one
+	/// of the entity_component_system subsystem. Returns false if the stream
+	/// does not hold data in the binary format.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool open(std::istream& stream, runtime::entity_component_system* world = nullptr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : step ()
+	/// <summary>
+	/// Creates up to max_entities entities and assigns their components.
+	/// Returns true once all entities are complete.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool step(std::size_t max_entities);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_done ()
+	/// <summary>
+	/// Are all entities complete.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_done() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_roots ()
+	/// <summary>
+	/// The entities that were passed to save, once all entities are complete.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::vector<runtime::entity>& get_roots() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_entities ()
+	/// <summary>
+	/// The entities by slot, parents before their children. The ones step did
+	/// not reach yet are invalid.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::vector<runtime::entity>& get_entities() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_remaining ()
+	/// <summary>
+	/// Number of entities still waiting for their components.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_remaining() const;
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : create_entity ()
+	/// <summary>
+	/// The entity of a slot, created on first use.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	runtime::entity create_entity(std::size_t slot);
+
+	/// World the entities are created in.
+	runtime::entity_component_system* world_ = nullptr;
+	/// Entities by slot.
+	std::vector<runtime::entity> entities_;
+	/// Names of the entities by slot.
+	std::vector<std::string> names_;
+	/// The entities that were passed to save.
+	std::vector<runtime::entity> roots_;
+	/// Slots of the entities that were passed to save.
+	std::vector<std::uint32_t> root_slots_;
+	/// Components of all entities ordered by slot.
+	std::vector<std::shared_ptr<runtime::component>> components_;
+	/// Start of the components of every slot in components_, plus the end.
+	std::vector<std::size_t> component_offsets_;
+	/// Slots still waiting for their components, from the last one down.
+	std::size_t remaining_ = 0;
+};
+}
+}
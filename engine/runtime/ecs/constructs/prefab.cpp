@@ -1,17 +1,128 @@
 #include "prefab.h"
 #include "utils.h"
 
-runtime::entity prefab::instantiate()
+#include <core/system/subsystem.h>
+
+#include <unordered_map>
+
+namespace
 {
-	std::vector<runtime::entity> out_data;
-	if(!data)
-		return {};
+// Template entities refer to each other by slot. A slot has no manager and
+// version zero, which no entity ever gets, so it is never valid.
+runtime::entity make_slot(std::size_t slot)
+{
+	return runtime::entity(nullptr, runtime::entity::id_t(static_cast<std::uint32_t>(slot + 1), 0));
+}
 
-	if(!ecs::utils::deserialize_data(*data, out_data))
-		return {};
+bool is_slot(const runtime::entity& e)
+{
+	return e.id().version() == 0 && e.id().index() != 0;
+}
 
-	if(out_data.empty())
+std::size_t get_slot(const runtime::entity& e)
+{
+	return e.id().index() - 1;
+}
+}
+
+runtime::entity prefab::instantiate()
+{
+	auto roots = instantiate(1);
+	if(roots.empty())
 		return {};
 	else
-		return out_data.front();
+		return roots.front();
+}
+
+std::vector<runtime::entity> prefab::instantiate(std::size_t count)
+{
+	std::vector<runtime::entity> roots;
+	if(count == 0)
+		return roots;
+
+	roots.reserve(count);
+	if(!compiled_from_ || compiled_from_ != data)
+	{
+		// The first instance is deserialized, the template is copied from it.
+		std::vector<runtime::entity> out_data;
+		if(!compile(out_data))
+			return roots;
+
+		roots.push_back(out_data.front());
+	}
+
+	const auto slot_count = names_.size();
+	const auto instance_count = count - roots.size();
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	auto entities = ecs.create(instance_count * slot_count);
+
+	for(std::size_t offset = 0; offset < entities.size(); offset += slot_count)
+	{
+		const auto from_slot = [&entities, offset](const runtime::entity& e) {
+			return is_slot(e) ? entities[offset + get_slot(e)] : e;
+		};
+
+		for(std::size_t slot = 0; slot < slot_count; ++slot)
+		{
+			if(!names_[slot].empty())
+			{
+				entities[offset + slot].set_name(names_[slot]);
+			}
+		}
+
+		for(const auto& compiled : components_)
+		{
+			auto component = compiled.prototype->clone();
+			component->remap_entities(from_slot);
+			entities[offset + compiled.slot].assign(component);
+		}
+
+		roots.push_back(entities[offset]);
+	}
+
+	return roots;
+}
+
+bool prefab::compile(std::vector<runtime::entity>& roots)
+{
+	names_.clear();
+	components_.clear();
+	compiled_from_.reset();
+
+	if(!data || !ecs::utils::deserialize_data(*data, roots) || roots.empty())
+		return false;
+
+	std::vector<runtime::entity> entities;
+	for(const auto& root : roots)
+	{
+		ecs::utils::collect_hierarchy(root, entities);
+	}
+
+	std::unordered_map<std::uint64_t, std::size_t> slots;
+	for(std::size_t slot = 0; slot < entities.size(); ++slot)
+	{
+		slots[entities[slot].id().id()] = slot;
+	}
+	const auto to_slot = [&slots](const runtime::entity& e) {
+		auto it = slots.find(e.id().id());
+		return it != slots.end() ? make_slot(it->second) : e;
+	};
+
+	names_.reserve(entities.size());
+	for(std::size_t slot = 0; slot < entities.size(); ++slot)
+	{
+		const auto& e = entities[slot];
+		names_.push_back(e.get_name());
+		for(const auto& component : e.all_components_shared())
+		{
+			compiled_component compiled;
+			compiled.slot = slot;
+			compiled.prototype = component->clone();
+			compiled.prototype->remap_entities(to_slot);
+			components_.emplace_back(std::move(compiled));
+		}
+	}
+
+	compiled_from_ = data;
+	return true;
 }
@@ -3,9 +3,56 @@
 #include "../ecs.h"
 #include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 struct prefab
 {
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates an instance of the prefab and returns its root.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	runtime::entity instantiate();
+
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates count instances of the prefab and returns their roots. The data
+	/// is only parsed for the first instance ever created, it is compiled into
+	/// a template the components of every later instance are copied from. The
+	/// entities of all instances are created at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<runtime::entity> instantiate(std::size_t count);
+
+	/// Serialized entities of the prefab.
 	std::shared_ptr<std::istream> data;
+
+private:
+	struct compiled_component
+	{
+		/// Template entity owning the component.
+		std::size_t slot = 0;
+		/// Copy of the component the instances clone, it refers to the other
+		/// entities of the template by slot.
+		std::shared_ptr<runtime::component> prototype;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : compile ()
+	/// <summary>
+	/// Deserializes the data into roots and builds the template from the
+	/// entities created. Returns false if nothing was created.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool compile(std::vector<runtime::entity>& roots);
+
+	/// Names of the template entities by slot, the root comes first.
+	std::vector<std::string> names_;
+	/// Components of all template entities, ordered by slot.
+	std::vector<compiled_component> components_;
+	/// Data the template was compiled from.
+	std::shared_ptr<std::istream> compiled_from_;
 };
@@ -3,13 +3,18 @@
 
 #include <core/system/subsystem.h>
 
-std::vector<runtime::entity> scene::instantiate(mode mod)
+static void prepare(scene::mode mod)
 {
-	if(mod == mode::standard)
+	if(mod == scene::mode::standard)
 	{
 		auto& ecs = core::get_subsystem<runtime::entity_component_system>();
 		ecs.dispose();
 	}
+}
+
+std::vector<runtime::entity> scene::instantiate(mode mod)
+{
+	prepare(mod);
 
 	std::vector<runtime::entity> out_vec;
 	if(!data)
@@ -19,3 +24,13 @@ std::vector<runtime::entity> scene::instantiate(mode mod)
 
 	return out_vec;
 }
+
+bool scene::instantiate(mode mod, ecs::binary_scene::reader& reader)
+{
+	if(!data || !ecs::binary_scene::is_binary(*data))
+		return false;
+
+	prepare(mod);
+
+	return reader.open(*data);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ecs.h"
+#include "binary_scene.h"
 #include <fstream>
 #include <memory>
 
@@ -12,5 +13,16 @@ struct scene
 		additive,
 	};
 	std::vector<runtime::entity> instantiate(mode mod);
+
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Starts instantiating a scene saved in the binary format. The entities
+	/// are complete once the reader was stepped through, a chunk per frame
+	/// keeps large scenes from stalling. Returns false for other formats.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool instantiate(mode mod, ecs::binary_scene::reader& reader);
+
 	std::shared_ptr<std::istream> data;
 };
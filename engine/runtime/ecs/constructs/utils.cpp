@@ -1,9 +1,15 @@
 #include "utils.h"
 #include "../../meta/ecs/entity.hpp"
+#include "../components/transform_component.h"
+#include "binary_scene.h"
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
 #include <core/serialization/serialization.h>
+#include <core/system/subsystem.h>
+
+#include <limits>
+#include <unordered_map>
 
 namespace ecs
 {
@@ -14,29 +20,31 @@ template <typename OArchive>
 static void serialize_t(std::ostream& stream, const std::vector<runtime::entity>& data)
 {
 	OArchive ar(stream);
+	runtime::serialization_context context;
+	runtime::serialization_scope scope(ar, context);
 
 	try_save(ar, cereal::make_nvp("data", data));
-
-	runtime::get_serialization_map().clear();
 }
 
 template <typename IArchive>
-static bool deserialize_t(std::istream& stream, std::vector<runtime::entity>& out_data)
+static bool deserialize_t(std::istream& stream, std::vector<runtime::entity>& out_data,
+						  runtime::entity_component_system* world = nullptr)
 {
 	// get length of file:
-	runtime::get_serialization_map().clear();
 	stream.seekg(0, stream.end);
 	std::streampos length = stream.tellg();
 	stream.seekg(0, stream.beg);
 	if(length > 0)
 	{
 		IArchive ar(stream);
+		runtime::serialization_context context;
+		context.set_world(world);
+		runtime::serialization_scope scope(ar, context);
 
 		try_load(ar, cereal::make_nvp("data", out_data));
 
 		stream.clear();
 		stream.seekg(0);
-		runtime::get_serialization_map().clear();
 		return true;
 	}
 	return false;
@@ -73,22 +81,139 @@ bool load_entities_from_file(const fs::path& full_path, std::vector<runtime::ent
 
 runtime::entity clone_entity(const runtime::entity& data)
 {
-	std::stringstream stream;
-	serialize_t<cereal::oarchive_binary_t>(stream, {data});
+	auto roots = clone_entities(data, 1);
+	if(!roots.empty())
+	{
+		return roots.front();
+	}
+	return {};
+}
+
+std::vector<runtime::entity> clone_entities(const runtime::entity& data, std::size_t count)
+{
+	std::vector<runtime::entity> roots;
+	if(!data.valid() || count == 0)
+	{
+		return roots;
+	}
 
-	std::vector<runtime::entity> vec_data;
-	deserialize_t<cereal::iarchive_binary_t>(stream, vec_data);
+	std::vector<runtime::entity> hierarchy;
+	collect_hierarchy(data, hierarchy);
 
-	if(!vec_data.empty())
+	std::unordered_map<std::uint64_t, std::size_t> slots;
+	slots.reserve(hierarchy.size());
+	std::vector<std::vector<std::shared_ptr<runtime::component>>> components;
+	components.reserve(hierarchy.size());
+	for(std::size_t slot = 0; slot < hierarchy.size(); ++slot)
 	{
-		return vec_data.front();
+		slots.emplace(hierarchy[slot].id().id(), slot);
+		components.emplace_back(hierarchy[slot].all_components_shared());
 	}
-	return {};
+
+	runtime::entity parent;
+	if(auto transform = data.get_component<transform_component>().lock())
+	{
+		parent = transform->get_parent();
+	}
+
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	auto entities = ecs.create(count * hierarchy.size());
+	roots.reserve(count);
+	for(std::size_t offset = 0; offset < entities.size(); offset += hierarchy.size())
+	{
+		const auto remap = [&slots, &entities, offset](const runtime::entity& e) {
+			auto it = slots.find(e.id().id());
+			return it != slots.end() ? entities[offset + it->second] : e;
+		};
+		const auto remap_root = [&remap, &parent](const runtime::entity& e) {
+			return e == parent ? runtime::entity() : remap(e);
+		};
+
+		for(std::size_t slot = 0; slot < hierarchy.size(); ++slot)
+		{
+			auto& e = entities[offset + slot];
+			e.set_name(hierarchy[slot].get_name());
+			for(const auto& component : components[slot])
+			{
+				auto copy = component->clone();
+				if(slot == 0)
+				{
+					copy->remap_entities(remap_root);
+				}
+				else
+				{
+					copy->remap_entities(remap);
+				}
+				e.assign(copy);
+				copy->touch();
+			}
+		}
+
+		roots.push_back(entities[offset]);
+	}
+
+	return roots;
 }
 
 bool deserialize_data(std::istream& stream, std::vector<runtime::entity>& out_data)
 {
+	binary_scene::reader reader;
+	if(reader.open(stream))
+	{
+		reader.step(std::numeric_limits<std::size_t>::max());
+		out_data = reader.get_roots();
+		return true;
+	}
+
 	return deserialize_t<cereal::iarchive_associative_t>(stream, out_data);
 }
+
+bool convert_to_binary(std::istream& stream, std::ostream& out_stream)
+{
+	// Loaded into a world of its own, the systems never see the entities.
+	runtime::entity_component_system world(false);
+	std::vector<runtime::entity> data;
+	if(!deserialize_t<cereal::iarchive_associative_t>(stream, data, &world))
+	{
+		return false;
+	}
+
+	binary_scene::save(out_stream, data);
+	return true;
+}
+
+bool convert_to_associative(std::istream& stream, std::ostream& out_stream)
+{
+	// Loaded into a world of its own, the systems never see the entities.
+	runtime::entity_component_system world(false);
+	binary_scene::reader reader;
+	if(!reader.open(stream, &world))
+	{
+		return false;
+	}
+
+	reader.step(std::numeric_limits<std::size_t>::max());
+	serialize_t<cereal::oarchive_associative_t>(out_stream, reader.get_roots());
+	return true;
+}
+
+void collect_hierarchy(const runtime::entity& data, std::vector<runtime::entity>& out_data)
+{
+	out_data.push_back(data);
+
+	auto transform = data.get_component<transform_component>().lock();
+	if(!transform)
+	{
+		return;
+	}
+
+	for(const auto& child : transform->get_children())
+	{
+		if(child.valid())
+		{
+			collect_hierarchy(child, out_data);
+		}
+	}
+}
 }
 }
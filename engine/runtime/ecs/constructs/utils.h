@@ -12,7 +12,25 @@ namespace ecs
 namespace utils
 {
 
+//-----------------------------------------------------------------------------
+//  Name : clone_entity ()
+/// <summary>
+/// Copies an entity with all its children, see clone_entities.
+/// </summary>
+//-----------------------------------------------------------------------------
 runtime::entity clone_entity(const runtime::entity& data);
+
+//-----------------------------------------------------------------------------
+//  Name : clone_entities ()
+/// <summary>
+/// Makes count copies of an entity with all its children and returns their
+/// roots. The components are cloned directly, references between entities
+/// of the hierarchy point into the same copy. The copies are not attached to
+/// the parent of the original.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<runtime::entity> clone_entities(const runtime::entity& data, std::size_t count);
+
 //-----------------------------------------------------------------------------
 //  Name : save_entity ()
 /// <summary>
@@ -56,11 +74,36 @@ bool load_entities_from_file(const fs::path& full_path, std::vector<runtime::ent
 //-----------------------------------------------------------------------------
 //  Name : deserialize_data ()
 /// <summary>
-///
-///
-///
+/// Loads entities saved in the binary format or in the associative one.
 /// </summary>
 //-----------------------------------------------------------------------------
 bool deserialize_data(std::istream& stream, std::vector<runtime::entity>& out_data);
+
+//-----------------------------------------------------------------------------
+//  Name : convert_to_binary ()
+/// <summary>
+/// Converts entities saved in the associative format to the binary one. The
+/// entities are created in a world of their own, so it runs on any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool convert_to_binary(std::istream& stream, std::ostream& out_stream);
+
+//-----------------------------------------------------------------------------
+//  Name : convert_to_associative ()
+/// <summary>
+/// Converts entities saved in the binary format to the associative one. The
+/// entities are created in a world of their own, so it runs on any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool convert_to_associative(std::istream& stream, std::ostream& out_stream);
+
+//-----------------------------------------------------------------------------
+//  Name : collect_hierarchy ()
+/// <summary>
+/// Appends the entity and everything below it in the transform hierarchy,
+/// parents come before their children.
+/// </summary>
+//-----------------------------------------------------------------------------
+void collect_hierarchy(const runtime::entity& data, std::vector<runtime::entity>& out_data);
 }
 }
@@ -0,0 +1,46 @@
+#include "world_layout.h"
+#include "../../meta/ecs/world_layout.hpp"
+
+#include <core/serialization/associative_archive.h>
+
+#include <fstream>
+
+float world_layout::get_distance(const world_cell& cell, const math::vec3& position) const
+{
+	const float min_x = float(cell.x) * cell_size;
+	const float min_z = float(cell.z) * cell_size;
+	const float dx = math::max(math::max(min_x - position.x, position.x - (min_x + cell_size)), 0.0f);
+	const float dz = math::max(math::max(min_z - position.z, position.z - (min_z + cell_size)), 0.0f);
+	return math::sqrt(dx * dx + dz * dz);
+}
+
+std::pair<std::int32_t, std::int32_t> world_layout::get_cell_coordinates(const math::vec3& position) const
+{
+	return {static_cast<std::int32_t>(math::floor(position.x / cell_size)),
+			static_cast<std::int32_t>(math::floor(position.z / cell_size))};
+}
+
+namespace ecs
+{
+namespace utils
+{
+void save_world_layout_to_file(const fs::path& full_path, const world_layout& layout)
+{
+	std::ofstream stream(full_path.string(), std::fstream::binary | std::fstream::trunc);
+	cereal::oarchive_associative_t ar(stream);
+	try_save(ar, cereal::make_nvp("layout", layout));
+}
+
+bool try_load_world_layout_from_file(const fs::path& full_path, world_layout& layout)
+{
+	std::ifstream stream(full_path.string(), std::fstream::binary);
+	if(!stream.good())
+	{
+		return false;
+	}
+
+	cereal::iarchive_associative_t ar(stream);
+	return try_load(ar, cereal::make_nvp("layout", layout));
+}
+}
+}
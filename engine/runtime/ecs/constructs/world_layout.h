@@ -0,0 +1,89 @@
+#pragma once
+
+#include <core/filesystem/filesystem.h>
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : world_cell (Struct)
+/// <summary>
+/// A square of the world grid with the scene holding its entities and the
+/// assets they use, so the assets can be loaded before the entities.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct world_cell
+{
+	/// Position of the cell on the grid along x.
+	std::int32_t x = 0;
+	/// Position of the cell on the grid along z.
+	std::int32_t z = 0;
+	/// Key of the scene with the entities of the cell.
+	std::string scene;
+	/// Keys of the meshes used by the cell.
+	std::vector<std::string> meshes;
+	/// Keys of the materials used by the cell.
+	std::vector<std::string> materials;
+	/// Keys of the sounds used by the cell.
+	std::vector<std::string> sounds;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : world_layout (Struct)
+/// <summary>
+/// A world split into cells on a grid in the xz plane, each of them streamed
+/// in and out on its own.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct world_layout
+{
+	//-----------------------------------------------------------------------------
+	//  Name : get_distance ()
+	/// <summary>
+	/// Distance in the xz plane from the point to the closest point of the
+	/// cell, zero inside of it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_distance(const world_cell& cell, const math::vec3& position) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_cell_coordinates ()
+	/// <summary>
+	/// Grid position of the cell holding the given point.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::pair<std::int32_t, std::int32_t> get_cell_coordinates(const math::vec3& position) const;
+
+	/// Size of the side of a cell.
+	float cell_size = 64.0f;
+	/// Cells that hold anything.
+	std::vector<world_cell> cells;
+};
+
+namespace ecs
+{
+namespace utils
+{
+//-----------------------------------------------------------------------------
+//  Name : save_world_layout_to_file ()
+/// <summary>
+/// Saves the layout in the associative format.
+/// </summary>
+//-----------------------------------------------------------------------------
+void save_world_layout_to_file(const fs::path& full_path, const world_layout& layout);
+
+//-----------------------------------------------------------------------------
+//  Name : try_load_world_layout_from_file ()
+/// <summary>
+/// Loads a layout saved with save_world_layout_to_file.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool try_load_world_layout_from_file(const fs::path& full_path, world_layout& layout);
+}
+}
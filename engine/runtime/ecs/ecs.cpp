@@ -32,6 +32,7 @@ uint64_t get_frame()
 
 event<void(entity)> on_entity_created;
 event<void(entity)> on_entity_destroyed;
+event<void(entity)> on_entity_renamed;
 event<void(entity, chandle<component>)> on_component_added;
 event<void(entity, chandle<component>)> on_component_removed;
 
@@ -98,6 +99,11 @@ void entity::destroy()
 	invalidate();
 }
 
+entity_component_system::entity_component_system(bool publish_events)
+	: publish_events_(publish_events)
+{
+}
+
 entity_component_system::~entity_component_system()
 {
 	dispose();
@@ -139,13 +145,58 @@ entity entity_component_system::create()
 		version = entity_version_[index];
 	}
 	entity entity(this, entity::id_t(index, version));
-	on_entity_created(entity);
+	if(publish_events_)
+	{
+		on_entity_created(entity);
+	}
 	return entity;
 }
 
+std::vector<entity> entity_component_system::create(std::size_t count)
+{
+	std::vector<entity> entities;
+	entities.reserve(count);
+
+	const auto reused = std::min(count, free_list_.size());
+	if(count > reused)
+	{
+		accomodate_entity(index_counter_ + static_cast<std::uint32_t>(count - reused) - 1);
+	}
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		std::uint32_t index, version;
+		if(free_list_.empty())
+		{
+			index = index_counter_++;
+			version = entity_version_[index] = 1;
+		}
+		else
+		{
+			index = free_list_.back();
+			free_list_.pop_back();
+			version = entity_version_[index];
+		}
+		entities.emplace_back(this, entity::id_t(index, version));
+	}
+
+	if(publish_events_)
+	{
+		for(const auto& entity : entities)
+		{
+			on_entity_created(entity);
+		}
+	}
+	return entities;
+}
+
 void entity_component_system::set_entity_name(entity::id_t id, const std::string& name)
 {
 	entity_names_[id.id()] = name;
+	if(publish_events_)
+	{
+		on_entity_renamed(get(id));
+	}
 }
 
 const std::string& entity_component_system::get_entity_name(entity::id_t id)
@@ -180,7 +231,10 @@ void entity_component_system::remove(entity::id_t id, rtti::type_index_sequentia
 	// Find the pool for this component family.
 	auto& pool = component_pools_[family];
 	chandle<component> handle(pool->get(id.index()));
-	on_component_removed(get(id), handle);
+	if(publish_events_)
+	{
+		on_component_removed(get(id), handle);
+	}
 	// Remove component bit.
 	entity_component_mask_[id.index()].reset(family);
 
@@ -260,7 +314,10 @@ chandle<component> entity_component_system::assign(entity::id_t id, const std::s
 	comp->entity_ = get(id);
 	comp->on_entity_set();
 	chandle<component> handle(ptr);
-	on_component_added(get(id), handle);
+	if(publish_events_)
+	{
+		on_component_added(get(id), handle);
+	}
 	return handle;
 }
 
@@ -283,7 +340,10 @@ void entity_component_system::destroy(entity::id_t id)
 		}
 	}
 
-	on_entity_destroyed(get(id));
+	if(publish_events_)
+	{
+		on_entity_destroyed(get(id));
+	}
 	entity_component_mask_[index].reset();
 	entity_version_[index]++;
 	free_list_.push_back(index);
@@ -246,6 +246,9 @@ private:
 	entity_component_system* manager_ = nullptr;
 };
 
+/// Maps an entity referenced by a component to the one it should refer to.
+using entity_remap_t = std::function<entity(const entity&)>;
+
 class component : public std::enable_shared_from_this<component>
 {
 	REFLECTABLEV(component)
@@ -327,6 +330,27 @@ public:
 	{
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone (virtual )
+	/// <summary>
+	/// Copy of the component that is not assigned to any entity yet. The
+	/// entities it refers to are copied as they are, use remap_entities to
+	/// redirect them before the copy is assigned or released.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual std::shared_ptr<component> clone() const = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : remap_entities (virtual )
+	/// <summary>
+	/// Replaces every entity the component refers to with the one returned by
+	/// remap. Components referring to other entities override it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void remap_entities(const entity_remap_t& /*remap*/)
+	{
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_entity ()
 	/// <summary>
@@ -367,9 +391,13 @@ private:
 
 public:
 	component_impl() = default;
-	component_impl(component_impl& rhs) = delete;
 	component_impl& operator=(component_impl& rhs) = delete;
 
+	std::shared_ptr<component> clone() const override
+	{
+		return std::make_shared<T>(static_cast<const T&>(*this));
+	}
+
 	static rtti::type_index_sequential_t::index_t static_id()
 	{
 		return rtti::type_index_sequential_t::id<component, T>();
@@ -379,10 +407,15 @@ public:
 	{
 		return std::static_pointer_cast<T>(shared_from_this());
 	}
+
+protected:
+	/// Used by clone, the copy does not take over the entity of the original.
+	component_impl(const component_impl& rhs) = default;
 };
 
 extern event<void(entity)> on_entity_created;
 extern event<void(entity)> on_entity_destroyed;
+extern event<void(entity)> on_entity_renamed;
 extern event<void(entity, chandle<component>)> on_component_added;
 extern event<void(entity, chandle<component>)> on_component_removed;
 
@@ -395,7 +428,11 @@ class entity_component_system
 public:
 	using component_mask_t = std::bitset<MAX_COMPONENTS>;
 
-	explicit entity_component_system() = default;
+	/**
+	 * A world that does not publish its events stays unseen by the systems,
+	 * so it can hold entities for a conversion on any thread.
+	 */
+	explicit entity_component_system(bool publish_events = true);
 	virtual ~entity_component_system();
 	/// An iterator over a view of the entities in an entity_component_system.
 	/// If All is true it will iterate over all valid entities and will ignore the
@@ -692,6 +729,13 @@ public:
 	 */
 	entity create();
 
+	/**
+	 * Create count entities at once, growing the storage a single time.
+	 *
+	 * Emits EntityCreatedEvent for each of them.
+	 */
+	std::vector<entity> create(std::size_t count);
+
 	/**
 	 * Destroy an existing entity::Id and its associated Components.
 	 *
@@ -985,6 +1029,8 @@ private:
 	std::vector<std::uint32_t> free_list_;
 
 	std::unordered_map<std::uint64_t, std::string> entity_names_;
+	// Fire the global entity and component events.
+	bool publish_events_ = true;
 };
 
 template <typename C, typename... Args>
@@ -4,12 +4,15 @@
 #include "../components/audio_source_component.h"
 #include "../components/transform_component.h"
 
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 namespace runtime
 {
 void audio_system::frame_update(delta_t dt)
 {
+	PROFILE_SCOPE("audio_system::frame_update");
+
 	auto& ecs = core::get_subsystem<entity_component_system>();
 
 	ecs.for_each<transform_component, audio_source_component>(
@@ -4,6 +4,7 @@
 #include "../components/model_component.h"
 #include "../components/transform_component.h"
 
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 namespace runtime
@@ -68,6 +69,8 @@ get_transforms_for_bones(const std::vector<runtime::entity>& bone_entities)
 
 void bone_system::frame_update(delta_t)
 {
+	PROFILE_SCOPE("bone_system::frame_update");
+
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
 	ecs.for_each<model_component>([&ecs](runtime::entity e, model_component& model_comp) {
 
@@ -3,12 +3,15 @@
 #include "../components/camera_component.h"
 #include "../components/transform_component.h"
 
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 namespace runtime
 {
 void camera_system::frame_update(delta_t)
 {
+	PROFILE_SCOPE("camera_system::frame_update");
+
 	auto& ecs = core::get_subsystem<entity_component_system>();
 
 	ecs.for_each<transform_component, camera_component>(
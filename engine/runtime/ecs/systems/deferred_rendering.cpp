@@ -11,16 +11,248 @@
 #include "../components/model_component.h"
 #include "../components/reflection_probe_component.h"
 #include "../components/transform_component.h"
+#include "texture_streaming.h"
 
 #include <core/graphics/index_buffer.h>
 #include <core/graphics/render_pass.h>
 #include <core/graphics/render_view.h>
 #include <core/graphics/texture.h>
+#include <core/graphics/uniform.h>
 #include <core/graphics/vertex_buffer.h>
+#include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
+#include <limits>
 
 namespace runtime
 {
+namespace
+{
+const gfx::uniform_id u_camera_clip_planes("u_camera_clip_planes");
+const gfx::uniform_id u_camera_position("u_camera_position");
+const gfx::uniform_id u_camera_wpos("u_camera_wpos");
+const gfx::uniform_id u_cluster_data0("u_cluster_data0");
+const gfx::uniform_id u_cluster_data1("u_cluster_data1");
+const gfx::uniform_id u_data0("u_data0");
+const gfx::uniform_id u_data1("u_data1");
+const gfx::uniform_id u_data2("u_data2");
+const gfx::uniform_id u_inv_world("u_inv_world");
+const gfx::uniform_id u_light_color_intensity("u_light_color_intensity");
+const gfx::uniform_id u_light_data("u_light_data");
+const gfx::uniform_id u_light_direction("u_light_direction");
+const gfx::uniform_id u_light_position("u_light_position");
+const gfx::uniform_id u_lod_params("u_lod_params");
+const gfx::uniform_id u_shadow_matrix("u_shadow_matrix");
+const gfx::uniform_id u_shadow_params("u_shadow_params");
+const gfx::uniform_id s_clusters("s_clusters");
+const gfx::uniform_id s_input("s_input");
+const gfx::uniform_id s_light_indices("s_light_indices");
+const gfx::uniform_id s_lights("s_lights");
+const gfx::uniform_id s_shadow_atlas("s_shadow_atlas");
+const gfx::uniform_id s_tex0("s_tex0");
+const gfx::uniform_id s_tex1("s_tex1");
+const gfx::uniform_id s_tex2("s_tex2");
+const gfx::uniform_id s_tex3("s_tex3");
+const gfx::uniform_id s_tex4("s_tex4");
+const gfx::uniform_id s_tex5("s_tex5");
+const gfx::uniform_id s_tex6("s_tex6");
+const gfx::uniform_id s_tex_cube("s_tex_cube");
+
+gfx::texture_format get_color_format()
+{
+	static auto format = gfx::get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER,
+											  gfx::format_search_flags::four_channels |
+												  gfx::format_search_flags::requires_alpha);
+	return format;
+}
+
+gfx::texture_format get_hdr_format()
+{
+	static auto format = gfx::get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER,
+											  gfx::format_search_flags::four_channels |
+												  gfx::format_search_flags::requires_alpha |
+												  gfx::format_search_flags::half_precision_float);
+	return format;
+}
+
+gfx::texture_format get_depth_format()
+{
+	static auto format =
+		gfx::get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::requires_depth);
+	return format;
+}
+
+gfx::render_graph::texture_desc get_desc(const usize32_t& size, gfx::texture_format format)
+{
+	gfx::render_graph::texture_desc desc;
+	desc.width = std::uint16_t(size.width);
+	desc.height = std::uint16_t(size.height);
+	desc.format = format;
+	return desc;
+}
+
+// Lights with the largest screen coverage get shadows.
+constexpr std::size_t max_shadowed_lights = 32;
+// Face size of a light covering the whole screen.
+constexpr std::uint32_t max_spot_shadow_size = 1024;
+constexpr std::uint32_t max_point_shadow_size = 512;
+// Receiver bias in units of the light range.
+constexpr float shadow_bias = 0.01f;
+
+struct shadow_caster
+{
+	/// Handle of the model, copied once a light needs the caster.
+	chandle<model_component> model_comp;
+	/// Copy of the model for drawing.
+	model model_data;
+	/// World transform.
+	math::transform world;
+	/// World bounds.
+	math::bbox bounds;
+	/// Cached with the static casters.
+	bool is_static = false;
+	/// The model was copied.
+	bool captured = false;
+};
+
+struct shadow_job
+{
+	/// Pixel rectangles of the faces.
+	std::vector<urect32_t> rects;
+	/// Cameras of the faces.
+	std::vector<camera> cameras;
+	/// Position and range of the light.
+	math::vec4 position_range;
+	/// Static casters to cache, empty if the cache is valid.
+	std::vector<const shadow_caster*> static_casters;
+	/// Dynamic casters to draw over the cache.
+	std::vector<const shadow_caster*> dynamic_casters;
+	/// Whether the cache has to be rendered.
+	bool render_static = false;
+};
+
+struct g_buffer_draw
+{
+	/// Copy of the model, the scene may change while the frame is submitted.
+	model model_data;
+	/// World transform.
+	math::transform world;
+	/// Skinning palette.
+	std::vector<math::transform> bones;
+	/// Lods faded between.
+	std::uint32_t current_lod = 0;
+	std::uint32_t target_lod = 0;
+	/// u_lod_params of the current and the target lod.
+	math::vec3 params;
+	math::vec3 params_inv;
+	/// The target lod is faded in.
+	bool transition = false;
+};
+
+struct light_draw
+{
+	/// Copy of the light.
+	light light_data;
+	/// World position and direction.
+	math::vec3 position;
+	math::vec3 direction;
+	/// Scissor rectangle on the light buffer.
+	irect32_t rect;
+	/// World space to atlas uv of the shadow faces.
+	std::array<math::mat4, 6> shadow_matrices;
+	/// The light samples the shadow atlas.
+	bool shadowed = false;
+};
+
+struct probe_draw
+{
+	/// Copy of the probe.
+	reflection_probe probe;
+	/// World transform.
+	math::transform world;
+	/// Scissor rectangle on the reflection buffer.
+	irect32_t rect;
+	/// Cubemap of the probe.
+	std::shared_ptr<gfx::texture> cubemap;
+};
+
+bool intersects(const math::bbox& bounds, const math::vec3& center, float radius)
+{
+	const auto offset = bounds.closest_point(center) - center;
+	return math::dot(offset, offset) <= radius * radius;
+}
+
+math::mat4 get_atlas_matrix(const urect32_t& rect, float atlas_size)
+{
+	// ndc to uv of the square, the y flip depends on the texture origin.
+	const float sx = float(rect.width()) / atlas_size;
+	const float sy = float(rect.height()) / atlas_size;
+	const float ox = float(rect.left) / atlas_size;
+	const bool bottom_left = gfx::is_origin_bottom_left();
+	const float oy = bottom_left ? 1.0f - float(rect.bottom) / atlas_size : float(rect.top) / atlas_size;
+
+	math::mat4 result(1.0f);
+	result[0][0] = 0.5f * sx;
+	result[1][1] = (bottom_left ? 0.5f : -0.5f) * sy;
+	result[3][0] = 0.5f * sx + ox;
+	result[3][1] = 0.5f * sy + oy;
+	return result;
+}
+
+std::vector<camera> get_shadow_cameras(const light& l, const math::transform& world)
+{
+	std::vector<camera> result;
+	const auto& position = world.get_position();
+	if(l.type == light_type::point)
+	{
+		math::transform t;
+		t.set_position(position);
+		for(std::uint32_t i = 0; i < 6; ++i)
+		{
+			auto cam = camera::get_face_camera(i, t);
+			cam.set_near_clip(0.05f);
+			cam.set_far_clip(l.point_data.range);
+			result.emplace_back(cam);
+		}
+	}
+	else
+	{
+		const auto direction = world.z_unit_axis();
+		const auto up =
+			math::abs(direction.y) > 0.99f ? math::vec3(0.0f, 0.0f, 1.0f) : math::vec3(0.0f, 1.0f, 0.0f);
+		camera cam;
+		cam.set_fov(math::clamp(l.spot_data.get_outer_angle(), 1.0f, 179.0f));
+		cam.set_aspect_ratio(1.0f, true);
+		cam.set_near_clip(0.05f);
+		cam.set_far_clip(l.spot_data.get_range());
+		cam.look_at(position, position + direction, up);
+		result.emplace_back(cam);
+	}
+	return result;
+}
+
+void draw_shadow_casters(gfx::render_pass& pass, gpu_program& program, const camera& cam,
+						 const math::vec4& position_range, const std::vector<const shadow_caster*>& casters)
+{
+	const auto& frustum = cam.get_frustum();
+	for(const auto caster : casters)
+	{
+		const auto& model = caster->model_data;
+		const auto& world_transform = caster->world;
+		const auto mesh = model.get_lod(0);
+		if(!mesh || !math::frustum::test_obb(frustum, mesh->get_bounds(), world_transform))
+			continue;
+
+		// No depth buffer, the closest distance is kept by min blending.
+		model.render(pass.id, world_transform, {}, false, false, false,
+					 BGFX_STATE_WRITE_RGB | BGFX_STATE_BLEND_MIN, 0, &program,
+					 [&position_range](auto& p) { p.set_uniform(u_light_position, position_range); });
+	}
+}
+}
 
 bool update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits, std::size_t total_lods,
 					 float transition_time, float dt, asset_handle<mesh> mesh, const math::transform& world,
@@ -66,93 +298,14 @@ bool update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits,
 	return true;
 }
 
-bool should_rebuild_reflections(visibility_set_models_t& visibility_set, const reflection_probe& probe)
-{
-
-	if(probe.method == reflect_method::environment)
-		return false;
-
-	for(auto& element : visibility_set)
-	{
-		auto& transform_comp_handle = std::get<1>(element);
-		auto& model_comp_handle = std::get<2>(element);
-		auto transform_comp_ptr = transform_comp_handle.lock();
-		auto model_comp_ptr = model_comp_handle.lock();
-		if(!transform_comp_ptr || !model_comp_ptr)
-			continue;
-
-		auto& transform_comp_ref = *transform_comp_ptr.get();
-		auto& model_comp_ref = *model_comp_ptr.get();
-
-		const auto& model = model_comp_ref.get_model();
-		if(!model.is_valid())
-			continue;
-
-		const auto mesh = model.get_lod(0);
-
-		const auto& world_transform = transform_comp_ref.get_transform();
-
-		const auto& bounds = mesh->get_bounds();
-
-		bool result = false;
-
-		for(std::uint32_t i = 0; i < 6; ++i)
-		{
-			const auto& frustum = camera::get_face_camera(i, world_transform).get_frustum();
-			result |= math::frustum::test_obb(frustum, bounds, world_transform);
-		}
-
-		if(result)
-			return true;
-	}
-
-	return false;
-}
-
-bool should_rebuild_shadows(visibility_set_models_t& visibility_set, const light&)
-{
-	//	for(auto& element : visibility_set)
-	//	{
-	//		auto& transform_comp_handle = std::get<1>(element);
-	//		auto& model_comp_handle = std::get<2>(element);
-	//		auto transform_comp_ptr = transform_comp_handle.lock();
-	//		auto model_comp_ptr = model_comp_handle.lock();
-	//		if(!transform_comp_ptr || !model_comp_ptr)
-	//			continue;
-
-	//		auto& transform_comp_ref = *transform_comp_ptr.get();
-	//		auto& model_comp_ref = *model_comp_ptr.get();
-
-	//		const auto& model = model_comp_ref.get_model();
-	//		if(!model.is_valid())
-	//			continue;
-
-	//		const auto mesh = model.get_lod(0);
-
-	//		const auto& world_transform = transform_comp_ref.get_transform();
-	//		const auto& bounds = mesh->get_bounds();
-
-	//		bool result = false;
-
-	//		// for(std::uint32_t i = 0; i < 6; ++i)
-	//		//{
-	//		//	const auto& frustum = camera::get_face_camera(i, world_transform).get_frustum();
-	//		//	result |= math::frustum::test_obb(frustum, bounds, world_transform);
-	//		//}
-
-	//		if(result)
-	//			return true;
-	//	}
-
-	return false;
-}
-
 visibility_set_models_t deferred_rendering::gather_visible_models(entity_component_system& ecs,
 																  camera* camera,
 																  bool dirty_only /* = false*/,
 																  bool static_only /*= true*/,
 																  bool require_reflection_caster /*= false*/)
 {
+	PROFILE_SCOPE("deferred_rendering::gather_visible_models");
+
 	visibility_set_models_t result;
 	chandle<transform_component> transform_comp_handle;
 	chandle<model_component> model_comp_handle;
@@ -224,135 +377,627 @@ visibility_set_models_t deferred_rendering::gather_visible_models(entity_compone
 
 void deferred_rendering::frame_render(std::chrono::duration<float> dt)
 {
+	PROFILE_SCOPE("deferred_rendering::frame_render");
+
 	auto& ecs = core::get_subsystem<entity_component_system>();
+	auto& renderer = core::get_subsystem<runtime::renderer>();
+
+	// The passes copy what they draw from the scene while the graph is built,
+	// so the graph can be executed on the render thread a frame later.
+	auto graph = std::make_shared<gfx::render_graph>();
+	build_reflections_pass(*graph, ecs, dt);
+	build_shadows_pass(*graph, ecs, dt);
+	camera_pass(*graph, ecs, dt);
+
+	graph->compile();
+	transient_memory_ = graph->get_transient_memory();
+	unaliased_memory_ = graph->get_unaliased_memory();
 
-	build_reflections_pass(ecs, dt);
-	build_shadows_pass(ecs, dt);
-	camera_pass(ecs, dt);
+	renderer.record([this, graph]() {
+		// Textures the previous graph did not use are released here.
+		transient_pool_.release_unused_resources();
+		clustered_views_used_ = 0;
+
+		graph->execute(transient_pool_);
+	});
 }
 
-void deferred_rendering::build_reflections_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
+void deferred_rendering::build_reflections_pass(gfx::render_graph& graph, entity_component_system& ecs,
+												std::chrono::duration<float> dt)
 {
-	auto dirty_models = gather_visible_models(ecs, nullptr, true, true, true);
+	PROFILE_SCOPE("deferred_rendering::build_reflections_pass");
+
+	struct face_request
+	{
+		entity probe;
+		std::uint32_t face = 0;
+		float priority = 0.0f;
+	};
+
+	core::frame_vector<math::vec3> camera_positions;
+	ecs.for_each<camera_component>([&camera_positions](entity ce, camera_component& camera_comp) {
+		camera_positions.emplace_back(camera_comp.get_camera().get_position());
+	});
+
+	// Only the changed models are tested against the cached face visibility.
+	const auto dirty_models = gather_visible_models(ecs, nullptr, true, false, false);
+	core::frame_vector<face_request> requests;
+	core::frame_vector<entity> probes;
 	ecs.for_each<transform_component, reflection_probe_component>(
-		[this, &ecs, dt, &dirty_models](entity ce, transform_component& transform_comp,
-										reflection_probe_component& reflection_probe_comp) {
+		[this, &ecs, dt, &dirty_models, &camera_positions, &requests,
+		 &probes](entity ce, transform_component& transform_comp,
+				  reflection_probe_component& reflection_probe_comp) {
 			const auto& world_tranform = transform_comp.get_transform();
 			const auto& probe = reflection_probe_comp.get_probe();
+			auto& state = probe_states_[ce];
+			probes.emplace_back(ce);
 
-			auto cubemap_fbo = reflection_probe_comp.get_cubemap_fbo();
-			bool should_rebuild = true;
-
-			if(!transform_comp.is_touched() && !reflection_probe_comp.is_touched())
+			if(!state.initialized || transform_comp.is_touched() || reflection_probe_comp.is_touched())
 			{
-				// If reflections shouldn't be rebuilt - continue.
-				should_rebuild = should_rebuild_reflections(dirty_models, probe);
+				for(std::uint32_t i = 0; i < 6; ++i)
+				{
+					auto camera = camera::get_face_camera(i, world_tranform);
+					camera.set_far_clip(probe.box_data.extents.r);
+					state.frustums[i] = camera.get_frustum();
+					state.visibility[i].clear();
+					if(probe.method != reflect_method::environment)
+					{
+						const auto visible = gather_visible_models(ecs, &camera, false, true, true);
+						state.visibility[i].assign(std::begin(visible), std::end(visible));
+					}
+					state.dirty[i] = true;
+				}
+				state.initialized = true;
+			}
+			else if(probe.method != reflect_method::environment)
+			{
+				update_probe_visibility(state, dirty_models);
 			}
 
-			if(!should_rebuild)
-				return;
+			// Close probes first, the longer a face waits the more it climbs.
+			float distance = 0.0f;
+			if(!camera_positions.empty())
+			{
+				distance = std::numeric_limits<float>::max();
+				for(const auto& position : camera_positions)
+				{
+					distance = math::min(distance, math::distance(position, world_tranform.get_position()));
+				}
+			}
 
-			// iterate trough each cube face
 			for(std::uint32_t i = 0; i < 6; ++i)
 			{
-				auto camera = camera::get_face_camera(i, world_tranform);
-				camera.set_far_clip(reflection_probe_comp.get_probe().box_data.extents.r);
-				auto& render_view = reflection_probe_comp.get_render_view(i);
-				camera.set_viewport_size(usize32_t(cubemap_fbo->get_size()));
-				auto& camera_lods = lod_data_[ce];
-				visibility_set_models_t visibility_set;
-
-				if(probe.method != reflect_method::environment)
-					visibility_set = gather_visible_models(ecs, &camera, !should_rebuild, true, true);
-
-				std::shared_ptr<gfx::frame_buffer> output = nullptr;
-				output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
-				output = lighting_pass(output, camera, render_view, ecs, dt);
-				output = atmospherics_pass(output, camera, render_view, ecs, dt);
-				output = tonemapping_pass(output, camera, render_view);
-
-				gfx::render_pass pass("cubemap_fill");
-				pass.touch();
-				gfx::blit(pass.id, cubemap_fbo->get_texture()->native_handle(), 0, 0, 0, std::uint16_t(i),
-						  output->get_texture()->native_handle());
-			}
+				if(!state.dirty[i])
+					continue;
 
-			gfx::render_pass pass("cubemap_generate_mips");
-			pass.bind(cubemap_fbo.get());
-			pass.touch();
+				state.waiting[i] += dt.count();
+				requests.push_back({ce, i, (1.0f + state.waiting[i]) / (1.0f + distance)});
+			}
 		});
+
+	// Forget probes whose component was removed.
+	for(auto it = std::begin(probe_states_); it != std::end(probe_states_);)
+	{
+		if(std::find(std::begin(probes), std::end(probes), it->first) == std::end(probes))
+			it = probe_states_.erase(it);
+		else
+			++it;
+	}
+
+	std::stable_sort(std::begin(requests), std::end(requests),
+					 [](const face_request& a, const face_request& b) { return a.priority > b.priority; });
+	if(reflection_face_budget_ > 0 && requests.size() > reflection_face_budget_)
+	{
+		requests.resize(reflection_face_budget_);
+	}
+
+	for(auto ce : probes)
+	{
+		auto& state = probe_states_[ce];
+		const auto is_selected = [ce](const face_request& r) { return r.probe == ce; };
+		if(std::none_of(std::begin(requests), std::end(requests), is_selected))
+			continue;
+
+		auto transform_comp = ce.get_component<transform_component>().lock();
+		auto reflection_probe_comp = ce.get_component<reflection_probe_component>().lock();
+		const auto& world_tranform = transform_comp->get_transform();
+		auto& camera_lods = lod_data_[ce];
+		auto cubemap_fbo = reflection_probe_comp->get_cubemap_fbo();
+		const auto cubemap = graph.import_texture("CUBEMAP", reflection_probe_comp->get_cubemap());
+
+		for(const auto& request : requests)
+		{
+			if(request.probe != ce)
+				continue;
+
+			const auto i = request.face;
+			auto camera = camera::get_face_camera(i, world_tranform);
+			camera.set_far_clip(reflection_probe_comp->get_probe().box_data.extents.r);
+			camera.set_viewport_size(usize32_t(cubemap_fbo->get_size()));
+
+			// The faces are rendered one after the other, so they all share the
+			// same transient targets.
+			auto targets = std::make_shared<render_view_targets>();
+			targets->size = camera.get_viewport_size();
+
+			g_buffer_pass(graph, targets, camera, state.visibility[i], camera_lods, dt);
+			clear_reflections_pass(graph, targets);
+			lighting_pass(graph, targets, camera, ecs);
+			atmospherics_pass(graph, targets, camera, ecs);
+			tonemapping_pass(graph, targets, camera);
+
+			graph.add_pass("cubemap_fill",
+						   [&targets, cubemap](gfx::render_graph::builder& builder) {
+							   builder.read(targets->output);
+							   builder.write(cubemap);
+						   },
+						   [targets, cubemap, i](gfx::render_graph::resources& res) {
+							   gfx::render_pass pass("cubemap_fill");
+							   pass.touch();
+							   const auto face = res.get_texture(targets->output);
+							   gfx::blit(pass.id, res.get_texture(cubemap)->native_handle(), 0, 0, 0,
+										 std::uint16_t(i), face->native_handle());
+						   });
+
+			state.dirty[i] = false;
+			state.waiting[i] = 0.0f;
+			state.faces_since_mips++;
+		}
+
+		// Generate the mips once the pending faces are done. Probes that never
+		// settle still get them after every six faces.
+		const bool pending =
+			std::any_of(std::begin(state.dirty), std::end(state.dirty), [](bool dirty) { return dirty; });
+		if(state.faces_since_mips == 0 || (pending && state.faces_since_mips < 6))
+			continue;
+
+		state.faces_since_mips = 0;
+		graph.add_pass("cubemap_generate_mips",
+					   [cubemap](gfx::render_graph::builder& builder) {
+						   builder.write(cubemap);
+						   builder.set_side_effect();
+					   },
+					   [cubemap_fbo](gfx::render_graph::resources&) {
+						   gfx::render_pass pass("cubemap_generate_mips");
+						   pass.bind(cubemap_fbo.get());
+						   pass.touch();
+					   });
+	}
 }
 
-void deferred_rendering::build_shadows_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
+void deferred_rendering::update_probe_visibility(probe_state& state,
+												 const visibility_set_models_t& dirty_models)
 {
-	auto dirty_models = gather_visible_models(ecs, nullptr, true, true, true);
+	for(const auto& element : dirty_models)
+	{
+		const auto& e = std::get<0>(element);
+		auto transform_comp_ptr = std::get<1>(element).lock();
+		auto model_comp_ptr = std::get<2>(element).lock();
+		if(!transform_comp_ptr || !model_comp_ptr)
+			continue;
+
+		const auto mesh = model_comp_ptr->get_model().get_lod(0);
+		const bool is_caster = mesh && model_comp_ptr->is_static() && model_comp_ptr->casts_reflection();
+		const auto& world_transform = transform_comp_ptr->get_transform();
+
+		for(std::uint32_t i = 0; i < 6; ++i)
+		{
+			auto& visibility = state.visibility[i];
+			const auto it = std::find_if(std::begin(visibility), std::end(visibility),
+										 [&e](const auto& other) { return std::get<0>(other) == e; });
+			const bool was_visible = it != std::end(visibility);
+			const bool visible =
+				is_caster && math::frustum::test_obb(state.frustums[i], mesh->get_bounds(), world_transform);
+
+			// Entering, leaving or changing inside the face all need a render.
+			if(was_visible || visible)
+				state.dirty[i] = true;
+
+			if(visible && !was_visible)
+				visibility.emplace_back(element);
+			else if(!visible && was_visible)
+				visibility.erase(it);
+		}
+	}
+}
+
+void deferred_rendering::build_shadows_pass(gfx::render_graph& graph, entity_component_system& ecs,
+											 std::chrono::duration<float> dt)
+{
+	PROFILE_SCOPE("deferred_rendering::build_shadows_pass");
+
+	shadow_atlas_resource_ = render_view_targets::invalid;
+	if(!shadow_program_)
+	{
+		return;
+	}
+
+	// Gather the casters and the regions in which static casters changed. A
+	// moved caster invalidates both its old and its new bounds.
+	auto casters = std::make_shared<std::vector<shadow_caster>>();
+	auto dirty_regions = std::move(removed_caster_bounds_);
+	removed_caster_bounds_.clear();
+	chandle<transform_component> transform_comp_handle;
+	chandle<model_component> model_comp_handle;
+	for(auto e : ecs.entities_with_components(transform_comp_handle, model_comp_handle))
+	{
+		auto transform_comp_ptr = transform_comp_handle.lock();
+		auto model_comp_ptr = model_comp_handle.lock();
+		const auto mesh = model_comp_ptr->get_model().get_lod(0);
+		const bool touched = transform_comp_ptr->is_touched() || model_comp_ptr->is_touched();
+		const bool is_caster = mesh && model_comp_ptr->casts_shadow();
+		const bool is_static = is_caster && model_comp_ptr->is_static();
+
+		auto it = static_caster_bounds_.find(e);
+		const bool was_static = it != std::end(static_caster_bounds_);
+		if(was_static && (touched || !is_static))
+		{
+			dirty_regions.emplace_back(it->second);
+			static_caster_bounds_.erase(it);
+		}
+
+		if(!is_caster)
+			continue;
+
+		shadow_caster caster;
+		caster.model_comp = model_comp_handle;
+		caster.world = transform_comp_ptr->get_transform();
+		caster.bounds = math::bbox::mul(mesh->get_bounds(), caster.world);
+		caster.is_static = is_static;
+
+		// Also covers meshes that finished loading.
+		if(is_static && (touched || !was_static))
+		{
+			dirty_regions.emplace_back(caster.bounds);
+			static_caster_bounds_[e] = caster.bounds;
+		}
+		casters->emplace_back(caster);
+	}
+
+	// Rank the lights by the largest share of a camera they cover.
+	core::frame_vector<const camera*> cameras;
+	ecs.for_each<camera_component>([&cameras](entity ce, camera_component& camera_comp) {
+		cameras.emplace_back(&camera_comp.get_camera());
+	});
+
+	struct candidate
+	{
+		entity e;
+		const light_component* light_comp = nullptr;
+		const transform_component* transform_comp = nullptr;
+		float coverage = 0.0f;
+	};
+	core::frame_vector<candidate> candidates;
 	ecs.for_each<transform_component, light_component>(
-		[this, &ecs, dt, &dirty_models](entity ce, transform_component& transform_comp,
-										light_component& light_comp) {
-			// const auto& world_tranform = transform_comp.get_transform();
+		[&cameras, &candidates](entity e, transform_component& transform_comp, light_component& light_comp) {
 			const auto& light = light_comp.get_light();
+			if(light.type == light_type::directional)
+				return;
 
-			bool should_rebuild = true;
+			const auto& world_transform = transform_comp.get_transform();
+			float coverage = 0.0f;
+			for(const auto cam : cameras)
+			{
+				const auto& viewport = cam->get_viewport_size();
+				if(viewport.width == 0 || viewport.height == 0)
+					continue;
+
+				irect32_t rect(0, 0, irect32_t::value_type(viewport.width),
+							   irect32_t::value_type(viewport.height));
+				if(light_comp.compute_projected_sphere_rect(rect, world_transform.get_position(),
+															world_transform.z_unit_axis(), cam->get_view(),
+															cam->get_projection()) == 0)
+					continue;
+
+				const float area = float(rect.width()) * float(rect.height());
+				coverage = math::max(coverage, area / (float(viewport.width) * float(viewport.height)));
+			}
 
-			if(!transform_comp.is_touched() && !light_comp.is_touched())
+			if(coverage > 0.0f)
 			{
-				// If shadows shouldn't be rebuilt - continue.
-				should_rebuild = should_rebuild_shadows(dirty_models, light);
+				candidates.push_back({e, &light_comp, &transform_comp, math::min(coverage, 1.0f)});
 			}
+		});
 
-			if(!should_rebuild)
-				return;
+	std::stable_sort(std::begin(candidates), std::end(candidates),
+					 [](const candidate& a, const candidate& b) { return a.coverage > b.coverage; });
+	if(candidates.size() > max_shadowed_lights)
+	{
+		candidates.resize(max_shadowed_lights);
+	}
 
-		});
+	// Lights that went out of view or lost their rank give their squares back
+	// first, so the remaining ones can grow into them.
+	for(auto it = std::begin(shadows_); it != std::end(shadows_);)
+	{
+		const auto same = [&it](const candidate& c) { return c.e == it->first; };
+		if(std::none_of(std::begin(candidates), std::end(candidates), same))
+		{
+			release_shadow(it->second);
+			it = shadows_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if(candidates.empty())
+	{
+		return;
+	}
+
+	const auto atlas_size = shadow_layout_.get_size();
+	if(!shadow_fbo_)
+	{
+		const auto flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+		const auto format = gfx::texture_format::R32F;
+		const auto size = std::uint16_t(atlas_size);
+		auto static_tex = std::make_shared<gfx::texture>(size, size, false, 1, format, flags);
+		auto tex = std::make_shared<gfx::texture>(size, size, false, 1, format, flags);
+		using textures_t = std::vector<std::shared_ptr<gfx::texture>>;
+		static_shadow_fbo_ = std::make_shared<gfx::frame_buffer>(textures_t{static_tex});
+		shadow_fbo_ = std::make_shared<gfx::frame_buffer>(textures_t{tex});
+	}
+
+	auto jobs = std::make_shared<std::vector<shadow_job>>();
+	for(const auto& c : candidates)
+	{
+		const auto& light = c.light_comp->get_light();
+		const auto& world_transform = c.transform_comp->get_transform();
+		const bool is_point = light.type == light_type::point;
+		const std::uint32_t face_count = is_point ? 6 : 1;
+		const auto max_size = is_point ? max_point_shadow_size : max_spot_shadow_size;
+		const auto scaled_size = std::uint32_t(float(max_size) * math::sqrt(c.coverage));
+		const auto target_size = shadow_layout_.fit_size(scaled_size);
+
+		auto& entry = shadows_[c.e];
+
+		// Grow right away, shrink only when a quarter of the size is enough, so
+		// lights near a threshold do not render their cache every frame.
+		if(entry.face_count != face_count || target_size > entry.size || target_size * 4 <= entry.size)
+		{
+			release_shadow(entry);
+			for(auto size = target_size; size >= shadow_layout_.get_min_size(); size /= 2)
+			{
+				std::uint32_t allocated = 0;
+				for(; allocated < face_count; ++allocated)
+				{
+					entry.faces[allocated] = shadow_layout_.allocate(size);
+					if(entry.faces[allocated] == shadow_atlas::invalid_handle)
+						break;
+				}
+				entry.face_count = allocated;
+				if(allocated == face_count)
+				{
+					entry.size = size;
+					break;
+				}
+				release_shadow(entry);
+			}
+
+			entry.static_dirty = true;
+			entry.has_dynamic = false;
+		}
+
+		if(entry.face_count == 0)
+		{
+			shadows_.erase(c.e);
+			continue;
+		}
+
+		const float range = is_point ? light.point_data.range : light.spot_data.get_range();
+		const auto& position = world_transform.get_position();
+		if(c.transform_comp->is_touched() || c.light_comp->is_touched())
+		{
+			entry.static_dirty = true;
+		}
+		for(const auto& region : dirty_regions)
+		{
+			entry.static_dirty |= intersects(region, position, range);
+		}
+
+		shadow_job job;
+		job.position_range = math::vec4(position, range);
+		job.cameras = get_shadow_cameras(light, world_transform);
+		for(std::uint32_t i = 0; i < face_count; ++i)
+		{
+			const auto& cam = job.cameras[i];
+			const auto& rect = shadow_layout_.get_rect(entry.faces[i]);
+			job.rects.emplace_back(rect);
+			const auto view_proj = cam.get_projection().get_matrix() * cam.get_view().get_matrix();
+			entry.matrices[i] = get_atlas_matrix(rect, float(atlas_size)) * view_proj;
+		}
+
+		for(auto& caster : *casters)
+		{
+			if(!intersects(caster.bounds, position, range))
+				continue;
+
+			const bool is_drawn = !caster.is_static || entry.static_dirty;
+			if(is_drawn && !caster.captured)
+			{
+				caster.model_data = caster.model_comp.lock()->get_model();
+				caster.captured = true;
+			}
+
+			if(!caster.is_static)
+			{
+				job.dynamic_casters.emplace_back(&caster);
+			}
+			else if(entry.static_dirty)
+			{
+				job.static_casters.emplace_back(&caster);
+			}
+		}
+
+		// A valid cache without dynamic casters now or before is already in the
+		// sampled atlas.
+		job.render_static = entry.static_dirty;
+		const bool compose = entry.static_dirty || entry.has_dynamic || !job.dynamic_casters.empty();
+		entry.static_dirty = false;
+		entry.has_dynamic = !job.dynamic_casters.empty();
+		if(compose)
+		{
+			jobs->emplace_back(std::move(job));
+		}
+	}
+
+	shadow_atlas_resource_ = graph.import_texture("SHADOW_ATLAS", shadow_fbo_->get_texture(0));
+	if(jobs->empty())
+	{
+		return;
+	}
+
+	const auto atlas_resource = shadow_atlas_resource_;
+	const auto setup = [atlas_resource](gfx::render_graph::builder& builder) {
+		builder.write(atlas_resource);
+	};
+	auto execute = [this, casters, jobs, atlas_resource](gfx::render_graph::resources& res) {
+		auto& program = *shadow_program_;
+		if(!program.begin())
+			return;
+
+		for(const auto& job : *jobs)
+		{
+			if(!job.render_static)
+				continue;
+
+			for(std::size_t i = 0; i < job.rects.size(); ++i)
+			{
+				const auto& rect = job.rects[i];
+				gfx::render_pass pass("shadow_static_fill");
+				pass.bind(static_shadow_fbo_.get());
+				gfx::set_view_rect(pass.id, std::uint16_t(rect.left), std::uint16_t(rect.top),
+								   std::uint16_t(rect.width()), std::uint16_t(rect.height()));
+				gfx::set_view_scissor(pass.id, std::uint16_t(rect.left), std::uint16_t(rect.top),
+									  std::uint16_t(rect.width()), std::uint16_t(rect.height()));
+				pass.clear(BGFX_CLEAR_COLOR, 0xffffffff, 1.0f, 0);
+				pass.set_view_proj(job.cameras[i].get_view(), job.cameras[i].get_projection());
+				draw_shadow_casters(pass, program, job.cameras[i], job.position_range, job.static_casters);
+			}
+		}
+
+		// Restore the cache in the sampled atlas with a single view.
+		auto atlas = res.get_texture(atlas_resource);
+		auto static_atlas = static_shadow_fbo_->get_texture(0);
+		gfx::render_pass compose_pass("shadow_compose");
+		compose_pass.touch();
+		for(const auto& job : *jobs)
+		{
+			for(const auto& rect : job.rects)
+			{
+				gfx::blit(compose_pass.id, atlas->native_handle(), std::uint16_t(rect.left),
+						  std::uint16_t(rect.top), static_atlas->native_handle(), std::uint16_t(rect.left),
+						  std::uint16_t(rect.top), std::uint16_t(rect.width()), std::uint16_t(rect.height()));
+			}
+		}
+
+		for(const auto& job : *jobs)
+		{
+			if(job.dynamic_casters.empty())
+				continue;
+
+			for(std::size_t i = 0; i < job.rects.size(); ++i)
+			{
+				const auto& rect = job.rects[i];
+				gfx::render_pass pass("shadow_dynamic_fill");
+				pass.bind(shadow_fbo_.get());
+				gfx::set_view_rect(pass.id, std::uint16_t(rect.left), std::uint16_t(rect.top),
+								   std::uint16_t(rect.width()), std::uint16_t(rect.height()));
+				gfx::set_view_scissor(pass.id, std::uint16_t(rect.left), std::uint16_t(rect.top),
+									  std::uint16_t(rect.width()), std::uint16_t(rect.height()));
+				pass.set_view_proj(job.cameras[i].get_view(), job.cameras[i].get_projection());
+				draw_shadow_casters(pass, program, job.cameras[i], job.position_range, job.dynamic_casters);
+			}
+		}
+
+		program.end();
+	};
+
+	graph.add_pass("shadow_update", setup, std::move(execute));
 }
 
-void deferred_rendering::camera_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
+void deferred_rendering::camera_pass(gfx::render_graph& graph, entity_component_system& ecs,
+									 std::chrono::duration<float> dt)
 {
-	ecs.for_each<camera_component>([this, &ecs, dt](entity ce, camera_component& camera_comp) {
+	ecs.for_each<camera_component>([this, &graph, &ecs, dt](entity ce, camera_component& camera_comp) {
 		auto& camera_lods = lod_data_[ce];
 		auto& camera = camera_comp.get_camera();
 		auto& render_view = camera_comp.get_render_view();
 
-		auto output = deferred_render_full(camera, render_view, ecs, camera_lods, dt);
+		deferred_render_full(graph, camera, render_view, ecs, camera_lods, dt);
 	});
 }
 
-std::shared_ptr<gfx::frame_buffer> deferred_rendering::deferred_render_full(
-	camera& camera, gfx::render_view& render_view, entity_component_system& ecs,
-	std::unordered_map<entity, lod_data>& camera_lods, std::chrono::duration<float> dt)
+void deferred_rendering::deferred_render_full(gfx::render_graph& graph, camera& camera,
+											  gfx::render_view& render_view, entity_component_system& ecs,
+											  std::unordered_map<entity, lod_data>& camera_lods,
+											  std::chrono::duration<float> dt)
 {
-	std::shared_ptr<gfx::frame_buffer> output = nullptr;
+	const auto& viewport_size = camera.get_viewport_size();
+
+	auto targets = std::make_shared<render_view_targets>();
+	targets->size = viewport_size;
+	targets->depth = graph.import_texture("DEPTH", render_view.get_depth_buffer(viewport_size));
+	targets->output = graph.import_texture("OUTPUT", render_view.get_output_buffer(viewport_size));
+	targets->shadow_atlas = shadow_atlas_resource_;
+	if(persistent_g_buffer_)
+	{
+		auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size);
+		for(std::uint32_t i = 0; i < targets->g_buffer.size(); ++i)
+		{
+			targets->g_buffer[i] = graph.import_texture("GBUFFER", g_buffer_fbo->get_texture(i));
+		}
+	}
 
 	auto visibility_set = gather_visible_models(ecs, &camera, false, false, false);
 
-	output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
+	if(core::has_subsystems<texture_streaming>())
+	{
+		core::get_subsystem<texture_streaming>().request(camera, visibility_set);
+	}
 
-	output = reflection_probe_pass(output, camera, render_view, ecs, dt);
+	g_buffer_pass(graph, targets, camera, std::move(visibility_set), camera_lods, dt);
 
-	output = lighting_pass(output, camera, render_view, ecs, dt);
+	reflection_probe_pass(graph, targets, camera, ecs);
 
-	output = atmospherics_pass(output, camera, render_view, ecs, dt);
+	lighting_pass(graph, targets, camera, ecs);
 
-	output = tonemapping_pass(output, camera, render_view);
+	atmospherics_pass(graph, targets, camera, ecs);
 
-	return output;
+	tonemapping_pass(graph, targets, camera);
 }
 
-std::shared_ptr<gfx::frame_buffer>
-deferred_rendering::g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-								  gfx::render_view& render_view, visibility_set_models_t& visibility_set,
-								  std::unordered_map<entity, lod_data>& camera_lods,
-								  std::chrono::duration<float> dt)
+void deferred_rendering::g_buffer_pass(gfx::render_graph& graph,
+									   const std::shared_ptr<render_view_targets>& targets,
+									   const camera& camera, visibility_set_models_t visibility_set,
+									   std::unordered_map<entity, lod_data>& camera_lods,
+									   std::chrono::duration<float> dt)
 {
-	const auto& view = camera.get_view();
-	const auto& proj = camera.get_projection();
-	const auto& viewport_size = camera.get_viewport_size();
-	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size);
-	gfx::render_pass pass("g_buffer_fill");
-	pass.clear();
-	pass.set_view_proj(view, proj);
-	pass.bind(g_buffer_fbo.get());
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		if(targets->depth == render_view_targets::invalid)
+		{
+			targets->depth = builder.create("DEPTH", get_desc(targets->size, get_depth_format()));
+		}
+
+		for(std::uint32_t i = 0; i < targets->g_buffer.size(); ++i)
+		{
+			if(targets->g_buffer[i] == render_view_targets::invalid)
+			{
+				// The normals need the extra precision.
+				const auto format = i == 1 ? get_hdr_format() : get_color_format();
+				targets->g_buffer[i] =
+					builder.create("GBUFFER" + std::to_string(i), get_desc(targets->size, format));
+			}
+			builder.write(targets->g_buffer[i]);
+		}
+		builder.write(targets->depth);
+	};
 
+	// Update the lods and copy the models, the draws must not touch the scene.
+	std::vector<g_buffer_draw> draws;
+	draws.reserve(visibility_set.size());
 	for(auto& element : visibility_set)
 	{
 		auto& e = std::get<0>(element);
@@ -371,7 +1016,6 @@ deferred_rendering::g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, came
 			continue;
 
 		const auto& world_transform = transform_comp_ref.get_transform();
-		const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
 
 		auto& lod_data = camera_lods[e];
 		const auto transition_time = model.get_lod_transition_time();
@@ -388,83 +1032,144 @@ deferred_rendering::g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, came
 		if(false == update_lod_data(lod_data, lod_limits, lod_count, transition_time, dt.count(),
 									current_mesh, world_transform, camera))
 			continue;
-		const auto params = math::vec3{0.0f, -1.0f, (transition_time - current_time) / transition_time};
-
-		const auto params_inv = math::vec3{1.0f, 1.0f, current_time / transition_time};
 
-		const auto& bone_transforms = model_comp_ref.get_bone_transforms();
+		g_buffer_draw draw;
+		draw.model_data = model;
+		draw.world = world_transform;
+		draw.bones = model_comp_ref.get_bone_transforms();
+		draw.current_lod = current_lod_index;
+		draw.target_lod = target_lod_index;
+		draw.params = math::vec3{0.0f, -1.0f, (transition_time - current_time) / transition_time};
+		draw.params_inv = math::vec3{1.0f, 1.0f, current_time / transition_time};
+		draw.transition = current_time != 0.0f;
+		draws.emplace_back(std::move(draw));
+	}
 
-		model.render(pass.id, world_transform, bone_transforms, true, true, true, 0, current_lod_index,
-					 nullptr, [&camera, &clip_planes, &params](auto& p) {
-						 auto camera_pos = camera.get_position();
-						 p.set_uniform("u_camera_wpos", camera_pos);
-						 p.set_uniform("u_camera_clip_planes", clip_planes);
-						 p.set_uniform("u_lod_params", params);
-					 });
+	auto execute = [targets, camera, draws = std::move(draws)](gfx::render_graph::resources& res) {
+		const auto& view = camera.get_view();
+		const auto& proj = camera.get_projection();
+		const auto& g_buffer = targets->g_buffer;
+		auto g_buffer_fbo = res.get_fbo(
+			"GBUFFER", {g_buffer[0], g_buffer[1], g_buffer[2], g_buffer[3], targets->depth});
+		gfx::render_pass pass("g_buffer_fill");
+		pass.clear();
+		pass.set_view_proj(view, proj);
+		pass.bind(g_buffer_fbo.get());
 
-		if(current_time != 0.0f)
+		const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
+		for(const auto& draw : draws)
 		{
-			model.render(
-				pass.id, world_transform, bone_transforms, true, true, true, 0, target_lod_index, nullptr,
-				[&params_inv](auto& p) { p.set_uniform("u_lod_params", params_inv); });
+			const auto& params = draw.params;
+			const auto& params_inv = draw.params_inv;
+			draw.model_data.render(pass.id, draw.world, draw.bones, true, true, true, 0, draw.current_lod,
+								   nullptr, [&camera, &clip_planes, &params](auto& p) {
+									   auto camera_pos = camera.get_position();
+									   p.set_uniform(u_camera_wpos, camera_pos);
+									   p.set_uniform(u_camera_clip_planes, clip_planes);
+									   p.set_uniform(u_lod_params, params);
+								   });
+
+			if(draw.transition)
+			{
+				draw.model_data.render(
+					pass.id, draw.world, draw.bones, true, true, true, 0, draw.target_lod, nullptr,
+					[&params_inv](auto& p) { p.set_uniform(u_lod_params, params_inv); });
+			}
 		}
-	}
+	};
 
-	return g_buffer_fbo;
+	graph.add_pass("g_buffer_fill", setup, std::move(execute));
 }
 
-std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared_ptr<gfx::frame_buffer> input,
-																	 camera& camera,
-																	 gfx::render_view& render_view,
-																	 entity_component_system& ecs,
-																	 std::chrono::duration<float> dt)
+void deferred_rendering::lighting_pass(gfx::render_graph& graph,
+									   const std::shared_ptr<render_view_targets>& targets,
+									   const camera& camera, entity_component_system& ecs)
 {
-	const auto& view = camera.get_view();
-	const auto& proj = camera.get_projection();
-
-	const auto& viewport_size = camera.get_viewport_size();
-	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size).get();
-
-	static auto light_buffer_format = gfx::get_best_format(
-		BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::four_channels |
-												  gfx::format_search_flags::requires_alpha |
-												  gfx::format_search_flags::half_precision_float);
-
-	auto light_buffer = render_view.get_texture("LBUFFER", viewport_size.width, viewport_size.height, false,
-												1, light_buffer_format);
-	auto l_buffer_fbo = render_view.get_fbo("LBUFFER", {light_buffer});
-	const auto buffer_size = l_buffer_fbo->get_size();
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		for(auto id : targets->g_buffer)
+		{
+			builder.read(id);
+		}
+		builder.read(targets->depth);
+		builder.read(targets->refl_buffer);
+		if(targets->shadow_atlas != render_view_targets::invalid)
+		{
+			builder.read(targets->shadow_atlas);
+		}
 
-	gfx::render_pass pass("light_buffer_fill");
-	pass.bind(l_buffer_fbo.get());
-	pass.set_view_proj(view, proj);
-	pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
-	auto refl_buffer =
-		render_view
-			.get_texture("RBUFFER", viewport_size.width, viewport_size.height, false, 1, light_buffer_format)
-			.get();
+		targets->light_buffer = builder.create("LBUFFER", get_desc(targets->size, get_hdr_format()));
+		builder.write(targets->light_buffer);
+	};
 
+	// Copy the lights, the unshadowed point and spot lights are also binned
+	// into clusters when the camera supports it.
+	std::vector<light_draw> lights;
+	std::vector<light_clusters::light_data> clustered_lights;
 	ecs.for_each<transform_component, light_component>(
-		[this, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo,
-		 refl_buffer](entity e, transform_component& transform_comp_ref, light_component& light_comp_ref) {
+		[this, &targets, &camera, &lights, &clustered_lights](
+			entity e, transform_component& transform_comp_ref, light_component& light_comp_ref) {
 			const auto& light = light_comp_ref.get_light();
+			const auto shadow = get_shadow(e);
 			const auto& world_transform = transform_comp_ref.get_transform();
-			const auto& light_position = world_transform.get_position();
-			const auto& light_direction = world_transform.z_unit_axis();
+			if(light.type != light_type::directional && !shadow)
+			{
+				clustered_lights.emplace_back(light_clusters::make_light_data(light, world_transform));
+			}
+
+			light_draw draw;
+			draw.light_data = light;
+			draw.position = world_transform.get_position();
+			draw.direction = world_transform.z_unit_axis();
+			draw.rect = irect32_t(0, 0, irect32_t::value_type(targets->size.width),
+								  irect32_t::value_type(targets->size.height));
+			if(light_comp_ref.compute_projected_sphere_rect(draw.rect, draw.position, draw.direction,
+															camera.get_view(), camera.get_projection()) == 0)
+				return;
+
+			if(shadow)
+			{
+				draw.shadow_matrices = shadow->matrices;
+				draw.shadowed = true;
+			}
+			lights.emplace_back(std::move(draw));
+		});
 
-			irect32_t rect(0, 0, irect32_t::value_type(buffer_size.width),
-						   irect32_t::value_type(buffer_size.height));
-			if(light_comp_ref.compute_projected_sphere_rect(rect, light_position, light_direction, view,
-															proj) == 0)
+	auto execute = [this, targets, camera, lights = std::move(lights),
+					clustered_lights = std::move(clustered_lights)](gfx::render_graph::resources& res) {
+		const auto& view = camera.get_view();
+		const auto& proj = camera.get_projection();
+
+		const auto& g_buffer = targets->g_buffer;
+		auto g_buffer_fbo = res.get_fbo(
+			"GBUFFER", {g_buffer[0], g_buffer[1], g_buffer[2], g_buffer[3], targets->depth});
+		auto l_buffer_fbo = res.get_fbo("LBUFFER", {targets->light_buffer});
+		auto refl_buffer = res.get_texture(targets->refl_buffer);
+
+		gfx::render_pass pass("light_buffer_fill");
+		pass.bind(l_buffer_fbo.get());
+		pass.set_view_proj(view, proj);
+		pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
+
+		const bool clustered =
+			draw_clustered_lights(pass, camera, clustered_lights, g_buffer_fbo.get(), refl_buffer.get());
+
+		const auto draw_light = [this, clustered, &camera, &pass, &g_buffer_fbo,
+								 &refl_buffer](const light_draw& draw) {
+			const auto& light = draw.light_data;
+			if(clustered && light.type != light_type::directional && !draw.shadowed)
 				return;
 
+			const auto& light_position = draw.position;
+			const auto& light_direction = draw.direction;
+			const auto& rect = draw.rect;
+
 			gpu_program* program = nullptr;
 			if(light.type == light_type::directional && directional_light_program_)
 			{
 				// Draw light.
 				program = directional_light_program_.get();
 				program->begin();
-				program->set_uniform("u_light_direction", light_direction);
+				program->set_uniform(u_light_direction, light_direction);
 			}
 			if(light.type == light_type::point && point_light_program_)
 			{
@@ -473,8 +1178,8 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 				// Draw light.
 				program = point_light_program_.get();
 				program->begin();
-				program->set_uniform("u_light_position", light_position);
-				program->set_uniform("u_light_data", light_data);
+				program->set_uniform(u_light_position, light_position);
+				program->set_uniform(u_light_data, light_data);
 			}
 
 			if(light.type == light_type::spot && spot_light_program_)
@@ -487,9 +1192,20 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 				// Draw light.
 				program = spot_light_program_.get();
 				program->begin();
-				program->set_uniform("u_light_position", light_position);
-				program->set_uniform("u_light_direction", light_direction);
-				program->set_uniform("u_light_data", light_data);
+				program->set_uniform(u_light_position, light_position);
+				program->set_uniform(u_light_direction, light_direction);
+				program->set_uniform(u_light_data, light_data);
+			}
+
+			if(program && light.type != light_type::directional)
+			{
+				float shadow_params[4] = {draw.shadowed ? 1.0f : 0.0f, shadow_bias, 0.0f, 0.0f};
+				program->set_uniform(u_shadow_params, shadow_params);
+				if(draw.shadowed)
+				{
+					program->set_uniform(u_shadow_matrix, draw.shadow_matrices.data(), 6);
+					program->set_texture(7, s_shadow_atlas, shadow_fbo_->get_texture(0).get());
+				}
 			}
 
 			if(program)
@@ -497,15 +1213,15 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 				float light_color_intensity[4] = {light.color.value.r, light.color.value.g,
 												  light.color.value.b, light.intensity};
 				auto camera_pos = camera.get_position();
-				program->set_uniform("u_light_color_intensity", light_color_intensity);
-				program->set_uniform("u_camera_position", camera_pos);
-				program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
-				program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
-				program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
-				program->set_texture(3, "s_tex3", g_buffer_fbo->get_texture(3).get());
-				program->set_texture(4, "s_tex4", g_buffer_fbo->get_texture(4).get());
-				program->set_texture(5, "s_tex5", refl_buffer);
-				program->set_texture(6, "s_tex6", ibl_brdf_lut_.get());
+				program->set_uniform(u_light_color_intensity, light_color_intensity);
+				program->set_uniform(u_camera_position, camera_pos);
+				program->set_texture(0, s_tex0, g_buffer_fbo->get_texture(0).get());
+				program->set_texture(1, s_tex1, g_buffer_fbo->get_texture(1).get());
+				program->set_texture(2, s_tex2, g_buffer_fbo->get_texture(2).get());
+				program->set_texture(3, s_tex3, g_buffer_fbo->get_texture(3).get());
+				program->set_texture(4, s_tex4, g_buffer_fbo->get_texture(4).get());
+				program->set_texture(5, s_tex5, refl_buffer.get());
+				program->set_texture(6, s_tex6, ibl_brdf_lut_.get());
 
 				gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
 				auto topology = gfx::clip_quad(1.0f);
@@ -515,49 +1231,168 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 
 				program->end();
 			}
-		});
+		};
+		std::for_each(std::begin(lights), std::end(lights), draw_light);
+	};
 
-	return l_buffer_fbo;
+	graph.add_pass("light_buffer_fill", setup, std::move(execute));
 }
 
-std::shared_ptr<gfx::frame_buffer>
-deferred_rendering::reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-										  gfx::render_view& render_view, entity_component_system& ecs,
-										  std::chrono::duration<float> dt)
+bool deferred_rendering::draw_clustered_lights(gfx::render_pass& pass, const camera& camera,
+											   const std::vector<light_clusters::light_data>& lights,
+											   gfx::frame_buffer* g_buffer_fbo, gfx::texture* refl_buffer)
 {
-	const auto& view = camera.get_view();
-	const auto& proj = camera.get_projection();
+	if(camera.get_projection_mode() != projection_mode::perspective || !clustered_light_program_ ||
+	   !clustered_light_program_->begin())
+	{
+		return false;
+	}
 
-	const auto& viewport_size = camera.get_viewport_size();
-	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size).get();
-
-	static auto refl_buffer_format = gfx::get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER,
-														  gfx::format_search_flags::four_channels |
-															  gfx::format_search_flags::requires_alpha |
-															  gfx::format_search_flags::half_precision_float);
-
-	auto refl_buffer = render_view.get_texture("RBUFFER", viewport_size.width, viewport_size.height, false, 1,
-											   refl_buffer_format);
-	auto r_buffer_fbo = render_view.get_fbo("RBUFFER", {refl_buffer});
-	const auto buffer_size = refl_buffer->get_size();
-
-	gfx::render_pass pass("refl_buffer_fill");
-	pass.bind(r_buffer_fbo.get());
-	pass.set_view_proj(view, proj);
-	pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
-	ecs.for_each<transform_component, reflection_probe_component>(
-		[this, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo](
-			entity e, transform_component& transform_comp_ref, reflection_probe_component& probe_comp_ref) {
-			const auto& probe = probe_comp_ref.get_probe();
-			const auto& world_transform = transform_comp_ref.get_transform();
-			const auto& probe_position = world_transform.get_position();
+	PROFILE_SCOPE("deferred_rendering::draw_clustered_lights");
+
+	if(lights.empty())
+	{
+		clustered_light_program_->end();
+		return true;
+	}
+
+	if(clustered_views_used_ == clustered_views_.size())
+	{
+		const auto flags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+		const auto format = gfx::texture_format::RGBA32F;
+		auto view_data = std::make_unique<clustered_view>();
+		view_data->lights = std::make_shared<gfx::texture>(
+			light_clusters::max_lights, light_clusters::light_texture_rows, false, 1, format, flags);
+		view_data->cluster_ranges = std::make_shared<gfx::texture>(
+			light_clusters::tiles, light_clusters::slices, false, 1, format, flags);
+		view_data->light_indices =
+			std::make_shared<gfx::texture>(light_clusters::index_texture_width,
+										   light_clusters::index_texture_height, false, 1, format, flags);
+		clustered_views_.emplace_back(std::move(view_data));
+	}
+	auto& view_data = *clustered_views_[clustered_views_used_++];
+
+	const auto near_clip = camera.get_near_clip();
+	const auto far_clip = camera.get_far_clip();
+	auto& ts = core::get_subsystem<core::task_system>();
+	view_data.clusters.build(lights, camera.get_view(), camera.get_projection(), near_clip, far_clip, &ts);
+
+	// What does not fit is not shaded, warn whenever that starts or changes.
+	const auto dropped_lights = view_data.clusters.get_dropped_lights();
+	const bool dropped_indices = view_data.clusters.get_dropped_indices() > 0;
+	if(dropped_lights != view_data.reported_dropped_lights ||
+	   dropped_indices != view_data.reported_dropped_indices)
+	{
+		view_data.reported_dropped_lights = dropped_lights;
+		view_data.reported_dropped_indices = dropped_indices;
+		if(dropped_lights > 0)
+		{
+			APPLOG_WARNING("Clustered lighting shades {0} of {1} lights, the rest is dropped.",
+						   light_clusters::max_lights, lights.size());
+		}
+		if(dropped_indices)
+		{
+			APPLOG_WARNING("Clustered lighting dropped {0} light indices, some clusters miss lights.",
+						   view_data.clusters.get_dropped_indices());
+		}
+	}
 
-			irect32_t rect(0, 0, irect32_t::value_type(buffer_size.width),
-						   irect32_t::value_type(buffer_size.height));
-			if(probe_comp_ref.compute_projected_sphere_rect(rect, probe_position, view, proj) == 0)
+	const auto upload = [&view_data](gfx::texture& tex, std::uint16_t width, std::uint16_t height) {
+		const auto size = std::uint32_t(view_data.texels.size() * sizeof(float));
+		gfx::update_texture_2d(tex.native_handle(), 0, 0, 0, 0, width, height,
+							   gfx::copy(view_data.texels.data(), size));
+	};
+	light_clusters::pack_lights(lights, view_data.texels);
+	upload(*view_data.lights, light_clusters::max_lights, light_clusters::light_texture_rows);
+	view_data.clusters.pack_clusters(view_data.texels);
+	upload(*view_data.cluster_ranges, light_clusters::tiles, light_clusters::slices);
+	view_data.clusters.pack_indices(view_data.texels);
+	upload(*view_data.light_indices, light_clusters::index_texture_width,
+		   light_clusters::index_texture_height);
+
+	float cluster_data0[4] = {float(light_clusters::tiles_x), float(light_clusters::tiles_y),
+							  float(light_clusters::slices), view_data.clusters.get_depth_scale()};
+	float cluster_data1[4] = {near_clip, float(light_clusters::max_lights),
+							  float(light_clusters::index_texture_width),
+							  float(light_clusters::index_texture_height)};
+
+	auto program = clustered_light_program_.get();
+	auto camera_pos = camera.get_position();
+	program->set_uniform(u_cluster_data0, cluster_data0);
+	program->set_uniform(u_cluster_data1, cluster_data1);
+	program->set_uniform(u_camera_position, camera_pos);
+	program->set_texture(0, s_tex0, g_buffer_fbo->get_texture(0).get());
+	program->set_texture(1, s_tex1, g_buffer_fbo->get_texture(1).get());
+	program->set_texture(2, s_tex2, g_buffer_fbo->get_texture(2).get());
+	program->set_texture(3, s_tex3, g_buffer_fbo->get_texture(3).get());
+	program->set_texture(4, s_tex4, g_buffer_fbo->get_texture(4).get());
+	program->set_texture(5, s_tex5, refl_buffer);
+	program->set_texture(6, s_tex6, ibl_brdf_lut_.get());
+	program->set_texture(7, s_lights, view_data.lights.get());
+	program->set_texture(8, s_clusters, view_data.cluster_ranges.get());
+	program->set_texture(9, s_light_indices, view_data.light_indices.get());
+
+	auto topology = gfx::clip_quad(1.0f);
+	gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ADD);
+	gfx::submit(pass.id, program->native_handle());
+	gfx::set_state(BGFX_STATE_DEFAULT);
+
+	program->end();
+	return true;
+}
+
+void deferred_rendering::reflection_probe_pass(gfx::render_graph& graph,
+											   const std::shared_ptr<render_view_targets>& targets,
+											   const camera& camera, entity_component_system& ecs)
+{
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		for(auto id : targets->g_buffer)
+		{
+			builder.read(id);
+		}
+		builder.read(targets->depth);
+
+		targets->refl_buffer = builder.create("RBUFFER", get_desc(targets->size, get_hdr_format()));
+		builder.write(targets->refl_buffer);
+	};
+
+	// Copy the probes, the cubemaps live in the render views of the components.
+	std::vector<probe_draw> probes;
+	ecs.for_each<transform_component, reflection_probe_component>(
+		[&targets, &camera, &probes](entity e, transform_component& transform_comp_ref,
+									 reflection_probe_component& probe_comp_ref) {
+			probe_draw draw;
+			draw.probe = probe_comp_ref.get_probe();
+			draw.world = transform_comp_ref.get_transform();
+			draw.rect = irect32_t(0, 0, irect32_t::value_type(targets->size.width),
+								  irect32_t::value_type(targets->size.height));
+			if(probe_comp_ref.compute_projected_sphere_rect(draw.rect, draw.world.get_position(),
+															camera.get_view(), camera.get_projection()) == 0)
 				return;
 
-			const auto cubemap = probe_comp_ref.get_cubemap();
+			draw.cubemap = probe_comp_ref.get_cubemap();
+			probes.emplace_back(std::move(draw));
+		});
+
+	auto execute = [this, targets, camera, probes = std::move(probes)](gfx::render_graph::resources& res) {
+		const auto& view = camera.get_view();
+		const auto& proj = camera.get_projection();
+
+		const auto& g_buffer = targets->g_buffer;
+		auto g_buffer_fbo = res.get_fbo(
+			"GBUFFER", {g_buffer[0], g_buffer[1], g_buffer[2], g_buffer[3], targets->depth});
+		auto r_buffer_fbo = res.get_fbo("RBUFFER", {targets->refl_buffer});
+
+		gfx::render_pass pass("refl_buffer_fill");
+		pass.bind(r_buffer_fbo.get());
+		pass.set_view_proj(view, proj);
+		pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
+		const auto draw_probe = [this, &pass, &g_buffer_fbo](const probe_draw& draw) {
+			const auto& probe = draw.probe;
+			const auto& world_transform = draw.world;
+			const auto& probe_position = world_transform.get_position();
+			const auto& rect = draw.rect;
+			const auto& cubemap = draw.cubemap;
 
 			gpu_program* program = nullptr;
 			float influence_radius = 0.0f;
@@ -573,14 +1408,14 @@ deferred_rendering::reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> inp
 				math::transform t;
 				t.set_scale(probe.box_data.extents);
 				t = world_transform * t;
-				auto u_inv_world = math::inverse(t).get_matrix();
+				auto inv_world = math::inverse(t).get_matrix();
 				float data2[4] = {probe.box_data.extents.x, probe.box_data.extents.y,
 								  probe.box_data.extents.z, probe.box_data.transition_distance};
 
 				program = box_ref_probe_program_.get();
 				program->begin();
-				program->set_uniform("u_inv_world", math::value_ptr(u_inv_world));
-				program->set_uniform("u_data2", data2);
+				program->set_uniform(u_inv_world, math::value_ptr(inv_world));
+				program->set_uniform(u_data2, data2);
 
 				influence_radius = math::length(t.get_scale() + probe.box_data.transition_distance);
 			}
@@ -597,15 +1432,15 @@ deferred_rendering::reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> inp
 
 				float data1[4] = {mips, 0.0f, 0.0f, 0.0f};
 
-				program->set_uniform("u_data0", data0);
-				program->set_uniform("u_data1", data1);
+				program->set_uniform(u_data0, data0);
+				program->set_uniform(u_data1, data1);
 
-				program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
-				program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
-				program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
-				program->set_texture(3, "s_tex3", g_buffer_fbo->get_texture(3).get());
-				program->set_texture(4, "s_tex4", g_buffer_fbo->get_texture(4).get());
-				program->set_texture(5, "s_tex_cube", cubemap.get());
+				program->set_texture(0, s_tex0, g_buffer_fbo->get_texture(0).get());
+				program->set_texture(1, s_tex1, g_buffer_fbo->get_texture(1).get());
+				program->set_texture(2, s_tex2, g_buffer_fbo->get_texture(2).get());
+				program->set_texture(3, s_tex3, g_buffer_fbo->get_texture(3).get());
+				program->set_texture(4, s_tex4, g_buffer_fbo->get_texture(4).get());
+				program->set_texture(5, s_tex_cube, cubemap.get());
 				gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
 				auto topology = gfx::clip_quad(1.0f);
 				gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA);
@@ -613,108 +1448,137 @@ deferred_rendering::reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> inp
 				gfx::set_state(BGFX_STATE_DEFAULT);
 				program->end();
 			}
-		});
+		};
+		std::for_each(std::begin(probes), std::end(probes), draw_probe);
+	};
 
-	return r_buffer_fbo;
+	graph.add_pass("refl_buffer_fill", setup, std::move(execute));
 }
 
-std::shared_ptr<gfx::frame_buffer>
-deferred_rendering::atmospherics_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-									  gfx::render_view& render_view, entity_component_system& ecs,
-									  std::chrono::duration<float> dt)
+void deferred_rendering::clear_reflections_pass(gfx::render_graph& graph,
+												const std::shared_ptr<render_view_targets>& targets)
 {
-	auto far_clip_cache = camera.get_far_clip();
-	camera.set_far_clip(10000.0f);
-	const auto& view = camera.get_view();
-	const auto& proj = camera.get_projection();
-	camera.set_far_clip(far_clip_cache);
-	const auto& viewport_size = camera.get_viewport_size();
-
-	static auto light_buffer_format = gfx::get_best_format(
-		BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::four_channels |
-												  gfx::format_search_flags::requires_alpha |
-												  gfx::format_search_flags::half_precision_float);
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		targets->refl_buffer = builder.create("RBUFFER", get_desc(targets->size, get_hdr_format()));
+		builder.write(targets->refl_buffer);
+	};
+
+	auto execute = [targets](gfx::render_graph::resources& res) {
+		auto r_buffer_fbo = res.get_fbo("RBUFFER", {targets->refl_buffer});
+		gfx::render_pass pass("refl_buffer_clear");
+		pass.bind(r_buffer_fbo.get());
+		pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
+	};
+
+	graph.add_pass("refl_buffer_clear", setup, std::move(execute));
+}
 
-	auto light_buffer = render_view.get_texture("LBUFFER", viewport_size.width, viewport_size.height, false,
-												1, light_buffer_format, gfx::get_default_rt_sampler_flags());
-	input = render_view.get_fbo("LBUFFER", {light_buffer, render_view.get_depth_buffer(viewport_size)});
+void deferred_rendering::atmospherics_pass(gfx::render_graph& graph,
+										   const std::shared_ptr<render_view_targets>& targets,
+										   const camera& camera, entity_component_system& ecs)
+{
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		builder.read(targets->depth);
+		builder.read(targets->light_buffer);
+		builder.write(targets->light_buffer);
+	};
+
+	// The first directional light is the sun.
+	auto light_direction = math::normalize(math::vec3(0.2f, -0.8f, 1.0f));
+	bool found_sun = false;
+	ecs.for_each<transform_component, light_component>(
+		[&light_direction, &found_sun](entity e, transform_component& transform_comp_ref,
+									   light_component& light_comp_ref) {
+			if(found_sun)
+			{
+				return;
+			}
 
-	const auto surface = input.get();
-	const auto output_size = surface->get_size();
-	gfx::render_pass pass("atmospherics_fill");
-	pass.set_view_proj(view, proj);
-	pass.bind(surface);
+			const auto& light = light_comp_ref.get_light();
 
-	if((surface != nullptr) && atmospherics_program_)
-	{
-		bool found_sun = false;
-		auto light_direction = math::normalize(math::vec3(0.2f, -0.8f, 1.0f));
-		ecs.for_each<transform_component, light_component>(
-			[&light_direction, &found_sun](entity e, transform_component& transform_comp_ref,
-										   light_component& light_comp_ref) {
-				if(found_sun)
-				{
-					return;
-				}
+			if(light.type == light_type::directional)
+			{
+				found_sun = true;
+				const auto& world_transform = transform_comp_ref.get_transform();
+				light_direction = world_transform.z_unit_axis();
+			}
+		});
 
-				const auto& light = light_comp_ref.get_light();
+	auto execute = [this, targets, camera, light_direction](gfx::render_graph::resources& res) {
+		auto sky_camera = camera;
+		sky_camera.set_far_clip(10000.0f);
+		const auto& view = sky_camera.get_view();
+		const auto& proj = sky_camera.get_projection();
 
-				if(light.type == light_type::directional)
-				{
-					found_sun = true;
-					const auto& world_transform = transform_comp_ref.get_transform();
-					light_direction = world_transform.z_unit_axis();
-				}
-			});
+		auto input = res.get_fbo("LBUFFER", {targets->light_buffer, targets->depth});
 
-		atmospherics_program_->begin();
-		atmospherics_program_->set_uniform("u_light_direction", light_direction);
+		const auto surface = input.get();
+		const auto output_size = surface->get_size();
+		gfx::render_pass pass("atmospherics_fill");
+		pass.set_view_proj(view, proj);
+		pass.bind(surface);
 
-		irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
-					   irect32_t::value_type(output_size.height));
-		gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
-		auto topology = gfx::clip_quad(1.0f);
-		gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_DEPTH_TEST_LEQUAL |
-					   BGFX_STATE_BLEND_ADD);
-		gfx::submit(pass.id, atmospherics_program_->native_handle());
-		gfx::set_state(BGFX_STATE_DEFAULT);
-		atmospherics_program_->end();
-	}
+		if((surface != nullptr) && atmospherics_program_)
+		{
+			atmospherics_program_->begin();
+			atmospherics_program_->set_uniform(u_light_direction, light_direction);
+
+			irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
+						   irect32_t::value_type(output_size.height));
+			gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
+			auto topology = gfx::clip_quad(1.0f);
+			gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A |
+						   BGFX_STATE_DEPTH_TEST_LEQUAL | BGFX_STATE_BLEND_ADD);
+			gfx::submit(pass.id, atmospherics_program_->native_handle());
+			gfx::set_state(BGFX_STATE_DEFAULT);
+			atmospherics_program_->end();
+		}
+	};
 
-	return input;
+	graph.add_pass("atmospherics_fill", setup, std::move(execute));
 }
 
-std::shared_ptr<gfx::frame_buffer>
-deferred_rendering::tonemapping_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-									 gfx::render_view& render_view)
+void deferred_rendering::tonemapping_pass(gfx::render_graph& graph,
+										  const std::shared_ptr<render_view_targets>& targets,
+										  const camera& camera)
 {
-	if(!input)
-		return nullptr;
+	const auto setup = [&targets](gfx::render_graph::builder& builder) {
+		builder.read(targets->light_buffer);
+		builder.read(targets->depth);
 
-	const auto& viewport_size = camera.get_viewport_size();
-	const auto surface = render_view.get_output_fbo(viewport_size);
-	const auto output_size = surface->get_size();
-	const auto& view = camera.get_view();
-	const auto& proj = camera.get_projection();
-	gfx::render_pass pass("output_buffer_fill");
-	pass.set_view_proj(view, proj);
-	pass.bind(surface.get());
-
-	if(surface && gamma_correction_program_)
-	{
-		gamma_correction_program_->begin();
-		gamma_correction_program_->set_texture(0, "s_input", input->get_texture().get());
-		irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
-					   irect32_t::value_type(output_size.height));
-		gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
-		auto topology = gfx::clip_quad(1.0f);
-		gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
-		gfx::submit(pass.id, gamma_correction_program_->native_handle());
-		gfx::set_state(BGFX_STATE_DEFAULT);
-		gamma_correction_program_->end();
-	}
-
-	return surface;
+		if(targets->output == render_view_targets::invalid)
+		{
+			targets->output = builder.create("OUTPUT", get_desc(targets->size, get_color_format()));
+		}
+		builder.write(targets->output);
+	};
+
+	auto execute = [this, targets, camera](gfx::render_graph::resources& res) {
+		const auto surface = res.get_fbo("OUTPUT", {targets->output, targets->depth});
+		const auto input = res.get_texture(targets->light_buffer);
+		const auto output_size = surface->get_size();
+		const auto& view = camera.get_view();
+		const auto& proj = camera.get_projection();
+		gfx::render_pass pass("output_buffer_fill");
+		pass.set_view_proj(view, proj);
+		pass.bind(surface.get());
+
+		if(surface && gamma_correction_program_)
+		{
+			gamma_correction_program_->begin();
+			gamma_correction_program_->set_texture(0, s_input, input.get());
+			irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
+						   irect32_t::value_type(output_size.height));
+			gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
+			auto topology = gfx::clip_quad(1.0f);
+			gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+			gfx::submit(pass.id, gamma_correction_program_->native_handle());
+			gfx::set_state(BGFX_STATE_DEFAULT);
+			gamma_correction_program_->end();
+		}
+	};
+
+	graph.add_pass("output_buffer_fill", setup, std::move(execute));
 }
 
 void deferred_rendering::receive(entity e)
@@ -724,6 +1588,58 @@ void deferred_rendering::receive(entity e)
 	{
 		pair.second.erase(e);
 	}
+
+	probe_states_.erase(e);
+	for(auto& pair : probe_states_)
+	{
+		auto& state = pair.second;
+		for(std::uint32_t i = 0; i < 6; ++i)
+		{
+			auto& visibility = state.visibility[i];
+			const auto it = std::find_if(std::begin(visibility), std::end(visibility),
+										 [&e](const auto& element) { return std::get<0>(element) == e; });
+			if(it != std::end(visibility))
+			{
+				visibility.erase(it);
+				state.dirty[i] = true;
+			}
+		}
+	}
+
+	auto shadow_it = shadows_.find(e);
+	if(shadow_it != std::end(shadows_))
+	{
+		release_shadow(shadow_it->second);
+		shadows_.erase(shadow_it);
+	}
+
+	auto caster_it = static_caster_bounds_.find(e);
+	if(caster_it != std::end(static_caster_bounds_))
+	{
+		removed_caster_bounds_.emplace_back(caster_it->second);
+		static_caster_bounds_.erase(caster_it);
+	}
+}
+
+const deferred_rendering::shadow_entry* deferred_rendering::get_shadow(entity e) const
+{
+	auto it = shadows_.find(e);
+	if(it == std::end(shadows_) || it->second.face_count == 0 || !shadow_fbo_)
+	{
+		return nullptr;
+	}
+	return &it->second;
+}
+
+void deferred_rendering::release_shadow(shadow_entry& entry)
+{
+	for(std::uint32_t i = 0; i < entry.face_count; ++i)
+	{
+		shadow_layout_.free(entry.faces[i]);
+		entry.faces[i] = shadow_atlas::invalid_handle;
+	}
+	entry.face_count = 0;
+	entry.size = 0;
 }
 deferred_rendering::deferred_rendering()
 {
@@ -752,6 +1668,13 @@ deferred_rendering::deferred_rendering()
 	fs_box_reflection_probe.wait();
 	auto fs_atmospherics = am.load<gfx::shader>("engine:/data/shaders/fs_atmospherics.sc");
 	fs_atmospherics.wait();
+	auto fs_deferred_clustered_light =
+		am.load<gfx::shader>("engine:/data/shaders/fs_deferred_clustered_light.sc");
+	fs_deferred_clustered_light.wait();
+	auto vs_shadow = am.load<gfx::shader>("engine:/data/shaders/vs_shadow.sc");
+	vs_shadow.wait();
+	auto fs_shadow = am.load<gfx::shader>("engine:/data/shaders/fs_shadow.sc");
+	fs_shadow.wait();
 	ibl_brdf_lut_ = am.load<gfx::texture>("engine:/data/textures/ibl_brdf_lut.png").get();
 	ts.push_or_execute_on_owner_thread(
 		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
@@ -800,11 +1723,34 @@ deferred_rendering::deferred_rendering()
 
 		},
 		vs_clip_quad_ex, fs_atmospherics);
+
+	// Without a compiled shader the lights are drawn one by one.
+	if(fs_deferred_clustered_light.get())
+	{
+		ts.push_or_execute_on_owner_thread(
+			[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+				clustered_light_program_ = std::make_unique<gpu_program>(vs, fs);
+			},
+			vs_clip_quad, fs_deferred_clustered_light);
+	}
+
+	// Without compiled shaders there are no shadows.
+	if(vs_shadow.get() && fs_shadow.get())
+	{
+		ts.push_or_execute_on_owner_thread(
+			[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+				shadow_program_ = std::make_unique<gpu_program>(vs, fs);
+			},
+			vs_shadow, fs_shadow);
+	}
 }
 
 deferred_rendering::~deferred_rendering()
 {
 	on_entity_destroyed.disconnect(this, &deferred_rendering::receive);
 	on_frame_render.disconnect(this, &deferred_rendering::frame_render);
+
+	// The submitted frame still executes our graph.
+	core::get_subsystem<runtime::renderer>().flush();
 }
 }
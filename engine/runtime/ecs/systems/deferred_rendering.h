@@ -1,12 +1,19 @@
 #pragma once
 
 #include "../../rendering/gpu_program.h"
+#include "../../rendering/light_clusters.h"
+#include "../../rendering/shadow_atlas.h"
 #include "../components/model_component.h"
 #include "../components/transform_component.h"
 #include "../ecs.h"
 
 #include <core/common/basetypes.hpp>
+#include <core/graphics/render_graph.h>
+#include <core/graphics/render_pass.h>
+#include <core/graphics/render_view.h>
+#include <core/memory/frame_allocator.h>
 
+#include <array>
 #include <chrono>
 #include <memory>
 #include <tuple>
@@ -14,13 +21,6 @@
 
 class camera;
 
-namespace gfx
-{
-struct texture;
-struct frame_buffer;
-class render_view;
-}
-
 namespace runtime
 {
 struct lod_data
@@ -30,8 +30,29 @@ struct lod_data
 	float current_time = 0.0f;
 };
 
-using visibility_set_models_t =
-	std::vector<std::tuple<entity, chandle<transform_component>, chandle<model_component>>>;
+using visible_model_t = std::tuple<entity, chandle<transform_component>, chandle<model_component>>;
+using visibility_set_models_t = core::frame_vector<visible_model_t>;
+
+struct render_view_targets
+{
+	using resource_id = gfx::render_graph::resource_id;
+	static constexpr resource_id invalid = gfx::render_graph::invalid_index;
+
+	/// Size of all targets.
+	usize32_t size;
+	/// Depth buffer shared by the g-buffer and the output.
+	resource_id depth = invalid;
+	/// G-buffer attachments.
+	std::array<resource_id, 4> g_buffer = {{invalid, invalid, invalid, invalid}};
+	/// Light accumulation buffer.
+	resource_id light_buffer = invalid;
+	/// Reflection buffer.
+	resource_id refl_buffer = invalid;
+	/// Tonemapped output.
+	resource_id output = invalid;
+	/// Shadow maps of the lights, shared by all cameras.
+	resource_id shadow_atlas = invalid;
+};
 
 class deferred_rendering
 {
@@ -72,108 +93,246 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : build_reflections ()
 	/// <summary>
-	///
-	///
-	///
+	/// Adds the passes rendering the reflection probe faces that are out of date.
+	/// Faces are scheduled by camera distance and by how long they have been
+	/// waiting, at most the face budget per frame. The mips of a probe are
+	/// generated once its pending faces are done.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void build_reflections_pass(entity_component_system& ecs, delta_t dt);
+	void build_reflections_pass(gfx::render_graph& graph, entity_component_system& ecs, delta_t dt);
 
 	//-----------------------------------------------------------------------------
 	//  Name : build_shadows ()
 	/// <summary>
-	///
-	///
-	///
+	/// Assigns the visible point and spot lights their squares in the shadow
+	/// atlas, sized by their screen coverage. The static casters of a light are
+	/// cached and only rendered again when the light or a static caster inside
+	/// its range changed. Dynamic casters are drawn on top of a copy of the
+	/// cache, so lights without dynamic casters cost nothing.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void build_shadows_pass(entity_component_system& ecs, delta_t dt);
+	void build_shadows_pass(gfx::render_graph& graph, entity_component_system& ecs, delta_t dt);
 
 	//-----------------------------------------------------------------------------
 	//  Name : camera_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Adds the passes rendering every camera.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void camera_pass(entity_component_system& ecs, delta_t dt);
+	void camera_pass(gfx::render_graph& graph, entity_component_system& ecs, delta_t dt);
 
 	//-----------------------------------------------------------------------------
-	//  Name : scene_pass ()
+	//  Name : deferred_render_full ()
 	/// <summary>
-	///
-	///
-	///
+	/// Adds all passes for a camera. Its depth and output are imported from the
+	/// render view since they are presented after the graph ran, everything else
+	/// is transient.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> deferred_render_full(camera& camera, gfx::render_view& render_view,
-															entity_component_system& ecs,
-															std::unordered_map<entity, lod_data>& camera_lods,
-															delta_t dt);
+	void deferred_render_full(gfx::render_graph& graph, camera& camera, gfx::render_view& render_view,
+							  entity_component_system& ecs, std::unordered_map<entity, lod_data>& camera_lods,
+							  delta_t dt);
 
 	//-----------------------------------------------------------------------------
 	//  Name : g_buffer_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Fills the g-buffer with the visible models.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-													 gfx::render_view& render_view,
-													 visibility_set_models_t& visibility_set,
-													 std::unordered_map<entity, lod_data>& camera_lods,
-													 delta_t dt);
+	void g_buffer_pass(gfx::render_graph& graph, const std::shared_ptr<render_view_targets>& targets,
+					   const camera& camera, visibility_set_models_t visibility_set,
+					   std::unordered_map<entity, lod_data>& camera_lods, delta_t dt);
 
 	//-----------------------------------------------------------------------------
 	//  Name : lighting_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Accumulates the lights into the light buffer.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> lighting_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-													 gfx::render_view& render_view,
-													 entity_component_system& ecs, delta_t dt);
+	void lighting_pass(gfx::render_graph& graph, const std::shared_ptr<render_view_targets>& targets,
+					   const camera& camera, entity_component_system& ecs);
 
 	//-----------------------------------------------------------------------------
-	//  Name : reflection_probe ()
+	//  Name : reflection_probe_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Accumulates the reflection probes into the reflection buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void reflection_probe_pass(gfx::render_graph& graph, const std::shared_ptr<render_view_targets>& targets,
+							   const camera& camera, entity_component_system& ecs);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear_reflections_pass ()
+	/// <summary>
+	/// Clears the reflection buffer for views that do not render the probes.
+	/// A transient buffer may hold anything before its first write.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> input,
-															 camera& camera, gfx::render_view& render_view,
-															 entity_component_system& ecs, delta_t dt);
+	void clear_reflections_pass(gfx::render_graph& graph,
+								const std::shared_ptr<render_view_targets>& targets);
 
 	//-----------------------------------------------------------------------------
 	//  Name : atmospherics_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Adds the sky to the light buffer.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> atmospherics_pass(std::shared_ptr<gfx::frame_buffer> input,
-														 camera& camera, gfx::render_view& render_view,
-														 entity_component_system& ecs, delta_t dt);
+	void atmospherics_pass(gfx::render_graph& graph, const std::shared_ptr<render_view_targets>& targets,
+						   const camera& camera, entity_component_system& ecs);
 
 	//-----------------------------------------------------------------------------
 	//  Name : tonemapping_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Resolves the light buffer into the output.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void tonemapping_pass(gfx::render_graph& graph, const std::shared_ptr<render_view_targets>& targets,
+						  const camera& camera);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_persistent_g_buffer ()
+	/// <summary>
+	/// Renders the g-buffer of the cameras into their render views instead of
+	/// transient targets, so it can be inspected after the frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline void set_persistent_g_buffer(bool persistent)
+	{
+		persistent_g_buffer_ = persistent;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_reflection_face_budget ()
+	/// <summary>
+	/// Reflection probe faces rendered per frame, 0 renders all pending faces.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline void set_reflection_face_budget(std::uint32_t faces)
+	{
+		reflection_face_budget_ = faces;
+	}
+
+	inline std::uint32_t get_reflection_face_budget() const
+	{
+		return reflection_face_budget_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_transient_memory ()
+	/// <summary>
+	/// Bytes of transient targets used by the last frame after aliasing.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint64_t get_transient_memory() const
+	{
+		return transient_memory_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_unaliased_memory ()
+	/// <summary>
+	/// Bytes the transient targets of the last frame would need without
+	/// aliasing.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<gfx::frame_buffer> tonemapping_pass(std::shared_ptr<gfx::frame_buffer> input,
-														camera& camera, gfx::render_view& render_view);
+	inline std::uint64_t get_unaliased_memory() const
+	{
+		return unaliased_memory_;
+	}
 
 private:
+	struct shadow_entry
+	{
+		shadow_entry()
+		{
+			faces.fill(shadow_atlas::invalid_handle);
+		}
+
+		/// Squares of the faces, one for spot lights and six for point lights.
+		std::array<shadow_atlas::handle, 6> faces;
+		/// Used faces.
+		std::uint32_t face_count = 0;
+		/// Edge length of every face.
+		std::uint32_t size = 0;
+		/// World space to atlas uv of every face.
+		std::array<math::mat4, 6> matrices;
+		/// The cached static casters have to be rendered.
+		bool static_dirty = true;
+		/// Dynamic casters were drawn over the cache the last time.
+		bool has_dynamic = false;
+	};
+
+	struct probe_state
+	{
+		/// Reflection casters visible from every face.
+		std::array<std::vector<visible_model_t>, 6> visibility;
+		/// Frustums of the faces.
+		std::array<math::frustum, 6> frustums;
+		/// Faces waiting for an update.
+		std::array<bool, 6> dirty = {{true, true, true, true, true, true}};
+		/// Seconds the faces have been waiting.
+		std::array<float, 6> waiting = {{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
+		/// Faces rendered since the mips were generated.
+		std::uint32_t faces_since_mips = 0;
+		/// The visibility and frustums are valid.
+		bool initialized = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_probe_visibility ()
+	/// <summary>
+	/// Updates the cached visibility of the faces with the changed models and
+	/// marks the faces they entered or left as dirty.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_probe_visibility(probe_state& state, const visibility_set_models_t& dirty_models);
+
+	struct clustered_view
+	{
+		/// Lights binned for the view.
+		light_clusters clusters;
+		/// Lights packed by light_clusters::pack_lights.
+		std::shared_ptr<gfx::texture> lights;
+		/// Offset and count of every cluster.
+		std::shared_ptr<gfx::texture> cluster_ranges;
+		/// Light index lists of the clusters.
+		std::shared_ptr<gfx::texture> light_indices;
+		/// Scratch for the texel data.
+		std::vector<float> texels;
+		/// Lights dropped by the last build that was reported.
+		std::uint32_t reported_dropped_lights = 0;
+		/// Whether light indices were dropped by the last build that was reported.
+		bool reported_dropped_indices = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_clustered_lights ()
+	/// <summary>
+	/// Bins the point and spot lights into clusters of the camera and shades them
+	/// all with one full screen draw. Returns false if the camera or the program
+	/// does not support it, in which case the lights are drawn one by one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool draw_clustered_lights(gfx::render_pass& pass, const camera& camera,
+							   const std::vector<light_clusters::light_data>& lights,
+							   gfx::frame_buffer* g_buffer_fbo, gfx::texture* refl_buffer);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_shadow ()
+	/// <summary>
+	/// Shadow of the light this frame or nullptr if it has none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const shadow_entry* get_shadow(entity e) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : release_shadow ()
+	/// <summary>
+	/// Returns the squares of a shadow to the atlas.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void release_shadow(shadow_entry& entry);
+
 	std::unordered_map<entity, std::unordered_map<entity, lod_data>> lod_data_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> directional_light_program_;
@@ -189,7 +348,42 @@ private:
 	std::unique_ptr<gpu_program> gamma_correction_program_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> atmospherics_program_;
+	/// Program that is responsible for rendering.
+	std::unique_ptr<gpu_program> clustered_light_program_;
+	/// Program that is responsible for rendering.
+	std::unique_ptr<gpu_program> shadow_program_;
 	///
 	asset_handle<gfx::texture> ibl_brdf_lut_;
+	/// Physical textures of the transient targets.
+	gfx::render_view transient_pool_;
+	/// Cameras keep their g-buffer.
+	bool persistent_g_buffer_ = false;
+	/// Transient memory of the last frame.
+	std::uint64_t transient_memory_ = 0;
+	/// Transient memory of the last frame without aliasing.
+	std::uint64_t unaliased_memory_ = 0;
+	/// Cluster data of the views. bgfx applies texture updates once per frame,
+	/// so every view rendered in a frame uses its own textures.
+	std::vector<std::unique_ptr<clustered_view>> clustered_views_;
+	/// Views of the current frame.
+	std::size_t clustered_views_used_ = 0;
+	/// Update state of the reflection probes.
+	std::unordered_map<entity, probe_state> probe_states_;
+	/// Reflection probe faces rendered per frame.
+	std::uint32_t reflection_face_budget_ = 2;
+	/// Layout of the shadow atlas.
+	shadow_atlas shadow_layout_;
+	/// Depth of the static casters of every shadow.
+	std::shared_ptr<gfx::frame_buffer> static_shadow_fbo_;
+	/// Cache plus dynamic casters, sampled by the lighting.
+	std::shared_ptr<gfx::frame_buffer> shadow_fbo_;
+	/// Shadows of the lights.
+	std::unordered_map<entity, shadow_entry> shadows_;
+	/// Last known bounds of the static casters.
+	std::unordered_map<entity, math::bbox> static_caster_bounds_;
+	/// Bounds of static casters destroyed since the last frame.
+	std::vector<math::bbox> removed_caster_bounds_;
+	/// The atlas in the graph of the current frame.
+	gfx::render_graph::resource_id shadow_atlas_resource_ = gfx::render_graph::invalid_index;
 };
 }
@@ -0,0 +1,123 @@
+#include "raycast_system.h"
+#include "../../rendering/mesh.h"
+#include "../../rendering/model.h"
+#include "../../system/events.h"
+#include "../components/model_component.h"
+#include "../components/transform_component.h"
+
+#include <core/profiler/profiler.h>
+#include <core/system/subsystem.h>
+
+namespace runtime
+{
+void raycast_system::build()
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+
+	proxies_.clear();
+	std::vector<math::bbox> bounds;
+	ecs.for_each<transform_component, model_component>(
+		[this, &bounds](entity e, transform_component& transform_comp, model_component& model_comp) {
+			const auto& model = model_comp.get_model();
+			if(!model.is_valid())
+			{
+				return;
+			}
+
+			auto lod = model.get_lod(0);
+			if(!lod || lod->get_status() != mesh_status::prepared)
+			{
+				return;
+			}
+
+			proxy p;
+			p.object = e;
+			p.geometry = lod;
+			p.world = transform_comp.get_transform();
+			bounds.emplace_back(math::bbox::mul(lod->get_bounds(), p.world));
+			proxies_.emplace_back(std::move(p));
+		});
+
+	scene_bvh_.build(bounds, 1);
+	dirty_ = false;
+}
+
+bool raycast_system::raycast(const math::vec3& origin, const math::vec3& direction, float max_distance,
+							 raycast_hit& hit, const filter_t& filter /* = nullptr*/)
+{
+	if(math::length2(direction) <= 0.0f)
+	{
+		return false;
+	}
+
+	if(dirty_)
+	{
+		build();
+	}
+
+	const auto dir = math::normalize(direction);
+	float distance = max_distance;
+	bool result = scene_bvh_.raycast(
+		origin, dir, distance, [&](std::uint32_t index, float& closest) {
+			const auto& p = proxies_[index];
+			if(!p.object.valid() || !p.geometry)
+			{
+				return false;
+			}
+
+			if(filter && !filter(p.object))
+			{
+				return false;
+			}
+
+			// test in object space, the distance along the untouched direction
+			// stays the same since the mapping is affine.
+			const auto inv_world = math::inverse(p.world.get_matrix());
+			const auto local_origin = math::vec3(inv_world * math::vec4(origin, 1.0f));
+			const auto local_dir = math::vec3(inv_world * math::vec4(dir, 0.0f));
+
+			float local_distance = closest;
+			math::vec3 local_normal;
+			if(!p.geometry->raycast(local_origin, local_dir, local_distance, &local_normal))
+			{
+				return false;
+			}
+
+			closest = local_distance;
+			hit.object = p.object;
+			hit.normal =
+				math::normalize(math::vec3(math::transpose(inv_world) * math::vec4(local_normal, 0.0f)));
+			return true;
+		});
+
+	if(result)
+	{
+		hit.distance = distance;
+		hit.point = origin + dir * distance;
+	}
+
+	return result;
+}
+
+void raycast_system::invalidate()
+{
+	dirty_ = true;
+}
+
+void raycast_system::frame_begin(delta_t)
+{
+	PROFILE_SCOPE("raycast_system::frame_begin");
+
+	invalidate();
+}
+
+raycast_system::raycast_system()
+{
+	on_frame_begin.connect(this, &raycast_system::frame_begin);
+}
+
+raycast_system::~raycast_system()
+{
+	on_frame_begin.disconnect(this, &raycast_system::frame_begin);
+}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+
+#include <runtime/assets/asset_handle.h>
+
+#include <functional>
+#include <vector>
+
+class mesh;
+
+namespace runtime
+{
+struct raycast_hit
+{
+	/// Entity that was hit.
+	entity object;
+	/// Distance from the ray origin to the hit point.
+	float distance = 0.0f;
+	/// World space hit point.
+	math::vec3 point;
+	/// World space normal of the hit triangle.
+	math::vec3 normal;
+};
+
+class raycast_system
+{
+public:
+	using filter_t = std::function<bool(entity)>;
+
+	raycast_system();
+	~raycast_system();
+
+	//-----------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Finds the closest model hit by the world space ray. A scene level
+	/// hierarchy over the world bounds of all models is built on the first
+	/// query of each frame, candidates are then tested against the triangle
+	/// hierarchy of their first lod. The optional filter can reject entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool raycast(const math::vec3& origin, const math::vec3& direction, float max_distance,
+				 raycast_hit& hit, const filter_t& filter = nullptr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Forces the scene hierarchy to be rebuilt on the next query. Call this
+	/// when objects were moved during the frame and queried again afterwards.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void invalidate();
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_begin ()
+	/// <summary>
+	/// Invalidates the scene hierarchy built during the previous frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_begin(delta_t dt);
+
+private:
+	void build();
+
+	struct proxy
+	{
+		/// owning entity
+		entity object;
+		/// mesh to test against
+		asset_handle<mesh> geometry;
+		/// world transform at build time
+		math::transform world;
+	};
+
+	/// models that can be hit, indexed by the scene hierarchy
+	std::vector<proxy> proxies_;
+	/// hierarchy over the world bounds of the proxies
+	math::bvh scene_bvh_;
+	/// needs to be rebuilt before the next query
+	bool dirty_ = true;
+};
+}
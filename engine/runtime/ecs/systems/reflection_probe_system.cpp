@@ -2,12 +2,15 @@
 #include "../../system/events.h"
 #include "../components/reflection_probe_component.h"
 
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 namespace runtime
 {
 void reflection_probe_system::frame_update(delta_t dt)
 {
+	PROFILE_SCOPE("reflection_probe_system::frame_update");
+
 	auto& ecs = core::get_subsystem<entity_component_system>();
 
 	ecs.for_each<reflection_probe_component>(
@@ -2,13 +2,32 @@
 #include "../../system/events.h"
 #include "../components/transform_component.h"
 
+#include <core/profiler/profiler.h>
 #include <core/system/subsystem.h>
 
 namespace runtime
 {
 
-void scene_graph::frame_update(delta_t dt)
+void scene_graph::frame_update(delta_t)
 {
+	PROFILE_SCOPE("scene_graph::frame_update");
+
+	update_roots();
+}
+
+const std::vector<entity>& scene_graph::get_roots()
+{
+	update_roots();
+	return roots_;
+}
+
+void scene_graph::update_roots()
+{
+	if(!dirty_.exchange(false))
+	{
+		return;
+	}
+
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
 	roots_.clear();
 	auto all_entities = ecs.all_entities();
@@ -30,9 +49,35 @@ void scene_graph::frame_update(delta_t dt)
 	}
 }
 
+void scene_graph::on_entity_changed(entity)
+{
+	dirty_ = true;
+	++version_;
+}
+
+void scene_graph::on_entity_renamed(entity)
+{
+	// The roots stay the same, views filtering by name do not.
+	++version_;
+}
+
+void scene_graph::on_component_changed(entity e, chandle<component> component)
+{
+	if(std::dynamic_pointer_cast<transform_component>(component.lock()))
+	{
+		on_entity_changed(e);
+	}
+}
+
 scene_graph::scene_graph()
 {
 	runtime::on_frame_update.connect(this, &scene_graph::frame_update);
+	runtime::on_entity_created.connect(this, &scene_graph::on_entity_changed);
+	runtime::on_entity_destroyed.connect(this, &scene_graph::on_entity_changed);
+	runtime::on_entity_renamed.connect(this, &scene_graph::on_entity_renamed);
+	runtime::on_entity_parent_changed.connect(this, &scene_graph::on_entity_changed);
+	runtime::on_component_added.connect(this, &scene_graph::on_component_changed);
+	runtime::on_component_removed.connect(this, &scene_graph::on_component_changed);
 
 	transform_component::static_id();
 }
@@ -40,5 +85,11 @@ scene_graph::scene_graph()
 scene_graph::~scene_graph()
 {
 	runtime::on_frame_update.disconnect(this, &scene_graph::frame_update);
+	runtime::on_entity_created.disconnect(this, &scene_graph::on_entity_changed);
+	runtime::on_entity_destroyed.disconnect(this, &scene_graph::on_entity_changed);
+	runtime::on_entity_renamed.disconnect(this, &scene_graph::on_entity_renamed);
+	runtime::on_entity_parent_changed.disconnect(this, &scene_graph::on_entity_changed);
+	runtime::on_component_added.disconnect(this, &scene_graph::on_component_changed);
+	runtime::on_component_removed.disconnect(this, &scene_graph::on_component_changed);
 }
 }
@@ -4,6 +4,8 @@
 
 #include <core/common/basetypes.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 namespace runtime
@@ -16,9 +18,7 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : frame_update (virtual )
 	/// <summary>
-	///
-	///
-	///
+	/// Rebuilds the scene roots if the hierarchy changed since the last frame.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void frame_update(delta_t dt);
@@ -26,18 +26,37 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : getRoots ()
 	/// <summary>
-	///
-	///
-	///
+	/// Returns the entities without a parent. Rebuilt lazily if the hierarchy
+	/// changed since the last call.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	const std::vector<entity>& get_roots() const
+	const std::vector<entity>& get_roots();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_version ()
+	/// <summary>
+	/// Returns a counter that is incremented every time an entity is created,
+	/// destroyed, renamed or reparented, or a transform component is added or
+	/// removed. Views over the hierarchy can compare it against a stored value
+	/// to know when they need to rebuild. Safe to call from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_version() const
 	{
-		return roots_;
+		return version_;
 	}
 
 private:
+	void update_roots();
+	void on_entity_changed(entity e);
+	void on_entity_renamed(entity e);
+	void on_component_changed(entity e, chandle<component> component);
+
 	/// scene roots
 	std::vector<entity> roots_;
+	/// hierarchy version, changed by the events of loads on other threads too
+	std::atomic<std::uint64_t> version_ = {0};
+	/// roots need to be rebuilt
+	std::atomic<bool> dirty_ = {true};
 };
 }
@@ -0,0 +1,335 @@
+#include "texture_streaming.h"
+#include "../../rendering/camera.h"
+#include "../../rendering/material.h"
+#include "../../rendering/mesh.h"
+#include "../../rendering/model.h"
+#include "../../rendering/renderer.h"
+#include "../../rendering/texture_residency.h"
+#include "../../system/events.h"
+#include "../components/model_component.h"
+#include "../components/transform_component.h"
+
+#include <core/graphics/texture.h>
+#include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace runtime
+{
+namespace
+{
+// Textures keep the mips within this size resident, so there is always
+// something to draw.
+constexpr std::uint64_t tail_size = 64 * 1024;
+
+// Open texture_streaming_scopes of the thread.
+thread_local std::uint32_t open_scopes = 0;
+}
+
+texture_streaming::texture_streaming()
+{
+	on_frame_update.connect(this, &texture_streaming::frame_update);
+}
+
+texture_streaming::~texture_streaming()
+{
+	on_frame_update.disconnect(this, &texture_streaming::frame_update);
+}
+
+void texture_streaming::set_budget(std::uint64_t bytes)
+{
+	budget_ = bytes;
+}
+
+std::uint64_t texture_streaming::get_budget() const
+{
+	return budget_;
+}
+
+std::uint64_t texture_streaming::get_resident_size() const
+{
+	return resident_size_;
+}
+
+std::uint32_t texture_streaming::get_tail_mip(const streamed_texture::header& info)
+{
+	return texture_residency::get_tail_mip(info, tail_size);
+}
+
+std::uint64_t texture_streaming::get_head_size()
+{
+	return sizeof(streamed_texture::header) + tail_size;
+}
+
+std::shared_ptr<gfx::texture> texture_streaming::create_texture(const streamed_texture::header& info,
+																std::uint32_t first_mip,
+																const std::uint8_t* file_data)
+{
+	const auto size = streamed_texture::get_resident_size(info, first_mip);
+	const gfx::memory_view* mem = gfx::alloc(static_cast<std::uint32_t>(size));
+	if(mem == nullptr)
+	{
+		return nullptr;
+	}
+	streamed_texture::unpack(info, first_mip, file_data, mem->data);
+
+	const auto width = std::max(1u, std::uint32_t(info.width) >> first_mip);
+	const auto height = std::max(1u, std::uint32_t(info.height) >> first_mip);
+	const bool has_mips = first_mip + 1 < info.mips;
+	return std::make_shared<gfx::texture>(static_cast<std::uint16_t>(width),
+										  static_cast<std::uint16_t>(height), has_mips, 1,
+										  static_cast<gfx::texture_format>(info.format),
+										  BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+}
+
+void texture_streaming::add_texture(const asset_handle<gfx::texture>& handle, const fs::path& file,
+									const streamed_texture::header& info, std::uint32_t first_mip)
+{
+	auto it = textures_.find(handle.id());
+	if(it != std::end(textures_))
+	{
+		const auto& previous = it->second;
+		resident_size_ -= streamed_texture::get_resident_size(previous.info, previous.resident);
+		textures_.erase(it);
+	}
+
+	texture_state state;
+	state.link = handle.link;
+	state.file = file;
+	state.info = info;
+	state.resident = first_mip;
+	state.tail = get_tail_mip(info);
+	state.wanted = state.tail;
+	state.last_visible = frame_;
+	resident_size_ += streamed_texture::get_resident_size(info, first_mip);
+	textures_.emplace(handle.id(), std::move(state));
+}
+
+bool texture_streaming::is_streamed(const std::string& key) const
+{
+	return textures_.find(key) != std::end(textures_);
+}
+
+void texture_streaming::request(const camera& cam, const visibility_set_models_t& visibility_set)
+{
+	PROFILE_SCOPE("texture_streaming::request");
+
+	if(textures_.empty())
+	{
+		return;
+	}
+
+	const auto viewport_height = float(cam.get_viewport_size().height);
+	const bool perspective = cam.get_projection_mode() == projection_mode::perspective;
+	const float tan_half_fov = math::tan(math::radians<float>(cam.get_fov() * 0.5f));
+	const auto camera_pos = cam.get_position();
+
+	std::vector<asset_handle<gfx::texture>> textures;
+	for(const auto& element : visibility_set)
+	{
+		auto transform_comp_ptr = std::get<1>(element).lock();
+		auto model_comp_ptr = std::get<2>(element).lock();
+		if(!transform_comp_ptr || !model_comp_ptr)
+		{
+			continue;
+		}
+
+		const auto& model = model_comp_ptr->get_model();
+		const auto mesh = model.get_lod(0);
+		if(!mesh)
+		{
+			continue;
+		}
+
+		const auto bounds = math::bbox::mul(mesh->get_bounds(), transform_comp_ptr->get_transform());
+		const float radius = math::length(bounds.get_extents());
+		const float distance = math::distance(bounds.get_center(), camera_pos);
+		const float screen_size =
+			perspective ? texture_residency::get_screen_size(radius, distance, tan_half_fov, viewport_height)
+						: 2.0f * radius * cam.get_ppu();
+
+		for(const auto& mat : model.get_materials())
+		{
+			if(!mat)
+			{
+				continue;
+			}
+
+			textures.clear();
+			mat->get_textures(textures);
+			const float texels = screen_size * mat->get_texture_tiling();
+			for(const auto& tex : textures)
+			{
+				auto it = textures_.find(tex.id());
+				if(it == std::end(textures_))
+				{
+					continue;
+				}
+
+				auto& state = it->second;
+				state.wanted = std::min(state.wanted, texture_residency::select_mip(state.info, texels));
+				state.priority = std::max(state.priority, texels);
+				state.last_visible = frame_;
+			}
+		}
+	}
+}
+
+void texture_streaming::frame_update(delta_t /*dt*/)
+{
+	PROFILE_SCOPE("texture_streaming::frame_update");
+
+	++frame_;
+
+	// Replace the textures whose reads completed, drop the unloaded ones.
+	std::uint32_t reads = 0;
+	std::uint32_t creates = 0;
+	for(auto it = std::begin(textures_); it != std::end(textures_);)
+	{
+		auto& state = it->second;
+		auto link = state.link.lock();
+		// The asset itself may be swapped on the render thread, the id is not.
+		bool removed = !link || link->id.empty();
+		if(!removed && state.read.valid())
+		{
+			if(state.read.is_ready() && creates < max_creates_)
+			{
+				++creates;
+				// A file that can not be read any more keeps what it has.
+				removed = !complete_read(state);
+			}
+			else
+			{
+				++reads;
+			}
+		}
+
+		if(removed)
+		{
+			resident_size_ -= streamed_texture::get_resident_size(state.info, state.resident);
+			it = textures_.erase(it);
+			continue;
+		}
+		++it;
+	}
+
+	std::vector<texture_residency::item> items;
+	std::vector<texture_state*> states;
+	items.reserve(textures_.size());
+	states.reserve(textures_.size());
+	for(auto& pair : textures_)
+	{
+		auto& state = pair.second;
+		texture_residency::item i;
+		i.info = state.info;
+		i.resident = state.resident;
+		i.tail = state.tail;
+		i.wanted = state.wanted;
+		i.priority = state.priority;
+		i.last_visible = state.last_visible;
+		items.push_back(i);
+		states.push_back(&state);
+
+		// The demand is collected again until the next plan.
+		state.wanted = state.tail;
+		state.priority = 0.0f;
+	}
+	texture_residency::plan(items, budget_);
+
+	// Evictions first, they make room, then the loads the screen needs most.
+	std::vector<std::size_t> changes;
+	for(std::size_t index = 0; index < items.size(); ++index)
+	{
+		if(items[index].target != items[index].resident && !states[index]->read.valid())
+		{
+			changes.push_back(index);
+		}
+	}
+	std::sort(std::begin(changes), std::end(changes), [&items](std::size_t lhs, std::size_t rhs) {
+		const bool lhs_evicts = items[lhs].target > items[lhs].resident;
+		const bool rhs_evicts = items[rhs].target > items[rhs].resident;
+		if(lhs_evicts != rhs_evicts)
+		{
+			return lhs_evicts;
+		}
+		return items[lhs].priority > items[rhs].priority;
+	});
+
+	for(const auto index : changes)
+	{
+		if(reads >= max_reads_)
+		{
+			break;
+		}
+		start_read(*states[index], items[index].target);
+		++reads;
+	}
+}
+
+void texture_streaming::start_read(texture_state& state, std::uint32_t first_mip)
+{
+	auto& io = core::get_subsystem<fs::io_system>();
+
+	// Asset loads come first, the textures are drawn with their tails meanwhile.
+	fs::io_request request;
+	request.file = state.file;
+	request.size = streamed_texture::get_read_size(state.info, first_mip);
+	request.priority = fs::io_priority::low;
+
+	state.pending = first_mip;
+	state.read = io.read(request);
+}
+
+bool texture_streaming::complete_read(texture_state& state)
+{
+	PROFILE_SCOPE("texture_streaming::create texture");
+
+	auto result = state.read.get();
+	state.read = {};
+
+	// The file changed since the texture was loaded, its reload replaces the state.
+	const auto data = result.to_bytes();
+	streamed_texture::header info;
+	if(!result.ok() || !streamed_texture::read_header(data.data(), data.size(), info) ||
+	   info.width != state.info.width || info.height != state.info.height || info.format != state.info.format)
+	{
+		APPLOG_ERROR("Failed to stream the mips of {0}", state.file.string());
+		return false;
+	}
+
+	auto link = state.link.lock();
+	auto tex = create_texture(state.info, state.pending, data.data());
+	if(!link || !tex)
+	{
+		return false;
+	}
+
+	// The render thread may be drawing with the texture, so it is swapped
+	// there between its frames. The old one is released with the swap, bgfx
+	// destroys it after the frames using it were rendered.
+	auto& rend = core::get_subsystem<renderer>();
+	rend.record([link, tex]() mutable { link->asset = std::move(tex); });
+	resident_size_ -= streamed_texture::get_resident_size(state.info, state.resident);
+	resident_size_ += streamed_texture::get_resident_size(state.info, state.pending);
+	state.resident = state.pending;
+	return true;
+}
+
+texture_streaming_scope::texture_streaming_scope()
+{
+	++open_scopes;
+}
+
+texture_streaming_scope::~texture_streaming_scope()
+{
+	--open_scopes;
+}
+
+bool texture_streaming_scope::is_active()
+{
+	return open_scopes != 0;
+}
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../../assets/asset_handle.h"
+#include "../../rendering/streamed_texture.h"
+#include "deferred_rendering.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/filesystem/filesystem.h>
+#include <core/filesystem/io_system.h>
+#include <core/tasks/task_system.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class camera;
+namespace gfx
+{
+struct texture;
+}
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : texture_streaming (Class)
+/// <summary>
+/// Keeps only the mips of the streamed textures resident that the screen
+/// needs. The renderer reports the visible models of every camera, their
+/// screen size and the tiling of their materials give the mips each texture
+/// needs. Once per frame the mips are planned under the memory budget and
+/// the textures are created again from partial reads of their files, with
+/// more mips or with less. Only the textures loaded in a
+/// texture_streaming_scope are streamed.
+/// </summary>
+//-----------------------------------------------------------------------------
+class texture_streaming
+{
+public:
+	texture_streaming();
+	~texture_streaming();
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_budget ()
+	/// <summary>
+	/// Sets the bytes the mips of the streamed textures may use. The tails
+	/// of the textures are kept even beyond it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_budget(std::uint64_t bytes);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_budget ()
+	/// <summary>
+	/// Bytes the mips of the streamed textures may use.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_budget() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_resident_size ()
+	/// <summary>
+	/// Bytes of the mips resident now.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_resident_size() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_tail_mip (static )
+	/// <summary>
+	/// First mip a streamed texture is loaded with.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint32_t get_tail_mip(const streamed_texture::header& info);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_head_size (static )
+	/// <summary>
+	/// Bytes at the start of a streamed texture file that hold its header and
+	/// its tail.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint64_t get_head_size();
+
+	//-----------------------------------------------------------------------------
+	//  Name : create_texture (static )
+	/// <summary>
+	/// Creates a texture from the mips from first_mip down, file_data being
+	/// at least the first get_read_size bytes of a streamed texture file.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::shared_ptr<gfx::texture> create_texture(const streamed_texture::header& info,
+														std::uint32_t first_mip,
+														const std::uint8_t* file_data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_texture ()
+	/// <summary>
+	/// Starts streaming a texture loaded from the file with the mips from
+	/// first_mip down. A texture loaded again replaces the previous one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_texture(const asset_handle<gfx::texture>& handle, const fs::path& file,
+					 const streamed_texture::header& info, std::uint32_t first_mip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_streamed ()
+	/// <summary>
+	/// Whether the texture with the key is streamed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_streamed(const std::string& key) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : request ()
+	/// <summary>
+	/// Records the mips the textures of the visible models need for the
+	/// camera. Called by the renderer for every camera each frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void request(const camera& cam, const visibility_set_models_t& visibility_set);
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_update ()
+	/// <summary>
+	/// Plans the resident mips, starts the reads and replaces the textures
+	/// whose reads completed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_update(delta_t dt);
+
+private:
+	struct texture_state
+	{
+		/// Link shared by the handles of the texture
+		std::weak_ptr<asset_link<gfx::texture>> link;
+		/// The compiled file
+		fs::path file;
+		/// Header of the file
+		streamed_texture::header info;
+		/// First mip resident now
+		std::uint32_t resident = 0;
+		/// First mip always resident
+		std::uint32_t tail = 0;
+		/// First mip the screen needed since the last plan
+		std::uint32_t wanted = 0;
+		/// Screen pixels that needed the texture since the last plan
+		float priority = 0.0f;
+		/// Frame the texture was last visible
+		std::uint64_t last_visible = 0;
+		/// First mip of the read in flight
+		std::uint32_t pending = 0;
+		/// The read in flight
+		core::task_future<fs::io_result> read;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : start_read ()
+	/// <summary>
+	/// Reads the mips from first_mip down on the io threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void start_read(texture_state& state, std::uint32_t first_mip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : complete_read ()
+	/// <summary>
+	/// Replaces the texture with the mips read. Returns false when the read
+	/// failed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool complete_read(texture_state& state);
+
+	/// Streamed textures by key
+	std::unordered_map<std::string, texture_state> textures_;
+	/// Bytes the mips may use
+	std::uint64_t budget_ = 512ull * 1024 * 1024;
+	/// Bytes of the mips resident now
+	std::uint64_t resident_size_ = 0;
+	/// Number of the current frame
+	std::uint64_t frame_ = 0;
+	/// Reads in flight at most
+	std::uint32_t max_reads_ = 8;
+	/// Textures created per frame at most
+	std::uint32_t max_creates_ = 4;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : texture_streaming_scope (Class)
+/// <summary>
+/// Textures loaded on the calling thread for its lifetime are streamed, they
+/// are loaded with their tails. Material maps opt in with it. Any other
+/// texture, like an icon or a lookup table, is loaded with all of its mips
+/// and keeps them. Scopes nest.
+/// </summary>
+//-----------------------------------------------------------------------------
+class texture_streaming_scope
+{
+public:
+	texture_streaming_scope();
+	~texture_streaming_scope();
+
+	texture_streaming_scope(const texture_streaming_scope&) = delete;
+	texture_streaming_scope& operator=(const texture_streaming_scope&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_active (static )
+	/// <summary>
+	/// Whether a scope is open on the calling thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool is_active();
+};
+}
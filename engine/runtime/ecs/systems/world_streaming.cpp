@@ -0,0 +1,288 @@
+#include "world_streaming.h"
+#include "../../assets/asset_manager.h"
+#include "../../rendering/material.h"
+#include "../../rendering/mesh.h"
+#include "../../system/events.h"
+#include "../constructs/scene.h"
+#include "../constructs/utils.h"
+
+#include <core/audio/sound.h>
+#include <core/filesystem/filesystem.h>
+#include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+
+namespace runtime
+{
+namespace
+{
+// Cells stay until the sources are this much further away than the radius
+// they were loaded at, so moving along a cell border does not thrash them.
+constexpr float unload_factor = 1.25f;
+
+template <typename T>
+bool is_ready(const std::vector<core::task_future<asset_handle<T>>>& futures)
+{
+	return std::all_of(std::begin(futures), std::end(futures),
+					   [](const auto& future) { return future.is_ready(); });
+}
+
+template <typename T>
+void load_all(const std::vector<std::string>& keys, std::vector<core::task_future<asset_handle<T>>>& out)
+{
+	auto& am = core::get_subsystem<asset_manager>();
+	out.clear();
+	out.reserve(keys.size());
+	for(const auto& key : keys)
+	{
+		out.emplace_back(am.load<T>(key));
+	}
+}
+}
+
+world_streaming::world_streaming()
+{
+	on_frame_update.connect(this, &world_streaming::frame_update);
+}
+
+world_streaming::~world_streaming()
+{
+	on_frame_update.disconnect(this, &world_streaming::frame_update);
+}
+
+bool world_streaming::open(const std::string& key)
+{
+	close();
+
+	world_layout layout;
+	if(!ecs::utils::try_load_world_layout_from_file(fs::resolve_protocol(key), layout))
+	{
+		APPLOG_ERROR("Failed to load world layout {0}", key);
+		return false;
+	}
+
+	layout_ = std::move(layout);
+	cells_.resize(layout_.cells.size());
+	return true;
+}
+
+void world_streaming::close()
+{
+	for(std::size_t i = 0; i < cells_.size(); ++i)
+	{
+		auto& instance = cells_[i];
+		// The scene is cleared from the asset manager once it is loaded.
+		if(instance.data.valid())
+		{
+			instance.data.wait();
+		}
+		// Entities still being completed are destroyed all the same.
+		const auto& created = instance.reader.get_entities();
+		instance.entities.insert(std::end(instance.entities), std::begin(created), std::end(created));
+		for(auto it = instance.entities.rbegin(); it != instance.entities.rend(); ++it)
+		{
+			if(it->valid())
+			{
+				it->destroy();
+			}
+		}
+		release(layout_.cells[i], instance);
+	}
+
+	cells_.clear();
+	layout_ = {};
+}
+
+std::uint32_t world_streaming::add_source(const math::vec3& position, float radius)
+{
+	source s;
+	s.id = next_source_id_++;
+	s.position = position;
+	s.radius = radius;
+	sources_.emplace_back(s);
+	return s.id;
+}
+
+void world_streaming::set_source(std::uint32_t id, const math::vec3& position, float radius)
+{
+	auto it = std::find_if(std::begin(sources_), std::end(sources_),
+						   [id](const source& s) { return s.id == id; });
+	if(it != std::end(sources_))
+	{
+		it->position = position;
+		it->radius = radius;
+	}
+}
+
+void world_streaming::remove_source(std::uint32_t id)
+{
+	sources_.erase(std::remove_if(std::begin(sources_), std::end(sources_),
+								  [id](const source& s) { return s.id == id; }),
+				   std::end(sources_));
+}
+
+void world_streaming::set_budget(std::size_t instantiate_per_frame, std::size_t destroy_per_frame)
+{
+	instantiate_budget_ = std::max<std::size_t>(instantiate_per_frame, 1);
+	destroy_budget_ = std::max<std::size_t>(destroy_per_frame, 1);
+}
+
+std::size_t world_streaming::get_loaded_cell_count() const
+{
+	return static_cast<std::size_t>(std::count_if(std::begin(cells_), std::end(cells_),
+												  [](const cell_instance& instance) {
+													  return instance.state == cell_state::loaded;
+												  }));
+}
+
+void world_streaming::frame_update(delta_t dt)
+{
+	PROFILE_SCOPE("world_streaming::frame_update");
+
+	auto instantiate_left = instantiate_budget_;
+	auto destroy_left = destroy_budget_;
+	// Opening a scene decodes all of it, so only one is opened per frame.
+	bool opened = false;
+
+	for(std::size_t i = 0; i < cells_.size(); ++i)
+	{
+		const auto& cell = layout_.cells[i];
+		auto& instance = cells_[i];
+
+		bool wanted = false;
+		bool kept = false;
+		for(const auto& s : sources_)
+		{
+			const auto distance = layout_.get_distance(cell, s.position);
+			wanted |= distance <= s.radius;
+			kept |= distance <= s.radius * unload_factor;
+		}
+
+		switch(instance.state)
+		{
+			case cell_state::unloaded:
+				if(wanted)
+				{
+					request(cell, instance);
+					instance.state = cell_state::loading;
+				}
+				break;
+
+			case cell_state::loading:
+				if(!kept)
+				{
+					if(instance.data.is_ready())
+					{
+						release(cell, instance);
+						instance.state = cell_state::unloaded;
+					}
+				}
+				else if(!opened && instance.data.is_ready() && is_ready(instance.meshes) &&
+						is_ready(instance.materials) && is_ready(instance.sounds))
+				{
+					instantiate(cell, instance);
+					opened = true;
+					instance.state = cell_state::instantiating;
+				}
+				break;
+
+			case cell_state::instantiating:
+				if(instantiate_left > 0)
+				{
+					const auto remaining = instance.reader.get_remaining();
+					const auto done = instance.reader.step(instantiate_left);
+					const auto stepped = remaining - instance.reader.get_remaining();
+					instantiate_left -= std::min(instantiate_left, stepped);
+					if(done)
+					{
+						// Empty for scenes in the associative format.
+						const auto& created = instance.reader.get_entities();
+						instance.entities.insert(std::end(instance.entities), std::begin(created),
+												 std::end(created));
+						instance.reader = {};
+						instance.state = cell_state::loaded;
+					}
+				}
+				break;
+
+			case cell_state::loaded:
+				if(!kept)
+				{
+					instance.state = cell_state::unloading;
+				}
+				break;
+
+			case cell_state::unloading:
+				// Children go first, they are further back than their parents.
+				while(destroy_left > 0 && !instance.entities.empty())
+				{
+					auto e = instance.entities.back();
+					instance.entities.pop_back();
+					if(e.valid())
+					{
+						e.destroy();
+						--destroy_left;
+					}
+				}
+				if(instance.entities.empty())
+				{
+					release(cell, instance);
+					instance.state = cell_state::unloaded;
+				}
+				break;
+		}
+	}
+}
+
+void world_streaming::request(const world_cell& cell, cell_instance& instance)
+{
+	auto& am = core::get_subsystem<asset_manager>();
+	load_all(cell.meshes, instance.meshes);
+	load_all(cell.materials, instance.materials);
+	load_all(cell.sounds, instance.sounds);
+	instance.data = am.load<scene>(cell.scene);
+}
+
+void world_streaming::instantiate(const world_cell& cell, cell_instance& instance)
+{
+	instance.entities.clear();
+
+	auto handle = instance.data.get();
+	if(!handle)
+	{
+		APPLOG_ERROR("Failed to load world cell scene {0}", cell.scene);
+		return;
+	}
+
+	// The reader creates the entities as it steps through them.
+	if(handle->instantiate(scene::mode::additive, instance.reader))
+	{
+		return;
+	}
+
+	// Scenes in the associative format are instantiated at once.
+	for(const auto& root : handle->instantiate(scene::mode::additive))
+	{
+		ecs::utils::collect_hierarchy(root, instance.entities);
+	}
+}
+
+void world_streaming::release(const world_cell& cell, cell_instance& instance)
+{
+	instance.entities.clear();
+	instance.reader = {};
+	instance.meshes.clear();
+	instance.materials.clear();
+	instance.sounds.clear();
+	instance.data = {};
+
+	// The stream of a scene is read once, a cell loaded again needs a new one.
+	if(!cell.scene.empty())
+	{
+		auto& am = core::get_subsystem<asset_manager>();
+		am.clear_asset<scene>(cell.scene);
+	}
+}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../../assets/asset_handle.h"
+#include "../constructs/binary_scene.h"
+#include "../constructs/world_layout.h"
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+#include <core/tasks/task_system.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct scene;
+class mesh;
+class material;
+namespace audio
+{
+class sound;
+}
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : world_streaming (Class)
+/// <summary>
+/// Streams the cells of a world layout in and out around the streaming
+/// sources. The assets and the scene of a cell are loaded in the background,
+/// then its entities are created and destroyed within a budget per frame.
+/// </summary>
+//-----------------------------------------------------------------------------
+class world_streaming
+{
+public:
+	world_streaming();
+	~world_streaming();
+
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Loads the layout saved at the given key and starts streaming it. The
+	/// cells of the previous layout are destroyed at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool open(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : close ()
+	/// <summary>
+	/// Destroys the entities of all cells and stops streaming.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void close();
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_source ()
+	/// <summary>
+	/// Adds a point the cells within radius are loaded around. Cells are
+	/// unloaded again once they are a quarter further away than that.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t add_source(const math::vec3& position, float radius);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_source ()
+	/// <summary>
+	/// Moves a source or changes its radius.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_source(std::uint32_t id, const math::vec3& position, float radius);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove_source ()
+	/// <summary>
+	/// Removes a source added with add_source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove_source(std::uint32_t id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_budget ()
+	/// <summary>
+	/// Most entities completed and destroyed per frame over all cells.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_budget(std::size_t instantiate_per_frame, std::size_t destroy_per_frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_loaded_cell_count ()
+	/// <summary>
+	/// Number of cells with all their entities in the world.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_loaded_cell_count() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame_update ()
+	/// <summary>
+	/// Moves the cells along, see world_streaming.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_update(delta_t dt);
+
+private:
+	enum class cell_state
+	{
+		unloaded,
+		loading,
+		instantiating,
+		loaded,
+		unloading,
+	};
+
+	struct source
+	{
+		/// Id returned by add_source.
+		std::uint32_t id = 0;
+		/// Position of the source.
+		math::vec3 position;
+		/// Cells closer than that are loaded.
+		float radius = 0.0f;
+	};
+
+	struct cell_instance
+	{
+		/// Where the cell is in its lifetime.
+		cell_state state = cell_state::unloaded;
+		/// The scene with the entities of the cell.
+		core::task_future<asset_handle<scene>> data;
+		/// The assets of the cell, kept alive while it is loaded.
+		std::vector<core::task_future<asset_handle<mesh>>> meshes;
+		std::vector<core::task_future<asset_handle<material>>> materials;
+		std::vector<core::task_future<asset_handle<audio::sound>>> sounds;
+		/// Completes the entities while instantiating.
+		ecs::binary_scene::reader reader;
+		/// Entities of the cell, parents before their children. Filled once
+		/// the reader is done.
+		std::vector<entity> entities;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : request ()
+	/// <summary>
+	/// Starts loading the assets and the scene of the cell.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void request(const world_cell& cell, cell_instance& instance);
+
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates the entities of a cell whose assets are loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void instantiate(const world_cell& cell, cell_instance& instance);
+
+	//-----------------------------------------------------------------------------
+	//  Name : release ()
+	/// <summary>
+	/// Lets go of the assets of a cell without entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void release(const world_cell& cell, cell_instance& instance);
+
+	/// The streamed world.
+	world_layout layout_;
+	/// State of the cells, in the order of the layout.
+	std::vector<cell_instance> cells_;
+	/// Points the cells are loaded around.
+	std::vector<source> sources_;
+	/// Id of the next source.
+	std::uint32_t next_source_id_ = 1;
+	/// Most entities completed per frame.
+	std::size_t instantiate_budget_ = 256;
+	/// Most entities destroyed per frame.
+	std::size_t destroy_budget_ = 512;
+};
+}
@@ -1,6 +1,8 @@
 #include "input.h"
 #include "../system/events.h"
 
+#include <core/profiler/profiler.h>
+
 namespace runtime
 {
 input::input()
@@ -22,6 +24,8 @@ input::~input()
 
 void input::reset_state(delta_t /*unused*/)
 {
+	PROFILE_SCOPE("input::reset_state");
+
 	key_reset();
 
 	mouse_reset();
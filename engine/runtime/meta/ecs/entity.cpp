@@ -1,33 +1,128 @@
 #include "entity.hpp"
 
+#include <core/common/assert.hpp>
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
 #include <core/serialization/types/vector.hpp>
 #include <core/system/subsystem.h>
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 namespace runtime
 {
-std::map<std::uint64_t, runtime::entity>& get_serialization_map()
+namespace
+{
+struct binding
+{
+	/// The archive.
+	const void* archive = nullptr;
+	/// Its context.
+	serialization_context* context = nullptr;
+};
+
+std::vector<binding>& get_bindings()
 {
-	/// Keep count of serialized entities
-	static std::map<std::uint64_t, runtime::entity> serialization_map;
-	return serialization_map;
+	static thread_local std::vector<binding> bindings;
+	return bindings;
+}
 }
 
-SAVE(entity)
+const entity* serialization_context::find(std::uint64_t id) const
+{
+	auto it = entities_.find(id);
+	if(it == entities_.end())
+	{
+		return nullptr;
+	}
+	return &it->second;
+}
+
+void serialization_context::add(std::uint64_t id, const entity& e)
+{
+	entities_[id] = e;
+}
+
+void serialization_context::reserve(std::size_t count)
+{
+	entities_.reserve(count);
+}
+
+void serialization_context::clear()
+{
+	entities_.clear();
+}
+
+const std::unordered_map<std::uint64_t, entity>& serialization_context::get_entities() const
+{
+	return entities_;
+}
+
+void serialization_context::set_read_only(bool read_only)
+{
+	read_only_ = read_only;
+}
+
+bool serialization_context::is_read_only() const
 {
-	// TODO check for validity
+	return read_only_;
+}
+
+void serialization_context::set_world(entity_component_system* world)
+{
+	world_ = world;
+}
+
+entity_component_system& serialization_context::get_world() const
+{
+	if(world_ != nullptr)
+	{
+		return *world_;
+	}
+	return core::get_subsystem<entity_component_system>();
+}
+
+serialization_scope::serialization_scope(const void* archive, serialization_context& context)
+	: archive_(archive)
+{
+	get_bindings().push_back({archive, &context});
+}
+
+serialization_scope::~serialization_scope()
+{
+	auto& bindings = get_bindings();
+	auto it = std::find_if(bindings.rbegin(), bindings.rend(),
+						   [this](const binding& b) { return b.archive == archive_; });
+	if(it != bindings.rend())
+	{
+		bindings.erase(std::next(it).base());
+	}
+}
 
-	auto id = obj.id().id();
+serialization_context& get_serialization_context(const void* archive)
+{
+	const auto& bindings = get_bindings();
+	auto it = std::find_if(bindings.rbegin(), bindings.rend(),
+						   [archive](const binding& b) { return b.archive == archive; });
+
+	// An unbound archive would resolve its entities against stale ones.
+	expects(it != bindings.rend());
+	return *it->context;
+}
+
+SAVE(entity)
+{
+	// Dead entities are saved as invalid, loading them must not create anything.
+	auto id = obj.valid() ? obj.id().id() : entity::INVALID.id();
 	try_save(ar, cereal::make_nvp("entity_id", id));
 
 	if(obj.valid())
 	{
-		auto& serialization_map = get_serialization_map();
-		auto it = serialization_map.find(id);
-		if(it == serialization_map.end())
+		auto& context = get_serialization_context(&ar);
+		if(context.find(id) == nullptr)
 		{
-			serialization_map[id] = obj;
+			context.add(id, obj);
 
 			try_save(ar, cereal::make_nvp("name", obj.get_name()));
 			try_save(ar, cereal::make_nvp("components", obj.all_components()));
@@ -47,17 +142,26 @@ LOAD(entity)
 
 	if(id != entity::INVALID.id())
 	{
-		auto& serialization_map = get_serialization_map();
-		auto it = serialization_map.find(id);
-		if(it != serialization_map.end())
+		auto& context = get_serialization_context(&ar);
+		if(auto known = context.find(id))
 		{
-			obj = it->second;
+			obj = *known;
 		}
 		else
 		{
-			auto& ecs = core::get_subsystem<entity_component_system>();
+			// The data is read either way to keep the archive in step.
+			if(context.is_read_only())
+			{
+				try_load(ar, cereal::make_nvp("name", name));
+				try_load(ar, cereal::make_nvp("components", components));
+				obj = entity();
+				return;
+			}
+
+			// Mapped before the components, they may refer back to it.
+			auto& ecs = context.get_world();
 			obj = ecs.create();
-			serialization_map[id] = obj;
+			context.add(id, obj);
 
 			try_load(ar, cereal::make_nvp("name", name));
 			try_load(ar, cereal::make_nvp("components", components));
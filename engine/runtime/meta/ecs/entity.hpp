@@ -4,10 +4,143 @@
 #include <core/reflection/reflection.h>
 #include <core/serialization/serialization.h>
 
+#include <cstdint>
+#include <unordered_map>
+
 namespace runtime
 {
+//-----------------------------------------------------------------------------
+//  Name : serialization_context (Class)
+/// <summary>
+/// Entities met while saving or loading one archive. An entity is written in
+/// full the first time and as its id after that. Loading maps the saved ids
+/// to the entities created for them. Reading a context from several threads
+/// at once is safe while it is read only.
+/// </summary>
+//-----------------------------------------------------------------------------
+class serialization_context
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// The entity for a saved id, null if there is none yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const entity* find(std::uint64_t id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Maps a saved id to an entity.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add(std::uint64_t id, const entity& e);
+
+	//-----------------------------------------------------------------------------
+	//  Name : reserve ()
+	/// <summary>
+	/// Makes room for the given number of entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void reserve(std::size_t count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Forgets all entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_entities ()
+	/// <summary>
+	/// All entities by saved id.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::unordered_map<std::uint64_t, entity>& get_entities() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_read_only ()
+	/// <summary>
+	/// A read only context is never changed by loading. Ids it does not know
+	/// load as invalid entities and create nothing, so it can be shared by
+	/// archives decoded on different threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_read_only(bool read_only);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_read_only ()
+	/// <summary>
+	/// See set_read_only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_read_only() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_world ()
+	/// <summary>
+	/// Loading creates the entities in this world instead of the one of the
+	/// entity_component_system subsystem. Null restores the subsystem.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_world(entity_component_system* world);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_world ()
+	/// <summary>
+	/// The world loading creates the entities in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	entity_component_system& get_world() const;
+
+private:
+	/// Entities by saved id.
+	std::unordered_map<std::uint64_t, entity> entities_;
+	/// Is loading allowed to add entities.
+	bool read_only_ = false;
+	/// World the entities are created in, null for the subsystem.
+	entity_component_system* world_ = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : serialization_scope (Class)
+/// <summary>
+/// Binds a context to an archive on the calling thread for its lifetime.
+/// Scopes nest, so saving or loading may start another archive with its own
+/// context from inside of a component.
+/// </summary>
+//-----------------------------------------------------------------------------
+class serialization_scope
+{
+public:
+	template <typename Archive>
+	serialization_scope(const Archive& ar, serialization_context& context)
+		: serialization_scope(static_cast<const void*>(&ar), context)
+	{
+	}
+
+	serialization_scope(const void* archive, serialization_context& context);
+	~serialization_scope();
+
+	serialization_scope(const serialization_scope&) = delete;
+	serialization_scope& operator=(const serialization_scope&) = delete;
+
+private:
+	/// The archive the context is bound to.
+	const void* archive_ = nullptr;
+};
 
-std::map<std::uint64_t, runtime::entity>& get_serialization_map();
+//-----------------------------------------------------------------------------
+//  Name : get_serialization_context ()
+/// <summary>
+/// The context bound to the archive on the calling thread. Serializing an
+/// entity through an archive without one violates the contract.
+/// </summary>
+//-----------------------------------------------------------------------------
+serialization_context& get_serialization_context(const void* archive);
 
 SAVE_EXTERN(entity);
 LOAD_EXTERN(entity);
@@ -0,0 +1,46 @@
+#include "world_layout.hpp"
+
+#include <core/serialization/associative_archive.h>
+#include <core/serialization/binary_archive.h>
+#include <core/serialization/types/string.hpp>
+#include <core/serialization/types/vector.hpp>
+
+SAVE(world_cell)
+{
+	try_save(ar, cereal::make_nvp("x", obj.x));
+	try_save(ar, cereal::make_nvp("z", obj.z));
+	try_save(ar, cereal::make_nvp("scene", obj.scene));
+	try_save(ar, cereal::make_nvp("meshes", obj.meshes));
+	try_save(ar, cereal::make_nvp("materials", obj.materials));
+	try_save(ar, cereal::make_nvp("sounds", obj.sounds));
+}
+SAVE_INSTANTIATE(world_cell, cereal::oarchive_associative_t);
+SAVE_INSTANTIATE(world_cell, cereal::oarchive_binary_t);
+
+LOAD(world_cell)
+{
+	try_load(ar, cereal::make_nvp("x", obj.x));
+	try_load(ar, cereal::make_nvp("z", obj.z));
+	try_load(ar, cereal::make_nvp("scene", obj.scene));
+	try_load(ar, cereal::make_nvp("meshes", obj.meshes));
+	try_load(ar, cereal::make_nvp("materials", obj.materials));
+	try_load(ar, cereal::make_nvp("sounds", obj.sounds));
+}
+LOAD_INSTANTIATE(world_cell, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(world_cell, cereal::iarchive_binary_t);
+
+SAVE(world_layout)
+{
+	try_save(ar, cereal::make_nvp("cell_size", obj.cell_size));
+	try_save(ar, cereal::make_nvp("cells", obj.cells));
+}
+SAVE_INSTANTIATE(world_layout, cereal::oarchive_associative_t);
+SAVE_INSTANTIATE(world_layout, cereal::oarchive_binary_t);
+
+LOAD(world_layout)
+{
+	try_load(ar, cereal::make_nvp("cell_size", obj.cell_size));
+	try_load(ar, cereal::make_nvp("cells", obj.cells));
+}
+LOAD_INSTANTIATE(world_layout, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(world_layout, cereal::iarchive_binary_t);
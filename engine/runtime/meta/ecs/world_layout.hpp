@@ -0,0 +1,9 @@
+#pragma once
+#include "../../ecs/constructs/world_layout.h"
+
+#include <core/serialization/serialization.h>
+
+SAVE_EXTERN(world_cell);
+LOAD_EXTERN(world_cell);
+SAVE_EXTERN(world_layout);
+LOAD_EXTERN(world_layout);
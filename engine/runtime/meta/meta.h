@@ -13,6 +13,7 @@
 #include "ecs/components/reflection_probe_component.hpp"
 #include "ecs/components/transform_component.hpp"
 #include "ecs/entity.hpp"
+#include "ecs/world_layout.hpp"
 
 #include "rendering/camera.hpp"
 #include "rendering/light.hpp"
@@ -24,6 +24,8 @@ SAVE_INSTANTIATE(material, cereal::oarchive_binary_t);
 LOAD(material)
 {
 	try_load(ar, cereal::make_nvp("cull_type", obj.cull_type_));
+
+	obj.mark_dirty();
 }
 LOAD_INSTANTIATE(material, cereal::iarchive_associative_t);
 LOAD_INSTANTIATE(material, cereal::iarchive_binary_t);
@@ -1,6 +1,7 @@
 #include "standard_material.hpp"
 #include "material.hpp"
 
+#include "../../ecs/systems/texture_streaming.h"
 #include "../assets/asset_handle.hpp"
 #include "../core/math/vector.hpp"
 
@@ -74,7 +75,13 @@ LOAD(standard_material)
 	try_load(ar, cereal::make_nvp("surface_data", obj.surface_data_));
 	try_load(ar, cereal::make_nvp("tiling", obj.tiling_));
 	try_load(ar, cereal::make_nvp("dither_threshold", obj.dither_threshold_));
-	try_load(ar, cereal::make_nvp("maps", obj.maps_));
+	{
+		// The maps are streamed by the screen size of the models using them.
+		runtime::texture_streaming_scope streamed;
+		try_load(ar, cereal::make_nvp("maps", obj.maps_));
+	}
+
+	obj.mark_dirty();
 }
 LOAD_INSTANTIATE(standard_material, cereal::iarchive_associative_t);
 LOAD_INSTANTIATE(standard_material, cereal::iarchive_binary_t);
@@ -0,0 +1,424 @@
+#include "light_clusters.h"
+
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ETH_LIGHT_CLUSTERS_SSE2 1
+#include <emmintrin.h>
+#else
+#define ETH_LIGHT_CLUSTERS_SSE2 0
+#endif
+
+constexpr std::uint32_t light_clusters::tiles_x;
+constexpr std::uint32_t light_clusters::tiles_y;
+constexpr std::uint32_t light_clusters::slices;
+constexpr std::uint32_t light_clusters::tiles;
+constexpr std::uint32_t light_clusters::cluster_count;
+constexpr std::uint32_t light_clusters::max_lights;
+constexpr std::uint32_t light_clusters::index_texture_width;
+constexpr std::uint32_t light_clusters::index_texture_height;
+constexpr std::uint32_t light_clusters::max_light_indices;
+constexpr std::uint32_t light_clusters::light_texture_rows;
+
+static_assert(light_clusters::tiles % 4 == 0, "clusters are tested four at a time");
+
+namespace
+{
+// Slices handed to one task.
+constexpr std::uint32_t slices_per_task = 4;
+
+//-----------------------------------------------------------------------------
+//  Name : test_clusters_scalar ()
+/// <summary>
+/// Tests a light against four consecutive clusters of a slice. Returns a bit
+/// per cluster that the light touches. Every light is tested with its bounding
+/// sphere against the cluster boxes, spot lights are then also tested with
+/// their cone against the cluster spheres.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Bounds, typename Light>
+int test_clusters_scalar(const Bounds& b, std::uint32_t first, const Light& l)
+{
+	int result = 0;
+	for(std::uint32_t i = 0; i < 4; ++i)
+	{
+		const auto c = first + i;
+		const auto axis_distance = [](float p, float mn, float mx) {
+			return std::max(mn - p, 0.0f) + std::max(p - mx, 0.0f);
+		};
+		const float dx = axis_distance(l.position.x, b.min_x[c], b.max_x[c]);
+		const float dy = axis_distance(l.position.y, b.min_y[c], b.max_y[c]);
+		const float dz = axis_distance(l.position.z, b.min_z[c], b.max_z[c]);
+		if(dx * dx + dy * dy + dz * dz > l.range * l.range)
+		{
+			continue;
+		}
+
+		if(l.cos_half_angle > -1.0f)
+		{
+			const float vx = b.center_x[c] - l.position.x;
+			const float vy = b.center_y[c] - l.position.y;
+			const float vz = b.center_z[c] - l.position.z;
+			const float len_sq = vx * vx + vy * vy + vz * vz;
+			const float along = vx * l.direction.x + vy * l.direction.y + vz * l.direction.z;
+			const float across = std::sqrt(std::max(len_sq - along * along, 0.0f));
+			const float closest = l.cos_half_angle * across - along * l.sin_half_angle;
+			const float radius = b.radius[c];
+			if(closest > radius || along > radius + l.range || along < -radius)
+			{
+				continue;
+			}
+		}
+
+		result |= 1 << i;
+	}
+	return result;
+}
+
+#if ETH_LIGHT_CLUSTERS_SSE2
+//-----------------------------------------------------------------------------
+//  Name : test_clusters_sse2 ()
+/// <summary>
+/// Same as test_clusters_scalar, the four clusters at once.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Bounds, typename Light>
+int test_clusters_sse2(const Bounds& b, std::uint32_t first, const Light& l)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 px = _mm_set1_ps(l.position.x);
+	const __m128 py = _mm_set1_ps(l.position.y);
+	const __m128 pz = _mm_set1_ps(l.position.z);
+
+	const auto axis_distance = [&zero](__m128 p, const float* mn, const float* mx) {
+		const __m128 below = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(mn), p), zero);
+		const __m128 above = _mm_max_ps(_mm_sub_ps(p, _mm_loadu_ps(mx)), zero);
+		return _mm_add_ps(below, above);
+	};
+
+	const __m128 dx = axis_distance(px, b.min_x + first, b.max_x + first);
+	const __m128 dy = axis_distance(py, b.min_y + first, b.max_y + first);
+	const __m128 dz = axis_distance(pz, b.min_z + first, b.max_z + first);
+	const __m128 dist_sq =
+		_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+	__m128 mask = _mm_cmple_ps(dist_sq, _mm_set1_ps(l.range * l.range));
+
+	if(l.cos_half_angle > -1.0f && _mm_movemask_ps(mask) != 0)
+	{
+		const __m128 vx = _mm_sub_ps(_mm_loadu_ps(b.center_x + first), px);
+		const __m128 vy = _mm_sub_ps(_mm_loadu_ps(b.center_y + first), py);
+		const __m128 vz = _mm_sub_ps(_mm_loadu_ps(b.center_z + first), pz);
+		const __m128 radius = _mm_loadu_ps(b.radius + first);
+
+		const __m128 len_sq =
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		const __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(l.direction.x)),
+												   _mm_mul_ps(vy, _mm_set1_ps(l.direction.y))),
+										_mm_mul_ps(vz, _mm_set1_ps(l.direction.z)));
+		const __m128 across = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(len_sq, _mm_mul_ps(along, along)), zero));
+		const __m128 closest = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(l.cos_half_angle), across),
+										  _mm_mul_ps(along, _mm_set1_ps(l.sin_half_angle)));
+
+		const __m128 angle_cull = _mm_cmpgt_ps(closest, radius);
+		const __m128 front_cull = _mm_cmpgt_ps(along, _mm_add_ps(radius, _mm_set1_ps(l.range)));
+		const __m128 back_cull = _mm_cmplt_ps(along, _mm_sub_ps(zero, radius));
+		const __m128 cull = _mm_or_ps(_mm_or_ps(angle_cull, front_cull), back_cull);
+		mask = _mm_andnot_ps(cull, mask);
+	}
+
+	return _mm_movemask_ps(mask);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//  Name : bin_lights ()
+/// <summary>
+/// Appends the lights touching the clusters of a slice to their lists.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Bounds, typename Light, typename Test>
+void bin_lights(const Bounds& b, std::uint32_t slice, const std::vector<Light>& lights,
+				std::vector<std::uint32_t>* lists, std::uint32_t tiles, Test test)
+{
+	for(const auto& l : lights)
+	{
+		if(slice < l.first_slice || slice > l.last_slice)
+		{
+			continue;
+		}
+
+		for(std::uint32_t first = 0; first < tiles; first += 4)
+		{
+			auto mask = test(b, first, l);
+			while(mask != 0)
+			{
+				const int bit = mask & -mask;
+				const int i = bit == 1 ? 0 : bit == 2 ? 1 : bit == 4 ? 2 : 3;
+				lists[first + std::uint32_t(i)].emplace_back(l.index);
+				mask &= ~bit;
+			}
+		}
+	}
+}
+}
+
+light_clusters::light_data light_clusters::make_light_data(const light& l, const math::transform& world)
+{
+	light_data result;
+	result.position = world.get_position();
+	result.direction = world.z_unit_axis();
+	result.type = l.type;
+	result.color_intensity = {l.color.value.r, l.color.value.g, l.color.value.b, l.intensity};
+
+	if(l.type == light_type::spot)
+	{
+		const float half_outer = math::radians(l.spot_data.get_outer_angle() * 0.5f);
+		const float half_inner = math::radians(l.spot_data.get_inner_angle() * 0.5f);
+		result.range = l.spot_data.get_range();
+		result.cos_half_angle = math::cos(half_outer);
+		result.data = {result.range, math::cos(half_inner), math::cos(half_outer), 0.0f};
+	}
+	else
+	{
+		result.range = l.point_data.range;
+		result.data = {result.range, l.point_data.exponent_falloff, 0.0f, 0.0f};
+	}
+
+	return result;
+}
+
+void light_clusters::build(const std::vector<light_data>& lights, const math::transform& view,
+						   const math::transform& proj, float near_clip, float far_clip,
+						   core::task_system* ts)
+{
+	const auto& proj_matrix = proj.get_matrix();
+	if(bounds_.empty() || proj_matrix != bounds_proj_ || near_clip != near_clip_ ||
+	   far_clip != bounds_far_clip_)
+	{
+		compute_bounds(proj_matrix, near_clip, far_clip);
+	}
+
+	// The w of a point in front of the camera is positive, this gives the sign
+	// of view space z regardless of the handedness.
+	const float z_sign = proj_matrix[2][3] < 0.0f ? -1.0f : 1.0f;
+
+	std::vector<view_light> view_lights;
+	view_lights.reserve(std::min<std::size_t>(lights.size(), max_lights));
+	const auto count = std::uint32_t(std::min<std::size_t>(lights.size(), max_lights));
+	dropped_lights_ = std::uint32_t(lights.size()) - count;
+	for(std::uint32_t i = 0; i < count; ++i)
+	{
+		const auto& l = lights[i];
+
+		view_light vl;
+		vl.position = view.transform_coord(l.position);
+		vl.direction = math::normalize(view.transform_normal(l.direction));
+		vl.range = l.range;
+		vl.index = i;
+
+		const float depth = vl.position.z * z_sign;
+		if(depth + vl.range < near_clip || depth - vl.range > far_clip)
+		{
+			continue;
+		}
+		vl.first_slice = get_slice(depth - vl.range);
+		vl.last_slice = get_slice(depth + vl.range);
+
+		if(l.type == light_type::spot)
+		{
+			vl.cos_half_angle = l.cos_half_angle;
+			vl.sin_half_angle = std::sqrt(std::max(1.0f - l.cos_half_angle * l.cos_half_angle, 0.0f));
+		}
+
+		view_lights.emplace_back(vl);
+	}
+
+	lists_.resize(cluster_count);
+	for(auto& list : lists_)
+	{
+		list.clear();
+	}
+
+	const auto bin_range = [this, &view_lights](std::uint32_t first, std::uint32_t last) {
+		for(auto slice = first; slice < last; ++slice)
+		{
+			bin_slice(slice, view_lights);
+		}
+	};
+
+	if(ts != nullptr && !view_lights.empty())
+	{
+		std::vector<core::task_future<void>> tasks;
+		for(std::uint32_t first = slices_per_task; first < slices; first += slices_per_task)
+		{
+			const auto last = std::min(first + slices_per_task, slices);
+			auto task = ts->push_on_worker_thread([bin_range, first, last]() { bin_range(first, last); });
+			tasks.emplace_back(std::move(task));
+		}
+		bin_range(0, std::min(slices_per_task, slices));
+
+		for(auto& task : tasks)
+		{
+			task.wait();
+		}
+	}
+	else
+	{
+		bin_range(0, slices);
+	}
+
+	// Concatenate in cluster order so the result does not depend on the
+	// scheduling.
+	clusters_.resize(cluster_count);
+	indices_.clear();
+	dropped_indices_ = 0;
+	for(std::uint32_t i = 0; i < cluster_count; ++i)
+	{
+		const auto& list = lists_[i];
+		const auto available = max_light_indices - std::uint32_t(indices_.size());
+		const auto list_count = std::min(std::uint32_t(list.size()), available);
+		dropped_indices_ += std::uint32_t(list.size()) - list_count;
+
+		clusters_[i].offset = std::uint32_t(indices_.size());
+		clusters_[i].count = list_count;
+		indices_.insert(std::end(indices_), std::begin(list), std::begin(list) + list_count);
+	}
+}
+
+std::uint32_t light_clusters::get_slice(float depth) const
+{
+	if(depth <= near_clip_)
+	{
+		return 0;
+	}
+
+	const auto slice = std::floor(std::log(depth / near_clip_) * depth_scale_);
+	return std::uint32_t(math::clamp(slice, 0.0f, float(slices - 1)));
+}
+
+void light_clusters::pack_clusters(std::vector<float>& texels) const
+{
+	texels.assign(cluster_count * 4, 0.0f);
+	for(std::size_t i = 0; i < clusters_.size(); ++i)
+	{
+		texels[i * 4 + 0] = float(clusters_[i].offset);
+		texels[i * 4 + 1] = float(clusters_[i].count);
+	}
+}
+
+void light_clusters::pack_indices(std::vector<float>& texels) const
+{
+	texels.assign(max_light_indices, 0.0f);
+	std::transform(std::begin(indices_), std::end(indices_), std::begin(texels),
+				   [](std::uint32_t index) { return float(index); });
+}
+
+void light_clusters::pack_lights(const std::vector<light_data>& lights, std::vector<float>& texels)
+{
+	texels.assign(max_lights * light_texture_rows * 4, 0.0f);
+
+	const auto count = std::min<std::size_t>(lights.size(), max_lights);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto& l = lights[i];
+		const float rows[light_texture_rows][4] = {
+			{l.position.x, l.position.y, l.position.z, l.range},
+			{l.direction.x, l.direction.y, l.direction.z, float(l.type)},
+			{l.color_intensity.x, l.color_intensity.y, l.color_intensity.z, l.color_intensity.w},
+			{l.data.x, l.data.y, l.data.z, l.data.w}};
+
+		for(std::size_t row = 0; row < light_texture_rows; ++row)
+		{
+			std::copy(std::begin(rows[row]), std::end(rows[row]), &texels[(row * max_lights + i) * 4]);
+		}
+	}
+}
+
+void light_clusters::compute_bounds(const math::mat4& proj, float near_clip, float far_clip)
+{
+	bounds_proj_ = proj;
+	bounds_far_clip_ = far_clip;
+	near_clip_ = near_clip;
+	depth_scale_ = float(slices) / std::log(far_clip / near_clip);
+	bounds_.resize(slices);
+
+	// A view space point at depth d projects to ndc (nx, ny) for
+	// x = d * (nx - s * p20) / p00 and y = d * (ny - s * p21) / p11, z = s * d.
+	const float s = proj[2][3] < 0.0f ? -1.0f : 1.0f;
+	const auto view_point = [&proj, s](float nx, float ny, float depth) {
+		return math::vec3(depth * (nx - s * proj[2][0]) / proj[0][0],
+						  depth * (ny - s * proj[2][1]) / proj[1][1], s * depth);
+	};
+
+	for(std::uint32_t z = 0; z < slices; ++z)
+	{
+		const float near_depth = near_clip * std::pow(far_clip / near_clip, float(z) / float(slices));
+		const float far_depth = near_clip * std::pow(far_clip / near_clip, float(z + 1) / float(slices));
+		auto& b = bounds_[z];
+
+		for(std::uint32_t y = 0; y < tiles_y; ++y)
+		{
+			const float ny0 = -1.0f + 2.0f * float(y) / float(tiles_y);
+			const float ny1 = -1.0f + 2.0f * float(y + 1) / float(tiles_y);
+
+			for(std::uint32_t x = 0; x < tiles_x; ++x)
+			{
+				const float nx0 = -1.0f + 2.0f * float(x) / float(tiles_x);
+				const float nx1 = -1.0f + 2.0f * float(x + 1) / float(tiles_x);
+
+				const math::vec3 corners[8] = {
+					view_point(nx0, ny0, near_depth), view_point(nx1, ny0, near_depth),
+					view_point(nx0, ny1, near_depth), view_point(nx1, ny1, near_depth),
+					view_point(nx0, ny0, far_depth),  view_point(nx1, ny0, far_depth),
+					view_point(nx0, ny1, far_depth),  view_point(nx1, ny1, far_depth)};
+
+				math::vec3 mn = corners[0];
+				math::vec3 mx = corners[0];
+				for(const auto& corner : corners)
+				{
+					mn = math::min(mn, corner);
+					mx = math::max(mx, corner);
+				}
+
+				const auto t = y * tiles_x + x;
+				b.min_x[t] = mn.x;
+				b.min_y[t] = mn.y;
+				b.min_z[t] = mn.z;
+				b.max_x[t] = mx.x;
+				b.max_y[t] = mx.y;
+				b.max_z[t] = mx.z;
+
+				const auto center = (mn + mx) * 0.5f;
+				b.center_x[t] = center.x;
+				b.center_y[t] = center.y;
+				b.center_z[t] = center.z;
+				b.radius[t] = math::length(mx - mn) * 0.5f;
+			}
+		}
+	}
+}
+
+void light_clusters::bin_slice(std::uint32_t slice, const std::vector<view_light>& lights)
+{
+	const auto& b = bounds_[slice];
+	auto* lists = &lists_[slice * tiles];
+
+	// The simd level selects the implementation like for the batch functions.
+#if ETH_LIGHT_CLUSTERS_SSE2
+	if(math::simd::get_level() != math::simd::level::scalar)
+	{
+		bin_lights(b, slice, lights, lists, tiles,
+				   [](const slice_bounds& sb, std::uint32_t first, const view_light& l) {
+					   return test_clusters_sse2(sb, first, l);
+				   });
+		return;
+	}
+#endif
+	bin_lights(b, slice, lights, lists, tiles,
+			   [](const slice_bounds& sb, std::uint32_t first, const view_light& l) {
+				   return test_clusters_scalar(sb, first, l);
+			   });
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "light.h"
+
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace core
+{
+class task_system;
+}
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : light_clusters (Class)
+/// <summary>
+/// Bins point and spot lights into the clusters (froxels) of a perspective
+/// view. The view is split into screen tiles and exponentially distributed
+/// depth slices, every cluster gets a compact list of the lights touching it
+/// so a single full screen draw can shade with all relevant lights. Binning is
+/// done on the cpu only and does not need a gpu.
+/// </summary>
+//-----------------------------------------------------------------------------
+class light_clusters
+{
+public:
+	/// Screen tiles along x.
+	static constexpr std::uint32_t tiles_x = 16;
+	/// Screen tiles along y.
+	static constexpr std::uint32_t tiles_y = 9;
+	/// Depth slices.
+	static constexpr std::uint32_t slices = 24;
+	/// Clusters of one slice.
+	static constexpr std::uint32_t tiles = tiles_x * tiles_y;
+	/// Clusters of the view.
+	static constexpr std::uint32_t cluster_count = tiles * slices;
+	/// Lights that can be binned, the rest is dropped.
+	static constexpr std::uint32_t max_lights = 1024;
+	/// Width of the index texture, every texel holds four indices.
+	static constexpr std::uint32_t index_texture_width = 1024;
+	/// Height of the index texture.
+	static constexpr std::uint32_t index_texture_height = 16;
+	/// Light indices of all clusters together.
+	static constexpr std::uint32_t max_light_indices = index_texture_width * index_texture_height * 4;
+	/// Rows of the light texture, one texel per light in every row.
+	static constexpr std::uint32_t light_texture_rows = 4;
+
+	struct light_data
+	{
+		/// World position.
+		math::vec3 position;
+		/// Radius of influence.
+		float range = 0.0f;
+		/// World direction of a spot light.
+		math::vec3 direction;
+		/// Point or spot.
+		light_type type = light_type::point;
+		/// Cosine of half the outer angle of a spot light.
+		float cos_half_angle = -1.0f;
+		/// Color and intensity.
+		math::vec4 color_intensity;
+		/// Same as u_light_data of the per light shaders.
+		math::vec4 data;
+	};
+
+	struct cluster
+	{
+		/// First index in the light index list.
+		std::uint32_t offset = 0;
+		/// Number of lights.
+		std::uint32_t count = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : make_light_data ()
+	/// <summary>
+	/// Converts a point or spot light with its world transform.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static light_data make_light_data(const light& l, const math::transform& world);
+
+	//-----------------------------------------------------------------------------
+	//  Name : build ()
+	/// <summary>
+	/// Bins the lights for a perspective view. The slices are distributed over
+	/// the worker threads when a task system is passed. The result does not
+	/// depend on the number of threads nor on the simd level.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void build(const std::vector<light_data>& lights, const math::transform& view,
+			   const math::transform& proj, float near_clip, float far_clip,
+			   core::task_system* ts = nullptr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_cluster_index ()
+	/// <summary>
+	/// Index of the cluster at the tile and slice.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static inline std::uint32_t get_cluster_index(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+	{
+		return z * tiles + y * tiles_x + x;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_slice ()
+	/// <summary>
+	/// Slice containing the view depth, the same mapping as the shader.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_slice(float depth) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : pack_clusters ()
+	/// <summary>
+	/// Writes offset and count of every cluster as rgba32f texels.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void pack_clusters(std::vector<float>& texels) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : pack_indices ()
+	/// <summary>
+	/// Writes the light index list as rgba32f texels, four indices per texel.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void pack_indices(std::vector<float>& texels) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : pack_lights ()
+	/// <summary>
+	/// Writes the lights as rgba32f texels, one row per attribute.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void pack_lights(const std::vector<light_data>& lights, std::vector<float>& texels);
+
+	inline const std::vector<cluster>& get_clusters() const
+	{
+		return clusters_;
+	}
+
+	inline const std::vector<std::uint32_t>& get_light_indices() const
+	{
+		return indices_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_depth_scale ()
+	/// <summary>
+	/// Slices per unit of log(depth / near).
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline float get_depth_scale() const
+	{
+		return depth_scale_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dropped_lights ()
+	/// <summary>
+	/// Lights past max_lights that were not binned the last build.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_dropped_lights() const
+	{
+		return dropped_lights_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dropped_indices ()
+	/// <summary>
+	/// Light indices that did not fit into the index list the last build.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_dropped_indices() const
+	{
+		return dropped_indices_;
+	}
+
+private:
+	struct slice_bounds
+	{
+		/// Bounding boxes of the clusters of the slice in view space.
+		float min_x[tiles];
+		float min_y[tiles];
+		float min_z[tiles];
+		float max_x[tiles];
+		float max_y[tiles];
+		float max_z[tiles];
+		/// Bounding spheres of the clusters used by the cone test.
+		float center_x[tiles];
+		float center_y[tiles];
+		float center_z[tiles];
+		float radius[tiles];
+	};
+
+	struct view_light
+	{
+		/// View space position.
+		math::vec3 position;
+		/// Radius of influence.
+		float range = 0.0f;
+		/// View space direction.
+		math::vec3 direction;
+		/// Sine and cosine of half the outer angle, cosine is -1 for points.
+		float cos_half_angle = -1.0f;
+		float sin_half_angle = 0.0f;
+		/// First and last slice touched.
+		std::uint32_t first_slice = 0;
+		std::uint32_t last_slice = 0;
+		/// Index into the input.
+		std::uint32_t index = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_bounds ()
+	/// <summary>
+	/// Computes the view space bounds of every cluster from the projection.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void compute_bounds(const math::mat4& proj, float near_clip, float far_clip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : bin_slice ()
+	/// <summary>
+	/// Bins the lights touching one slice into the lists of its clusters.
+	/// Slices write disjoint lists, so they can be binned concurrently.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void bin_slice(std::uint32_t slice, const std::vector<view_light>& lights);
+
+	/// Bounds of every slice.
+	std::vector<slice_bounds> bounds_;
+	/// Projection the bounds were computed for.
+	math::mat4 bounds_proj_;
+	/// Far clip the bounds were computed for.
+	float bounds_far_clip_ = 0.0f;
+	/// Light lists of every cluster while binning.
+	std::vector<std::vector<std::uint32_t>> lists_;
+	/// Binned clusters.
+	std::vector<cluster> clusters_;
+	/// Light indices of all clusters.
+	std::vector<std::uint32_t> indices_;
+	/// Near clip of the last build.
+	float near_clip_ = 0.1f;
+	/// Slices per unit of log(depth / near).
+	float depth_scale_ = 1.0f;
+	/// Lights that were not binned the last build.
+	std::uint32_t dropped_lights_ = 0;
+	/// Indices that did not fit the last build.
+	std::uint32_t dropped_indices_ = 0;
+};
@@ -7,7 +7,51 @@
 #include <core/graphics/uniform.h>
 #include <core/system/subsystem.h>
 
+#include <atomic>
+
+namespace
+{
+const gfx::uniform_id u_base_color("u_base_color");
+const gfx::uniform_id u_subsurface_color("u_subsurface_color");
+const gfx::uniform_id u_emissive_color("u_emissive_color");
+const gfx::uniform_id u_surface_data("u_surface_data");
+const gfx::uniform_id u_tiling("u_tiling");
+const gfx::uniform_id u_dither_threshold("u_dither_threshold");
+const gfx::uniform_id s_tex_color("s_tex_color");
+const gfx::uniform_id s_tex_normal("s_tex_normal");
+const gfx::uniform_id s_tex_roughness("s_tex_roughness");
+const gfx::uniform_id s_tex_metalness("s_tex_metalness");
+const gfx::uniform_id s_tex_ao("s_tex_ao");
+
+struct submit_cache
+{
+	/// Id of the material last submitted.
+	std::uint32_t material_id = 0;
+	/// Version of the material last submitted.
+	std::uint32_t version = 0;
+	/// Program the uniforms were set for.
+	std::uint16_t program = 0;
+	/// View the uniforms were set for.
+	gfx::view_id view = 0;
+};
+
+submit_cache& get_submit_cache()
+{
+	static submit_cache cache;
+	return cache;
+}
+
+std::uint32_t generate_material_id()
+{
+	// zero is reserved for 'nothing submitted', materials are also created
+	// by the loading workers
+	static std::atomic<std::uint32_t> id{0};
+	return id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+}
+
 material::material()
+	: id_(generate_material_id())
 {
 	auto& am = core::get_subsystem<runtime::asset_manager>();
 	auto default_color = am.load<gfx::texture>("engine:/data/textures/default_color.dds");
@@ -39,6 +83,33 @@ void material::set_uniform(const std::string& _name, const void* _value, std::ui
 	get_program()->set_uniform(_name, _value, _num);
 }
 
+void material::submit(gfx::view_id id)
+{
+	auto program = get_program();
+	if(program == nullptr)
+		return;
+
+	auto& cache = get_submit_cache();
+	const auto program_idx = program->native_handle().idx;
+	if(cache.material_id != id_ || cache.version != version_ || cache.program != program_idx ||
+	   cache.view != id)
+	{
+		submit_uniforms();
+
+		cache.material_id = id_;
+		cache.version = version_;
+		cache.program = program_idx;
+		cache.view = id;
+	}
+
+	submit_textures();
+}
+
+void material::reset_submit_cache()
+{
+	get_submit_cache() = {};
+}
+
 gpu_program* material::get_program() const
 {
 	return skinned ? program_skinned_.get() : program_.get();
@@ -103,33 +174,67 @@ standard_material::~standard_material()
 	}
 }
 
-void standard_material::submit()
+void standard_material::flatten_maps()
+{
+	if(flattened_version_ == version_)
+		return;
+
+	const auto get_map = [this](const std::string& name) {
+		auto it = maps_.find(name);
+		if(it != maps_.end())
+			return it->second;
+		return asset_handle<gfx::texture>();
+	};
+
+	flattened_maps_[0] = get_map("color");
+	flattened_maps_[1] = get_map("normal");
+	flattened_maps_[2] = get_map("roughness");
+	flattened_maps_[3] = get_map("metalness");
+	flattened_maps_[4] = get_map("ao");
+	flattened_version_ = version_;
+}
+
+void standard_material::get_textures(std::vector<asset_handle<gfx::texture>>& textures) const
+{
+	for(const auto& pair : maps_)
+	{
+		if(pair.second)
+		{
+			textures.push_back(pair.second);
+		}
+	}
+}
+
+void standard_material::submit_uniforms()
+{
+	if(!is_valid())
+		return;
+
+	get_program()->set_uniform(u_base_color, &base_color_);
+	get_program()->set_uniform(u_subsurface_color, &subsurface_color_);
+	get_program()->set_uniform(u_emissive_color, &emissive_color_);
+	get_program()->set_uniform(u_surface_data, &surface_data_);
+	get_program()->set_uniform(u_tiling, &tiling_);
+	get_program()->set_uniform(u_dither_threshold, &dither_threshold_);
+}
+
+void standard_material::submit_textures()
 {
 	if(!is_valid())
 		return;
 
-	get_program()->set_uniform("u_base_color", &base_color_);
-	get_program()->set_uniform("u_subsurface_color", &subsurface_color_);
-	get_program()->set_uniform("u_emissive_color", &emissive_color_);
-	get_program()->set_uniform("u_surface_data", &surface_data_);
-	get_program()->set_uniform("u_tiling", &tiling_);
-	get_program()->set_uniform("u_dither_threshold", &dither_threshold_);
-
-	const auto& color_map = maps_["color"];
-	const auto& normal_map = maps_["normal"];
-	const auto& roughness_map = maps_["roughness"];
-	const auto& metalness_map = maps_["metalness"];
-	const auto& ao_map = maps_["ao"];
-
-	auto albedo = color_map ? color_map : default_color_map_;
-	auto normal = normal_map ? normal_map : default_normal_map_;
-	auto roughness = roughness_map ? roughness_map : default_color_map_;
-	auto metalness = metalness_map ? metalness_map : default_color_map_;
-	auto ao = ao_map ? ao_map : default_color_map_;
-
-	get_program()->set_texture(0, "s_tex_color", albedo.get());
-	get_program()->set_texture(1, "s_tex_normal", normal.get());
-	get_program()->set_texture(2, "s_tex_roughness", roughness.get());
-	get_program()->set_texture(3, "s_tex_metalness", metalness.get());
-	get_program()->set_texture(4, "s_tex_ao", ao.get());
+	flatten_maps();
+
+	// maps may still be loading, so the fallback is picked per draw.
+	const auto& albedo = flattened_maps_[0] ? flattened_maps_[0] : default_color_map_;
+	const auto& normal = flattened_maps_[1] ? flattened_maps_[1] : default_normal_map_;
+	const auto& roughness = flattened_maps_[2] ? flattened_maps_[2] : default_color_map_;
+	const auto& metalness = flattened_maps_[3] ? flattened_maps_[3] : default_color_map_;
+	const auto& ao = flattened_maps_[4] ? flattened_maps_[4] : default_color_map_;
+
+	get_program()->set_texture(0, s_tex_color, albedo.get());
+	get_program()->set_texture(1, s_tex_normal, normal.get());
+	get_program()->set_texture(2, s_tex_roughness, roughness.get());
+	get_program()->set_texture(3, s_tex_metalness, metalness.get());
+	get_program()->set_texture(4, s_tex_ao, ao.get());
 }
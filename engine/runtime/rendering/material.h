@@ -8,6 +8,8 @@
 #include <core/serialization/serialization.h>
 #include <core/tasks/task_system.h>
 
+#include <array>
+#include <limits>
 #include <unordered_map>
 
 class gpu_program;
@@ -116,6 +118,40 @@ public:
 	//-----------------------------------------------------------------------------
 	virtual void submit()
 	{
+		submit_uniforms();
+		submit_textures();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Pushes the material state for a draw into the specified view. Uniform
+	/// values persist between draws in bgfx, so they are skipped when the
+	/// previous material draw in the same view used this material, at the same
+	/// version, with the same program. Texture bindings are discarded on every
+	/// submit so those are always set.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit(gfx::view_id id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : reset_submit_cache (static )
+	/// <summary>
+	/// Forgets the last submitted material state. Called once the frame was
+	/// handed over to the renderer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void reset_submit_cache();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_version ()
+	/// <summary>
+	/// Incremented every time a parameter of the material changes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_version() const
+	{
+		return version_;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -142,6 +178,7 @@ public:
 	inline void set_cull_type(cull_type val)
 	{
 		cull_type_ = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -155,9 +192,61 @@ public:
 	std::uint64_t get_render_states(bool apply_cull = true, bool depth_write = true,
 									bool depth_test = true) const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_textures (virtual )
+	/// <summary>
+	/// Adds the textures the material samples, for streaming their mips.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void get_textures(std::vector<asset_handle<gfx::texture>>& /*textures*/) const
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_texture_tiling (virtual )
+	/// <summary>
+	/// How often the textures repeat across the surface.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual float get_texture_tiling() const
+	{
+		return 1.0f;
+	}
+
 	bool skinned = false;
 
 protected:
+	//-----------------------------------------------------------------------------
+	//  Name : submit_uniforms (virtual )
+	/// <summary>
+	/// Pushes the uniform values of the material.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void submit_uniforms()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_textures (virtual )
+	/// <summary>
+	/// Binds the textures of the material.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void submit_textures()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : mark_dirty ()
+	/// <summary>
+	/// Bumps the version after a parameter changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline void mark_dirty()
+	{
+		++version_;
+	}
+
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> program_;
 	/// Program that is responsible for rendering.
@@ -170,6 +259,11 @@ protected:
 	asset_handle<gfx::texture> default_normal_map_;
 
 	std::vector<core::task_future<void>> futures_;
+
+	/// Unique id used to recognize the material between draws.
+	std::uint32_t id_ = 0;
+	/// Parameter version.
+	std::uint32_t version_ = 0;
 };
 
 class standard_material : public material
@@ -212,6 +306,7 @@ public:
 	inline void set_base_color(const math::color& val)
 	{
 		base_color_ = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -238,6 +333,7 @@ public:
 	inline void set_subsurface_color(const math::color& val)
 	{
 		subsurface_color_ = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -264,6 +360,7 @@ public:
 	inline void set_emissive_color(const math::color& val)
 	{
 		emissive_color_ = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -290,6 +387,7 @@ public:
 	inline void set_roughness(float rougness)
 	{
 		surface_data_.x = rougness;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -316,6 +414,7 @@ public:
 	inline void set_metalness(float metalness)
 	{
 		surface_data_.y = metalness;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -342,6 +441,7 @@ public:
 	inline void set_bumpiness(float bumpiness)
 	{
 		surface_data_.z = bumpiness;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -368,6 +468,7 @@ public:
 	inline void set_alpha_test_value(float alphaTestValue)
 	{
 		surface_data_.w = alphaTestValue;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -394,6 +495,7 @@ public:
 	inline void set_tiling(const math::vec2& tiling)
 	{
 		tiling_ = tiling;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -420,6 +522,7 @@ public:
 	inline void set_dither_threshold(const math::vec2& threshold)
 	{
 		dither_threshold_ = threshold;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -446,6 +549,7 @@ public:
 	inline void set_color_map(asset_handle<gfx::texture> val)
 	{
 		maps_["color"] = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -472,6 +576,7 @@ public:
 	inline void set_normal_map(asset_handle<gfx::texture> val)
 	{
 		maps_["normal"] = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -498,6 +603,7 @@ public:
 	inline void set_roughness_map(asset_handle<gfx::texture> val)
 	{
 		maps_["roughness"] = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -524,6 +630,7 @@ public:
 	inline void set_metalness_map(asset_handle<gfx::texture> val)
 	{
 		maps_["metalness"] = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -550,19 +657,54 @@ public:
 	inline void set_ao_map(asset_handle<gfx::texture> val)
 	{
 		maps_["ao"] = val;
+		mark_dirty();
 	}
 
 	//-----------------------------------------------------------------------------
-	//  Name : submit (virtual )
+	//  Name : submit_uniforms (virtual )
 	/// <summary>
-	///
-	///
-	///
+	/// Pushes the surface parameters.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void submit();
+	void submit_uniforms() override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_textures (virtual )
+	/// <summary>
+	/// Binds the texture maps, falling back to the defaults for missing ones.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit_textures() override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_textures (virtual )
+	/// <summary>
+	/// Adds the assigned texture maps.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void get_textures(std::vector<asset_handle<gfx::texture>>& textures) const override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_texture_tiling (virtual )
+	/// <summary>
+	/// The larger of the primary tiling factors.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_texture_tiling() const override
+	{
+		return math::max(tiling_.x, tiling_.y);
+	}
 
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : flatten_maps ()
+	/// <summary>
+	/// Resolves the named texture maps into sampler slots if the material
+	/// changed since they were last resolved.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void flatten_maps();
+
 	/// Base color
 	math::color base_color_{
 		1.0f, 1.0f, 1.0f, /// Color
@@ -597,4 +739,9 @@ private:
 
 	/// Texture maps
 	std::unordered_map<std::string, asset_handle<gfx::texture>> maps_;
+	/// Texture maps resolved by sampler slot (color, normal, roughness,
+	/// metalness, ao).
+	std::array<asset_handle<gfx::texture>, 5> flattened_maps_;
+	/// Version the maps were resolved for.
+	std::uint32_t flattened_version_ = std::numeric_limits<std::uint32_t>::max();
 };
@@ -68,6 +68,10 @@ void mesh::dispose()
 	checked_array_delete(system_ib_);
 
 	triangle_data_.clear();
+	{
+		std::lock_guard<std::mutex> lock(raycast_mutex_);
+		raycast_data_.reset();
+	}
 
 	// Release resources
 	hardware_vb_.reset();
@@ -1291,6 +1295,12 @@ bool mesh::end_prepare(bool hardware_copy /* = true */, bool weld /* = true */,
 	hardware_mesh_ = hardware_copy;
 	optimize_mesh_ = optimize;
 
+	// Any ray query data refers to the old buffers.
+	{
+		std::lock_guard<std::mutex> lock(raycast_mutex_);
+		raycast_data_.reset();
+	}
+
 	// Success!
 	return true;
 }
@@ -2778,6 +2788,67 @@ const mesh::subset* mesh::get_subset(std::uint32_t data_group_id /* = 0 */) cons
 	return it->second;
 }
 
+bool mesh::raycast(const math::vec3& origin, const math::vec3& direction, float& distance,
+				   math::vec3* normal /* = nullptr */)
+{
+	if(prepare_status_ != mesh_status::prepared || face_count_ == 0 || system_vb_ == nullptr ||
+	   system_ib_ == nullptr)
+		return false;
+
+	// hold a reference so a concurrent rebuild cannot pull the data away
+	std::shared_ptr<const raycast_data> data;
+	{
+		std::lock_guard<std::mutex> lock(raycast_mutex_);
+		if(!raycast_data_)
+		{
+			auto new_data = std::make_shared<raycast_data>();
+			new_data->positions.resize(std::size_t(face_count_) * 3);
+
+			std::vector<math::bbox> triangle_bounds(face_count_);
+			const std::uint32_t* indices_ptr = system_ib_;
+			for(std::uint32_t i = 0; i < face_count_; ++i)
+			{
+				auto& bounds = triangle_bounds[i];
+				bounds.reset();
+				for(std::uint32_t j = 0; j < 3; ++j)
+				{
+					float position[4];
+					gfx::vertex_unpack(position, gfx::attribute::Position, vertex_format_, system_vb_,
+									   *indices_ptr++);
+					auto& corner = new_data->positions[(std::size_t(i) * 3) + j];
+					corner = math::vec3(position[0], position[1], position[2]);
+					bounds.add_point(corner);
+				}
+			}
+			new_data->bvh.build(triangle_bounds);
+			raycast_data_ = std::move(new_data);
+		}
+		data = raycast_data_;
+	}
+
+	const auto& positions = data->positions;
+	std::uint32_t hit_face = 0;
+	const bool hit = data->bvh.raycast(
+		origin, direction, distance, [&](std::uint32_t face, float& max_distance) {
+			const auto* v = &positions[std::size_t(face) * 3];
+			float t = 0.0f;
+			if(!math::bvh::intersect_triangle(origin, direction, v[0], v[1], v[2], t) || t > max_distance)
+				return false;
+
+			max_distance = t;
+			hit_face = face;
+			return true;
+		});
+
+	if(hit && normal != nullptr)
+	{
+		const auto* v = &positions[std::size_t(hit_face) * 3];
+		*normal = math::normalize(math::cross(v[1] - v[0], v[2] - v[0]));
+	}
+
+	return hit;
+}
+
 const skin_bind_data& mesh::get_skin_bind_data() const
 {
 	return skin_bind_data_;
@@ -3008,7 +3079,7 @@ bone_palette::~bone_palette()
 {
 }
 
-std::vector<math::transform>
+core::frame_vector<math::transform>
 bone_palette::get_skinning_matrices(const std::vector<math::transform>& node_transforms,
 									const skin_bind_data& bind_data, bool compute_inverse_transpose) const
 {
@@ -3016,10 +3087,10 @@ bone_palette::get_skinning_matrices(const std::vector<math::transform>& node_tra
 	// be referenced by the palette's bone index list.
 	const auto& bind_list = bind_data.get_bones();
 	if(node_transforms.empty())
-		return node_transforms;
+		return {};
 
 	const std::uint32_t max_blend_transforms = gfx::get_max_blend_transforms();
-	std::vector<math::transform> transforms;
+	core::frame_vector<math::transform> transforms;
 	transforms.resize(max_blend_transforms);
 
 	// Compute transformation matrix for each bone in the palette
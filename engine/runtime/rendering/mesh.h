@@ -3,11 +3,13 @@
 #include <core/common/basetypes.hpp>
 #include <core/graphics/graphics.h>
 #include <core/math/math_includes.h>
+#include <core/memory/frame_allocator.h>
 #include <core/reflection/registration.h>
 #include <core/serialization/serialization.h>
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 class camera;
@@ -222,12 +224,12 @@ public:
 	//  Name : get_skinning_matrices()
 	/// <summary>
 	/// Gather the bone / palette information and matrices ready for
-	/// drawing the skinned mesh.
+	/// drawing the skinned mesh. The result lives until the end of the frame.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::vector<math::transform> get_skinning_matrices(const std::vector<math::transform>& node_transforms,
-													   const skin_bind_data& bind_data,
-													   bool compute_inverse_transpose) const;
+	core::frame_vector<math::transform>
+	get_skinning_matrices(const std::vector<math::transform>& node_transforms,
+						  const skin_bind_data& bind_data, bool compute_inverse_transpose) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : compute_palette_fit()
@@ -747,6 +749,20 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	const subset* get_subset(std::uint32_t data_group_id = 0) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Intersects an object space ray with the triangles of the prepared mesh.
+	/// On input distance is the max distance along the direction to consider,
+	/// on success it is the distance to the closest hit and normal (if provided)
+	/// is the object space normal of the hit triangle. The triangle hierarchy is
+	/// built from the system memory buffers on first use. Skinned meshes are
+	/// tested in their bind pose.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool raycast(const math::vec3& origin, const math::vec3& direction, float& distance,
+				 math::vec3* normal = nullptr);
 	//-------------------------------------------------------------------------
 	// Public Inline Methods
 	//-------------------------------------------------------------------------
@@ -1096,4 +1112,17 @@ protected:
 	bone_palette_array_t bone_palettes_;
 	/// List of each of armature nodes
 	std::unique_ptr<armature_node> root_ = nullptr;
+
+	// Ray queries
+	struct raycast_data
+	{
+		/// Hierarchy over the triangles of the mesh.
+		math::bvh bvh;
+		/// Triangle corner positions, three per face.
+		std::vector<math::vec3> positions;
+	};
+	/// Lazily built triangle hierarchy used for ray queries.
+	std::shared_ptr<const raycast_data> raycast_data_;
+	/// Guards the lazy build of the triangle hierarchy.
+	std::mutex raycast_mutex_;
 };
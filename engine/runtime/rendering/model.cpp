@@ -6,6 +6,7 @@
 #include "../assets/asset_manager.h"
 
 #include <core/math/math_includes.h>
+#include <core/memory/frame_allocator.h>
 #include <core/system/subsystem.h>
 
 model::model()
@@ -142,10 +143,10 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 	}
 
 	auto render_subset = [this, &mesh](gfx::view_id id, bool skinned, std::uint32_t group_id,
-									   const std::vector<math::transform>& matrices, bool apply_cull,
-									   bool depth_write, bool depth_test, std::uint64_t extra_states,
-									   gpu_program* user_program,
-									   std::function<void(gpu_program&)> setup_params) {
+									   const math::transform* matrices, std::size_t matrix_count,
+									   bool apply_cull, bool depth_write, bool depth_test,
+									   std::uint64_t extra_states, gpu_program* user_program,
+									   const std::function<void(gpu_program&)>& setup_params) {
 
 		bool valid_program = false;
 		gpu_program* program = user_program;
@@ -175,20 +176,24 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 			{
 				if(user_program == nullptr)
 				{
-					mat->submit();
+					mat->submit(id);
 				}
 
 				extra_states |= mat->get_render_states(apply_cull, depth_write, depth_test);
 			}
 
-			if(!matrices.empty())
+			if(matrix_count == 1)
+			{
+				gfx::set_transform(&matrices[0].get_matrix(), 1);
+			}
+			else if(matrix_count > 1)
 			{
 				using mat_type = math::transform::mat4_t;
-				std::vector<mat_type> mats;
-				mats.reserve(matrices.size());
-				for(const auto& m : matrices)
+				core::frame_vector<mat_type> mats;
+				mats.reserve(matrix_count);
+				for(std::size_t i = 0; i < matrix_count; ++i)
 				{
-					mats.emplace_back(m.get_matrix());
+					mats.emplace_back(matrices[i].get_matrix());
 				}
 				gfx::set_transform(mats.data(), static_cast<std::uint16_t>(mats.size()));
 			}
@@ -221,8 +226,8 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 			// auto max_blend_index = palette.get_maximum_blend_index();
 
 			auto data_group = palette.get_data_group();
-			render_subset(id, true, data_group, skinning_matrices, apply_cull, depth_write, depth_test,
-						  extra_states, user_program, setup_params);
+			render_subset(id, true, data_group, skinning_matrices.data(), skinning_matrices.size(),
+						  apply_cull, depth_write, depth_test, extra_states, user_program, setup_params);
 
 		} // Next Palette
 	}
@@ -230,8 +235,8 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 	{
 		for(std::size_t i = 0; i < mesh->get_subset_count(); ++i)
 		{
-			render_subset(id, false, std::uint32_t(i), {world_transform}, apply_cull, depth_write, depth_test,
-						  extra_states, user_program, setup_params);
+			render_subset(id, false, std::uint32_t(i), &world_transform, 1, apply_cull, depth_write,
+						  depth_test, extra_states, user_program, setup_params);
 		}
 	}
 }
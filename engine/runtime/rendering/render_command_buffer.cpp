@@ -0,0 +1,25 @@
+#include "render_command_buffer.h"
+
+namespace runtime
+{
+void render_command_buffer::record(command_t command)
+{
+	commands_.emplace_back(std::move(command));
+}
+
+void render_command_buffer::execute()
+{
+	for(auto& command : commands_)
+	{
+		command();
+	}
+
+	// Captured per frame data is released here, on the executing thread.
+	clear();
+}
+
+void render_command_buffer::clear()
+{
+	commands_.clear();
+}
+}
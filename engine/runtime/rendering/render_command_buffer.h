@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : render_command_buffer (Class)
+/// <summary>
+/// Ordered list of recorded render commands of one frame. A command owns the
+/// per frame data it draws with (transforms, skinning palettes, cameras), so
+/// the simulation can change the scene while the previous frame is submitted.
+/// </summary>
+//-----------------------------------------------------------------------------
+class render_command_buffer
+{
+public:
+	using command_t = std::function<void()>;
+
+	//-----------------------------------------------------------------------------
+	//  Name : record ()
+	/// <summary>
+	/// Appends a command. It must not touch the scene when executed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void record(command_t command);
+
+	//-----------------------------------------------------------------------------
+	//  Name : execute ()
+	/// <summary>
+	/// Runs the commands in recording order and clears the buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void execute();
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Drops the commands without running them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	inline bool empty() const
+	{
+		return commands_.empty();
+	}
+
+	inline std::size_t size() const
+	{
+		return commands_.size();
+	}
+
+private:
+	/// Recorded commands.
+	std::vector<command_t> commands_;
+};
+}
@@ -0,0 +1,91 @@
+#include "render_thread.h"
+
+#include <core/common/platform/thread.hpp>
+#include <core/memory/frame_allocator.h>
+#include <core/profiler/profiler.h>
+
+#include <utility>
+
+namespace runtime
+{
+render_thread::render_thread()
+{
+	thread_ = std::thread([this]() { run(); });
+	platform::set_thread_name(thread_, "render_thread");
+}
+
+render_thread::~render_thread()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		cv_.wait(lock, [this]() { return !has_frame_; });
+		exit_ = true;
+	}
+	cv_.notify_all();
+
+	if(thread_.joinable())
+	{
+		thread_.join();
+	}
+}
+
+void render_thread::submit(render_command_buffer& frame)
+{
+	PROFILE_SCOPE("render_thread::submit");
+
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		cv_.wait(lock, [this]() { return !has_frame_; });
+		std::swap(pending_, frame);
+		has_frame_ = true;
+	}
+	cv_.notify_all();
+}
+
+void render_thread::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	cv_.wait(lock, [this]() { return !has_frame_; });
+}
+
+bool render_thread::wait_for(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	return cv_.wait_for(lock, timeout, [this]() { return !has_frame_; });
+}
+
+bool render_thread::is_current() const
+{
+	return std::this_thread::get_id() == thread_.get_id();
+}
+
+void render_thread::run()
+{
+	PROFILE_THREAD("render");
+
+	// The frames end here, not when the simulation ends them.
+	core::frame_arena::detach_thread();
+
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]() { return has_frame_ || exit_; });
+			if(!has_frame_)
+			{
+				return;
+			}
+		}
+
+		// Only this thread touches pending_ until has_frame_ is reset.
+		pending_.execute();
+		core::frame_arena::get().reset();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			has_frame_ = false;
+		}
+		cv_.notify_all();
+	}
+}
+}
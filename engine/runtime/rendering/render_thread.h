@@ -0,0 +1,87 @@
+#pragma once
+
+#include "render_command_buffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : render_thread (Class)
+/// <summary>
+/// Executes the recorded frames on a dedicated thread one frame behind the
+/// simulation. One frame is executed while the next one is recorded, so the
+/// command buffers and the data they own are double buffered. It is the api
+/// thread of bgfx, the thread that owns the renderer renders the backend
+/// frames it submits.
+/// </summary>
+//-----------------------------------------------------------------------------
+class render_thread
+{
+public:
+	render_thread();
+	~render_thread();
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Waits until the previous frame was executed and hands the buffer over.
+	/// The buffer is empty afterwards and can record the next frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit(render_command_buffer& frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : wait ()
+	/// <summary>
+	/// Waits until the submitted frame was executed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wait();
+
+	//-----------------------------------------------------------------------------
+	//  Name : wait_for ()
+	/// <summary>
+	/// Waits at most the timeout for the submitted frame. Returns true if it
+	/// was executed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool wait_for(std::chrono::milliseconds timeout);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_current ()
+	/// <summary>
+	/// Returns true when called from the render thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_current() const;
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Thread loop executing the submitted frames.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void run();
+
+	/// Guards the hand over.
+	std::mutex mutex_;
+	/// Signals a submitted or an executed frame.
+	std::condition_variable cv_;
+	/// Frame being executed.
+	render_command_buffer pending_;
+	/// Whether pending_ holds a frame that was not executed yet.
+	bool has_frame_ = false;
+	/// Set on destruction.
+	bool exit_ = false;
+	/// The render thread.
+	std::thread thread_;
+};
+}
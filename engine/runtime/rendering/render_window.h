@@ -60,22 +60,23 @@ public:
 	//-----------------------------------------------------------------------------
 	std::uint32_t get_id() const;
 
-protected:
 	//-----------------------------------------------------------------------------
-	//  Name : prepare_surface (virtual )
+	//  Name : destroy_surface (virtual )
 	/// <summary>
-	/// Creates the window fbo.
+	/// Destroys the window fbo. Calls the bgfx api, so the renderer calls it
+	/// on the render thread before the window is closed.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void prepare_surface();
+	virtual void destroy_surface();
 
+protected:
 	//-----------------------------------------------------------------------------
-	//  Name : destroy_surface (virtual )
+	//  Name : prepare_surface (virtual )
 	/// <summary>
-	/// Destroys the window fbo.
+	/// Creates the window fbo.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void destroy_surface();
+	virtual void prepare_surface();
 
 	//-----------------------------------------------------------------------------
 	//  Name : on_resize (virtual )
@@ -1,4 +1,6 @@
 #include "renderer.h"
+#include "material.h"
+#include "render_thread.h"
 
 #include "../system/events.h"
 
@@ -6,6 +8,7 @@
 #include <core/graphics/graphics.h>
 #include <core/graphics/render_pass.h>
 #include <core/logging/logging.h>
+#include <core/profiler/profiler.h>
 
 #include <algorithm>
 #include <cstdarg>
@@ -17,11 +20,30 @@ renderer::renderer(cmd_line::parser& parser)
 	on_platform_events.connect(this, &renderer::platform_events);
 	on_frame_end.connect(this, &renderer::frame_end);
 
+	parser.try_get("headless", headless_);
+
+	bool use_render_thread = false;
+	parser.try_get("render_thread", use_render_thread);
+	if(use_render_thread)
+	{
+		render_thread_ = std::make_unique<render_thread>();
+	}
+
 	if(!init_backend(parser))
 	{
 		return;
 	}
 
+	if(render_thread_)
+	{
+		APPLOG_INFO("Submitting frames on the render thread.");
+	}
+
+	if(headless_)
+	{
+		return;
+	}
+
 	mml::video_mode desktop = mml::video_mode::get_desktop_mode();
 	desktop.width = 1280;
 	desktop.height = 720;
@@ -35,9 +57,20 @@ renderer::~renderer()
 {
 	on_platform_events.disconnect(this, &renderer::platform_events);
 	on_frame_end.disconnect(this, &renderer::frame_end);
+	// Commands of an unsubmitted frame may refer to destroyed systems.
+	commands_.clear();
+	for(auto& window : windows_)
+	{
+		destroy_surface(*window);
+	}
+	for(auto& window : windows_pending_addition_)
+	{
+		destroy_surface(*window);
+	}
+	run_on_render_thread([]() { gfx::shutdown(); });
+	render_thread_.reset();
 	windows_.clear();
 	windows_pending_addition_.clear();
-	gfx::shutdown();
 }
 
 render_window* renderer::get_focused_window() const
@@ -121,6 +154,13 @@ void renderer::platform_events(const std::pair<std::uint32_t, bool>& info,
 	{
 		if(e.type == mml::platform_event::closed)
 		{
+			for(auto& window : windows_)
+			{
+				if(window->get_id() == info.first)
+				{
+					destroy_surface(*window);
+				}
+			}
 			windows_.erase(std::remove_if(std::begin(windows_), std::end(windows_),
 										  [window_id = info.first](const auto& window) {
 											  return window->get_id() == window_id;
@@ -133,6 +173,22 @@ void renderer::platform_events(const std::pair<std::uint32_t, bool>& info,
 
 bool renderer::init_backend(cmd_line::parser& parser)
 {
+	if(headless_)
+	{
+		gfx::init_type init_data;
+		init_data.type = gfx::renderer_type::Noop;
+		init_data.resolution.width = 1280;
+		init_data.resolution.height = 720;
+		init_data.resolution.reset = 0;
+		if(!init_api(init_data))
+		{
+			APPLOG_ERROR("Could not initialize headless rendering backend!");
+			return false;
+		}
+
+		APPLOG_INFO("Running headless.");
+		return true;
+	}
 
 	mml::video_mode desktop = mml::video_mode::get_desktop_mode();
 	desktop.width = 100;
@@ -183,7 +239,7 @@ bool renderer::init_backend(cmd_line::parser& parser)
 	{
 		init_data.resolution.reset = 0;
 	}
-	if(!gfx::init(init_data))
+	if(!init_api(init_data))
 	{
 		APPLOG_ERROR("Could not initialize rendering backend!");
 		return false;
@@ -204,7 +260,94 @@ bool renderer::init_backend(cmd_line::parser& parser)
 	return true;
 }
 
+bool renderer::init_api(const gfx::init_type& init_data)
+{
+	if(!render_thread_)
+	{
+		return gfx::init(init_data);
+	}
+
+	// Rendering a frame before init makes this the backend thread of bgfx, the
+	// render thread calling init becomes its api thread.
+	gfx::render_frame(0);
+	bool initialized = false;
+	run_on_render_thread([&initialized, &init_data]() { initialized = gfx::init(init_data); });
+	return initialized;
+}
+
+void renderer::record(render_command_buffer::command_t command)
+{
+	if(render_thread_)
+	{
+		commands_.record(std::move(command));
+	}
+	else
+	{
+		command();
+	}
+}
+
+void renderer::flush()
+{
+	if(render_thread_)
+	{
+		wait_for_render_thread();
+	}
+}
+
+void renderer::run_on_render_thread(render_command_buffer::command_t command)
+{
+	if(!render_thread_)
+	{
+		command();
+		return;
+	}
+
+	wait_for_render_thread();
+	render_command_buffer buffer;
+	buffer.record(std::move(command));
+	render_thread_->submit(buffer);
+	wait_for_render_thread();
+}
+
+void renderer::wait_for_render_thread()
+{
+	PROFILE_SCOPE("renderer::wait_for_render_thread");
+
+	// The api calls of the render thread may wait for the backend frames,
+	// which only this thread renders.
+	using namespace std::literals;
+	while(!render_thread_->wait_for(1ms))
+	{
+		gfx::render_frame(0);
+	}
+
+	// Render the frame it submitted last right away. Its next frame call then
+	// does not wait for the backend while holding the resource lock of bgfx,
+	// which this thread needs to create and destroy resources.
+	gfx::render_frame(0);
+}
+
+void renderer::destroy_surface(render_window& window)
+{
+	// The executing frame may still present to the surface.
+	run_on_render_thread([&window]() { window.destroy_surface(); });
+}
+
 void renderer::frame_end(delta_t /*unused*/)
+{
+	PROFILE_SCOPE("renderer::frame_end");
+
+	record([this]() { submit_frame(); });
+
+	if(render_thread_)
+	{
+		wait_for_render_thread();
+		render_thread_->submit(commands_);
+	}
+}
+
+void renderer::submit_frame()
 {
 	gfx::render_pass pass("init_bb_update");
 	pass.bind();
@@ -212,6 +355,8 @@ void renderer::frame_end(delta_t /*unused*/)
 
 	render_frame_ = gfx::frame();
 
+	material::reset_submit_cache();
+
 	gfx::render_pass::reset();
 }
 } // namespace runtime
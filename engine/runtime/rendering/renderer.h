@@ -1,14 +1,18 @@
 #pragma once
+#include "render_command_buffer.h"
 #include "render_window.h"
 
 #include <core/cmd_line/parser.hpp>
 #include <core/common/basetypes.hpp>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
 namespace runtime
 {
+class render_thread;
+
 struct renderer
 {
 	renderer(cmd_line::parser& parser);
@@ -47,6 +51,55 @@ struct renderer
 		return render_frame_;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : is_headless ()
+	/// <summary>
+	/// Returns true when running on the Noop backend without any windows.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline bool is_headless() const
+	{
+		return headless_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : record ()
+	/// <summary>
+	/// Records a command for the render thread, it is executed one frame later
+	/// and must not touch the scene. Without a render thread it runs right away.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void record(render_command_buffer::command_t command);
+
+	//-----------------------------------------------------------------------------
+	//  Name : flush ()
+	/// <summary>
+	/// Waits until the render thread executed the submitted frame. Needed
+	/// before destroying anything the recorded commands refer to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void flush();
+
+	//-----------------------------------------------------------------------------
+	//  Name : run_on_render_thread ()
+	/// <summary>
+	/// Runs a command on the thread that calls the bgfx api and waits for it.
+	/// Without a render thread it runs right away.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void run_on_render_thread(render_command_buffer::command_t command);
+
+	//-----------------------------------------------------------------------------
+	//  Name : has_render_thread ()
+	/// <summary>
+	/// Returns true when the frames are submitted on the render thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline bool has_render_thread() const
+	{
+		return render_thread_ != nullptr;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : register_window ()
 	/// <summary>
@@ -85,7 +138,49 @@ struct renderer
 						 const std::vector<mml::platform_event>& events);
 
 protected:
-	std::uint32_t render_frame_ = 0;
+	//-----------------------------------------------------------------------------
+	//  Name : init_api ()
+	/// <summary>
+	/// Initializes bgfx, on the render thread when there is one. This thread
+	/// then renders the backend frames.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool init_api(const gfx::init_type& init_data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : wait_for_render_thread ()
+	/// <summary>
+	/// Waits until the render thread executed the submitted frame, rendering
+	/// the backend frames it submits meanwhile.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wait_for_render_thread();
+
+	//-----------------------------------------------------------------------------
+	//  Name : destroy_surface ()
+	/// <summary>
+	/// Destroys the surface of a window on the thread that calls the bgfx api.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void destroy_surface(render_window& window);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_frame ()
+	/// <summary>
+	/// Closes the backend frame, on the render thread when there is one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit_frame();
+
+	/// written by the render thread
+	std::atomic<std::uint32_t> render_frame_ = {0};
+	/// no windows, Noop backend
+	bool headless_ = false;
+
+	/// frame being recorded for the render thread
+	render_command_buffer commands_;
+	/// executes the recorded frames one frame behind, null when disabled
+	std::unique_ptr<render_thread> render_thread_;
 
 	/// engine windows
 	std::unique_ptr<mml::window> init_window_;
@@ -0,0 +1,168 @@
+#include "shadow_atlas.h"
+
+#include <algorithm>
+
+constexpr shadow_atlas::handle shadow_atlas::invalid_handle;
+
+namespace
+{
+std::uint32_t next_pow2(std::uint32_t value)
+{
+	std::uint32_t result = 1;
+	while(result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+}
+
+shadow_atlas::shadow_atlas(std::uint32_t size, std::uint32_t min_size)
+	: size_(next_pow2(size))
+	, min_size_(std::min(next_pow2(min_size), next_pow2(size)))
+{
+	clear();
+}
+
+shadow_atlas::handle shadow_atlas::allocate(std::uint32_t size)
+{
+	size = fit_size(size);
+
+	auto result = find(0, size, false);
+	if(result == invalid_handle)
+	{
+		result = find(0, size, true);
+	}
+
+	if(result != invalid_handle)
+	{
+		nodes_[result].state = node_state::used;
+	}
+	return result;
+}
+
+void shadow_atlas::free(handle h)
+{
+	if(h >= nodes_.size() || nodes_[h].state != node_state::used)
+	{
+		return;
+	}
+
+	nodes_[h].state = node_state::free;
+
+	// Merge upwards while all four siblings are free.
+	auto parent = nodes_[h].parent;
+	while(parent != invalid_handle)
+	{
+		const auto first = nodes_[parent].children;
+		const bool all_free = std::all_of(std::begin(nodes_) + first, std::begin(nodes_) + first + 4,
+										  [](const node& n) { return n.state == node_state::free; });
+		if(!all_free)
+		{
+			break;
+		}
+
+		free_blocks_.emplace_back(first);
+		nodes_[parent].children = invalid_handle;
+		nodes_[parent].state = node_state::free;
+		parent = nodes_[parent].parent;
+	}
+}
+
+void shadow_atlas::clear()
+{
+	nodes_.clear();
+	free_blocks_.clear();
+
+	node root;
+	root.size = size_;
+	nodes_.emplace_back(root);
+}
+
+urect32_t shadow_atlas::get_rect(handle h) const
+{
+	const auto& n = nodes_[h];
+	return urect32_t(n.x, n.y, n.x + n.size, n.y + n.size);
+}
+
+std::uint64_t shadow_atlas::get_used_area() const
+{
+	std::uint64_t area = 0;
+	for(const auto& n : nodes_)
+	{
+		if(n.state == node_state::used)
+		{
+			area += std::uint64_t(n.size) * n.size;
+		}
+	}
+	return area;
+}
+
+std::uint32_t shadow_atlas::fit_size(std::uint32_t size) const
+{
+	return std::min(std::max(next_pow2(size), min_size_), size_);
+}
+
+shadow_atlas::handle shadow_atlas::find(handle n, std::uint32_t size, bool allow_split)
+{
+	const auto& current = nodes_[n];
+	if(current.size < size || current.state == node_state::used)
+	{
+		return invalid_handle;
+	}
+
+	if(current.state == node_state::free)
+	{
+		if(current.size == size)
+		{
+			return n;
+		}
+		if(!allow_split)
+		{
+			return invalid_handle;
+		}
+		split(n);
+	}
+
+	// The node may have been reallocated by split.
+	const auto children = nodes_[n].children;
+	for(handle i = 0; i < 4; ++i)
+	{
+		const auto result = find(children + i, size, allow_split);
+		if(result != invalid_handle)
+		{
+			return result;
+		}
+	}
+	return invalid_handle;
+}
+
+void shadow_atlas::split(handle n)
+{
+	handle first = invalid_handle;
+	if(!free_blocks_.empty())
+	{
+		first = free_blocks_.back();
+		free_blocks_.pop_back();
+	}
+	else
+	{
+		first = handle(nodes_.size());
+		nodes_.resize(nodes_.size() + 4);
+	}
+
+	const auto parent = nodes_[n];
+	const auto half = parent.size / 2;
+	for(handle i = 0; i < 4; ++i)
+	{
+		auto& child = nodes_[first + i];
+		child = node();
+		child.x = parent.x + (i % 2) * half;
+		child.y = parent.y + (i / 2) * half;
+		child.size = half;
+		child.parent = n;
+	}
+
+	nodes_[n].children = first;
+	nodes_[n].state = node_state::split;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : shadow_atlas (Class)
+/// <summary>
+/// Packs square shadow maps with power of two sizes into one square texture.
+/// The atlas is a quad tree, a node is either free, used or split into four
+/// children. Freed siblings are merged back so large maps fit again. Only
+/// the layout is managed here, the texture is owned by the renderer.
+/// </summary>
+//-----------------------------------------------------------------------------
+class shadow_atlas
+{
+public:
+	using handle = std::uint32_t;
+	static constexpr handle invalid_handle = std::numeric_limits<handle>::max();
+
+	//-----------------------------------------------------------------------------
+	//  Name : shadow_atlas ()
+	/// <summary>
+	/// Creates an empty atlas. Both sizes are rounded up to a power of two.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	shadow_atlas(std::uint32_t size = 2048, std::uint32_t min_size = 64);
+
+	//-----------------------------------------------------------------------------
+	//  Name : allocate ()
+	/// <summary>
+	/// Reserves a square of at least the size, clamped to the atlas limits.
+	/// Exactly fitting free squares are preferred over splitting larger ones.
+	/// Returns invalid_handle if there is no room left.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	handle allocate(std::uint32_t size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : free ()
+	/// <summary>
+	/// Releases a square returned by allocate.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void free(handle h);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Releases all squares.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_rect ()
+	/// <summary>
+	/// Pixel rectangle of an allocated square.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	urect32_t get_rect(handle h) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_used_area ()
+	/// <summary>
+	/// Allocated pixels.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_used_area() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : fit_size ()
+	/// <summary>
+	/// Size allocate would reserve for the requested size.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t fit_size(std::uint32_t size) const;
+
+	inline std::uint32_t get_size() const
+	{
+		return size_;
+	}
+
+	inline std::uint32_t get_min_size() const
+	{
+		return min_size_;
+	}
+
+private:
+	enum class node_state : std::uint8_t
+	{
+		free,
+		used,
+		split
+	};
+
+	struct node
+	{
+		/// Top left corner in pixels.
+		std::uint32_t x = 0;
+		std::uint32_t y = 0;
+		/// Edge length in pixels.
+		std::uint32_t size = 0;
+		/// Parent node, invalid_handle for the root.
+		handle parent = invalid_handle;
+		/// First of the four consecutive children of a split node.
+		handle children = invalid_handle;
+		/// Current state.
+		node_state state = node_state::free;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// Searches the subtree for a free node of the size, splitting larger free
+	/// nodes only when allowed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	handle find(handle n, std::uint32_t size, bool allow_split);
+
+	//-----------------------------------------------------------------------------
+	//  Name : split ()
+	/// <summary>
+	/// Turns a free node into four free children.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void split(handle n);
+
+	/// All nodes, children are stored in blocks of four.
+	std::vector<node> nodes_;
+	/// Unused blocks of four nodes.
+	std::vector<handle> free_blocks_;
+	/// Edge length of the atlas.
+	std::uint32_t size_ = 0;
+	/// Smallest square handed out.
+	std::uint32_t min_size_ = 0;
+};
@@ -0,0 +1,117 @@
+#include "streamed_texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace runtime
+{
+namespace streamed_texture
+{
+namespace
+{
+constexpr std::uint32_t layout_magic = 0x54535445; // "ETST"
+constexpr std::uint32_t layout_version = 1;
+constexpr std::uint32_t max_mips = 16;
+
+std::uint32_t get_full_chain(std::uint32_t width, std::uint32_t height)
+{
+	std::uint32_t mips = 1;
+	for(auto size = std::max(width, height); size > 1; size >>= 1)
+	{
+		++mips;
+	}
+	return mips;
+}
+
+// Offset of the mip in the file data after the header, the smaller mips come first.
+std::uint64_t get_packed_offset(const header& info, std::uint32_t mip)
+{
+	return get_resident_size(info, mip + 1);
+}
+}
+
+header make_header(std::uint16_t width, std::uint16_t height, std::uint8_t texel_size, std::uint32_t format)
+{
+	header result;
+	result.magic = layout_magic;
+	result.version = layout_version;
+	result.width = width;
+	result.height = height;
+	result.mips = static_cast<std::uint8_t>(get_full_chain(width, height));
+	result.texel_size = texel_size;
+	result.format = format;
+	return result;
+}
+
+bool read_header(const std::uint8_t* data, std::size_t size, header& result)
+{
+	if(size < sizeof(header))
+	{
+		return false;
+	}
+
+	header info;
+	std::memcpy(&info, data, sizeof(header));
+	if(info.magic != layout_magic || info.version != layout_version)
+	{
+		return false;
+	}
+	if(info.width == 0 || info.height == 0 || info.texel_size == 0 || info.mips > max_mips ||
+	   info.mips != get_full_chain(info.width, info.height))
+	{
+		return false;
+	}
+
+	result = info;
+	return true;
+}
+
+std::uint64_t get_mip_size(const header& info, std::uint32_t mip)
+{
+	const std::uint64_t width = std::max(1u, std::uint32_t(info.width) >> mip);
+	const std::uint64_t height = std::max(1u, std::uint32_t(info.height) >> mip);
+	return width * height * info.texel_size;
+}
+
+std::uint64_t get_resident_size(const header& info, std::uint32_t first_mip)
+{
+	std::uint64_t result = 0;
+	for(auto mip = first_mip; mip < info.mips; ++mip)
+	{
+		result += get_mip_size(info, mip);
+	}
+	return result;
+}
+
+std::uint64_t get_read_size(const header& info, std::uint32_t first_mip)
+{
+	return sizeof(header) + get_resident_size(info, first_mip);
+}
+
+void unpack(const header& info, std::uint32_t first_mip, const std::uint8_t* file_data,
+			std::uint8_t* output)
+{
+	const auto mips = file_data + sizeof(header);
+	for(auto mip = first_mip; mip < info.mips; ++mip)
+	{
+		const auto size = get_mip_size(info, mip);
+		std::memcpy(output, mips + get_packed_offset(info, mip), size);
+		output += size;
+	}
+}
+
+void pack(const header& info, const std::uint8_t* mips, std::vector<std::uint8_t>& output)
+{
+	output.resize(get_read_size(info, 0));
+	std::memcpy(output.data(), &info, sizeof(header));
+
+	const auto packed = output.data() + sizeof(header);
+	for(std::uint32_t mip = 0; mip < info.mips; ++mip)
+	{
+		const auto size = get_mip_size(info, mip);
+		std::memcpy(packed + get_packed_offset(info, mip), mips, size);
+		mips += size;
+	}
+}
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Layout of compiled textures that can be loaded partially. The header is
+// followed by the mips from the smallest to the largest, so any number of
+// the smallest mips is a single read from the start of the file. Nothing
+// here touches the gpu.
+//-----------------------------------------------------------------------------
+namespace streamed_texture
+{
+struct header
+{
+	/// Identifies the layout
+	std::uint32_t magic = 0;
+	/// Version of the layout
+	std::uint32_t version = 0;
+	/// Width of mip 0
+	std::uint16_t width = 0;
+	/// Height of mip 0
+	std::uint16_t height = 0;
+	/// Number of mips, always the full chain down to 1x1
+	std::uint8_t mips = 0;
+	/// Bytes per texel
+	std::uint8_t texel_size = 0;
+	/// Unused
+	std::uint16_t reserved = 0;
+	/// The gfx::texture_format of the texels
+	std::uint32_t format = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : make_header ()
+/// <summary>
+/// Header of a texture with the full mip chain of the given size.
+/// </summary>
+//-----------------------------------------------------------------------------
+header make_header(std::uint16_t width, std::uint16_t height, std::uint8_t texel_size, std::uint32_t format);
+
+//-----------------------------------------------------------------------------
+//  Name : read_header ()
+/// <summary>
+/// Reads the header from the start of the file data. Returns false when the
+/// data is not a streamed texture.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool read_header(const std::uint8_t* data, std::size_t size, header& result);
+
+//-----------------------------------------------------------------------------
+//  Name : get_mip_size ()
+/// <summary>
+/// Bytes of a single mip.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t get_mip_size(const header& info, std::uint32_t mip);
+
+//-----------------------------------------------------------------------------
+//  Name : get_resident_size ()
+/// <summary>
+/// Bytes of the mips from first_mip down to the smallest one.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t get_resident_size(const header& info, std::uint32_t first_mip);
+
+//-----------------------------------------------------------------------------
+//  Name : get_read_size ()
+/// <summary>
+/// Bytes to read from the start of the file for the mips from first_mip
+/// down, the header included.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t get_read_size(const header& info, std::uint32_t first_mip);
+
+//-----------------------------------------------------------------------------
+//  Name : unpack ()
+/// <summary>
+/// Copies the mips from first_mip down out of the file data into output in
+/// the largest first order textures are created from. Output has to hold
+/// get_resident_size bytes.
+/// </summary>
+//-----------------------------------------------------------------------------
+void unpack(const header& info, std::uint32_t first_mip, const std::uint8_t* file_data,
+			std::uint8_t* output);
+
+//-----------------------------------------------------------------------------
+//  Name : pack ()
+/// <summary>
+/// Writes the header and the mips, given largest first, in the streamed
+/// layout.
+/// </summary>
+//-----------------------------------------------------------------------------
+void pack(const header& info, const std::uint8_t* mips, std::vector<std::uint8_t>& output);
+}
+}
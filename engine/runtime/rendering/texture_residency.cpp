@@ -0,0 +1,126 @@
+#include "texture_residency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace runtime
+{
+namespace texture_residency
+{
+float get_screen_size(float radius, float distance, float tan_half_fov, float viewport_height)
+{
+	// Inside the sphere it covers the whole screen.
+	distance = std::max(distance, radius);
+	if(distance <= 0.0f || tan_half_fov <= 0.0f)
+	{
+		return viewport_height;
+	}
+	return radius / (distance * tan_half_fov) * viewport_height;
+}
+
+std::uint32_t select_mip(const streamed_texture::header& info, float texels_on_screen)
+{
+	const float size = std::max(info.width, info.height);
+	if(texels_on_screen >= size)
+	{
+		return 0;
+	}
+
+	const auto last = std::uint32_t(info.mips) - 1;
+	if(texels_on_screen <= 1.0f)
+	{
+		return last;
+	}
+	const auto mip = static_cast<std::uint32_t>(std::floor(std::log2(size / texels_on_screen)));
+	return std::min(mip, last);
+}
+
+std::uint32_t get_tail_mip(const streamed_texture::header& info, std::uint64_t tail_size)
+{
+	auto mip = std::uint32_t(info.mips) - 1;
+	while(mip > 0 && streamed_texture::get_resident_size(info, mip - 1) <= tail_size)
+	{
+		--mip;
+	}
+	return mip;
+}
+
+std::uint64_t plan(std::vector<item>& items, std::uint64_t budget)
+{
+	std::uint64_t used = 0;
+	for(auto& i : items)
+	{
+		i.target = i.tail;
+		i.wanted = std::min(i.wanted, i.tail);
+		used += streamed_texture::get_resident_size(i.info, i.tail);
+	}
+
+	// The next level of every item, by screen pixels per byte.
+	using step = std::pair<float, std::size_t>;
+	const auto get_step = [&items](std::size_t index) {
+		const auto& i = items[index];
+		const auto size = streamed_texture::get_mip_size(i.info, i.target - 1);
+		return step(i.priority / float(size), index);
+	};
+
+	std::priority_queue<step> steps;
+	for(std::size_t index = 0; index < items.size(); ++index)
+	{
+		if(items[index].priority > 0.0f && items[index].target > items[index].wanted)
+		{
+			steps.push(get_step(index));
+		}
+	}
+
+	while(!steps.empty())
+	{
+		auto& i = items[steps.top().second];
+		steps.pop();
+
+		// Smaller levels of other items may still fit.
+		const auto size = streamed_texture::get_mip_size(i.info, i.target - 1);
+		if(used + size > budget)
+		{
+			continue;
+		}
+
+		used += size;
+		--i.target;
+		if(i.target > i.wanted)
+		{
+			steps.push(get_step(std::size_t(&i - items.data())));
+		}
+	}
+
+	std::vector<std::size_t> kept;
+	for(std::size_t index = 0; index < items.size(); ++index)
+	{
+		if(items[index].resident < items[index].target)
+		{
+			kept.push_back(index);
+		}
+	}
+	std::sort(std::begin(kept), std::end(kept), [&items](std::size_t lhs, std::size_t rhs) {
+		return items[lhs].last_visible > items[rhs].last_visible;
+	});
+
+	for(const auto index : kept)
+	{
+		auto& i = items[index];
+		while(i.target > i.resident)
+		{
+			const auto size = streamed_texture::get_mip_size(i.info, i.target - 1);
+			if(used + size > budget)
+			{
+				break;
+			}
+			used += size;
+			--i.target;
+		}
+	}
+	return used;
+}
+}
+}
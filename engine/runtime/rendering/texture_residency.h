@@ -0,0 +1,73 @@
+#pragma once
+
+#include "streamed_texture.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Decides which mips of the streamed textures are resident. Only works on
+// the headers and the screen demand, so it runs without a gpu.
+//-----------------------------------------------------------------------------
+namespace texture_residency
+{
+struct item
+{
+	/// The streamed texture
+	streamed_texture::header info;
+	/// First mip resident now
+	std::uint32_t resident = 0;
+	/// First mip that is always resident, the tail
+	std::uint32_t tail = 0;
+	/// First mip the screen needs
+	std::uint32_t wanted = 0;
+	/// Screen pixels that need the texture, zero when it was not visible
+	float priority = 0.0f;
+	/// Frame the texture was last visible
+	std::uint64_t last_visible = 0;
+	/// First mip that should be resident, the result of plan
+	std::uint32_t target = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_screen_size ()
+/// <summary>
+/// Pixels across a sphere of the radius at the distance from a perspective
+/// camera.
+/// </summary>
+//-----------------------------------------------------------------------------
+float get_screen_size(float radius, float distance, float tan_half_fov, float viewport_height);
+
+//-----------------------------------------------------------------------------
+//  Name : select_mip ()
+/// <summary>
+/// First mip with at least as many texels across as there are screen pixels
+/// across the surface, texels_on_screen already scaled by the tiling.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint32_t select_mip(const streamed_texture::header& info, float texels_on_screen);
+
+//-----------------------------------------------------------------------------
+//  Name : get_tail_mip ()
+/// <summary>
+/// First mip of the largest tail not exceeding tail_size bytes, at least the
+/// smallest mip.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint32_t get_tail_mip(const streamed_texture::header& info, std::uint64_t tail_size);
+
+//-----------------------------------------------------------------------------
+//  Name : plan ()
+/// <summary>
+/// Sets the target of every item so the resident mips fit the budget. The
+/// tails are always kept. Mips the screen wants are granted one level at a
+/// time, next the level with the most screen pixels per byte. What is left
+/// keeps resident mips no longer wanted, the most recently visible first,
+/// so they are only evicted under pressure. Returns the bytes used.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t plan(std::vector<item>& items, std::uint64_t budget);
+}
+}
@@ -8,18 +8,25 @@
 #include "../ecs/systems/bone_system.h"
 #include "../ecs/systems/camera_system.h"
 #include "../ecs/systems/deferred_rendering.h"
+#include "../ecs/systems/raycast_system.h"
 #include "../ecs/systems/reflection_probe_system.h"
 #include "../ecs/systems/scene_graph.h"
+#include "../ecs/systems/texture_streaming.h"
+#include "../ecs/systems/world_streaming.h"
 #include "../input/input.h"
 #include "../rendering/render_window.h"
 #include "../rendering/renderer.h"
 
 #include <core/audio/library.h>
+#include <core/filesystem/io_system.h>
 #include <core/logging/logging.h>
+#include <core/memory/frame_allocator.h>
+#include <core/profiler/profiler.h>
 #include <core/serialization/serialization.h>
 #include <core/simulation/simulation.h>
 #include <core/tasks/task_system.h>
 
+#include <fstream>
 #include <sstream>
 
 namespace runtime
@@ -31,7 +38,7 @@ void app::setup(cmd_line::parser& parser)
 	logging_container->add_sink(std::make_shared<logging::sinks::platform_sink_mt>());
 	logging_container->add_sink(std::make_shared<logging::sinks::simple_file_sink_mt>("Log.txt", true));
 
-	logging::create(APPLOG, logging_container);
+	logging::create_async(APPLOG, logging_container);
 
 	serialization::set_warning_logger([](const std::string& msg) { APPLOG_WARNING(msg); });
 
@@ -46,25 +53,51 @@ void app::setup(cmd_line::parser& parser)
 
 	parser.set_optional<std::string>("r", "renderer", "auto", "Select preferred renderer.");
 	parser.set_optional<bool>("n", "novsync", false, "Disable vsync.");
+	parser.set_optional<bool>("rt", "render_thread", false,
+							  "Submit the frames on a render thread, one frame behind the simulation.");
+	parser.set_optional<bool>("hl", "headless", false,
+							  "Run without windows on the noop renderer and report frame timings.");
+	parser.set_optional<unsigned int>("f", "frames", 300, "Number of frames to run in headless mode.");
+	parser.set_optional<float>("dt", "dt", 1.0f / 60.0f, "Fixed delta time in seconds for headless mode.");
+	parser.set_optional<std::string>("t", "timings", "",
+									 "File to write the headless per frame timings to (csv).");
 }
 
 void app::start(cmd_line::parser& parser)
 {
+	parser.try_get("headless", headless_);
+	if(headless_)
+	{
+		parser.try_get("frames", headless_frames_);
+		parser.try_get("timings", timings_path_);
+	}
+
 	// this order is important
-	core::add_subsystem<core::simulation>();
+	auto& sim = core::add_subsystem<core::simulation>();
+	if(headless_)
+	{
+		float dt = 1.0f / 60.0f;
+		parser.try_get("dt", dt);
+		sim.set_fixed_timestep(
+			std::chrono::duration_cast<core::simulation::duration_t>(std::chrono::duration<float>(dt)));
+	}
 	core::add_subsystem<renderer>(parser);
 	core::add_subsystem<input>();
 	core::add_subsystem<audio::device>();
+	core::add_subsystem<fs::io_system>();
 	core::add_subsystem<asset_manager>();
 	core::add_subsystem<core::task_system>(false);
 	setup_asset_manager();
 	core::add_subsystem<entity_component_system>();
 	core::add_subsystem<scene_graph>();
+	core::add_subsystem<raycast_system>();
 	core::add_subsystem<bone_system>();
 	core::add_subsystem<camera_system>();
 	core::add_subsystem<reflection_probe_system>();
 	core::add_subsystem<deferred_rendering>();
 	core::add_subsystem<audio_system>();
+	core::add_subsystem<world_streaming>();
+	core::add_subsystem<texture_streaming>();
 }
 
 void app::stop()
@@ -73,6 +106,8 @@ void app::stop()
 
 void poll_events()
 {
+	PROFILE_SCOPE("poll_events");
+
 	auto& renderer = core::get_subsystem<runtime::renderer>();
 	const auto& windows = renderer.get_windows();
 
@@ -112,43 +147,94 @@ void app::run_one_frame()
 {
 	using namespace std::literals;
 
+	PROFILE_FRAME();
+
 	auto& sim = core::get_subsystem<core::simulation>();
 	auto& tasks = core::get_subsystem<core::task_system>();
 	auto& renderer = core::get_subsystem<runtime::renderer>();
-	const bool is_active = renderer.get_focused_window() != nullptr;
+	const bool is_active = headless_ || renderer.get_focused_window() != nullptr;
 	sim.run_one_frame(is_active);
 	tasks.run_on_owner_thread(5ms);
 
 	auto dt = sim.get_delta_time();
 
-	poll_events();
+	if(!headless_)
+	{
+		poll_events();
 
-	renderer.process_pending_windows();
+		renderer.process_pending_windows();
 
-	const auto& windows = renderer.get_windows();
-	bool should_quit = std::all_of(std::begin(windows), std::end(windows),
-								   [](const auto& window) { return !window->is_visible(); });
-	if(should_quit)
-	{
-		quit(0);
-		return;
+		const auto& windows = renderer.get_windows();
+		bool should_quit = std::all_of(std::begin(windows), std::end(windows),
+									   [](const auto& window) { return !window->is_visible(); });
+		if(should_quit)
+		{
+			quit(0);
+			return;
+		}
 	}
 
-	on_frame_begin(dt);
+	frame_timings::stage_durations_t durations;
+	auto last = frame_timings::clock_t::now();
+	auto run_stage = [&](event<void(delta_t)>& stage_event, frame_timings::stage stage) {
+		{
+			PROFILE_SCOPE(frame_timings::get_stage_name(stage));
+			stage_event(dt);
+		}
+
+		const auto now = frame_timings::clock_t::now();
+		durations[stage] = now - last;
+		last = now;
+	};
+
+	run_stage(on_frame_begin, frame_timings::frame_begin);
+
+	run_stage(on_frame_update, frame_timings::frame_update);
+
+	run_stage(on_frame_render, frame_timings::frame_render);
 
-	on_frame_update(dt);
+	run_stage(on_frame_ui_render, frame_timings::frame_ui_render);
 
-	on_frame_render(dt);
+	run_stage(on_frame_end, frame_timings::frame_end);
 
-	on_frame_ui_render(dt);
+	// Transient containers of the frame are gone, their memory can be reused.
+	core::frame_arena::end_frame();
 
-	on_frame_end(dt);
+	if(headless_)
+	{
+		timings_.add_frame(durations);
+		if(timings_.get_frame_count() >= headless_frames_)
+		{
+			quit(0);
+		}
+	}
+}
+
+void app::report_frame_timings()
+{
+	timings_.log_summary();
+
+	if(timings_path_.empty())
+	{
+		return;
+	}
+
+	std::ofstream stream{timings_path_, std::ios::out | std::ios::trunc};
+	if(!stream.good())
+	{
+		APPLOG_ERROR("Could not write frame timings to {0}", timings_path_);
+		return;
+	}
+	timings_.write_csv(stream);
+	APPLOG_INFO("Frame timings written to {0}", timings_path_);
 }
 
 int app::run(int argc, char* argv[])
 {
 	core::details::initialize();
 
+	PROFILE_THREAD("main");
+
 	cmd_line::parser parser(argc, argv);
 
 	setup(parser);
@@ -186,6 +272,11 @@ int app::run(int argc, char* argv[])
 	while(running_)
 		run_one_frame();
 
+	if(headless_)
+	{
+		report_frame_timings();
+	}
+
 	APPLOG_INFO("Deinitializing...");
 
 	stop();
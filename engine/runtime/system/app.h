@@ -1,5 +1,7 @@
 #pragma once
 
+#include "frame_timings.h"
+
 #include <core/cmd_line/parser.hpp>
 #include <core/common/basetypes.hpp>
 #include <core/system/subsystem.h>
@@ -68,8 +70,25 @@ struct app
 	void quit(int exitcode = 0);
 
 protected:
+	//-----------------------------------------------------------------------------
+	//  Name : report_frame_timings ()
+	/// <summary>
+	/// Logs the collected headless frame timings and writes them to the file
+	/// given on the command line, if any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void report_frame_timings();
+
 	/// exit code of the application
 	int exitcode_ = 0;
 	bool running_ = true;
+	/// running without windows for a fixed number of frames
+	bool headless_ = false;
+	/// number of frames to run in headless mode
+	unsigned int headless_frames_ = 0;
+	/// where to write the per frame timings, empty for log only
+	std::string timings_path_;
+	/// per stage cpu timings collected in headless mode
+	frame_timings timings_;
 };
 }
@@ -0,0 +1,115 @@
+#include "frame_timings.h"
+
+#include <core/logging/logging.h>
+
+#include <algorithm>
+#include <ostream>
+
+namespace runtime
+{
+namespace
+{
+struct stage_summary
+{
+	double min = 0.0;
+	double avg = 0.0;
+	double median = 0.0;
+	double p95 = 0.0;
+	double max = 0.0;
+};
+
+stage_summary summarize(std::vector<double> samples)
+{
+	stage_summary result;
+	if(samples.empty())
+	{
+		return result;
+	}
+
+	std::sort(std::begin(samples), std::end(samples));
+	const auto count = samples.size();
+	double total = 0.0;
+	for(auto sample : samples)
+	{
+		total += sample;
+	}
+
+	result.min = samples.front();
+	result.max = samples.back();
+	result.avg = total / double(count);
+	result.median = samples[count / 2];
+	result.p95 = samples[std::min(count - 1, (count * 95) / 100)];
+	return result;
+}
+}
+
+void frame_timings::add_frame(const stage_durations_t& durations)
+{
+	frames_.emplace_back(durations);
+}
+
+void frame_timings::write_csv(std::ostream& stream) const
+{
+	stream << "frame";
+	for(std::size_t s = 0; s < stage::count; ++s)
+	{
+		stream << "," << get_stage_name(s);
+	}
+	stream << ",total\n";
+
+	std::size_t frame = 0;
+	for(const auto& durations : frames_)
+	{
+		double total = 0.0;
+		stream << frame++;
+		for(const auto& duration : durations)
+		{
+			stream << "," << duration.count();
+			total += duration.count();
+		}
+		stream << "," << total << "\n";
+	}
+}
+
+void frame_timings::log_summary() const
+{
+	APPLOG_INFO("Frame timings over {0} frames (ms): min / avg / median / p95 / max", frames_.size());
+
+	std::vector<double> samples;
+	samples.reserve(frames_.size());
+	for(std::size_t s = 0; s <= stage::count; ++s)
+	{
+		samples.clear();
+		for(const auto& durations : frames_)
+		{
+			if(s < stage::count)
+			{
+				samples.emplace_back(durations[s].count());
+			}
+			else
+			{
+				double total = 0.0;
+				for(const auto& duration : durations)
+				{
+					total += duration.count();
+				}
+				samples.emplace_back(total);
+			}
+		}
+
+		const auto summary = summarize(samples);
+		const char* name = s < stage::count ? get_stage_name(s) : "total";
+		APPLOG_INFO("{0:<20} {1:8.3f} {2:8.3f} {3:8.3f} {4:8.3f} {5:8.3f}", name, summary.min, summary.avg,
+					summary.median, summary.p95, summary.max);
+	}
+}
+
+const char* frame_timings::get_stage_name(std::size_t s)
+{
+	static const char* names[] = {"on_frame_begin", "on_frame_update", "on_frame_render",
+								  "on_frame_ui_render", "on_frame_end"};
+	static_assert(sizeof(names) / sizeof(names[0]) == stage::count, "stage names out of sync");
+
+	return s < stage::count ? names[s] : "";
+}
+}
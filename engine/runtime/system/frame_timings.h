@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace runtime
+{
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : frame_timings (Class)
+/// <summary>
+/// Collects the CPU time spent in every engine loop stage per frame. Used by
+/// the headless mode to produce comparable numbers between runs.
+/// </summary>
+//-----------------------------------------------------------------------------
+class frame_timings
+{
+public:
+	using clock_t = std::chrono::high_resolution_clock;
+	using duration_t = std::chrono::duration<double, std::milli>;
+
+	enum stage : std::uint8_t
+	{
+		frame_begin,
+		frame_update,
+		frame_render,
+		frame_ui_render,
+		frame_end,
+		count
+	};
+
+	using stage_durations_t = std::array<duration_t, stage::count>;
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_frame ()
+	/// <summary>
+	/// Stores the stage durations of one frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_frame(const stage_durations_t& durations);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_count ()
+	/// <summary>
+	/// Returns the number of recorded frames.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::size_t get_frame_count() const
+	{
+		return frames_.size();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_csv ()
+	/// <summary>
+	/// Writes one row per frame with the stage durations in milliseconds.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write_csv(std::ostream& stream) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : log_summary ()
+	/// <summary>
+	/// Logs min/avg/median/p95/max of every stage and of the whole frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void log_summary() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_stage_name (static )
+	/// <summary>
+	/// Returns the name of the event the stage corresponds to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static const char* get_stage_name(std::size_t s);
+
+private:
+	/// recorded frames
+	std::vector<stage_durations_t> frames_;
+};
+}
@@ -0,0 +1 @@
+vec2 v_texcoord0 : TEXCOORD0 = vec2(0.0, 0.0);
\ No newline at end of file
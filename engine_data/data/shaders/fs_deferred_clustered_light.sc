@@ -0,0 +1,114 @@
+$input v_texcoord0
+
+#include "common.sh"
+#include "lighting.sh"
+
+SAMPLER2D(s_tex0, 0);
+SAMPLER2D(s_tex1, 1);
+SAMPLER2D(s_tex2, 2);
+SAMPLER2D(s_tex3, 3);
+SAMPLER2D(s_tex4, 4);
+SAMPLER2D(s_tex5, 5); // reflection data
+SAMPLER2D(s_tex6, 6); // ibl_brdf_lut
+SAMPLER2D(s_lights, 7); // position/range, direction/type, color/intensity, data rows
+SAMPLER2D(s_clusters, 8); // offset, count
+SAMPLER2D(s_light_indices, 9); // four light indices per texel
+
+uniform vec4 u_cluster_data0; // tiles_x, tiles_y, slices, depth_scale
+uniform vec4 u_cluster_data1; // near_clip, max_lights, index_texture_width, index_texture_height
+uniform vec4 u_camera_position;
+
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+vec4 fetch_texel(sampler2D tex, vec2 texel, vec2 size)
+{
+	return texture2DLod(tex, (texel + 0.5f) / size, 0.0f);
+}
+
+void main()
+{
+	vec2 texcoord0 = v_texcoord0;
+	GBufferData data = decodeGBuffer(texcoord0, s_tex0, s_tex1, s_tex2, s_tex3, s_tex4);
+	vec3 indirect_specular = texture2D(s_tex5, texcoord0).xyz;
+	vec3 clip = vec3(texcoord0 * 2.0 - 1.0, data.depth);
+	clip = clipTransform(clip);
+	vec3 world_position = clipToWorld(u_invViewProj, clip);
+	vec3 lobe_roughness = vec3(0.0f, data.roughness, 1.0f);
+	vec3 albedo_color = data.base_color - data.base_color * data.metalness;
+	vec3 indirect_diffuse = vec3(0.0f, 0.0f, 0.0f);
+	vec3 N = data.world_normal;
+	vec3 V = normalize(u_camera_position.xyz - world_position);
+
+	// Same cluster mapping as light_clusters on the cpu.
+	vec4 projected = mul(u_viewProj, vec4(world_position, 1.0f));
+	vec2 ndc = projected.xy / projected.w;
+	vec2 tiles = u_cluster_data0.xy;
+	vec2 tile = clamp(floor((ndc * 0.5f + 0.5f) * tiles), vec2(0.0f, 0.0f), tiles - 1.0f);
+	float depth = max(abs(mul(u_view, vec4(world_position, 1.0f)).z), u_cluster_data1.x);
+	float slice = clamp(floor(log(depth / u_cluster_data1.x) * u_cluster_data0.w), 0.0f, u_cluster_data0.z - 1.0f);
+
+	vec2 cluster_size = vec2(tiles.x * tiles.y, u_cluster_data0.z);
+	vec4 cluster = fetch_texel(s_clusters, vec2(tile.y * tiles.x + tile.x, slice), cluster_size);
+	float offset = cluster.x;
+	int count = int(cluster.y);
+
+	vec2 index_size = u_cluster_data1.zw;
+	vec2 lights_size = vec2(u_cluster_data1.y, 4.0f);
+	vec3 lighting = data.emissive_color;
+	for(int i = 0; i < MAX_LIGHTS_PER_CLUSTER; ++i)
+	{
+		if(i >= count)
+		{
+			break;
+		}
+
+		float list_index = offset + float(i);
+		float texel_index = floor(list_index / 4.0f);
+		float component = list_index - texel_index * 4.0f;
+		float row = floor(texel_index / index_size.x);
+		vec4 indices = fetch_texel(s_light_indices, vec2(texel_index - row * index_size.x, row), index_size);
+		float light_index = dot(indices, step(abs(vec4_splat(component) - vec4(0.0f, 1.0f, 2.0f, 3.0f)), vec4_splat(0.5f)));
+
+		vec4 light_position = fetch_texel(s_lights, vec2(light_index, 0.0f), lights_size);
+		vec4 light_direction = fetch_texel(s_lights, vec2(light_index, 1.0f), lights_size);
+		vec4 light_color_intensity = fetch_texel(s_lights, vec2(light_index, 2.0f), lights_size);
+		vec4 light_data = fetch_texel(s_lights, vec2(light_index, 3.0f), lights_size);
+
+		vec3 light_color = light_color_intensity.xyz;
+		float intensity = light_color_intensity.w;
+		vec3 specular_color = mix( 0.04f * light_color, data.base_color, data.metalness );
+		vec3 vector_to_light = light_position.xyz - world_position;
+		float distance_sqr = dot( vector_to_light, vector_to_light );
+		vec3 L = vector_to_light / sqrt( distance_sqr );
+		float NoL = saturate( dot(N, L) );
+		float distance_attenuation = 1.0f;
+		vec3 vector_to_light_over_radius = vector_to_light / light_data.x;
+
+		// light_type::spot is 0, light_type::point is 1
+		float light_radius_mask;
+		float spot_falloff;
+		if(light_direction.w < 0.5f)
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, 1.0f);
+			spot_falloff = SpotAttenuation( vector_to_light_over_radius, normalize(light_direction.xyz), vec2(light_data.z, 1.0f / (light_data.y - light_data.z )));
+		}
+		else
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, light_data.y);
+			spot_falloff = 1.0f;
+		}
+
+		float surface_attenuation = intensity * distance_attenuation * light_radius_mask * spot_falloff;
+		float subsurface_attenuation = distance_attenuation * light_radius_mask * spot_falloff;
+
+		vec3 energy = AreaLightSpecular(0.0f, 0.0f, normalize(vector_to_light), lobe_roughness, vector_to_light, L, V, N);
+		SurfaceShading surface_lighting = StandardShading(albedo_color, indirect_diffuse, specular_color, indirect_specular, s_tex6, lobe_roughness, energy, data.metalness, data.ambient_occlusion, L, V, N);
+		vec3 subsurface_lighting = SubsurfaceShading(data.subsurface_color, data.subsurface_opacity, data.ambient_occlusion, L, V, N);
+		vec3 surface_multiplier = light_color * (NoL * surface_attenuation);
+		vec3 subsurface_multiplier = light_color * subsurface_attenuation;
+
+		lighting += surface_multiplier * surface_lighting.direct + (subsurface_lighting + surface_lighting.indirect) * subsurface_multiplier;
+	}
+
+	gl_FragColor = vec4(lighting, 1.0f);
+}
@@ -18,6 +18,42 @@ uniform vec4 u_light_color_intensity;
 uniform vec4 u_light_data;
 uniform vec4 u_camera_position;
 
+#if POINT_LIGHT || SPOT_LIGHT
+SAMPLER2D(s_shadow_atlas, 7);
+uniform mat4 u_shadow_matrix[6]; // world to atlas uv, one per cube face for point lights
+uniform vec4 u_shadow_params; // enabled, bias
+
+float light_shadow(vec3 world_position)
+{
+	if(u_shadow_params.x < 0.5f)
+	{
+		return 1.0f;
+	}
+
+	vec3 to_surface = world_position - u_light_position.xyz;
+	int face = 0;
+#if POINT_LIGHT
+	vec3 axis = abs(to_surface);
+	if(axis.x >= axis.y && axis.x >= axis.z)
+	{
+		face = to_surface.x > 0.0f ? 0 : 1;
+	}
+	else if(axis.y >= axis.z)
+	{
+		face = to_surface.y > 0.0f ? 2 : 3;
+	}
+	else
+	{
+		face = to_surface.z > 0.0f ? 4 : 5;
+	}
+#endif
+	vec4 coord = mul(u_shadow_matrix[face], vec4(world_position, 1.0f));
+	float occluder = texture2DLod(s_shadow_atlas, coord.xy / coord.w, 0.0f).x;
+	float receiver = length(to_surface) / u_light_data.x - u_shadow_params.y;
+	return receiver > occluder ? 0.0f : 1.0f;
+}
+#endif
+
 vec4 pbr_light(vec2 texcoord0)
 {
 	GBufferData data = decodeGBuffer(texcoord0, s_tex0, s_tex1, s_tex2, s_tex3, s_tex4);
@@ -57,7 +93,11 @@ vec4 pbr_light(vec2 texcoord0)
 	float spot_falloff = 1.0f;
 #endif
 	
+#if POINT_LIGHT || SPOT_LIGHT
+	float surface_shadow = light_shadow(world_position);
+#else
 	float surface_shadow = 1.0f;
+#endif
 	float subsurface_shadow = 1.0f;
 	float surface_attenuation = (intensity * distance_attenuation * light_radius_mask * spot_falloff) * surface_shadow;
 	float subsurface_attenuation = (distance_attenuation * light_radius_mask * spot_falloff) * subsurface_shadow;
@@ -0,0 +1 @@
+vec3 v_wpos      : TEXCOORD2 = vec3(0.0, 0.0, 0.0);
\ No newline at end of file
@@ -0,0 +1,13 @@
+$input v_wpos
+
+#include "common.sh"
+
+uniform vec4 u_light_position; // position, range
+
+void main()
+{
+	// Distance to the light over its range, the atlas is blended with min so
+	// the closest caster wins without a depth buffer.
+	float distance = length(v_wpos - u_light_position.xyz) / u_light_position.w;
+	gl_FragColor = vec4(distance, distance, distance, 1.0f);
+}